@@ -0,0 +1,330 @@
+/*
+ * Digital Logic Lab Simulator - And-Inverter Graph
+ * See Aig.h for the lowering model.
+ */
+
+#include "Aig.h"
+
+#include <string.h>
+
+// Tags in AigNode::in[0] for nodes that are not ANDs. Literals stay below
+// them because begin() caps the graph at aigMaxNodes.
+const AigLit constantTag = 0xFFFF;
+const AigLit inputTag = 0xFFFE;
+const AigLit latchTag = 0xFFFD;
+const uint16_t aigMaxNodes = 0x7FF0;
+
+// nodeLits[] states while lowering
+const AigLit litUnvisited = 0xFFFF;
+const AigLit litPending = 0xFFFE;
+
+static uint16_t hashTableSize(uint16_t maxNodes) {
+  uint16_t size = 4;
+  while (size < 2 * (uint32_t)maxNodes) size <<= 1;
+  return size;
+}
+
+Aig::Aig()
+  : nodes(0), table(0), tableMask(0), maxNodes(0), numNodes(0),
+    numSources(0), full(false) {
+  memset(&stats, 0, sizeof(stats));
+}
+
+size_t Aig::storageBytes(uint16_t maxNodes) {
+  return (size_t)maxNodes * sizeof(AigNode) + (size_t)hashTableSize(maxNodes) * sizeof(uint16_t);
+}
+
+bool Aig::begin(uint8_t* storage, size_t size, uint16_t capacity) {
+  if (capacity < 1 || capacity > aigMaxNodes || size < storageBytes(capacity)) return false;
+  maxNodes = capacity;
+  nodes = (AigNode*)storage;
+  table = (uint16_t*)(nodes + maxNodes);
+  uint16_t tableSize = hashTableSize(maxNodes);
+  tableMask = tableSize - 1;
+  memset(table, 0, (size_t)tableSize * sizeof(uint16_t));
+
+  nodes[0].in[0] = constantTag;
+  nodes[0].in[1] = 0;
+  numNodes = 1;
+  numSources = 0;
+  full = false;
+  memset(&stats, 0, sizeof(stats));
+  return true;
+}
+
+AigLit Aig::addInput() {
+  if (numNodes >= maxNodes) {
+    full = true;
+    return aigFalse;
+  }
+  nodes[numNodes].in[0] = inputTag;
+  nodes[numNodes].in[1] = 0;
+  numSources++;
+  return (AigLit)(numNodes++ << 1);
+}
+
+AigLit Aig::addLatch() {
+  if (numNodes >= maxNodes) {
+    full = true;
+    return aigFalse;
+  }
+  nodes[numNodes].in[0] = latchTag;
+  nodes[numNodes].in[1] = aigFalse;
+  numSources++;
+  return (AigLit)(numNodes++ << 1);
+}
+
+void Aig::setLatchNext(AigLit latch, AigLit next) {
+  if (isLatch(aigNode(latch))) nodes[aigNode(latch)].in[1] = next;
+}
+
+bool Aig::isAnd(uint16_t node) const {
+  return node > 0 && node < numNodes && nodes[node].in[0] < latchTag;
+}
+
+bool Aig::isLatch(uint16_t node) const {
+  return node < numNodes && nodes[node].in[0] == latchTag;
+}
+
+// Returns the table slot holding (a, b), or the empty slot where it belongs
+uint16_t Aig::lookup(AigLit a, AigLit b) const {
+  uint16_t h = (uint16_t)(((uint32_t)a * 0x9E37u) ^ ((uint32_t)b * 0x85EBu)) & tableMask;
+  while (table[h]) {
+    const AigNode& n = nodes[table[h]];
+    if (n.in[0] == a && n.in[1] == b) break;
+    h = (h + 1) & tableMask;
+  }
+  return h;
+}
+
+AigLit Aig::andOf(AigLit a, AigLit b) {
+  if (a > b) {
+    AigLit t = a;
+    a = b;
+    b = t;
+  }
+  // Constants sort first, so these cover x&0, x&1, x&x and x&!x
+  if (a == aigFalse || a == aigNot(b)) {
+    stats.folded++;
+    return aigFalse;
+  }
+  if (a == aigTrue || a == b) {
+    stats.folded++;
+    return b;
+  }
+
+  uint16_t h = lookup(a, b);
+  if (table[h]) {
+    stats.sharedHits++;
+    return (AigLit)(table[h] << 1);
+  }
+  if (numNodes >= maxNodes) {
+    full = true;
+    return aigFalse;
+  }
+  nodes[numNodes].in[0] = a;
+  nodes[numNodes].in[1] = b;
+  table[h] = numNodes;
+  stats.andNodes++;
+  return (AigLit)(numNodes++ << 1);
+}
+
+AigLit Aig::xorOf(AigLit a, AigLit b) {
+  return aigNot(andOf(aigNot(andOf(a, aigNot(b))), aigNot(andOf(aigNot(a), b))));
+}
+
+AigLit Aig::gateOf(uint8_t type, AigLit a, AigLit b) {
+  switch (type) {
+    case GATE_CONST1: return aigTrue;
+    case GATE_BUF:    return a;
+    case GATE_NOT:    return aigNot(a);
+    case GATE_AND:    return andOf(a, b);
+    case GATE_OR:     return orOf(a, b);
+    case GATE_NAND:   return aigNot(andOf(a, b));
+    case GATE_NOR:    return aigNot(orOf(a, b));
+    case GATE_XOR:    return xorOf(a, b);
+    case GATE_XNOR:   return aigNot(xorOf(a, b));
+    case GATE_ANDNOT: return andOf(a, aigNot(b));
+    default:          return aigFalse;
+  }
+}
+
+// ====================
+// NETLIST LOWERING
+// ====================
+static uint16_t aigNodeBound(const NetlistGate* gates, uint16_t numNodes) {
+  uint32_t bound = 1;
+  for (uint16_t n = 0; n < numNodes; n++) {
+    uint8_t type = gates[n].type;
+    bound += (type == GATE_XOR || type == GATE_XNOR) ? 3 : 1;
+  }
+  return bound > aigMaxNodes ? aigMaxNodes : (uint16_t)bound;
+}
+
+uint16_t aigLoweredBound(const NetlistGate* gates, uint16_t numNodes, uint16_t numOutputs) {
+  uint16_t flipFlops = 0;
+  for (uint16_t n = 0; n < numNodes; n++) {
+    if (gates[n].type == GATE_DFF) flipFlops++;
+  }
+  // Every AIG node, an inverter per output and flip-flop, two constants
+  return aigNodeBound(gates, numNodes) + numOutputs + flipFlops + 2;
+}
+
+size_t aigScratchBytes(const NetlistGate* gates, uint16_t numNodes) {
+  uint16_t bound = aigNodeBound(gates, numNodes);
+  return Aig::storageBytes(bound)
+       + 2 * (size_t)numNodes * sizeof(AigLit)  // nodeLits, DFS stack
+       + 2 * (size_t)bound * sizeof(NodeId)     // literal -> lowered node
+       + 1;
+}
+
+bool lowerNetlist(const NetlistGate* gates, uint16_t numNodes,
+                  const NodeId* outputs, uint16_t numOutputs,
+                  NetlistGate* loweredGates, uint16_t capacity,
+                  NodeId* loweredOutputs, uint16_t& loweredNodes,
+                  uint8_t* scratch, size_t scratchSize, AigStats* stats) {
+  if (scratchSize < aigScratchBytes(gates, numNodes)) return false;
+  if ((uintptr_t)scratch & 1) scratch++;
+  uint16_t bound = aigNodeBound(gates, numNodes);
+  Aig aig;
+  if (!aig.begin(scratch, Aig::storageBytes(bound), bound)) return false;
+  AigLit* nodeLits = (AigLit*)(scratch + Aig::storageBytes(bound));
+  NodeId* stack = nodeLits + numNodes;
+  NodeId* litMap = stack + numNodes;
+
+  // Sources first, in netlist order, so input numbering is preserved
+  uint16_t sourceCount = 0;
+  for (uint16_t n = 0; n < numNodes; n++) {
+    nodeLits[n] = litUnvisited;
+    if (gates[n].type == GATE_INPUT) {
+      nodeLits[n] = aig.addInput();
+      sourceCount++;
+    }
+  }
+  for (uint16_t n = 0; n < numNodes; n++) {
+    if (gates[n].type == GATE_DFF) {
+      nodeLits[n] = aig.addLatch();
+      sourceCount++;
+    }
+  }
+
+  // Depth-first over fanins. Only the current path is ever pending, so
+  // reaching a pending node means a combinational cycle.
+  for (uint16_t root = 0; root < numNodes; root++) {
+    if (nodeLits[root] != litUnvisited) continue;
+    uint16_t top = 0;
+    stack[top++] = root;
+    nodeLits[root] = litPending;
+    while (top) {
+      NodeId n = stack[top - 1];
+      const NetlistGate& g = gates[n];
+      bool ready = true;
+      for (uint8_t i = 0; i < 2 && ready; i++) {
+        NodeId f = g.in[i];
+        if (f == noNode) continue;
+        if (nodeLits[f] == litPending) return false;
+        if (nodeLits[f] == litUnvisited) {
+          nodeLits[f] = litPending;
+          stack[top++] = f;
+          ready = false;
+        }
+      }
+      if (!ready) continue;
+      AigLit a = g.in[0] != noNode ? nodeLits[g.in[0]] : aigFalse;
+      AigLit b = g.in[1] != noNode ? nodeLits[g.in[1]] : aigFalse;
+      nodeLits[n] = aig.gateOf(g.type, a, b);
+      top--;
+    }
+  }
+  for (uint16_t n = 0; n < numNodes; n++) {
+    if (gates[n].type == GATE_DFF) {
+      NodeId d = gates[n].in[0];
+      aig.setLatchNext(nodeLits[n], d != noNode ? nodeLits[d] : aigFalse);
+    }
+  }
+  if (aig.overflowed()) return false;
+
+  // Keep the ANDs reachable from the outputs and flip-flops. Fanins always
+  // have lower indices, so one downward sweep marks the whole cone.
+  uint16_t aigNodes = aig.nodeCount();
+  const NodeId live = 0;
+  for (uint16_t i = 0; i < 2 * aigNodes; i++) litMap[i] = noNode;
+  for (uint16_t i = 0; i < numOutputs; i++) litMap[nodeLits[outputs[i]] & ~1] = live;
+  for (uint16_t n = 1; n < aigNodes; n++) {
+    if (aig.isLatch(n)) litMap[aig.node(n).in[1] & ~1] = live;
+  }
+  for (uint16_t n = aigNodes - 1; n > 0; n--) {
+    if (litMap[n << 1] == live && aig.isAnd(n)) {
+      litMap[aig.node(n).in[0] & ~1] = live;
+      litMap[aig.node(n).in[1] & ~1] = live;
+    }
+  }
+  litMap[aigFalse] = noNode;  // Constants are created on demand below
+
+  // Emit sources, then live ANDs in creation (topological) order
+  uint16_t count = 0;
+  for (uint16_t n = 1; n < aigNodes; n++) {
+    bool source = !aig.isAnd(n);
+    bool keep = source || litMap[n << 1] == live;
+    litMap[n << 1] = noNode;
+    if (!keep) continue;
+    if (count >= capacity) return false;
+
+    NetlistGate& out = loweredGates[count];
+    if (source) {
+      out.type = aig.isLatch(n) ? GATE_DFF : GATE_INPUT;
+      out.in[0] = noNode;
+      out.in[1] = noNode;
+    }
+    else {
+      AigLit a = aig.node(n).in[0];
+      AigLit b = aig.node(n).in[1];
+      if (aigComplemented(a) && !aigComplemented(b)) {
+        AigLit t = a;
+        a = b;
+        b = t;
+      }
+      out.in[0] = litMap[a & ~1];
+      out.in[1] = litMap[b & ~1];
+      if (!aigComplemented(a) && !aigComplemented(b)) out.type = GATE_AND;
+      else if (!aigComplemented(a)) out.type = GATE_ANDNOT;
+      else out.type = GATE_NOR;
+    }
+    litMap[n << 1] = count++;
+  }
+
+  // Constants and complemented uses get their own node, created once
+  for (uint16_t pass = 0; pass < 2; pass++) {
+    uint16_t uses = pass == 0 ? numOutputs : aigNodes;
+    for (uint16_t i = 0; i < uses; i++) {
+      AigLit lit;
+      if (pass == 0) lit = nodeLits[outputs[i]];
+      else if (aig.isLatch(i)) lit = aig.node(i).in[1];
+      else continue;
+
+      if (litMap[lit] == noNode) {
+        if (count >= capacity) return false;
+        NetlistGate& out = loweredGates[count];
+        out.in[0] = noNode;
+        out.in[1] = noNode;
+        if (lit == aigFalse) out.type = GATE_CONST0;
+        else if (lit == aigTrue) out.type = GATE_CONST1;
+        else {
+          out.type = GATE_NOT;
+          out.in[0] = litMap[lit & ~1];
+        }
+        litMap[lit] = count++;
+      }
+      if (pass == 0) loweredOutputs[i] = litMap[lit];
+      else loweredGates[litMap[(AigLit)(i << 1)]].in[0] = litMap[lit];
+    }
+  }
+
+  loweredNodes = count;
+  if (stats) {
+    *stats = aig.stats;
+    stats->sourceGates = numNodes - sourceCount;
+    stats->loweredGates = count - sourceCount;
+  }
+  return true;
+}
@@ -0,0 +1,102 @@
+/*
+ * Digital Logic Lab Simulator - And-Inverter Graph
+ * Every gate type is lowered into two-input ANDs with complemented edges.
+ * Structurally identical ANDs are shared through a hash table and constants
+ * are folded as the graph is built. The result is written back as a netlist
+ * whose gates are AND, ANDNOT and NOR (an AND under the four edge
+ * polarities), so every engine runs the same smaller, uniform graph.
+ *
+ * Like the Netlist engine, all storage is supplied by the caller.
+ */
+
+#ifndef AIG_H
+#define AIG_H
+
+#include "Netlist.h"
+
+// ====================
+// AIG DEFINITIONS
+// ====================
+// A literal is node << 1 | complement. Node 0 is the constant false.
+typedef uint16_t AigLit;
+const AigLit aigFalse = 0;
+const AigLit aigTrue = 1;
+
+inline AigLit aigNot(AigLit lit) { return lit ^ 1; }
+inline uint16_t aigNode(AigLit lit) { return lit >> 1; }
+inline bool aigComplemented(AigLit lit) { return lit & 1; }
+
+// AND node fanins; inputs and latches are tagged in in[0]
+struct AigNode {
+  AigLit in[2];
+};
+
+struct AigStats {
+  uint16_t sourceGates;    // Gates in the netlist before lowering
+  uint16_t andNodes;       // AND nodes created
+  uint16_t sharedHits;     // ANDs found in the hash table instead
+  uint16_t folded;         // ANDs removed by constant propagation
+  uint16_t loweredGates;   // Gates in the exported netlist
+};
+
+// ====================
+// AIG BUILDER
+// ====================
+class Aig {
+public:
+  Aig();
+
+  static size_t storageBytes(uint16_t maxNodes);
+  bool begin(uint8_t* storage, size_t size, uint16_t maxNodes);
+
+  AigLit addInput();
+  AigLit addLatch();
+  void setLatchNext(AigLit latch, AigLit next);
+
+  // Hashed, constant-folded AND; the other operators are built from it
+  AigLit andOf(AigLit a, AigLit b);
+  AigLit orOf(AigLit a, AigLit b) { return aigNot(andOf(aigNot(a), aigNot(b))); }
+  AigLit xorOf(AigLit a, AigLit b);
+  AigLit gateOf(uint8_t type, AigLit a, AigLit b);
+
+  uint16_t nodeCount() const { return numNodes; }
+  uint16_t andCount() const { return numNodes - 1 - numSources; }
+  bool overflowed() const { return full; }
+
+  bool isAnd(uint16_t node) const;
+  bool isLatch(uint16_t node) const;
+  const AigNode& node(uint16_t index) const { return nodes[index]; }
+
+  AigStats stats;
+
+private:
+  uint16_t lookup(AigLit a, AigLit b) const;
+
+  AigNode* nodes;
+  uint16_t* table;       // Open-addressed hash of AND nodes, 0 = empty
+  uint16_t tableMask;
+  uint16_t maxNodes;
+  uint16_t numNodes;
+  uint16_t numSources;   // Inputs and latches
+  bool full;
+};
+
+// ====================
+// NETLIST LOWERING
+// ====================
+// Scratch needed by lowerNetlist() for this netlist
+size_t aigScratchBytes(const NetlistGate* gates, uint16_t numNodes);
+
+// Upper bound on the nodes lowerNetlist() writes
+uint16_t aigLoweredBound(const NetlistGate* gates, uint16_t numNodes, uint16_t numOutputs);
+
+// Lowers a netlist through an AIG and exports the logic reachable from the
+// outputs and flip-flops. Inputs keep their numbering. Fails if the netlist
+// has a combinational cycle (latches stay as gate netlists) or does not fit.
+bool lowerNetlist(const NetlistGate* gates, uint16_t numNodes,
+                  const NodeId* outputs, uint16_t numOutputs,
+                  NetlistGate* loweredGates, uint16_t capacity,
+                  NodeId* loweredOutputs, uint16_t& loweredNodes,
+                  uint8_t* scratch, size_t scratchSize, AigStats* stats);
+
+#endif
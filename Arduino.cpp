@@ -4,6 +4,26 @@
  * Designed for Arduino Mega (for sufficient I/O pins)
  */
 
+#include <EEPROM.h>
+
+#include "Aig.h"
+#include "Capture.h"
+#include "Checkpoint.h"
+#include "ClockDomain.h"
+#include "ConfigStore.h"
+#include "Counter.h"
+#include "Fsm.h"
+#include "Instances.h"
+#include "Latency.h"
+#include "Memory.h"
+#include "Minimizer.h"
+#include "Netlist.h"
+#include "Profile.h"
+#include "ShiftRegister.h"
+#include "Telemetry.h"
+#include "Timing.h"
+#include "Trace.h"
+
 // ====================
 // PIN CONFIGURATION
 // ====================
@@ -17,6 +37,7 @@ const int numOutputs = 8;
 
 // Special Pins
 const int clockPin = 38;     // For sequential circuits
+const int auxClockPin = 3;   // Second external clock
 const int resetPin = 39;     // System reset
 const int modePin = 40;      // Mode selection
 const int segmentPins[7] = {41, 43, 45, 47, 49, 51, 53}; // 7-segment pins (a-g)
@@ -25,10 +46,24 @@ const int segmentPins[7] = {41, 43, 45, 47, 49, 51, 53}; // 7-segment pins (a-g)
 // GLOBAL VARIABLES
 // ====================
 String currentCircuit = "AND";
-bool lastClockState = LOW;
+String currentCategory = "Basic";
 unsigned long lastPulseTime = 0;
 int counterValue = 0;
-bool flipFlopState = LOW;
+
+// All valid circuits (would be expanded)
+const char* const circuitNames[] = {
+  "AND", "OR", "NOT", "NAND", "NOR", "XOR", "XNOR",
+  "Half Adder", "Full Adder", "Multiplexer (MUX)",
+  "SR Latch (NAND)", "SR Latch (NOR)", "D Flip-Flop", "JK Flip-Flop",
+  "T Flip-Flop", "Sequence Detector (101)", "FSM",
+  "Astable Multivibrator",
+  "Binary Up Counter", "Binary Down Counter", "Decade Up Counter", "Decade Down Counter",
+  "Gray Code Counter", "Ring Counter", "Johnson Counter", "Frequency Divider",
+  "Shift Register",
+  "BCD Decoder with 7-Segment Display",
+  "Instances"
+};
+const uint8_t numCircuits = sizeof(circuitNames) / sizeof(circuitNames[0]);
 
 // 7-segment display patterns (0-9)
 const byte digitPatterns[10] = {
@@ -44,6 +79,389 @@ const byte digitPatterns[10] = {
   B01101111  // 9
 };
 
+// ====================
+// NETLIST CIRCUITS
+// ====================
+// Combinational circuits are evaluated as gate netlists so that an input
+// change only re-evaluates the gates in its fanout cone.
+// Input node k is input pin k; output k drives output pin k.
+// Feed-forward circuits are first lowered through an AIG (Aig.h); the
+// arena doubles as the lowering scratch before the engine takes it over.
+Netlist circuitNetlist;
+uint8_t netlistArena[netlistArenaBytes];
+bool netlistActive = false;
+NetlistGate loweredNetlist[loweredGateCount];
+NodeId loweredOutputs[numOutputs];
+AigStats loweredStats;
+bool netlistLowered = false;
+
+// Basic gates share one netlist; the gate type is patched on load
+NetlistGate basicGateNetlist[] = {
+  {GATE_INPUT, {noNode, noNode}},   // 0: A
+  {GATE_INPUT, {noNode, noNode}},   // 1: B
+  {GATE_AND,   {0, 1}}              // 2: Output
+};
+const NodeId basicGateOutputs[] = {2};
+
+const NetlistGate halfAdderNetlist[] = {
+  {GATE_INPUT, {noNode, noNode}},   // 0: A
+  {GATE_INPUT, {noNode, noNode}},   // 1: B
+  {GATE_XOR,   {0, 1}},             // 2: Sum
+  {GATE_AND,   {0, 1}}              // 3: Carry
+};
+const NodeId halfAdderOutputs[] = {2, 3};
+
+const NetlistGate fullAdderNetlist[] = {
+  {GATE_INPUT, {noNode, noNode}},   // 0: A
+  {GATE_INPUT, {noNode, noNode}},   // 1: B
+  {GATE_INPUT, {noNode, noNode}},   // 2: C
+  {GATE_XOR,   {0, 1}},             // 3: A ^ B
+  {GATE_XOR,   {3, 2}},             // 4: Sum
+  {GATE_AND,   {0, 1}},             // 5: A & B
+  {GATE_AND,   {3, 2}},             // 6: (A ^ B) & C
+  {GATE_OR,    {5, 6}}              // 7: Carry
+};
+const NodeId fullAdderOutputs[] = {4, 7};
+
+// 4:1 MUX, same sum of products as the original hand-written form
+// (data input C shares pin 2 with S0)
+const NetlistGate muxNetlist[] = {
+  {GATE_INPUT, {noNode, noNode}},   // 0: A
+  {GATE_INPUT, {noNode, noNode}},   // 1: B
+  {GATE_INPUT, {noNode, noNode}},   // 2: C / S0
+  {GATE_INPUT, {noNode, noNode}},   // 3: S1
+  {GATE_INPUT, {noNode, noNode}},   // 4: D
+  {GATE_NOT,   {2, noNode}},        // 5: !S0
+  {GATE_NOT,   {3, noNode}},        // 6: !S1
+  {GATE_AND,   {6, 5}},             // 7: !S1 & !S0
+  {GATE_AND,   {7, 0}},             // 8:   & A
+  {GATE_AND,   {6, 2}},             // 9: !S1 & S0
+  {GATE_AND,   {9, 1}},             // 10:  & B
+  {GATE_AND,   {3, 5}},             // 11: S1 & !S0
+  {GATE_AND,   {11, 2}},            // 12:  & C
+  {GATE_AND,   {3, 2}},             // 13: S1 & S0
+  {GATE_AND,   {13, 4}},            // 14:  & D
+  {GATE_OR,    {8, 10}},            // 15
+  {GATE_OR,    {12, 14}},           // 16
+  {GATE_OR,    {15, 16}}            // 17: Output
+};
+const NodeId muxOutputs[] = {17};
+
+// Cross-coupled latches; the netlist engine settles the feedback loop
+const NetlistGate srLatchNandNetlist[] = {
+  {GATE_INPUT, {noNode, noNode}},   // 0: S' (active low)
+  {GATE_INPUT, {noNode, noNode}},   // 1: R' (active low)
+  {GATE_NAND,  {0, 3}},             // 2: Q
+  {GATE_NAND,  {1, 2}}              // 3: Q'
+};
+const NetlistGate srLatchNorNetlist[] = {
+  {GATE_INPUT, {noNode, noNode}},   // 0: S
+  {GATE_INPUT, {noNode, noNode}},   // 1: R
+  {GATE_NOR,   {1, 3}},             // 2: Q
+  {GATE_NOR,   {0, 2}}              // 3: Q'
+};
+const NodeId srLatchOutputs[] = {2, 3};
+
+// ====================
+// FSM CIRCUITS
+// ====================
+// Clocked circuits are state tables run by the FSM engine (Fsm.h): one
+// lookup per rising clock edge. The built-in tables live in flash; 'fsm'
+// builds one in SRAM, which runs as the "FSM" circuit. Inputs are the low
+// input pins, outputs the low output pins.
+FsmMachine fsmMachine;
+uint16_t fsmRamTable[fsmRamEntries];
+FsmTable fsmLoaded = {fsmRamTable, 0, 0, 1, FSM_MOORE, 0, 0};
+
+// D on input 0; Q = D after the edge
+const uint16_t dFlipFlopTable[] PROGMEM = {
+  fsmEntry(0, 0), fsmEntry(1, 1),   // Q = 0
+  fsmEntry(0, 0), fsmEntry(1, 1)    // Q = 1
+};
+// J on input 0, K on input 1
+const uint16_t jkFlipFlopTable[] PROGMEM = {
+  fsmEntry(0, 0), fsmEntry(1, 1), fsmEntry(0, 0), fsmEntry(1, 1),   // Q = 0
+  fsmEntry(1, 1), fsmEntry(1, 1), fsmEntry(0, 0), fsmEntry(0, 0)    // Q = 1
+};
+// T on input 0
+const uint16_t tFlipFlopTable[] PROGMEM = {
+  fsmEntry(0, 0), fsmEntry(1, 1),   // Q = 0
+  fsmEntry(1, 1), fsmEntry(0, 0)    // Q = 1
+};
+// Mealy: output 0 goes high while the input completes 1-0-1 (overlapping)
+const uint16_t sequence101Table[] PROGMEM = {
+  fsmEntry(0, 0), fsmEntry(1, 0),   // 0: idle
+  fsmEntry(2, 0), fsmEntry(1, 0),   // 1: seen 1
+  fsmEntry(0, 0), fsmEntry(1, 1)    // 2: seen 10
+};
+
+const FsmTable dFlipFlopFsm = {dFlipFlopTable, 2, 1, 1, FSM_MOORE, 0, 0};
+const FsmTable jkFlipFlopFsm = {jkFlipFlopTable, 2, 2, 1, FSM_MOORE, 0, 0};
+const FsmTable tFlipFlopFsm = {tFlipFlopTable, 2, 1, 1, FSM_MOORE, 0, 0};
+const FsmTable sequence101Fsm = {sequence101Table, 3, 1, 1, FSM_MEALY, 0, 0};
+
+// ====================
+// CLOCK DOMAINS
+// ====================
+// Clocked circuits take their edges from a clock domain (ClockDomain.h)
+// instead of reading the clock pin themselves. Each circuit is bound to
+// one, "main" (the clock pin) until 'clock bind' says otherwise, and its
+// domain's stale edges are dropped when the circuit is selected.
+const uint8_t numClockDomains = 5;
+ClockDomain clockDomains[numClockDomains];
+uint8_t circuitClocks[numCircuits];     // Domain of each circuit
+uint8_t currentClock = 0;               // Domain of the current circuit
+
+// ====================
+// CLOCK GENERATOR
+// ====================
+// Timer1 pulses the "gen" domain at 1 Hz-100 kHz, free-running or in
+// bursts of N; 'gen step' gives single pulses. The interrupt only counts
+// pulses and serviceClocks() queues them, so edges a circuit cannot keep
+// up with show as lost. While the current circuit runs on "gen", loop()
+// skips its pause, so the highest rate with nothing lost is the rate that
+// circuit's engine sustains.
+const uint8_t generatorClock = 4;
+const uint32_t generatorMaxRate = 100000;
+uint32_t generatorRate = 1000;          // Programmed rate, Hz
+volatile bool generatorRunning = false;
+volatile uint32_t generatorBurst = 0;   // Pulses left in a burst, 0 free-running
+volatile uint16_t generatorTicks = 0;   // Pulses not yet queued
+uint32_t generatorPulses = 0;
+unsigned long generatorStartMillis = 0;
+uint32_t generatorStartEdges = 0;       // Domain counts when the run started
+uint16_t generatorStartLost = 0;
+
+// ====================
+// COUNTERS
+// ====================
+// Counter circuits are Counter<> instances (Counter.h). Inputs 0-3 are the
+// parallel data; input 6 LOW holds the count and input 7 LOW loads the
+// data on the next clock edge (both idle HIGH on their pull-ups).
+const uint8_t counterHoldBit = 6;
+const uint8_t counterLoadBit = 7;
+Counter<4> binaryUpCounter;
+Counter<4, 0, COUNT_DOWN> binaryDownCounter;
+Counter<4, 10, COUNT_UP, COUNT_BCD> decadeUpCounter;
+Counter<4, 10, COUNT_DOWN, COUNT_BCD> decadeDownCounter;
+Counter<4, 0, COUNT_UP, COUNT_GRAY> grayCounter;
+Counter<4, 0, COUNT_UP, COUNT_RING> ringCounter;
+Counter<4, 0, COUNT_UP, COUNT_JOHNSON> johnsonCounter;
+// Two cascaded decades: the units' carry enables the tens
+Counter<4, 10, COUNT_UP, COUNT_BCD> dividerUnits;
+Counter<4, 10, COUNT_UP, COUNT_BCD> dividerTens;
+
+// The counter the current circuit runs, resolved once by enterCircuit()
+// so a clock edge does not compare circuit names
+enum CounterCircuit : uint8_t {
+  COUNTER_NONE,
+  COUNTER_BINARY_UP,
+  COUNTER_BINARY_DOWN,
+  COUNTER_DECADE_UP,
+  COUNTER_DECADE_DOWN,
+  COUNTER_GRAY,
+  COUNTER_RING,
+  COUNTER_JOHNSON,
+  COUNTER_DIVIDER
+};
+uint8_t currentCounter = COUNTER_NONE;
+
+// ====================
+// SHIFT REGISTER
+// ====================
+// The shift register clocks on pin 2 (INT4) rather than the polled clock
+// pin, and each rising edge is applied in the interrupt, so no edge is
+// missed however long the loop pass. Input 0 is the serial data, input 1
+// HIGH shifts toward the top bit (LOW toward bit 0) and input 2 LOW holds;
+// with the mode pin LOW a PISO edge loads inputs 0-7 instead. The state
+// is 4-64 bits (ShiftRegister.h); outputs show its low 8 bits, or in the
+// serial-out modes output 0 the bit at the outgoing end.
+const int shiftClockPin = 2;
+const uint8_t shiftDataBit = 0;
+const uint8_t shiftUpBit = 1;
+const uint8_t shiftHoldBit = 2;
+UniversalShiftRegister shiftRegister;
+volatile uint8_t shiftMode = SHIFT_SIPO;
+volatile bool shiftClockEnabled = false;
+volatile uint32_t shiftEdges = 0;
+
+// ====================
+// CIRCUIT SLOTS
+// ====================
+// Switching circuits does not reset the system. A circuit name command
+// only stages the switch; loop() makes it before the next pass samples,
+// so no pass sees two circuits, and swapCircuit() saves the outgoing
+// circuit's outputs, state table state, counter value and netlist node
+// values into its slot and resumes the incoming one from its own. The
+// counters and the shift register keep their state in their own objects,
+// so a counter picks up its count where it left off, and a latch comes
+// back holding what it held. 'reset' still resets everything and empties
+// the slots.
+struct CircuitSlot {
+  uint8_t outputs;          // Output pins when switched away
+  uint8_t state;            // fsmMachine state and Moore output
+  uint8_t latched;
+  int counter;              // counterValue
+  uint32_t nodes;           // circuitNetlist node values (latches)
+  bool saved;
+};
+CircuitSlot circuitSlots[numCircuits];
+uint8_t pendingCircuit = numCircuits;   // Staged switch, numCircuits for none
+unsigned long swapMicros = 0;           // Time the last switch took
+
+// ====================
+// CIRCUIT INSTANCES
+// ====================
+// The "Instances" circuit runs up to circuitInstances circuits side by
+// side, each on its own input and output bits, e.g. four gates or a half
+// adder next to a D flip-flop (Instances.h). 'inst add' compiles gates and
+// combinational circuits to truth tables through their netlist; clocked
+// circuits keep a state table and follow their own clock domain. One pass
+// evaluates them all on the packed input word and writes the whole output
+// word; the reset pin resets every instance.
+InstanceBank instanceBank;
+
+// ====================
+// CHECKPOINTS
+// ====================
+// 'checkpoint' snapshots the simulator into checkpointBlob (Checkpoint.h)
+// and sends it as a FRAME_CHECKPOINT frame; 'restore apply' puts the last
+// one back, so one checkpoint can start any number of runs. A checkpoint
+// from the host is loaded first with 'restore <offset> <hex>' lines
+// (host/checkpoint_fork writes them). It holds the current circuit and
+// every circuit slot, the state table, counters, shift register, the
+// astable's phase, the output pins, the latch node values, the clock
+// bindings, every domain's phase, the generator and the instances. Capture, telemetry, timing
+// checks and statistics observe the simulator and are left alone.
+CheckpointBlob checkpointBlob;
+
+// ====================
+// SAVED CONFIGURATION
+// ====================
+// 'config save' keeps the simulator in EEPROM (ConfigStore.h): the
+// checkpoint, which holds the circuit, the clock bindings and domains, the
+// generator and the instances, followed by the state table built with
+// 'fsm' and the analyzer and telemetry timer settings. At power-up setup() puts it back and skips the menu, so the Mega
+// evaluates the saved circuit without the host resending anything. Four
+// 1 KB slots of the 4 KB EEPROM take repeated saves in turn. The time
+// from reset to the first evaluation is reported at every boot.
+const uint8_t configSlots = 4;
+const uint16_t configSlotBytes = 1024;
+ConfigStore configStore(readEeprom, writeEeprom, configSlots, configSlotBytes);
+bool warmStart = false;                 // Booted from a saved configuration
+bool firstEvaluation = true;
+unsigned long firstEvaluationMicros = 0;
+
+// ====================
+// LOGIC ANALYZER CAPTURE
+// ====================
+// Timer3 samples PINA and PINC, which hold all 16 I/O pins, into a ring
+// buffer. Words are converted to packed inputs (low byte) and outputs
+// (high byte) only when the capture is dumped as a binary frame. In rle
+// mode the buffer holds run-length records, so slow signals cover far
+// more samples than the raw depth.
+uint16_t captureBuffer[captureDepth];
+LogicCapture logicCapture;
+uint32_t captureRate = 10000;           // Programmed rate, Hz
+const uint32_t captureMaxRate = 200000;
+unsigned long captureStartMicros = 0;
+volatile unsigned long captureEndMicros = 0;
+bool captureRunning = false;
+
+// Trigger as entered, on packed words
+uint8_t captureTriggerType = TRIGGER_NOW;
+uint16_t captureTriggerMask = 0;
+uint16_t captureTriggerValue = 0;
+
+// Packed bit k is this bit of PINA | PINC << 8 (input pins 22-36 are
+// PA0, PA2, PA4, PA6, PC7, PC5, PC3, PC1; output pins 23-37 the others)
+const uint8_t captureRawBits[16] = {0, 2, 4, 6, 15, 13, 11, 9, 1, 3, 5, 7, 14, 12, 10, 8};
+
+// ====================
+// TELEMETRY STREAM
+// ====================
+// Timer4 samples the same port word as the analyzer and queues only the
+// changes, with the counter; loop() drains the queue into binary frames.
+TelemetryEvent telemetryQueue[telemetryQueueDepth];
+TelemetryStream telemetry;
+uint32_t telemetryRate = 10000;         // Programmed rate, Hz
+const uint32_t telemetryMaxRate = 50000;
+uint32_t serialBaud = 115200;
+
+// ====================
+// SETUP/HOLD CHECKING
+// ====================
+// With 'timing on' the telemetry timer (Timer4) also samples the clock pin
+// (PD7) and checks the clocked circuit's data inputs, those of its state
+// table, against that circuit's setup and hold windows (Timing.h), whether
+// or not it is streaming. Violations are counted, printed and marked in
+// the telemetry stream.
+TimingCheck timingCheck;
+TimingWindow timingWindows[numCircuits];
+volatile bool timingActive = false;
+uint16_t timingReported = 0;            // Violations already printed
+
+// ====================
+// PHASE PROFILING AND TRACING
+// ====================
+// Set PHASE_PROFILE to 1 to time the loop phases with Timer5, which then
+// counts CPU cycles freely; 'stats' sends the figures as a binary frame.
+// Set PHASE_TRACE to 1 to also queue each phase, the timer interrupts,
+// command reads and input edges as timeline events, which 'trace on'
+// streams as binary frames. At 0 the trace points compile to nothing.
+#ifndef PHASE_PROFILE
+#define PHASE_PROFILE 0
+#endif
+#ifndef PHASE_TRACE
+#define PHASE_TRACE 0
+#endif
+
+#if PHASE_PROFILE
+PhaseProfile phaseProfile;
+#endif
+#if PHASE_TRACE
+TraceEvent traceEvents[traceDepth];
+TraceBuffer traceBuffer;
+int tracedInputs = -1;                   // Input word last marked, -1 for none
+#define TRACE_BEGIN(id) traceEvent(id, TRACE_KIND_BEGIN, 0)
+#define TRACE_END(id) traceEvent(id, TRACE_KIND_END, 0)
+#define TRACE_INPUTS(word) traceInputs(word)
+#else
+#define TRACE_BEGIN(id)
+#define TRACE_END(id)
+#define TRACE_INPUTS(word)
+#endif
+#if PHASE_PROFILE || PHASE_TRACE
+#define PROFILE_BEGIN(phase) phaseBegin(phase)
+#define PROFILE_END(phase) phaseEnd(phase)
+#else
+#define PROFILE_BEGIN(phase)
+#define PROFILE_END(phase)
+#endif
+
+// ====================
+// CYCLE TIMER AND LATENCY SELF-TEST
+// ====================
+// Timer5 counts CPU cycles freely once profiling, tracing or the latency
+// test needs it. For 'latency' its compare output OC5A (pin 46) drives
+// the stimulus edge and its input capture ICP5 (pin 48) timestamps the
+// response, both to the cycle: jumper pin 46 to the input under test and
+// the output under test to pin 48.
+volatile uint16_t cycleOverflows = 0;
+const int stimulusPin = 46;
+const int responsePin = 48;
+const unsigned long latencyTimeoutMillis = 50;
+LatencyResults latencyResults;
+bool latencyRunning = false;
+uint32_t latencyTrials = 0;             // Trials left, 0 for no limit
+bool latencyPending = false;            // Stimulus sent, response not yet seen
+bool stimulusLevel = false;
+unsigned long latencySentMillis = 0;
+unsigned long latencyNextMillis = 0;
+volatile uint32_t latencyStimulus = 0;  // Cycle of the stimulus edge
+volatile uint32_t latencyResponse = 0;
+volatile bool latencyCaptured = false;
+
 // ====================
 // SETUP FUNCTION
 // ====================
@@ -60,8 +478,18 @@ void setup() {
   
   // Initialize special pins
   pinMode(clockPin, INPUT_PULLUP);
+  pinMode(auxClockPin, INPUT_PULLUP);
   pinMode(resetPin, INPUT_PULLUP);
   pinMode(modePin, INPUT_PULLUP);
+  pinMode(shiftClockPin, INPUT_PULLUP);
+  for (uint8_t i = 0; i < numCircuits; i++) {
+    timingWindows[i] = defaultTimingWindow;
+  }
+  clockDomains[0].begin("main", CLOCK_PIN, clockPin);
+  clockDomains[1].begin("aux", CLOCK_PIN, auxClockPin);
+  clockDomains[2].begin("timer", CLOCK_TIMER, 1000);
+  clockDomains[3].begin("host", CLOCK_HOST, 0);
+  clockDomains[generatorClock].begin("gen", CLOCK_GENERATOR, 0);
   
   // Initialize 7-segment display pins
   for (int i = 0; i < 7; i++) {
@@ -69,9 +497,28 @@ void setup() {
   }
   
   // Start serial communication
-  Serial.begin(115200);
-  Serial.println("Digital Logic Lab Simulator Initialized");
-  printMenu();
+  Serial.begin(serialBaud);
+  loadCircuitNetlist();
+  loadCircuitFsm();
+  startShiftClock();
+  loadTimingCheck();
+  logicCapture.begin(captureBuffer, captureDepth);
+  telemetry.begin(telemetryQueue, telemetryQueueDepth);
+#if PHASE_PROFILE || PHASE_TRACE
+  startCycleTimer();
+#endif
+#if PHASE_TRACE
+  traceBuffer.begin(traceEvents, traceDepth);
+#endif
+  Serial.println(F("Digital Logic Lab Simulator Initialized"));
+  warmStart = loadConfig();
+  if (warmStart) {
+    Serial.print(F("Restored ")); Serial.print(currentCircuit);
+    Serial.println(F(" from EEPROM, type 'menu' for options"));
+  }
+  else {
+    printMenu();
+  }
 }
 
 // ====================
@@ -80,36 +527,75 @@ void setup() {
 void loop() {
   // Check for serial commands
   if (Serial.available() > 0) {
+    PROFILE_BEGIN(PHASE_RX_PARSE);
     handleSerialCommand();
+    PROFILE_END(PHASE_RX_PARSE);
+  }
+  if (pendingCircuit < numCircuits) {
+    swapCircuit();
   }
+  serviceCapture();
+  serviceLatency();
   
   // Read all inputs
+  PROFILE_BEGIN(PHASE_SAMPLE);
   bool inputs[numInputs];
   for (int i = 0; i < numInputs; i++) {
     inputs[i] = digitalRead(inputPins[i]);
   }
+  serviceClocks();
+  PROFILE_END(PHASE_SAMPLE);
+  PROFILE_BEGIN(PHASE_DEBOUNCE);
+  byte inputWord = packInputs(inputs);
+  PROFILE_END(PHASE_DEBOUNCE);
+  TRACE_INPUTS(inputWord);
   
   // Process the selected circuit
-  if (currentCircuit.startsWith("Basic")) {
-    processBasicGates(inputs);
+  PROFILE_BEGIN(PHASE_EVALUATE);
+  if (currentCategory == "Basic") {
+    processBasicGates(inputWord);
   } 
-  else if (currentCircuit.startsWith("Combinational")) {
-    processCombinationalCircuits(inputs);
+  else if (currentCategory == "Combinational") {
+    processCombinationalCircuits(inputWord);
   }
-  else if (currentCircuit.startsWith("Sequential")) {
-    processSequentialCircuits(inputs);
+  else if (currentCategory == "Sequential") {
+    processSequentialCircuits(inputWord);
   }
-  else if (currentCircuit.startsWith("Timers")) {
+  else if (currentCategory == "Timers") {
     processTimerCircuits();
   }
-  else if (currentCircuit.startsWith("Counters")) {
-    processCounterCircuits(inputs);
+  else if (currentCategory == "Counters") {
+    processCounterCircuits(inputWord);
   }
-  else if (currentCircuit.startsWith("Decoders")) {
+  else if (currentCategory == "Registers") {
+    processRegisterCircuits(inputWord);
+  }
+  else if (currentCategory == "Decoders") {
     processDecoderCircuits(inputs);
   }
+  else if (currentCategory == "Instances") {
+    processInstanceCircuits(inputWord);
+  }
+  PROFILE_END(PHASE_EVALUATE);
+  if (firstEvaluation) {
+    firstEvaluationMicros = micros();
+    firstEvaluation = false;
+    printBoot();
+  }
+  logicCapture.counter = counterValue;
+  telemetry.counter = counterValue;
   
-  delay(10); // Small delay for stability
+  if (telemetry.active() || traceStreaming()) {
+    // Same pause, but keep the telemetry and trace queues drained
+    for (uint8_t ms = 0; ms < 10; ms++) {
+      serviceTelemetry();
+      serviceTrace();
+      delay(1);
+    }
+  }
+  else if (!(generatorRunning && currentClock == generatorClock)) {
+    delay(10); // Small delay for stability
+  }
 }
 
 // ====================
@@ -117,77 +603,65 @@ void loop() {
 // ====================
 
 // Basic Logic Gates
-void processBasicGates(bool inputs[]) {
-  bool A = inputs[0];
-  bool B = inputs[1];
-  bool output = LOW;
-  
-  if (currentCircuit == "AND") output = A && B;
-  else if (currentCircuit == "OR") output = A || B;
-  else if (currentCircuit == "NOT") output = !A;
-  else if (currentCircuit == "NAND") output = !(A && B);
-  else if (currentCircuit == "NOR") output = !(A || B);
-  else if (currentCircuit == "XOR") output = A ^ B;
-  else if (currentCircuit == "XNOR") output = !(A ^ B);
-  
-  digitalWrite(outputPins[0], output);
-  Serial.print("Output: "); Serial.println(output ? "HIGH" : "LOW");
+void processBasicGates(byte inputWord) {
+  uint32_t outputs = processNetlistCircuit(inputWord);
+  bool output = outputs & 0x01;
+  PROFILE_BEGIN(PHASE_TX);
+  Serial.print(F("Output: ")); Serial.println(output ? F("HIGH") : F("LOW"));
+  PROFILE_END(PHASE_TX);
 }
 
 // Combinational Circuits
-void processCombinationalCircuits(bool inputs[]) {
-  bool A = inputs[0];
-  bool B = inputs[1];
-  bool C = inputs[2];
-  
-  if (currentCircuit == "Half Adder") {
-    bool sum = A ^ B;
-    bool carry = A && B;
-    digitalWrite(outputPins[0], sum);
-    digitalWrite(outputPins[1], carry);
-  }
-  else if (currentCircuit == "Full Adder") {
-    bool sum = A ^ B ^ C;
-    bool carry = (A && B) || (B && C) || (A && C);
-    digitalWrite(outputPins[0], sum);
-    digitalWrite(outputPins[1], carry);
-  }
-  else if (currentCircuit == "Multiplexer (MUX)") {
-    // 4:1 MUX implementation
-    bool S0 = inputs[2];
-    bool S1 = inputs[3];
-    bool output = (!S1 && !S0 && A) || (!S1 && S0 && B) || 
-                 (S1 && !S0 && C) || (S1 && S0 && inputs[4]);
-    digitalWrite(outputPins[0], output);
-  }
+void processCombinationalCircuits(byte inputWord) {
+  // Half Adder, Full Adder and Multiplexer (MUX) are netlists
+  processNetlistCircuit(inputWord);
   // Additional combinational circuits...
 }
 
+// Netlist Circuits - only the cones of changed inputs are re-evaluated
+uint32_t processNetlistCircuit(byte inputWord) {
+  if (!netlistActive) return 0;
+  circuitNetlist.applyInputWord(inputWord);
+  circuitNetlist.update();
+  if (circuitNetlist.oscillating()) {
+    PROFILE_BEGIN(PHASE_TX);
+    Serial.println(F("Oscillation: feedback loop did not settle"));
+    PROFILE_END(PHASE_TX);
+  }
+  
+  uint32_t outputs = circuitNetlist.outputWord();
+  PROFILE_BEGIN(PHASE_OUTPUT);
+  for (int i = 0; i < circuitNetlist.outputCount() && i < numOutputs; i++) {
+    digitalWrite(outputPins[i], (outputs >> i) & 0x01);
+  }
+  PROFILE_END(PHASE_OUTPUT);
+  return outputs;
+}
+
 // Sequential Circuits
-void processSequentialCircuits(bool inputs[]) {
-  bool clock = digitalRead(clockPin);
-  bool reset = digitalRead(resetPin);
+void processSequentialCircuits(byte inputWord) {
+  // Latches are level-sensitive netlists with feedback
+  if (currentCircuit.startsWith("SR Latch")) {
+    processNetlistCircuit(inputWord);
+    return;
+  }
   
-  // Detect rising clock edge
-  if (clock == HIGH && lastClockState == LOW) {
-    if (currentCircuit == "D Flip-Flop") {
-      flipFlopState = inputs[0];
-    }
-    else if (currentCircuit == "JK Flip-Flop") {
-      bool J = inputs[0];
-      bool K = inputs[1];
-      if (J && K) flipFlopState = !flipFlopState;
-      else if (J) flipFlopState = HIGH;
-      else if (K) flipFlopState = LOW;
-    }
+  // Everything clocked is a state table: one lookup per rising edge
+  for (uint8_t edges = takeClockEdges(); edges > 0; edges--) {
+    fsmMachine.clock(inputWord);
   }
-  lastClockState = clock;
   
-  if (reset == LOW) {
-    flipFlopState = LOW;
+  if (digitalRead(resetPin) == LOW) {
+    fsmMachine.reset();
   }
   
-  digitalWrite(outputPins[0], flipFlopState);
+  uint8_t outputs = fsmMachine.output(inputWord);
+  if (timingActive) reportTiming();
+  PROFILE_BEGIN(PHASE_OUTPUT);
+  for (int i = 0; i < fsmMachine.table().outputBits && i < numOutputs; i++) {
+    digitalWrite(outputPins[i], (outputs >> i) & 0x01);
+  }
+  PROFILE_END(PHASE_OUTPUT);
 }
 
 // Timer Circuits
@@ -196,8 +670,10 @@ void processTimerCircuits() {
   
   if (currentCircuit == "Astable Multivibrator") {
     if (currentTime - lastPulseTime >= 1000) { // 1Hz output
+      PROFILE_BEGIN(PHASE_OUTPUT);
       bool outputState = !digitalRead(outputPins[0]);
       digitalWrite(outputPins[0], outputState);
+      PROFILE_END(PHASE_OUTPUT);
       lastPulseTime = currentTime;
     }
   }
@@ -205,29 +681,96 @@ void processTimerCircuits() {
 }
 
 // Counter Circuits
-void processCounterCircuits(bool inputs[]) {
-  bool clock = digitalRead(clockPin);
-  bool reset = digitalRead(resetPin);
+void processCounterCircuits(byte inputWord) {
+  CounterControl control;
+  control.reset = digitalRead(resetPin) == LOW;
+  control.enable = (inputWord >> counterHoldBit) & 0x01;
+  control.load = !((inputWord >> counterLoadBit) & 0x01);
+  control.data = inputWord & 0x0F;
   
-  if (reset == LOW) {
-    counterValue = 0;
-  }
+  // One step per queued edge; a pass without edges still applies the reset
+  uint8_t edges = takeClockEdges();
+  control.edge = edges > 0;
+  uint8_t outputs = stepCounterCircuit(control);
+  while (edges-- > 1) outputs = stepCounterCircuit(control);
+  counterValue = outputs;
   
-  // Detect rising clock edge
-  if (clock == HIGH && lastClockState == LOW) {
-    if (currentCircuit == "Binary Up Counter") {
-      counterValue = (counterValue + 1) % 16;
-    }
-    else if (currentCircuit == "Binary Down Counter") {
-      counterValue = (counterValue - 1 + 16) % 16;
-    }
-    
-    // Display counter value on outputs
-    for (int i = 0; i < 4; i++) {
-      digitalWrite(outputPins[i], (counterValue >> i) & 0x01);
+  PROFILE_BEGIN(PHASE_OUTPUT);
+  for (int i = 0; i < numOutputs; i++) {
+    digitalWrite(outputPins[i], (outputs >> i) & 0x01);
+  }
+  PROFILE_END(PHASE_OUTPUT);
+}
+
+// Runs the current counter circuit for one pass; returns its outputs
+uint8_t stepCounterCircuit(CounterControl& control) {
+  switch (currentCounter) {
+    case COUNTER_BINARY_UP:   return runCounter(binaryUpCounter, control);
+    case COUNTER_BINARY_DOWN: return runCounter(binaryDownCounter, control);
+    case COUNTER_DECADE_UP:   return runCounter(decadeUpCounter, control);
+    case COUNTER_DECADE_DOWN: return runCounter(decadeDownCounter, control);
+    case COUNTER_GRAY:        return runCounter(grayCounter, control);
+    case COUNTER_RING:        return runCounter(ringCounter, control);
+    case COUNTER_JOHNSON:     return runCounter(johnsonCounter, control);
+    case COUNTER_DIVIDER: {
+      // Units on outputs 0-3; output 4 is high one clock in 10, output 5 one in 100
+      uint8_t outputs = runCounter(dividerUnits, control);
+      CounterControl tens = control;
+      tens.enable = control.carry;
+      tens.load = false;
+      runCounter(dividerTens, tens);
+      bool tenth = dividerUnits.terminalCount();
+      return outputs | tenth << 4 | (tenth && dividerTens.terminalCount()) << 5;
     }
+    default:                  return 0;
+  }
+}
+
+// The counter a circuit runs, COUNTER_NONE if it is not a counter
+uint8_t counterCircuit(String circuit) {
+  if (circuit == "Binary Up Counter") return COUNTER_BINARY_UP;
+  if (circuit == "Binary Down Counter") return COUNTER_BINARY_DOWN;
+  if (circuit == "Decade Up Counter") return COUNTER_DECADE_UP;
+  if (circuit == "Decade Down Counter") return COUNTER_DECADE_DOWN;
+  if (circuit == "Gray Code Counter") return COUNTER_GRAY;
+  if (circuit == "Ring Counter") return COUNTER_RING;
+  if (circuit == "Johnson Counter") return COUNTER_JOHNSON;
+  if (circuit == "Frequency Divider") return COUNTER_DIVIDER;
+  return COUNTER_NONE;
+}
+
+void resetCounters() {
+  binaryUpCounter.reset();
+  binaryDownCounter.reset();
+  decadeUpCounter.reset();
+  decadeDownCounter.reset();
+  grayCounter.reset();
+  ringCounter.reset();
+  johnsonCounter.reset();
+  dividerUnits.reset();
+  dividerTens.reset();
+}
+
+// Register Circuits - edges are applied by the INT4 interrupt
+void processRegisterCircuits(byte inputWord) {
+  if (digitalRead(resetPin) == LOW) {
+    noInterrupts();
+    shiftRegister.clear();
+    interrupts();
+  }
+  
+  noInterrupts();
+  uint8_t low = (uint8_t)shiftRegister.value();
+  bool end = shiftRegister.endBit((inputWord >> shiftUpBit) & 0x01);
+  interrupts();
+  uint8_t outputs = shiftParallelOut(shiftMode) ? low : end;
+  counterValue = low;
+  
+  PROFILE_BEGIN(PHASE_OUTPUT);
+  for (int i = 0; i < numOutputs; i++) {
+    digitalWrite(outputPins[i], (outputs >> i) & 0x01);
   }
-  lastClockState = clock;
+  PROFILE_END(PHASE_OUTPUT);
 }
 
 // Decoder and Display Circuits
@@ -237,10 +780,34 @@ void processDecoderCircuits(bool inputs[]) {
     value = constrain(value, 0, 9);
     
     // Display the digit on 7-segment
+    PROFILE_BEGIN(PHASE_OUTPUT);
     for (int i = 0; i < 7; i++) {
       digitalWrite(segmentPins[i], (digitPatterns[value] >> i) & 0x01);
     }
+    PROFILE_END(PHASE_OUTPUT);
+  }
+}
+
+// Instances - each domain's edges are taken once a pass and go to every
+// instance on it
+void processInstanceCircuits(byte inputWord) {
+  uint8_t edges[numClockDomains];
+  noInterrupts();
+  for (uint8_t i = 0; i < numClockDomains; i++) {
+    edges[i] = clockDomains[i].take();
+  }
+  interrupts();
+  
+  uint8_t outputs = instanceBank.evaluate(inputWord, edges);
+  if (digitalRead(resetPin) == LOW) {
+    instanceBank.resetAll();
   }
+  
+  PROFILE_BEGIN(PHASE_OUTPUT);
+  for (int i = 0; i < numOutputs; i++) {
+    digitalWrite(outputPins[i], (outputs >> i) & 0x01);
+  }
+  PROFILE_END(PHASE_OUTPUT);
 }
 
 // ====================
@@ -248,7 +815,9 @@ void processDecoderCircuits(bool inputs[]) {
 // ====================
 
 void handleSerialCommand() {
+  TRACE_BEGIN(TRACE_READ_LINE);
   String command = Serial.readStringUntil('\n');
+  TRACE_END(TRACE_READ_LINE);
   command.trim();
   
   if (command == "menu") {
@@ -257,63 +826,2368 @@ void handleSerialCommand() {
   else if (command == "reset") {
     resetSystem();
   }
+  else if (command == "netlist") {
+    printNetlistStats();
+  }
+  else if (command == "minimize") {
+    printMinimizedCircuit();
+  }
+  else if (command == "mem") {
+    printMemory();
+  }
+  else if (command.startsWith("fsm")) {
+    handleFsmCommand(command.substring(3));
+  }
+  else if (command.startsWith("capture")) {
+    handleCaptureCommand(command.substring(7));
+  }
+  else if (command.startsWith("stream")) {
+    handleStreamCommand(command.substring(6));
+  }
+  else if (command.startsWith("stats")) {
+    handleStatsCommand(command.substring(5));
+  }
+  else if (command.startsWith("trace")) {
+    handleTraceCommand(command.substring(5));
+  }
+  else if (command.startsWith("latency")) {
+    handleLatencyCommand(command.substring(7));
+  }
+  else if (command.startsWith("clock")) {
+    handleClockCommand(command.substring(5));
+  }
+  else if (command.startsWith("gen")) {
+    handleGeneratorCommand(command.substring(3));
+  }
+  else if (command.startsWith("timing")) {
+    handleTimingCommand(command.substring(6));
+  }
+  else if (command.startsWith("shift")) {
+    handleShiftCommand(command.substring(5));
+  }
+  else if (command.startsWith("inst")) {
+    handleInstanceCommand(command.substring(4));
+  }
+  else if (command.startsWith("checkpoint")) {
+    handleCheckpointCommand(command.substring(10));
+  }
+  else if (command.startsWith("restore")) {
+    handleRestoreCommand(command.substring(7));
+  }
+  else if (command.startsWith("config")) {
+    handleConfigCommand(command.substring(6));
+  }
   else {
     // Check if command matches any circuit
     if (isValidCircuit(command)) {
-      currentCircuit = command;
-      Serial.print("Circuit set to: ");
-      Serial.println(currentCircuit);
-      resetSystem();
+      pendingCircuit = circuitNumber(command);
     }
     else {
-      Serial.println("Invalid command. Type 'menu' for options.");
+      Serial.println(F("Invalid command. Type 'menu' for options."));
     }
   }
 }
 
+// Category used by loop() to dispatch to the processing function
+String circuitCategory(String circuit) {
+  if (circuit == "Half Adder" || circuit == "Full Adder" ||
+      circuit == "Multiplexer (MUX)") return "Combinational";
+  if (circuit.endsWith("Flip-Flop") || circuit.startsWith("SR Latch") ||
+      circuit.startsWith("Sequence Detector") || circuit == "FSM") return "Sequential";
+  if (circuit.endsWith("Multivibrator")) return "Timers";
+  if (circuit.endsWith("Counter") || circuit == "Frequency Divider") return "Counters";
+  if (circuit == "Shift Register") return "Registers";
+  if (circuit.startsWith("BCD Decoder")) return "Decoders";
+  if (circuit == "Instances") return "Instances";
+  return "Basic";
+}
+
 bool isValidCircuit(String circuit) {
-  // Array of all valid circuits (would be expanded)
-  String validCircuits[] = {
-    "AND", "OR", "NOT", "NAND", "NOR", "XOR", "XNOR",
-    "Half Adder", "Full Adder", "Multiplexer (MUX)",
-    "D Flip-Flop", "JK Flip-Flop",
-    "Astable Multivibrator",
-    "Binary Up Counter", "Binary Down Counter",
-    "BCD Decoder with 7-Segment Display"
-  };
-  
-  for (String valid : validCircuits) {
-    if (circuit == valid) return true;
+  return circuitNumber(circuit) < numCircuits;
+}
+
+// Position in circuitNames, numCircuits if it is not there
+uint8_t circuitNumber(String circuit) {
+  for (uint8_t i = 0; i < numCircuits; i++) {
+    if (circuit == circuitNames[i]) return i;
   }
-  return false;
+  return numCircuits;
 }
 
-void resetSystem() {
-  // Reset all outputs
+// The output pins as they are driven, bit i = output pin i
+uint8_t readOutputWord() {
+  uint8_t word = 0;
   for (int i = 0; i < numOutputs; i++) {
-    digitalWrite(outputPins[i], LOW);
+    if (digitalRead(outputPins[i])) word |= 1 << i;
+  }
+  return word;
+}
+
+// Packs the input pins into one byte, bit i = input pin i
+byte packInputs(bool inputs[]) {
+  byte word = 0;
+  for (int i = 0; i < numInputs; i++) {
+    if (inputs[i]) word |= 1 << i;
   }
+  return word;
+}
+
+// Selects and levelizes the netlist for the current circuit, if it has one
+void loadCircuitNetlist() {
+  loadNetlist(currentCircuit, true);
+}
+
+// Selects and levelizes the netlist for a circuit into circuitNetlist,
+// lowered into an AIG first if lower is set and the circuit allows it
+void loadNetlist(String circuit, bool lower) {
+  const NetlistGate* gates = 0;
+  const NodeId* outputs = 0;
+  uint16_t numNodes = 0;
+  uint16_t outputCount = 0;
   
-  // Reset 7-segment display
-  for (int i = 0; i < 7; i++) {
-    digitalWrite(segmentPins[i], LOW);
+  uint8_t basicType = GATE_INPUT;
+  if (circuit == "AND") basicType = GATE_AND;
+  else if (circuit == "OR") basicType = GATE_OR;
+  else if (circuit == "NOT") basicType = GATE_NOT;
+  else if (circuit == "NAND") basicType = GATE_NAND;
+  else if (circuit == "NOR") basicType = GATE_NOR;
+  else if (circuit == "XOR") basicType = GATE_XOR;
+  else if (circuit == "XNOR") basicType = GATE_XNOR;
+  
+  if (basicType != GATE_INPUT) {
+    basicGateNetlist[2].type = basicType;
+    basicGateNetlist[2].in[1] = (basicType == GATE_NOT) ? noNode : 1;
+    gates = basicGateNetlist; numNodes = 3;
+    outputs = basicGateOutputs; outputCount = 1;
+  }
+  else if (circuit == "Half Adder") {
+    gates = halfAdderNetlist; numNodes = 4;
+    outputs = halfAdderOutputs; outputCount = 2;
+  }
+  else if (circuit == "Full Adder") {
+    gates = fullAdderNetlist; numNodes = 8;
+    outputs = fullAdderOutputs; outputCount = 2;
+  }
+  else if (circuit == "Multiplexer (MUX)") {
+    gates = muxNetlist; numNodes = 18;
+    outputs = muxOutputs; outputCount = 1;
+  }
+  else if (circuit == "SR Latch (NAND)") {
+    gates = srLatchNandNetlist; numNodes = 4;
+    outputs = srLatchOutputs; outputCount = 2;
+  }
+  else if (circuit == "SR Latch (NOR)") {
+    gates = srLatchNorNetlist; numNodes = 4;
+    outputs = srLatchOutputs; outputCount = 2;
   }
   
-  // Reset state variables
-  flipFlopState = LOW;
-  counterValue = 0;
-  lastPulseTime = millis();
+  // Latches keep their gates: lowering rejects combinational feedback
+  uint16_t loweredNodes = 0;
+  netlistLowered = lower && gates != 0 &&
+    aigLoweredBound(gates, numNodes, outputCount) <= 32 &&
+    lowerNetlist(gates, numNodes, outputs, outputCount,
+                 loweredNetlist, loweredGateCount, loweredOutputs, loweredNodes,
+                 netlistArena, sizeof(netlistArena), &loweredStats);
+  if (netlistLowered) {
+    gates = loweredNetlist; numNodes = loweredNodes;
+    outputs = loweredOutputs;
+  }
+  
+  netlistActive = gates != 0 &&
+    circuitNetlist.begin(gates, numNodes, outputs, outputCount,
+                         netlistArena, sizeof(netlistArena));
+  
+  // Power up from the switches as they are, so latches do not see a
+  // spurious all-zero input history
+  if (netlistActive) {
+    bool inputs[numInputs];
+    for (int i = 0; i < numInputs; i++) {
+      inputs[i] = digitalRead(inputPins[i]);
+    }
+    circuitNetlist.preset(packInputs(inputs));
+  }
+}
+
+// Circuits that hold their state in the feedback of their netlist
+bool latchCircuit(uint8_t number) {
+  return strncmp(circuitNames[number], "SR Latch", 8) == 0;
+}
+
+// The current netlist's node values, which hold a latch's state
+uint32_t netlistState() {
+  return netlistActive ? circuitNetlist.nodeWord() : 0;
+}
+
+// Puts netlistState() back after the netlist was reloaded. Only circuits
+// with feedback hold anything; the rest keep what preset() gave them.
+void resumeNetlistState(uint32_t nodes) {
+  if (netlistActive && circuitNetlist.cycleCount() > 0) circuitNetlist.loadNodeWord(nodes);
+}
+
+void printNetlistStats() {
+  if (!netlistActive) {
+    Serial.println(F("No netlist for this circuit"));
+    return;
+  }
+  Serial.print(F("Gates: ")); Serial.print(circuitNetlist.gateCount());
+  if (netlistLowered) {
+    Serial.print(F(" (AIG from ")); Serial.print(loweredStats.sourceGates);
+    Serial.print(F(", ")); Serial.print(loweredStats.sharedHits);
+    Serial.print(F(" shared)"));
+  }
+  Serial.print(F(" Levels: ")); Serial.print(circuitNetlist.levelCount());
+  Serial.print(F(" Cycles: ")); Serial.println(circuitNetlist.cycleCount());
+  for (int i = 0; i < circuitNetlist.inputCount(); i++) {
+    Serial.print(F("Cone ")); Serial.print(i);
+    Serial.print(F(": ")); Serial.println(circuitNetlist.coneSize(i));
+  }
+  Serial.print(F("Last update: ")); Serial.println(circuitNetlist.lastEvaluated);
+  Serial.print(F("Evaluated: ")); Serial.print(circuitNetlist.totalEvaluated);
+  Serial.print(F(" in ")); Serial.print(circuitNetlist.updateCount);
+  Serial.println(F(" updates"));
+  Serial.print(F("Oscillations: ")); Serial.println(circuitNetlist.oscillationCount);
+}
+
+// Minimizes each output over the inputs in its cone and compares the cover
+// with the circuit's own gates, loaded without AIG lowering so the counts
+// are those of the source. The arena doubles as minimizer scratch, so the
+// circuit is reloaded afterwards; a latch is turned away before either, so
+// its held state is never disturbed.
+const uint8_t minimizeMaxInputs = 5;
+
+void printMinimizedCircuit() {
+  if (!netlistActive || circuitNetlist.cycleCount() > 0) {
+    Serial.println(F("No combinational netlist for this circuit"));
+    return;
+  }
+  loadNetlist(currentCircuit, false);
+  if (!netlistActive) {
+    Serial.println(F("No combinational netlist for this circuit"));
+    loadCircuitNetlist();
+    return;
+  }
+  uint8_t outputCount = circuitNetlist.outputCount() < numOutputs ? circuitNetlist.outputCount() : numOutputs;
+  uint16_t support[numOutputs][minimizeMaxInputs];
+  uint8_t supportSize[numOutputs];
+  uint8_t tables[numOutputs][4];
+  uint16_t coneGates[numOutputs];
+  uint16_t coneLiterals[numOutputs];
+  uint8_t marks[8];
+  
+  for (int o = 0; o < outputCount; o++) {
+    coneLiterals[o] = 0;
+    coneGates[o] = 0;
+    if (!outputSupport(circuitNetlist, o, support[o], minimizeMaxInputs, supportSize[o]) ||
+        circuitNetlist.nodeCount() > 8 * sizeof(marks)) {
+      supportSize[o] = 0xFF;
+      continue;
+    }
+    netlistTruthTable(circuitNetlist, o, support[o], supportSize[o], tables[o]);
+    memset(marks, 0, sizeof(marks));
+    coneGates[o] = faninConeGates(circuitNetlist, circuitNetlist.outputNode(o), marks, coneLiterals[o]);
+  }
+  
+  // Every input word through the netlist, then through the covers
+  uint16_t words = (uint16_t)1 << (circuitNetlist.inputCount() < 8 ? circuitNetlist.inputCount() : 8);
+  unsigned long start = micros();
+  for (uint16_t w = 0; w < words; w++) {
+    circuitNetlist.applyInputWord(w);
+    circuitNetlist.update();
+  }
+  unsigned long netlistMicros = micros() - start;
+  unsigned long coverMicros = 0;
+  uint16_t mismatches = 0;
+  
+  for (int o = 0; o < outputCount; o++) {
+    Serial.print(F("Out ")); Serial.print(o);
+    Cube cover[16];
+    uint16_t count = 0;
+    bool exact = false;
+    if (supportSize[o] == 0xFF ||
+        !minimizeSop(tables[o], 0, supportSize[o], cover, 16, count,
+                     netlistArena, sizeof(netlistArena), &exact)) {
+      Serial.println(F(": too many inputs to minimize"));
+      continue;
+    }
+    Serial.print(F(" = "));
+    printCover(cover, count, support[o]);
+    Serial.print(F("  Literals: ")); Serial.print(coneLiterals[o]);
+    Serial.print(F(" -> ")); Serial.print(coverLiterals(cover, count));
+    Serial.print(F(" Gates: ")); Serial.print(coneGates[o]);
+    Serial.print(F(" -> ")); Serial.print(coverGates(cover, count, false));
+    Serial.println(exact ? F(" (exact)") : F(""));
+    
+    // Each value is checked against the netlist's truth table, which also
+    // keeps the compiler from dropping the evaluation being timed
+    start = micros();
+    for (uint16_t w = 0; w < words; w++) {
+      uint16_t minterm = 0;
+      for (uint8_t v = 0; v < supportSize[o]; v++) {
+        if ((w >> support[o][v]) & 1) minterm |= 1 << v;
+      }
+      bool expected = tables[o][minterm >> 3] & (1 << (minterm & 7));
+      mismatches += coverValue(cover, count, minterm, false) != expected;
+    }
+    coverMicros += micros() - start;
+  }
+  
+  Serial.print(F("All ")); Serial.print(words);
+  Serial.print(F(" input words: netlist ")); Serial.print(netlistMicros);
+  Serial.print(F(" us, covers ")); Serial.print(coverMicros);
+  Serial.print(F(" us, ")); Serial.print(mismatches);
+  Serial.println(F(" mismatches"));
+  loadCircuitNetlist();
+}
+
+// Prints a sum of products over input pins, e.g. I0'I1 + I2
+void printCover(const Cube* cover, uint16_t count, const uint16_t* support) {
+  if (count == 0) Serial.print(F("0"));
+  for (uint16_t i = 0; i < count; i++) {
+    if (i > 0) Serial.print(F(" + "));
+    if (cover[i].care == 0) Serial.print(F("1"));
+    for (uint8_t v = 0; v < minimizerMaxInputs; v++) {
+      if (!(cover[i].care & (1 << v))) continue;
+      Serial.print(F("I")); Serial.print(support[v]);
+      if (!(cover[i].value & (1 << v))) Serial.print(F("'"));
+    }
+  }
+  Serial.println();
+}
+
+// ====================
+// FSM
+// ====================
+uint16_t readFlashEntry(const uint16_t* entry) {
+  return pgm_read_word(entry);
+}
+
+// Selects the state table for the current circuit, if it has one
+void loadCircuitFsm() {
+  FsmRead read;
+  const FsmTable* table = circuitFsm(currentCircuit, read);
+  if (table && !fsmMachine.begin(*table, read)) {
+    Serial.println(F("FSM: table invalid, 'fsm new' and 'fsm set' build one"));
+  }
+}
+
+// State table of a circuit and how to read it, 0 if it has none
+const FsmTable* circuitFsm(String circuit, FsmRead& read) {
+  read = readFlashEntry;
+  if (circuit == "D Flip-Flop") return &dFlipFlopFsm;
+  if (circuit == "JK Flip-Flop") return &jkFlipFlopFsm;
+  if (circuit == "T Flip-Flop") return &tFlipFlopFsm;
+  if (circuit == "Sequence Detector (101)") return &sequence101Fsm;
+  read = 0;
+  if (circuit == "FSM") return &fsmLoaded;
+  return 0;
+}
+
+// fsm new moore|mealy <states> <input bits> <output bits> [reset state]
+// fsm set <state> <inputs> <next> <output>
+// fsm data <index> <entry> ...  (entries in hex, next | output << 8)
+void handleFsmCommand(String args) {
+  args.trim();
+  int space = args.indexOf(' ');
+  String verb = space < 0 ? args : args.substring(0, space);
+  String rest = space < 0 ? String("") : args.substring(space + 1);
+  const char* at = rest.c_str();
+  char* end;
+  
+  if (verb == "new") {
+    rest.trim();
+    uint8_t kind = rest.startsWith("mealy") ? FSM_MEALY : FSM_MOORE;
+    if (!rest.startsWith("mealy") && !rest.startsWith("moore")) {
+      Serial.println(F("FSM: 'fsm new moore|mealy <states> <input bits> <output bits> [reset]'"));
+      return;
+    }
+    at = rest.c_str() + 5;
+    uint16_t states = strtoul(at, &end, 0); at = end;
+    uint8_t inputBits = strtoul(at, &end, 0); at = end;
+    uint8_t outputBits = strtoul(at, &end, 0); at = end;
+    uint8_t resetState = strtoul(at, &end, 0);
+    if (states == 0 || states > fsmMaxStates || inputBits > fsmMaxInputBits ||
+        outputBits == 0 || outputBits > 8 || resetState >= states ||
+        fsmTableEntries(states, inputBits) > fsmRamEntries) {
+      Serial.print(F("FSM: needs states x 2^inputs <= ")); Serial.print(fsmRamEntries);
+      Serial.println(F(", 1-8 outputs, reset < states"));
+      return;
+    }
+    // Instances share fsmRamTable, but keep the shape they were added with
+    if (fsmInstanceCount()) {
+      Serial.println(F("FSM: 'inst remove' the FSM instances before a new table"));
+      return;
+    }
+    // Every state holds until set otherwise
+    for (uint16_t i = 0; i < fsmTableEntries(states, inputBits); i++) {
+      fsmRamTable[i] = fsmEntry(i >> inputBits, 0);
+    }
+    fsmLoaded.states = states;
+    fsmLoaded.inputBits = inputBits;
+    fsmLoaded.outputBits = outputBits;
+    fsmLoaded.kind = kind;
+    fsmLoaded.resetState = resetState;
+    fsmLoaded.resetOutput = 0;
+    if (currentCircuit == "FSM") loadCircuitFsm();
+    Serial.println(F("FSM: table cleared"));
+  }
+  else if (verb == "set" || verb == "data") {
+    uint32_t count = fsmTableEntries(fsmLoaded.states, fsmLoaded.inputBits);
+    uint32_t index;
+    if (verb == "set") {
+      uint16_t state = strtoul(at, &end, 0); at = end;
+      uint16_t inputs = strtoul(at, &end, 0); at = end;
+      index = state < fsmLoaded.states && inputs < (1u << fsmLoaded.inputBits) ?
+              (uint32_t)state << fsmLoaded.inputBits | inputs : count;
+    }
+    else {
+      index = strtoul(at, &end, 0); at = end;
+    }
+    // Next states are checked here, so the running machine never leaves its table
+    uint8_t written = 0;
+    while (index < count) {
+      uint16_t value;
+      if (verb == "set") {
+        uint16_t next = strtoul(at, &end, 0);
+        if (end == at || next >= fsmLoaded.states) break;
+        at = end;
+        value = fsmEntry(next, strtoul(at, &end, 0));
+      }
+      else {
+        value = strtoul(at, &end, 16);
+        if (end == at || fsmNext(value) >= fsmLoaded.states) break;
+      }
+      at = end;
+      fsmRamTable[index++] = value;
+      written++;
+      if (verb == "set") break;
+    }
+    if (fsmLoaded.kind == FSM_MOORE && written) {
+      fsmLoaded.resetOutput = fsmLoadedResetOutput();
+      refreshFsmResetOutput();
+    }
+    Serial.print(F("FSM: ")); Serial.print(written); Serial.println(F(" entries written"));
+  }
+  else if (verb.length() == 0) {
+    printFsm();
+  }
+  else {
+    Serial.println(F("FSM: 'fsm [new ... | set <state> <inputs> <next> <output> | data <index> <hex> ...]'"));
+  }
+}
+
+// Moore reset output of fsmLoaded: that of any transition into the reset
+// state, else the one it has
+uint8_t fsmLoadedResetOutput() {
+  uint32_t count = fsmTableEntries(fsmLoaded.states, fsmLoaded.inputBits);
+  for (uint32_t i = 0; i < count; i++) {
+    if (fsmNext(fsmRamTable[i]) == fsmLoaded.resetState) return fsmOutput(fsmRamTable[i]);
+  }
+  return fsmLoaded.resetOutput;
+}
+
+// Instances of the "FSM" circuit, which run on fsmRamTable
+uint8_t fsmInstanceCount() {
+  uint8_t number = circuitNumber("FSM");
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < instanceBank.count(); i++) {
+    count += instanceBank.instance(i).circuit == number;
+  }
+  return count;
+}
+
+// Every machine running on fsmRamTable takes fsmLoaded's reset output
+void refreshFsmResetOutput() {
+  uint8_t number = circuitNumber("FSM");
+  for (uint8_t i = 0; i < instanceBank.count(); i++) {
+    CircuitInstance& instance = instanceBank.instance(i);
+    if (instance.circuit == number) instance.machine.setResetOutput(fsmLoaded.resetOutput);
+  }
+  if (currentCircuit == "FSM") fsmMachine.setResetOutput(fsmLoaded.resetOutput);
+}
+
+// True when the current circuit runs on fsmMachine
+bool stateTableCircuit() {
+  return fsmMachine.loaded() && currentCategory == "Sequential" && !currentCircuit.startsWith("SR Latch");
+}
+
+void printFsm() {
+  const FsmTable& table = fsmMachine.table();
+  if (!stateTableCircuit()) {
+    Serial.println(F("FSM: the current circuit is not a state table"));
+  }
+  else {
+    Serial.print(F("FSM: ")); Serial.print(table.kind == FSM_MEALY ? F("Mealy, ") : F("Moore, "));
+    Serial.print(table.states); Serial.print(F(" states, "));
+    Serial.print(table.inputBits); Serial.print(F(" inputs, "));
+    Serial.print(table.outputBits); Serial.print(F(" outputs, state "));
+    Serial.print(fsmMachine.state()); Serial.print(F(", "));
+    Serial.print(fsmMachine.transitions); Serial.println(F(" transitions"));
+  }
+  Serial.print(F("  SRAM table: ")); Serial.print(fsmLoaded.states);
+  Serial.print(F(" states x ")); Serial.print(1u << fsmLoaded.inputBits);
+  Serial.print(F(" inputs (")); Serial.print(fsmRamEntries); Serial.println(F(" entries max)"));
+}
+
+// ====================
+// SHIFT REGISTER
+// ====================
+// One clock edge. The inputs are unpacked from the ports directly; the
+// mode pin is PG1.
+ISR(INT4_vect) {
+  if (!shiftClockEnabled) return;
+  uint8_t inputs = packCaptureWord(PINA | PINC << 8);
+  bool modeLow = !(PING & (1 << 1));
+  shiftEdges++;
+  if (shiftMode == SHIFT_PIPO || (shiftMode == SHIFT_PISO && modeLow)) {
+    // Parallel data is the low 8 bits; any bits above them are kept
+    shiftRegister.load((shiftRegister.value() & ~(uint64_t)0xFF) | inputs);
+  }
+  else if ((inputs >> shiftHoldBit) & 0x01) {
+    shiftRegister.shift((inputs >> shiftUpBit) & 0x01, (inputs >> shiftDataBit) & 0x01);
+  }
+}
+
+// Rising edges on pin 2 interrupt; the handler ignores them until the
+// shift register is selected
+void startShiftClock() {
+  noInterrupts();
+  EICRB |= (1 << ISC41) | (1 << ISC40);
+  EIFR = 1 << INTF4;
+  EIMSK |= 1 << INT4;
+  interrupts();
+}
+
+// Hex digits of the low width bits, most significant first (Serial has no
+// 64-bit print)
+void printShiftValue(uint64_t value, uint8_t width) {
+  for (int8_t shift = (width + 3) / 4 * 4 - 4; shift >= 0; shift -= 4) {
+    Serial.print((uint8_t)(value >> shift) & 0x0F, HEX);
+  }
+}
+
+// shift width <4-64>
+// shift mode siso|sipo|piso|pipo
+// shift load <hex>
+// shift clear
+void handleShiftCommand(String args) {
+  args.trim();
+  int space = args.indexOf(' ');
+  String verb = space < 0 ? args : args.substring(0, space);
+  String rest = space < 0 ? String("") : args.substring(space + 1);
+  rest.trim();
+  
+  if (verb == "width") {
+    uint8_t width = strtoul(rest.c_str(), 0, 0);
+    noInterrupts();
+    bool valid = shiftRegister.setWidth(width);
+    interrupts();
+    if (!valid) {
+      Serial.print(F("Shift: width ")); Serial.print(shiftMinWidth);
+      Serial.print(F("-")); Serial.println(shiftMaxWidth);
+      return;
+    }
+    printShiftRegister();
+  }
+  else if (verb == "mode") {
+    static const char* const modes[] = {"siso", "sipo", "piso", "pipo"};
+    uint8_t mode = 0;
+    while (mode < 4 && rest != modes[mode]) mode++;
+    if (mode == 4) {
+      Serial.println(F("Shift: 'shift mode siso|sipo|piso|pipo'"));
+      return;
+    }
+    shiftMode = mode;
+    printShiftRegister();
+  }
+  else if (verb == "load") {
+    // Up to 16 hex digits; strtoul stops at 32 bits
+    uint64_t value = 0;
+    uint8_t digits = 0;
+    const char* at = rest.c_str();
+    if (at[0] == '0' && (at[1] == 'x' || at[1] == 'X')) at += 2;
+    for (; isHexadecimalDigit(*at) && digits < 16; at++, digits++) {
+      value = value << 4 | (uint8_t)(*at <= '9' ? *at - '0' : (*at | 0x20) - 'a' + 10);
+    }
+    if (digits == 0 || *at) {
+      Serial.println(F("Shift: 'shift load <hex>' (up to 16 digits)"));
+      return;
+    }
+    noInterrupts();
+    shiftRegister.load(value);
+    interrupts();
+    printShiftRegister();
+  }
+  else if (verb == "clear") {
+    noInterrupts();
+    shiftRegister.clear();
+    interrupts();
+    printShiftRegister();
+  }
+  else if (verb.length() == 0) {
+    printShiftRegister();
+  }
+  else {
+    Serial.println(F("Shift: 'shift [width <4-64> | mode siso|sipo|piso|pipo | load <hex> | clear]'"));
+  }
+}
+
+void printShiftRegister() {
+  static const char* const modes[] = {"SISO", "SIPO", "PISO", "PIPO"};
+  noInterrupts();
+  uint64_t value = shiftRegister.value();
+  uint32_t edges = shiftEdges;
+  interrupts();
+  uint8_t width = shiftRegister.width();
+  Serial.print(F("Shift: ")); Serial.print(width);
+  Serial.print(F(" bits, ")); Serial.print(modes[shiftMode]);
+  Serial.print(F(", state 0x")); printShiftValue(value, width);
+  Serial.print(F(", ")); Serial.print(edges); Serial.println(F(" edges"));
+}
+
+// ====================
+// LOGIC ANALYZER
+// ====================
+ISR(TIMER3_COMPA_vect) {
+  TRACE_BEGIN(TRACE_CAPTURE_ISR);
+  if (logicCapture.sample(PINA | (PINC << 8))) {
+    captureEndMicros = micros();
+  }
+  TRACE_END(TRACE_CAPTURE_ISR);
+}
+
+// Compare value and clock select (CSn = 1..5) for the nearest rate a 16-bit
+// timer in CTC mode can make; rate is updated to that rate
+uint16_t timerCompare(uint32_t& rate, uint8_t& clockSelect) {
+  const uint16_t prescalers[] = {1, 8, 64, 256, 1024};
+  uint8_t select = 0;
+  uint32_t ticks = F_CPU / rate;
+  while (ticks > 65536 && select < 4) {
+    select++;
+    ticks = F_CPU / ((uint32_t)prescalers[select] * rate);
+  }
+  if (ticks > 65536) ticks = 65536;
+  if (ticks < 1) ticks = 1;
+  rate = F_CPU / ((uint32_t)prescalers[select] * ticks);
+  clockSelect = select + 1;
+  return ticks - 1;
+}
+
+// Timer3 in CTC mode at the nearest rate it can make; returns that rate
+uint32_t startCaptureTimer(uint32_t rate) {
+  uint8_t clockSelect;
+  uint16_t compare = timerCompare(rate, clockSelect);
+  
+  noInterrupts();
+  TCCR3A = 0;
+  TCCR3B = (1 << WGM32) | clockSelect;
+  TCNT3 = 0;
+  OCR3A = compare;
+  TIFR3 = 1 << OCF3A;
+  TIMSK3 |= 1 << OCIE3A;
+  interrupts();
+  return rate;
+}
+
+void stopCaptureTimer() {
+  TIMSK3 &= ~(1 << OCIE3A);
+  TCCR3B = 0;
+}
+
+uint16_t packCaptureWord(uint16_t raw) {
+  uint16_t word = 0;
+  for (uint8_t k = 0; k < 16; k++) {
+    if (raw & (1 << captureRawBits[k])) word |= 1 << k;
+  }
+  return word;
+}
+
+uint16_t rawCaptureWord(uint16_t packed) {
+  uint16_t raw = 0;
+  for (uint8_t k = 0; k < 16; k++) {
+    if (packed & (1 << k)) raw |= 1 << captureRawBits[k];
+  }
+  return raw;
+}
+
+void serialFrameByte(uint8_t byte) {
+  Serial.write(byte);
+}
+
+void handleCaptureCommand(String args) {
+  args.trim();
+  if (args.length() == 0) {
+    printCaptureStatus();
+    return;
+  }
+  int space = args.indexOf(' ');
+  String verb = space < 0 ? args : args.substring(0, space);
+  String rest = space < 0 ? String("") : args.substring(space + 1);
+  rest.trim();
+  
+  if (verb == "rate") {
+    uint32_t rate = strtoul(rest.c_str(), 0, 0);
+    if (rate < 1 || rate > captureMaxRate) {
+      Serial.println(F("Rate must be 1-200000 Hz"));
+      return;
+    }
+    captureRate = rate;
+    printCaptureStatus();
+  }
+  else if (verb == "pre") {
+    logicCapture.setPreTrigger(strtoul(rest.c_str(), 0, 0));
+    printCaptureStatus();
+  }
+  else if (verb == "mode" && (rest == "raw" || rest == "rle")) {
+    logicCapture.setMode(rest == "rle" ? CAPTURE_RLE : CAPTURE_RAW);
+    printCaptureStatus();
+  }
+  else if (verb == "post") {
+    logicCapture.setPostTrigger(strtoul(rest.c_str(), 0, 0));
+    printCaptureStatus();
+  }
+  else if (verb == "trigger") {
+    if (parseCaptureTrigger(rest)) printCaptureStatus();
+    else Serial.println(F("Trigger: now | pattern <mask> <value> | rise <bit> | fall <bit> | counter <0-255>"));
+  }
+  else if (verb == "arm") {
+    if (captureTriggerType == TRIGGER_COUNTER) {
+      logicCapture.setTrigger(TRIGGER_COUNTER, 0, captureTriggerValue);
+    }
+    else {
+      logicCapture.setTrigger(captureTriggerType, rawCaptureWord(captureTriggerMask),
+                              rawCaptureWord(captureTriggerValue));
+    }
+    stopCaptureTimer();
+    logicCapture.arm();
+    captureStartMicros = micros();
+    captureRate = startCaptureTimer(captureRate);
+    captureRunning = true;
+    printCaptureStatus();
+  }
+  else if (verb == "stop") {
+    noInterrupts();
+    logicCapture.stop();
+    captureEndMicros = micros();
+    interrupts();
+  }
+  else {
+    Serial.println(F("Invalid capture command. Type 'menu' for options."));
+  }
+}
+
+bool parseCaptureTrigger(String args) {
+  int space = args.indexOf(' ');
+  String kind = space < 0 ? args : args.substring(0, space);
+  const char* numbers = space < 0 ? "" : args.c_str() + space + 1;
+  char* end = 0;
+  uint32_t first = strtoul(numbers, &end, 0);
+  uint32_t second = strtoul(end, 0, 0);
+  
+  if (kind == "now") {
+    captureTriggerType = TRIGGER_NOW;
+  }
+  else if (kind == "pattern" && space >= 0) {
+    captureTriggerType = TRIGGER_PATTERN;
+    captureTriggerMask = first;
+    captureTriggerValue = second & first;
+  }
+  else if ((kind == "rise" || kind == "fall") && space >= 0 && first < 16) {
+    captureTriggerType = kind == "rise" ? TRIGGER_RISING : TRIGGER_FALLING;
+    captureTriggerMask = 1 << first;
+    captureTriggerValue = 0;
+  }
+  else if (kind == "counter" && space >= 0 && first <= 0xFF) {
+    // The ISR compares the 8-bit counter the firmware mirrors
+    captureTriggerType = TRIGGER_COUNTER;
+    captureTriggerMask = 0;
+    captureTriggerValue = first;
+  }
+  else {
+    return false;
+  }
+  return true;
+}
+
+// ====================
+// TELEMETRY
+// ====================
+ISR(TIMER4_COMPA_vect) {
+  TRACE_BEGIN(TRACE_TELEMETRY_ISR);
+  uint32_t now = micros();
+  uint16_t word = PINA | (PINC << 8);
+  uint8_t violations = timingActive ? timingCheck.sample(now, word, PIND & (1 << 7)) : 0;
+  if (violations) telemetry.mark(now, word, violations);
+  else telemetry.record(now, word);
+  TRACE_END(TRACE_TELEMETRY_ISR);
+}
+
+// Timer4, set up like the capture timer; returns the rate it runs at
+uint32_t startTelemetryTimer(uint32_t rate) {
+  uint8_t clockSelect;
+  uint16_t compare = timerCompare(rate, clockSelect);
+  
+  noInterrupts();
+  TCCR4A = 0;
+  TCCR4B = (1 << WGM42) | clockSelect;
+  TCNT4 = 0;
+  OCR4A = compare;
+  TIFR4 = 1 << OCF4A;
+  TIMSK4 |= 1 << OCIE4A;
+  interrupts();
+  return rate;
+}
+
+void stopTelemetryTimer() {
+  TIMSK4 &= ~(1 << OCIE4A);
+  TCCR4B = 0;
+}
+
+// Sends what the timer queued, a few frames at a time so loop() keeps up
+void serviceTelemetry() {
+  PROFILE_BEGIN(PHASE_TX);
+  FrameWriter writer(serialFrameByte);
+  for (uint8_t frames = 0; frames < 4; frames++) {
+    if (!telemetry.writeFrame(writer, packCaptureWord)) break;
+  }
+  PROFILE_END(PHASE_TX);
+}
+
+void handleStreamCommand(String args) {
+  args.trim();
+  int space = args.indexOf(' ');
+  String verb = space < 0 ? args : args.substring(0, space);
+  String rest = space < 0 ? String("") : args.substring(space + 1);
+  rest.trim();
+  
+  if (verb == "on") {
+    stopTelemetryTimer();
+    telemetry.start();
+    telemetryRate = startTelemetryTimer(telemetryRate);
+  }
+  else if (verb == "off") {
+    if (!timingActive) stopTelemetryTimer();
+    telemetry.stop();
+    serviceTelemetry();
+  }
+  else if (verb == "rate") {
+    uint32_t rate = strtoul(rest.c_str(), 0, 0);
+    if (rate < 1 || rate > telemetryMaxRate) {
+      Serial.println(F("Rate must be 1-50000 Hz"));
+      return;
+    }
+    telemetryRate = rate;
+    if (telemetry.active() || timingActive) telemetryRate = startTelemetryTimer(telemetryRate);
+  }
+  else if (verb == "baud") {
+    uint32_t baud = strtoul(rest.c_str(), 0, 0);
+    if (baud < 9600 || baud > 2000000) {
+      Serial.println(F("Baud must be 9600-2000000"));
+      return;
+    }
+    Serial.print(F("Switching to ")); Serial.print(baud); Serial.println(F(" baud"));
+    Serial.flush();
+    serialBaud = baud;
+    Serial.begin(serialBaud);
+  }
+  else if (verb.length() > 0) {
+    Serial.println(F("Stream: 'stream [on | off | rate <hz> | baud <rate>]'"));
+    return;
+  }
+  printStreamStatus();
+}
+
+void printStreamStatus() {
+  Serial.print(F("Stream: ")); Serial.print(telemetry.active() ? F("on") : F("off"));
+  Serial.print(F(" Rate: ")); Serial.print(telemetryRate);
+  Serial.print(F(" Hz Baud: ")); Serial.print(serialBaud);
+  Serial.print(F(" Frames: ")); Serial.print(telemetry.sequence());
+  Serial.print(F(" Lost: ")); Serial.println(telemetry.lostEvents());
+}
+
+// ====================
+// SETUP/HOLD CHECKING
+// ====================
+// Points the check at the current circuit's data inputs and windows;
+// only state tables clocked from the clock pin are checked
+void loadTimingCheck() {
+  uint16_t mask = 0;
+  const ClockDomain& clock = clockDomains[currentClock];
+  bool clockPinDomain = clock.source() == CLOCK_PIN && clock.setting() == clockPin;
+  if (stateTableCircuit() && clockPinDomain) mask = rawCaptureWord((1 << fsmMachine.table().inputBits) - 1);
+  noInterrupts();
+  timingCheck.begin(mask, timingWindows[circuitNumber(currentCircuit)]);
+  interrupts();
+}
+
+// Prints violations found since the last call, unless the port is busy
+// with binary telemetry
+void reportTiming() {
+  noInterrupts();
+  uint16_t setups = timingCheck.setupViolations;
+  uint16_t holds = timingCheck.holdViolations;
+  uint32_t at = timingCheck.lastViolationMicros;
+  uint8_t last = timingCheck.lastViolation;
+  interrupts();
+  if ((uint16_t)(setups + holds) == timingReported || telemetry.active()) return;
+  timingReported = setups + holds;
+  Serial.print(F("Timing: "));
+  Serial.print(last == (TIMING_SETUP | TIMING_HOLD) ? F("setup and hold") :
+               last == TIMING_SETUP ? F("setup") : F("hold"));
+  Serial.print(F(" violation at ")); Serial.print(at);
+  Serial.print(F(" us (")); Serial.print(setups);
+  Serial.print(F(" setup, ")); Serial.print(holds); Serial.println(F(" hold)"));
+}
+
+// timing on | off | clear
+// timing setup <us> | hold <us>  (for the current circuit)
+void handleTimingCommand(String args) {
+  args.trim();
+  int space = args.indexOf(' ');
+  String verb = space < 0 ? args : args.substring(0, space);
+  String rest = space < 0 ? String("") : args.substring(space + 1);
+  rest.trim();
+  
+  if (verb == "on") {
+    loadTimingCheck();
+    timingActive = true;
+    if (!telemetry.active()) telemetryRate = startTelemetryTimer(telemetryRate);
+  }
+  else if (verb == "off") {
+    timingActive = false;
+    if (!telemetry.active()) stopTelemetryTimer();
+  }
+  else if (verb == "clear") {
+    noInterrupts();
+    timingCheck.clear();
+    interrupts();
+    timingReported = 0;
+  }
+  else if (verb == "setup" || verb == "hold") {
+    char* end;
+    uint32_t window = strtoul(rest.c_str(), &end, 0);
+    if (end == rest.c_str() || window > 65535) {
+      Serial.println(F("Timing: windows are 0-65535 us"));
+      return;
+    }
+    TimingWindow& limits = timingWindows[circuitNumber(currentCircuit)];
+    if (verb == "setup") limits.setupMicros = window;
+    else limits.holdMicros = window;
+    loadTimingCheck();
+  }
+  else if (verb.length() > 0) {
+    Serial.println(F("Timing: 'timing [on | off | clear | setup <us> | hold <us>]'"));
+    return;
+  }
+  printTiming();
+}
+
+void printTiming() {
+  noInterrupts();
+  uint32_t edges = timingCheck.edges;
+  uint16_t setups = timingCheck.setupViolations;
+  uint16_t holds = timingCheck.holdViolations;
+  interrupts();
+  const TimingWindow& limits = timingWindows[circuitNumber(currentCircuit)];
+  Serial.print(F("Timing: ")); Serial.print(timingActive ? F("on") : F("off"));
+  Serial.print(F(", ")); Serial.print(currentCircuit);
+  if (timingCheck.watched()) {
+    Serial.print(F(" setup ")); Serial.print(limits.setupMicros);
+    Serial.print(F(" us hold ")); Serial.print(limits.holdMicros);
+    Serial.print(F(" us, sampled every ")); Serial.print(1000000UL / telemetryRate);
+    Serial.println(F(" us"));
+  }
+  else {
+    Serial.println(F(" is not checked (needs a state table clocked by pin 38)"));
+  }
+  Serial.print(F("  ")); Serial.print(edges);
+  Serial.print(F(" edges, ")); Serial.print(setups);
+  Serial.print(F(" setup and ")); Serial.print(holds); Serial.println(F(" hold violations"));
+}
+
+// Dumps a finished capture once and reports what was achieved
+void serviceCapture() {
+  if (!captureRunning || logicCapture.status() != CAPTURE_DONE) return;
+  stopCaptureTimer();
+  captureRunning = false;
+  
+  noInterrupts();
+  uint32_t samples = logicCapture.sampleCount();
+  unsigned long elapsed = captureEndMicros - captureStartMicros;
+  interrupts();
+  uint32_t expected = (uint32_t)((uint64_t)elapsed * captureRate / 1000000UL);
+  uint32_t dropped = expected > samples ? expected - samples : 0;
+  
+  PROFILE_BEGIN(PHASE_TX);
+  FrameWriter writer(serialFrameByte);
+  writeCaptureFrame(writer, logicCapture, captureRate, elapsed, dropped, packCaptureWord);
+  
+  Serial.println();
+  Serial.print(F("Capture done: ")); Serial.print(samples);
+  Serial.print(F(" samples in ")); Serial.print(elapsed);
+  Serial.print(F(" us, achieved "));
+  Serial.print(elapsed ? (uint32_t)((uint64_t)samples * 1000000UL / elapsed) : 0UL);
+  Serial.print(F(" Hz, dropped ")); Serial.println(dropped);
+  if (logicCapture.captureMode() == CAPTURE_RLE) {
+    uint32_t covered = samples - logicCapture.firstSample();
+    Serial.print(F("RLE: ")); Serial.print(logicCapture.recordBytes());
+    Serial.print(F(" bytes cover ")); Serial.print(covered);
+    Serial.print(F(" samples (")); Serial.print((float)covered / captureDepth, 1);
+    Serial.println(F("x raw depth)"));
+  }
+  PROFILE_END(PHASE_TX);
+}
+
+void printCaptureStatus() {
+  const char* states[] = {"idle", "armed", "triggered", "done"};
+  Serial.print(F("Capture: ")); Serial.print(states[logicCapture.status()]);
+  Serial.print(F(" Rate: ")); Serial.print(captureRate);
+  Serial.print(F(" Hz Pre: ")); Serial.print(logicCapture.preTrigger());
+  Serial.print(F("/")); Serial.print(captureDepth);
+  if (logicCapture.captureMode() == CAPTURE_RLE) {
+    Serial.print(F(" Mode: rle Post: ")); Serial.print(logicCapture.postTrigger());
+  }
+  Serial.print(F(" Trigger: "));
+  if (captureTriggerType == TRIGGER_NOW) Serial.println(F("now"));
+  else if (captureTriggerType == TRIGGER_PATTERN) {
+    Serial.print(F("pattern 0x")); Serial.print(captureTriggerMask, HEX);
+    Serial.print(F(" 0x")); Serial.println(captureTriggerValue, HEX);
+  }
+  else if (captureTriggerType == TRIGGER_COUNTER) {
+    Serial.print(F("counter ")); Serial.println(captureTriggerValue);
+  }
+  else {
+    Serial.print(captureTriggerType == TRIGGER_RISING ? F("rise ") : F("fall "));
+    for (uint8_t bit = 0; bit < 16; bit++) {
+      if (captureTriggerMask == (1 << bit)) Serial.println(bit);
+    }
+  }
+}
+
+// ====================
+// CYCLE TIMER
+// ====================
+ISR(TIMER5_OVF_vect) {
+  cycleOverflows++;
+}
+
+// Timer5 counting every CPU cycle, extended to 32 bits by its overflows;
+// left alone when already running
+void startCycleTimer() {
+  if (TCCR5B & 0x07) return;
+  noInterrupts();
+  TCCR5A = 0;
+  TCCR5B = 1 << CS50;
+  TCNT5 = 0;
+  TIFR5 = 1 << TOV5;
+  TIMSK5 |= 1 << TOIE5;
+  interrupts();
+}
+
+// Extends a Timer5 reading taken with interrupts off; an overflow not yet
+// serviced belongs to a reading that has wrapped
+uint32_t extendCycles(uint16_t low) {
+  uint16_t high = cycleOverflows;
+  if ((TIFR5 & (1 << TOV5)) && low < 0x8000) high++;
+  return (uint32_t)high << 16 | low;
+}
+
+uint32_t cycleCount() {
+  uint8_t oldSREG = SREG;
+  cli();
+  uint32_t cycles = extendCycles(TCNT5);
+  SREG = oldSREG;
+  return cycles;
+}
+
+// ====================
+// CLOCK DOMAINS
+// ====================
+// Samples the pin domains, advances the timer domains and queues the
+// generator's pulses, every loop pass
+void serviceClocks() {
+  uint32_t now = millis();
+  for (uint8_t i = 0; i < numClockDomains; i++) {
+    ClockDomain& clock = clockDomains[i];
+    if (clock.source() == CLOCK_PIN) clock.sample(digitalRead(clock.setting()));
+    else if (clock.source() == CLOCK_TIMER) clock.tick(now);
+  }
+  noInterrupts();
+  uint16_t ticks = generatorTicks;
+  generatorTicks = 0;
+  interrupts();
+  if (ticks) {
+    generatorPulses += ticks;
+    if (clockDomains[generatorClock].source() == CLOCK_GENERATOR) clockDomains[generatorClock].pulse(ticks);
+  }
+}
+
+// Edges the current circuit's domain queued since the last call
+uint8_t takeClockEdges() {
+  noInterrupts();
+  uint8_t edges = clockDomains[currentClock].take();
+  interrupts();
+  return edges;
+}
+
+// Points the current circuit at its domain, without stale edges; the
+// instances may be on any of them
+void selectCircuitClock() {
+  currentClock = circuitClocks[circuitNumber(currentCircuit)];
+  noInterrupts();
+  for (uint8_t i = 0; i < numClockDomains; i++) {
+    if (i == currentClock || currentCategory == "Instances") clockDomains[i].flush();
+  }
+  interrupts();
+}
+
+// Domain by name or number, numClockDomains if there is none
+uint8_t clockNumber(String name) {
+  for (uint8_t i = 0; i < numClockDomains; i++) {
+    if (name == clockDomains[i].name() || name == String(i)) return i;
+  }
+  return numClockDomains;
+}
+
+// A pin a clock can be read from: not serial, an output or a segment
+bool isClockablePin(long pin) {
+  if (pin < 2 || pin > 69) return false;
+  for (int i = 0; i < numOutputs; i++) {
+    if (pin == outputPins[i]) return false;
+  }
+  for (int i = 0; i < 7; i++) {
+    if (pin == segmentPins[i]) return false;
+  }
+  return true;
+}
+
+// clock bind <domain>
+// clock <domain> pin <n> | timer <ms> | host | pulse [n]
+void handleClockCommand(String args) {
+  args.trim();
+  int space = args.indexOf(' ');
+  String first = space < 0 ? args : args.substring(0, space);
+  String rest = space < 0 ? String("") : args.substring(space + 1);
+  rest.trim();
+  space = rest.indexOf(' ');
+  String verb = space < 0 ? rest : rest.substring(0, space);
+  String value = space < 0 ? String("") : rest.substring(space + 1);
+  value.trim();
+  
+  if (first.length() == 0) {
+    printClocks();
+    return;
+  }
+  if (first == "bind") {
+    uint8_t domain = clockNumber(verb);
+    if (domain == numClockDomains) {
+      Serial.println(F("Clock: no such domain"));
+      return;
+    }
+    circuitClocks[circuitNumber(currentCircuit)] = domain;
+    selectCircuitClock();
+    loadTimingCheck();
+    printClocks();
+    return;
+  }
+  
+  uint8_t domain = clockNumber(first);
+  if (domain == numClockDomains) {
+    Serial.println(F("Clock: 'clock [bind <domain> | <domain> pin <n> | timer <ms> | host | pulse [n]]'"));
+    return;
+  }
+  ClockDomain& clock = clockDomains[domain];
+  long number = value.toInt();
+  if (verb == "pin") {
+    if (!isClockablePin(number)) {
+      Serial.println(F("Clock: pin must be 2-69 and not an output or segment pin"));
+      return;
+    }
+    pinMode(number, INPUT_PULLUP);
+    noInterrupts();
+    clock.setSource(CLOCK_PIN, number);
+    interrupts();
+  }
+  else if (verb == "timer") {
+    if (number < 1 || number > 60000) {
+      Serial.println(F("Clock: timer period must be 1-60000 ms"));
+      return;
+    }
+    noInterrupts();
+    clock.setSource(CLOCK_TIMER, number);
+    interrupts();
+  }
+  else if (verb == "host") {
+    noInterrupts();
+    clock.setSource(CLOCK_HOST, 0);
+    interrupts();
+  }
+  else if (verb == "pulse") {
+    long count = value.length() ? number : 1;
+    if (count < 1 || count > clockQueueDepth) {
+      Serial.print(F("Clock: 1-")); Serial.print(clockQueueDepth); Serial.println(F(" pulses at a time"));
+      return;
+    }
+    noInterrupts();
+    clock.pulse(count);
+    interrupts();
+  }
+  else {
+    Serial.println(F("Clock: 'clock <domain> pin <n> | timer <ms> | host | pulse [n]'"));
+    return;
+  }
+  if (domain == currentClock) loadTimingCheck();
+  printClocks();
+}
+
+void printClocks() {
+  for (uint8_t i = 0; i < numClockDomains; i++) {
+    const ClockDomain& clock = clockDomains[i];
+    noInterrupts();
+    uint32_t edges = clock.edges;
+    uint16_t lost = clock.lost;
+    interrupts();
+    Serial.print(i == currentClock ? F("* ") : F("  "));
+    Serial.print(F("Clock ")); Serial.print(clock.name()); Serial.print(F(": "));
+    if (clock.source() == CLOCK_PIN) {
+      Serial.print(F("pin ")); Serial.print(clock.setting());
+    }
+    else if (clock.source() == CLOCK_TIMER) {
+      Serial.print(F("timer ")); Serial.print(clock.setting()); Serial.print(F(" ms"));
+    }
+    else if (clock.source() == CLOCK_HOST) {
+      Serial.print(F("host"));
+    }
+    else {
+      Serial.print(F("generator"));
+    }
+    Serial.print(F(", ")); Serial.print(edges);
+    Serial.print(F(" edges, ")); Serial.print(lost); Serial.println(F(" lost"));
+  }
+}
+
+// ====================
+// CLOCK GENERATOR
+// ====================
+ISR(TIMER1_COMPA_vect) {
+  generatorTicks++;
+  if (generatorBurst && --generatorBurst == 0) {
+    TIMSK1 &= ~(1 << OCIE1A);
+    TCCR1B = 0;
+    generatorRunning = false;
+  }
+}
+
+// Timer1 in CTC mode at generatorRate, set to the rate it can make; a
+// running burst keeps its count
+void programGenerator() {
+  uint8_t clockSelect;
+  uint16_t compare = timerCompare(generatorRate, clockSelect);
+  noInterrupts();
+  TCCR1A = 0;
+  TCCR1B = (1 << WGM12) | clockSelect;
+  if (TCNT1 > compare) TCNT1 = 0;
+  OCR1A = compare;
+  interrupts();
+}
+
+// burst pulses, or free-running for 0
+void startGenerator(uint32_t burst) {
+  stopGenerator();
+  noInterrupts();
+  generatorBurst = burst;
+  generatorRunning = true;
+  TCNT1 = 0;
+  TIFR1 = 1 << OCF1A;
+  TIMSK1 |= 1 << OCIE1A;
+  interrupts();
+  programGenerator();
+  generatorStartMillis = millis();
+  generatorStartEdges = clockDomains[generatorClock].edges;
+  generatorStartLost = clockDomains[generatorClock].lost;
+}
+
+void stopGenerator() {
+  noInterrupts();
+  TIMSK1 &= ~(1 << OCIE1A);
+  TCCR1B = 0;
+  generatorRunning = false;
+  interrupts();
+}
+
+// gen rate <hz> | run | burst <n> | step | stop
+void handleGeneratorCommand(String args) {
+  args.trim();
+  int space = args.indexOf(' ');
+  String verb = space < 0 ? args : args.substring(0, space);
+  String rest = space < 0 ? String("") : args.substring(space + 1);
+  rest.trim();
+  
+  if (verb == "rate") {
+    uint32_t rate = strtoul(rest.c_str(), 0, 0);
+    if (rate < 1 || rate > generatorMaxRate) {
+      Serial.print(F("Gen: rate must be 1-")); Serial.print(generatorMaxRate); Serial.println(F(" Hz"));
+      return;
+    }
+    generatorRate = rate;
+    if (generatorRunning) programGenerator();
+  }
+  else if (verb == "run") {
+    startGenerator(0);
+  }
+  else if (verb == "burst") {
+    uint32_t burst = strtoul(rest.c_str(), 0, 0);
+    if (burst < 1) {
+      Serial.println(F("Gen: 'gen burst <pulses>'"));
+      return;
+    }
+    startGenerator(burst);
+  }
+  else if (verb == "step") {
+    if (generatorRunning) {
+      Serial.println(F("Gen: stop it before stepping"));
+      return;
+    }
+    noInterrupts();
+    generatorTicks++;
+    interrupts();
+  }
+  else if (verb == "stop") {
+    stopGenerator();
+  }
+  else if (verb.length() > 0) {
+    Serial.println(F("Gen: 'gen [rate <hz> | run | burst <n> | step | stop]'"));
+    return;
+  }
+  printGenerator();
+}
+
+// What the domain took since the last run or burst started, as a rate:
+// with nothing lost, at least what the bound circuit can sustain
+void printGenerator() {
+  const ClockDomain& clock = clockDomains[generatorClock];
+  noInterrupts();
+  bool running = generatorRunning;
+  uint32_t left = generatorBurst;
+  uint32_t edges = clock.edges - generatorStartEdges;
+  uint16_t lost = clock.lost - generatorStartLost;
+  interrupts();
+  Serial.print(F("Gen: ")); Serial.print(running ? F("running at ") : F("stopped, "));
+  Serial.print(generatorRate); Serial.print(F(" Hz"));
+  if (running && left) {
+    Serial.print(F(", ")); Serial.print(left); Serial.print(F(" pulses of the burst left"));
+  }
+  Serial.print(F(", ")); Serial.print(generatorPulses); Serial.println(F(" pulses"));
+  float seconds = (millis() - generatorStartMillis) / 1000.0;
+  Serial.print(F("  Domain ")); Serial.print(clock.name());
+  Serial.print(F(": ")); Serial.print(edges);
+  Serial.print(F(" edges taken, ")); Serial.print(lost);
+  Serial.print(F(" lost in ")); Serial.print(seconds, 2);
+  Serial.print(F(" s"));
+  if (seconds > 0) {
+    Serial.print(F(" (")); Serial.print(edges / seconds, 0); Serial.print(F(" edges/s)"));
+  }
+  Serial.println(currentClock == generatorClock ? F("") : F("; the current circuit is on another domain"));
+}
+
+// ====================
+// CIRCUIT SLOTS
+// ====================
+// Saves the current circuit into its slot, switches to the pending one and
+// resumes it from its slot, between two loop passes
+void swapCircuit() {
+  unsigned long start = micros();
+  uint8_t number = pendingCircuit;
+  pendingCircuit = numCircuits;
+  saveCircuitSlot(circuitNumber(currentCircuit));
+  enterCircuit(number);
+  restoreCircuitSlot(number);
+  swapMicros = micros() - start;
+  
+  Serial.print(F("Circuit set to: ")); Serial.print(currentCircuit);
+  Serial.print(F(" (")); Serial.print(swapMicros); Serial.println(F(" us switch)"));
+  if (latencyRunning) latencyResults.select(number);
+}
+
+// Makes a circuit current, fresh from its netlist or state table
+void enterCircuit(uint8_t number) {
+  currentCircuit = circuitNames[number];
+  currentCategory = circuitCategory(currentCircuit);
+  loadCircuitNetlist();
+  loadCircuitFsm();
+  selectCircuitClock();
+  loadTimingCheck();
+  currentCounter = counterCircuit(currentCircuit);
+  shiftClockEnabled = currentCategory == "Registers";
+}
+
+void saveCircuitSlot(uint8_t number) {
+  CircuitSlot& slot = circuitSlots[number];
+  slot.outputs = readOutputWord();
+  slot.state = fsmMachine.state();
+  slot.latched = fsmMachine.latchedOutput();
+  slot.counter = counterValue;
+  slot.nodes = netlistState();
+  slot.saved = true;
+}
+
+// A circuit never run since the last reset starts from all outputs low
+void restoreCircuitSlot(uint8_t number) {
+  const CircuitSlot& slot = circuitSlots[number];
+  uint8_t outputs = slot.saved ? slot.outputs : 0;
+  if (slot.saved && stateTableCircuit()) fsmMachine.resume(slot.state, slot.latched);
+  if (slot.saved) resumeNetlistState(slot.nodes);
+  counterValue = slot.saved ? slot.counter : 0;
+  for (int i = 0; i < numOutputs; i++) {
+    digitalWrite(outputPins[i], (outputs >> i) & 0x01);
+  }
+  // The decoder redraws the display on its next pass
+  for (int i = 0; i < 7; i++) {
+    digitalWrite(segmentPins[i], LOW);
+  }
+}
+
+// ====================
+// CHECKPOINTS
+// ====================
+// Fields in version 2 order; restoreCheckpoint() reads them back the same way
+bool takeCheckpoint() {
+  uint32_t now = millis();
+  checkpointBlob.begin(numCircuits);
+  checkpointBlob.put(circuitNumber(currentCircuit));
+  checkpointBlob.put(readOutputWord());
+  checkpointBlob.put(fsmMachine.state());
+  checkpointBlob.put(fsmMachine.latchedOutput());
+  checkpointBlob.put32(fsmMachine.transitions);
+  checkpointBlob.put16(counterValue);
+  checkpointBlob.put32(netlistState());
+  
+  checkpointBlob.put(binaryUpCounter.value());
+  checkpointBlob.put(binaryDownCounter.value());
+  checkpointBlob.put(decadeUpCounter.value());
+  checkpointBlob.put(decadeDownCounter.value());
+  checkpointBlob.put(grayCounter.value());
+  checkpointBlob.put(ringCounter.value());
+  checkpointBlob.put(johnsonCounter.value());
+  checkpointBlob.put(dividerUnits.value());
+  checkpointBlob.put(dividerTens.value());
+  
+  noInterrupts();
+  uint8_t width = shiftRegister.width();
+  uint64_t shiftValue = shiftRegister.value();
+  uint8_t mode = shiftMode;
+  interrupts();
+  checkpointBlob.put(width);
+  checkpointBlob.put(mode);
+  checkpointBlob.put64(shiftValue);
+  checkpointBlob.put32(now - lastPulseTime);
+  
+  for (uint8_t i = 0; i < numCircuits; i++) {
+    checkpointBlob.put(circuitClocks[i]);
+  }
+  for (uint8_t i = 0; i < numClockDomains; i++) {
+    noInterrupts();
+    ClockPhase phase = clockDomains[i].phase(now);
+    interrupts();
+    checkpointBlob.put(clockDomains[i].source());
+    checkpointBlob.put16(clockDomains[i].setting());
+    checkpointBlob.put(phase.pending);
+    checkpointBlob.put(phase.primed | phase.level << 1);
+    checkpointBlob.put32(phase.untilNext);
+  }
+  noInterrupts();
+  bool running = generatorRunning;
+  uint32_t burst = generatorBurst;
+  interrupts();
+  checkpointBlob.put32(generatorRate);
+  checkpointBlob.put(running);
+  checkpointBlob.put32(burst);
+  
+  for (uint8_t i = 0; i < numCircuits; i++) {
+    const CircuitSlot& slot = circuitSlots[i];
+    checkpointBlob.put(slot.outputs);
+    checkpointBlob.put(slot.state);
+    checkpointBlob.put(slot.latched);
+    checkpointBlob.put16(slot.counter);
+    checkpointBlob.put(slot.saved);
+  }
+  // Only the latches hold anything in their nodes
+  for (uint8_t i = 0; i < numCircuits; i++) {
+    if (latchCircuit(i)) checkpointBlob.put32(circuitSlots[i].nodes);
+  }
+  
+  // Instances are added again on restore, which rebuilds their tables
+  checkpointBlob.put(instanceBank.count());
+  for (uint8_t i = 0; i < circuitInstances; i++) {
+    if (i >= instanceBank.count()) {
+      for (uint8_t b = 0; b < 7; b++) checkpointBlob.put(0);
+      continue;
+    }
+    const CircuitInstance& instance = instanceBank.instance(i);
+    checkpointBlob.put(instance.circuit);
+    checkpointBlob.put(instance.inputShift);
+    checkpointBlob.put(instance.outputShift);
+    checkpointBlob.put(instance.clock);
+    checkpointBlob.put(instance.enabled);
+    checkpointBlob.put(instance.machine.state());
+    checkpointBlob.put(instance.machine.latchedOutput());
+  }
+  return checkpointBlob.finish();
+}
+
+// Puts checkpointBlob back; a blob that does not check out leaves
+// everything as it was, one that runs short resets the system
+bool restoreCheckpoint() {
+  if (!checkpointBlob.open() || checkpointBlob.circuits() != numCircuits) return false;
+  uint8_t number = checkpointBlob.get();
+  if (number >= numCircuits) return false;
+  uint32_t now = millis();
+  uint8_t outputs = checkpointBlob.get();
+  uint8_t state = checkpointBlob.get();
+  uint8_t latched = checkpointBlob.get();
+  uint32_t transitions = checkpointBlob.get32();
+  counterValue = (int16_t)checkpointBlob.get16();
+  uint32_t nodes = checkpointBlob.get32();
+  
+  binaryUpCounter.edge(false, true, checkpointBlob.get());
+  binaryDownCounter.edge(false, true, checkpointBlob.get());
+  decadeUpCounter.edge(false, true, checkpointBlob.get());
+  decadeDownCounter.edge(false, true, checkpointBlob.get());
+  grayCounter.edge(false, true, checkpointBlob.get());
+  ringCounter.edge(false, true, checkpointBlob.get());
+  johnsonCounter.edge(false, true, checkpointBlob.get());
+  dividerUnits.edge(false, true, checkpointBlob.get());
+  dividerTens.edge(false, true, checkpointBlob.get());
+  
+  uint8_t width = checkpointBlob.get();
+  uint8_t mode = checkpointBlob.get();
+  uint64_t shiftValue = checkpointBlob.get64();
+  noInterrupts();
+  shiftRegister.setWidth(width);
+  shiftRegister.load(shiftValue);
+  if (mode <= SHIFT_PIPO) shiftMode = mode;
+  interrupts();
+  lastPulseTime = now - checkpointBlob.get32();
+  
+  for (uint8_t i = 0; i < numCircuits; i++) {
+    uint8_t clock = checkpointBlob.get();
+    if (clock < numClockDomains) circuitClocks[i] = clock;
+  }
+  enterCircuit(number);
+  for (uint8_t i = 0; i < numClockDomains; i++) {
+    uint8_t source = checkpointBlob.get();
+    uint16_t setting = checkpointBlob.get16();
+    ClockPhase phase;
+    phase.pending = checkpointBlob.get();
+    uint8_t flags = checkpointBlob.get();
+    phase.primed = flags & 0x01;
+    phase.level = flags & 0x02;
+    phase.untilNext = checkpointBlob.get32();
+    bool valid = source <= CLOCK_GENERATOR && (source != CLOCK_PIN || isClockablePin(setting));
+    noInterrupts();
+    if (valid) clockDomains[i].setSource(source, setting);
+    clockDomains[i].resume(phase, now);
+    interrupts();
+  }
+  uint32_t rate = checkpointBlob.get32();
+  bool running = checkpointBlob.get();
+  uint32_t burst = checkpointBlob.get32();
+  if (rate >= 1 && rate <= generatorMaxRate) generatorRate = rate;
+  if (running) startGenerator(burst);
+  else stopGenerator();
+  
+  for (uint8_t i = 0; i < numCircuits; i++) {
+    CircuitSlot& slot = circuitSlots[i];
+    slot.outputs = checkpointBlob.get();
+    slot.state = checkpointBlob.get();
+    slot.latched = checkpointBlob.get();
+    slot.counter = (int16_t)checkpointBlob.get16();
+    slot.saved = checkpointBlob.get();
+  }
+  for (uint8_t i = 0; i < numCircuits; i++) {
+    if (latchCircuit(i)) circuitSlots[i].nodes = checkpointBlob.get32();
+  }
+  
+  uint8_t instances = checkpointBlob.get();
+  instanceBank.clear();
+  for (uint8_t i = 0; i < circuitInstances; i++) {
+    uint8_t circuit = checkpointBlob.get();
+    uint8_t inputShift = checkpointBlob.get();
+    uint8_t outputShift = checkpointBlob.get();
+    uint8_t clock = checkpointBlob.get();
+    bool enabled = checkpointBlob.get();
+    uint8_t instanceState = checkpointBlob.get();
+    uint8_t instanceLatched = checkpointBlob.get();
+    if (i >= instances || circuit >= numCircuits) continue;
+    uint8_t index = addInstance(circuitNames[circuit], inputShift, outputShift);
+    if (index == instanceBank.count()) continue;
+    CircuitInstance& instance = instanceBank.instance(index);
+    if (clock < numClockDomains) instance.clock = clock;
+    instance.enabled = enabled;
+    if (instance.kind == INSTANCE_FSM) instance.machine.resume(instanceState, instanceLatched);
+  }
+  
+  if (checkpointBlob.overran()) {
+    resetSystem();
+    return false;
+  }
+  if (stateTableCircuit()) {
+    fsmMachine.resume(state, latched);
+    fsmMachine.transitions = transitions;
+  }
+  resumeNetlistState(nodes);
+  for (int i = 0; i < numOutputs; i++) {
+    digitalWrite(outputPins[i], (outputs >> i) & 0x01);
+  }
+  return true;
+}
+
+// checkpoint
+void handleCheckpointCommand(String args) {
+  args.trim();
+  if (args.length() > 0) {
+    Serial.println(F("Checkpoint: 'checkpoint' (sends it as a frame; 'restore apply' puts it back)"));
+    return;
+  }
+  unsigned long start = micros();
+  bool ok = takeCheckpoint();
+  unsigned long took = micros() - start;
+  if (!ok) {
+    Serial.println(F("Checkpoint: state does not fit the blob"));
+    return;
+  }
+  FrameWriter writer(serialFrameByte);
+  writeCheckpointFrame(writer, checkpointBlob);
+  Serial.println();
+  Serial.print(F("Checkpoint: ")); Serial.print(checkpointBlob.length());
+  Serial.print(F(" bytes, version ")); Serial.print(checkpointVersion);
+  Serial.print(F(", ")); Serial.print(took); Serial.println(F(" us"));
+}
+
+// restore <offset> <hex bytes> | apply
+void handleRestoreCommand(String args) {
+  args.trim();
+  if (args == "apply") {
+    unsigned long start = micros();
+    bool ok = restoreCheckpoint();
+    unsigned long took = micros() - start;
+    if (!ok) {
+      Serial.print(F("Restore: no valid version ")); Serial.print(checkpointVersion);
+      Serial.println(F(" checkpoint for this build"));
+      return;
+    }
+    Serial.print(F("Restore: ")); Serial.print(currentCircuit);
+    Serial.print(F(", ")); Serial.print(took); Serial.println(F(" us"));
+    return;
+  }
+  
+  const char* at = args.c_str();
+  char* end;
+  unsigned long offset = strtoul(at, &end, 0);
+  bool ok = end != at && *end == ' ';
+  at = end;
+  while (*at == ' ') at++;
+  if (ok && offset == 0) checkpointBlob.clear();
+  for (; ok && isHexadecimalDigit(at[0]) && isHexadecimalDigit(at[1]); at += 2, offset++) {
+    uint8_t high = at[0] <= '9' ? at[0] - '0' : (at[0] | 0x20) - 'a' + 10;
+    uint8_t low = at[1] <= '9' ? at[1] - '0' : (at[1] | 0x20) - 'a' + 10;
+    ok = checkpointBlob.store(offset, high << 4 | low);
+  }
+  if (!ok || *at) {
+    Serial.print(F("Restore: 'restore <offset> <hex bytes>' (up to ")); Serial.print(checkpointBytes);
+    Serial.println(F(" bytes, offset 0 starts over), then 'restore apply'"));
+  }
+}
+
+// ====================
+// SAVED CONFIGURATION
+// ====================
+uint8_t readEeprom(uint16_t address) {
+  return EEPROM.read(address);
+}
+
+// update() skips bytes that already hold the value, sparing the cells
+void writeEeprom(uint16_t address, uint8_t byte) {
+  EEPROM.update(address, byte);
+}
+
+// Record: checkpoint length (uint16) | checkpoint | state table shape
+// (states uint16, inputs, outputs, kind, reset state) | its entries |
+// timer settings (capture rate uint32, pre uint16, mode, post uint32,
+// trigger type, mask uint16, value uint16, telemetry rate uint32)
+const uint8_t configTimerBytes = 20;
+
+bool saveConfig() {
+  if (!takeCheckpoint()) return false;
+  configStore.start();
+  configStore.put16(checkpointBlob.length());
+  for (uint16_t i = 0; i < checkpointBlob.length(); i++) {
+    configStore.put(checkpointBlob.data()[i]);
+  }
+  configStore.put16(fsmLoaded.states);
+  configStore.put(fsmLoaded.inputBits);
+  configStore.put(fsmLoaded.outputBits);
+  configStore.put(fsmLoaded.kind);
+  configStore.put(fsmLoaded.resetState);
+  uint16_t entries = fsmLoaded.states ? fsmTableEntries(fsmLoaded.states, fsmLoaded.inputBits) : 0;
+  for (uint16_t i = 0; i < entries; i++) {
+    configStore.put16(fsmRamTable[i]);
+  }
+  configStore.put32(captureRate);
+  configStore.put16(logicCapture.preTrigger());
+  configStore.put(logicCapture.captureMode());
+  configStore.put32(logicCapture.postTrigger());
+  configStore.put(captureTriggerType);
+  configStore.put16(captureTriggerMask);
+  configStore.put16(captureTriggerValue);
+  configStore.put32(telemetryRate);
+  return configStore.commit();
+}
+
+// The newest saved record; the state table goes back first, so a saved
+// "FSM" circuit finds it. Every field is checked against its range and
+// the record's length before anything is applied: a record of another
+// layout, or cut short, leaves the defaults for a cold start.
+bool loadConfig() {
+  if (!configStore.begin()) return false;
+  uint16_t length = configStore.get16(0);
+  uint32_t at = 2;
+  if (length > checkpointBytes || at + length + 6 > configStore.length()) return false;
+  checkpointBlob.clear();
+  for (uint16_t i = 0; i < length; i++) {
+    if (!checkpointBlob.store(i, configStore.get(at++))) return false;
+  }
+  if (!checkpointBlob.open() || checkpointBlob.circuits() != numCircuits) return false;
+  
+  uint16_t states = configStore.get16(at);
+  uint8_t inputBits = configStore.get(at + 2);
+  uint8_t outputBits = configStore.get(at + 3);
+  uint8_t kind = configStore.get(at + 4);
+  uint8_t resetState = configStore.get(at + 5);
+  at += 6;
+  uint32_t entries = states ? fsmTableEntries(states, inputBits) : 0;
+  if (states > 0 &&
+      (states > fsmMaxStates || inputBits > fsmMaxInputBits || outputBits == 0 ||
+       outputBits > 8 || kind > FSM_MEALY || resetState >= states || entries > fsmRamEntries)) {
+    return false;
+  }
+  if (at + 2 * entries + configTimerBytes != configStore.length()) return false;
+  for (uint32_t i = 0; i < entries; i++) {
+    if (fsmNext(configStore.get16(at + 2 * i)) >= states) return false;
+  }
+  uint16_t timers = at + 2 * entries;
+  uint32_t savedCaptureRate = configStore.get32(timers);
+  uint8_t savedMode = configStore.get(timers + 6);
+  uint8_t savedTrigger = configStore.get(timers + 11);
+  uint16_t savedTriggerValue = configStore.get16(timers + 14);
+  uint32_t savedTelemetryRate = configStore.get32(timers + 16);
+  if (savedCaptureRate < 1 || savedCaptureRate > captureMaxRate || savedMode > CAPTURE_RLE ||
+      savedTrigger > TRIGGER_COUNTER ||
+      (savedTrigger == TRIGGER_COUNTER && savedTriggerValue > 0xFF) ||
+      savedTelemetryRate < 1 || savedTelemetryRate > telemetryMaxRate) {
+    return false;
+  }
+  
+  if (states > 0) {
+    for (uint16_t i = 0; i < entries; i++, at += 2) {
+      fsmRamTable[i] = configStore.get16(at);
+    }
+    fsmLoaded.states = states;
+    fsmLoaded.inputBits = inputBits;
+    fsmLoaded.outputBits = outputBits;
+    fsmLoaded.kind = kind;
+    fsmLoaded.resetState = resetState;
+    fsmLoaded.resetOutput = fsmLoadedResetOutput();
+  }
+  if (!restoreCheckpoint()) {
+    fsmLoaded.states = 0;
+    return false;
+  }
+  // Taken up by the next 'capture arm' and 'stream on'
+  captureRate = savedCaptureRate;
+  logicCapture.setPreTrigger(configStore.get16(timers + 4));
+  logicCapture.setMode(savedMode);
+  logicCapture.setPostTrigger(configStore.get32(timers + 7));
+  captureTriggerType = savedTrigger;
+  captureTriggerMask = configStore.get16(timers + 12);
+  captureTriggerValue = savedTriggerValue;
+  telemetryRate = savedTelemetryRate;
+  return true;
+}
+
+// config [save | erase]
+void handleConfigCommand(String args) {
+  args.trim();
+  if (args == "save") {
+    unsigned long start = millis();
+    if (!saveConfig()) {
+      Serial.print(F("Config: does not fit a ")); Serial.print(configStore.capacity());
+      Serial.println(F(" byte slot"));
+      return;
+    }
+    Serial.print(F("Config: saved in ")); Serial.print(millis() - start);
+    Serial.println(F(" ms"));
+  }
+  else if (args == "erase") {
+    configStore.erase();
+  }
+  else if (args.length() > 0) {
+    Serial.println(F("Config: 'config [save | erase]'"));
+    return;
+  }
+  printConfig();
+}
+
+void printConfig() {
+  if (configStore.valid()) {
+    Serial.print(F("Config: save ")); Serial.print(configStore.sequence());
+    Serial.print(F(" in slot ")); Serial.print(configStore.slot());
+    Serial.print(F(" of ")); Serial.print(configSlots);
+    Serial.print(F(", ")); Serial.print(configStore.length());
+    Serial.print(F(" of ")); Serial.print(configStore.capacity());
+    Serial.println(F(" bytes"));
+  }
+  else {
+    Serial.println(F("Config: nothing saved, power-up starts with the defaults"));
+  }
+  printBoot();
+}
+
+void printBoot() {
+  Serial.print(F("Boot: ")); Serial.print(warmStart ? F("warm") : F("cold"));
+  Serial.print(F(" start, first evaluation ")); Serial.print(firstEvaluationMicros);
+  Serial.println(F(" us after reset"));
+}
+
+// ====================
+// CIRCUIT INSTANCES
+// ====================
+// Adds a circuit as an instance: gates and combinational circuits as truth
+// tables evaluated through their netlist, clocked circuits with their own
+// state table copy. Returns its index, instanceBank.count() if rejected.
+// The table is built in the shared engine, so the current circuit's node
+// values go back afterwards and a latch keeps what it holds.
+uint8_t addInstance(String circuit, uint8_t inputShift, uint8_t outputShift) {
+  uint8_t number = circuitNumber(circuit);
+  String category = circuitCategory(circuit);
+  CircuitInstance* instance = 0;
+  
+  if (category == "Basic" || category == "Combinational") {
+    uint32_t held = netlistState();
+    loadNetlist(circuit, true);
+    if (netlistActive) {
+      instance = instanceBank.add(number, INSTANCE_TABLE, inputShift, circuitNetlist.inputCount(),
+                                  outputShift, circuitNetlist.outputCount(), circuitClocks[number]);
+    }
+    if (instance) {
+      for (uint8_t inputs = 0; inputs < (1 << instance->inputBits); inputs++) {
+        circuitNetlist.applyInputWord(inputs);
+        circuitNetlist.update();
+        instance->table[inputs] = (uint8_t)circuitNetlist.outputWord();
+      }
+    }
+    // The netlist engine is shared with the current circuit
+    loadCircuitNetlist();
+    resumeNetlistState(held);
+  }
+  else {
+    FsmRead read;
+    const FsmTable* table = circuitFsm(circuit, read);
+    if (table) {
+      instance = instanceBank.add(number, INSTANCE_FSM, inputShift, table->inputBits,
+                                  outputShift, table->outputBits, circuitClocks[number]);
+    }
+    if (instance && !instance->machine.begin(*table, read)) {
+      instanceBank.remove(instanceBank.count() - 1);
+      instance = 0;
+    }
+  }
+  return instance ? instanceBank.count() - 1 : instanceBank.count();
+}
+
+// inst add <input bit> <output bit> <circuit>
+// inst <n> on | off | reset | clock <domain>
+// inst remove <n> | clear
+void handleInstanceCommand(String args) {
+  args.trim();
+  int space = args.indexOf(' ');
+  String verb = space < 0 ? args : args.substring(0, space);
+  String rest = space < 0 ? String("") : args.substring(space + 1);
+  rest.trim();
+  
+  if (verb == "add") {
+    const char* at = rest.c_str();
+    char* end;
+    long inputShift = strtol(at, &end, 0);
+    bool ok = end != at;
+    at = end;
+    long outputShift = strtol(at, &end, 0);
+    ok = ok && end != at;
+    String circuit = String(end);
+    circuit.trim();
+    if (!ok || inputShift < 0 || inputShift >= numInputs || outputShift < 0 || outputShift >= numOutputs ||
+        !isValidCircuit(circuit)) {
+      Serial.println(F("Inst: 'inst add <input bit> <output bit> <circuit>'"));
+      return;
+    }
+    String category = circuitCategory(circuit);
+    if (category != "Basic" && category != "Combinational" &&
+        !(category == "Sequential" && !circuit.startsWith("SR Latch"))) {
+      Serial.println(F("Inst: only gates, combinational circuits and state tables run as instances"));
+      return;
+    }
+    if (addInstance(circuit, inputShift, outputShift) == instanceBank.count()) {
+      Serial.print(F("Inst: does not fit; up to ")); Serial.print(circuitInstances);
+      Serial.println(F(" instances within the 8 inputs and outputs, no output shared"));
+      return;
+    }
+  }
+  else if (verb == "remove") {
+    if (rest.length() == 0 || !instanceBank.remove(strtoul(rest.c_str(), 0, 0))) {
+      Serial.println(F("Inst: 'inst remove <n>'"));
+      return;
+    }
+  }
+  else if (verb == "clear") {
+    instanceBank.clear();
+  }
+  else if (verb.length() > 0) {
+    uint8_t index = strtoul(verb.c_str(), 0, 0);
+    if (!isDigit(verb.charAt(0)) || index >= instanceBank.count()) {
+      Serial.println(F("Inst: 'inst [add <input bit> <output bit> <circuit> | <n> on|off|reset|clock <domain> | remove <n> | clear]'"));
+      return;
+    }
+    CircuitInstance& instance = instanceBank.instance(index);
+    if (rest == "on" || rest == "off") {
+      instance.enabled = rest == "on";
+    }
+    else if (rest == "reset") {
+      instanceBank.reset(index);
+    }
+    else if (rest.startsWith("clock")) {
+      String name = rest.substring(5);
+      name.trim();
+      uint8_t clock = clockNumber(name);
+      if (clock == numClockDomains) {
+        Serial.println(F("Inst: no such domain, 'clock' lists them"));
+        return;
+      }
+      instance.clock = clock;
+    }
+    else {
+      Serial.println(F("Inst: 'inst <n> on|off|reset|clock <domain>'"));
+      return;
+    }
+  }
+  printInstances();
+}
+
+void printInstances() {
+  Serial.print(F("Instances: ")); Serial.print(instanceBank.count());
+  Serial.print(F(" of ")); Serial.print(circuitInstances);
+  Serial.println(currentCategory == "Instances" ? F("") : F(" (select 'Instances' to run them)"));
+  for (uint8_t i = 0; i < instanceBank.count(); i++) {
+    const CircuitInstance& instance = instanceBank.instance(i);
+    Serial.print(F("  ")); Serial.print(i);
+    Serial.print(F(": ")); Serial.print(circuitNames[instance.circuit]);
+    Serial.print(F(", inputs ")); printBitRange(instance.inputShift, instance.inputBits);
+    Serial.print(F(", outputs ")); printBitRange(instance.outputShift, instance.outputBits);
+    if (instance.kind == INSTANCE_FSM) {
+      Serial.print(F(", clock ")); Serial.print(clockDomains[instance.clock].name());
+      Serial.print(F(", state ")); Serial.print(instance.machine.state());
+    }
+    Serial.println(instance.enabled ? F("") : F(", off"));
+  }
+}
+
+// e.g. 4-5, or 6 for a single bit
+void printBitRange(uint8_t first, uint8_t bits) {
+  Serial.print(first);
+  if (bits > 1) {
+    Serial.print(F("-")); Serial.print(first + bits - 1);
+  }
+}
+
+// ====================
+// LATENCY SELF-TEST
+// ====================
+ISR(TIMER5_CAPT_vect) {
+  uint32_t at = extendCycles(ICR5);
+  if ((int32_t)(at - latencyStimulus) < 0) return;  // An edge before the stimulus
+  latencyResponse = at;
+  latencyCaptured = true;
+  TIMSK5 &= ~(1 << ICIE5);
+}
+
+// Schedules the next stimulus edge a few hundred cycles ahead on OC5A and
+// arms the capture for the response edge the output should make
+void sendStimulus() {
+  stimulusLevel = !stimulusLevel;
+  noInterrupts();
+  if (digitalRead(responsePin)) TCCR5B &= ~(1 << ICES5);
+  else TCCR5B |= 1 << ICES5;
+  latencyStimulus = cycleCount() + 256;
+  OCR5A = (uint16_t)latencyStimulus;
+  // Set or clear on match, so later matches leave the pin alone
+  TCCR5A = stimulusLevel ? (1 << COM5A1) | (1 << COM5A0) : 1 << COM5A1;
+  latencyCaptured = false;
+  TIFR5 = 1 << ICF5;
+  TIMSK5 |= 1 << ICIE5;
+  interrupts();
+  latencyPending = true;
+  latencySentMillis = millis();
+}
+
+void stopLatencyTest() {
+  TIMSK5 &= ~(1 << ICIE5);
+  digitalWrite(stimulusPin, stimulusLevel);  // Also hands the pin back from OC5A
+  latencyRunning = false;
+  latencyPending = false;
+}
+
+// Collects the response to the last stimulus and paces the next one at a
+// random offset, so stimuli land at every point of the loop pass
+void serviceLatency() {
+  if (!latencyRunning) return;
+  if (latencyPending) {
+    if (latencyCaptured) {
+      latencyResults.addLatency(latencyResponse - latencyStimulus);
+    }
+    else if (millis() - latencySentMillis >= latencyTimeoutMillis) {
+      TIMSK5 &= ~(1 << ICIE5);
+      latencyResults.addTimeout();
+    }
+    else {
+      return;
+    }
+    latencyPending = false;
+    if (latencyTrials && --latencyTrials == 0) {
+      stopLatencyTest();
+      printLatencyResults();
+      return;
+    }
+    latencyNextMillis = millis() + 2 + random(20);
+    return;
+  }
+  if ((long)(millis() - latencyNextMillis) >= 0) sendStimulus();
+}
+
+void handleLatencyCommand(String args) {
+  args.trim();
+  int space = args.indexOf(' ');
+  String verb = space < 0 ? args : args.substring(0, space);
+  String rest = space < 0 ? String("") : args.substring(space + 1);
+  rest.trim();
+  
+  if (verb == "start") {
+    startCycleTimer();
+    pinMode(stimulusPin, OUTPUT);
+    pinMode(responsePin, INPUT);
+    stimulusLevel = digitalRead(stimulusPin);
+    latencyResults.select(circuitNumber(currentCircuit));
+    latencyTrials = strtoul(rest.c_str(), 0, 0);
+    latencyPending = false;
+    latencyNextMillis = millis();
+    latencyRunning = true;
+    Serial.println(F("Latency: running (pin 46 -> input under test, output under test -> pin 48)"));
+  }
+  else if (verb == "stop") {
+    if (latencyRunning) stopLatencyTest();
+    printLatencyResults();
+  }
+  else if (verb == "clear") {
+    latencyResults.clear();
+    if (latencyRunning) latencyResults.select(circuitNumber(currentCircuit));
+    Serial.println(F("Latency: cleared"));
+  }
+  else if (verb == "report") {
+    FrameWriter writer(serialFrameByte);
+    writeLatencyFrame(writer, latencyResults, F_CPU);
+    Serial.println();
+  }
+  else if (verb.length() == 0) {
+    printLatencyResults();
+  }
+  else {
+    Serial.println(F("Latency: 'latency [start [trials] | stop | clear | report]'"));
+  }
+}
+
+void printLatencyResults() {
+  Serial.print(F("Latency: ")); Serial.println(latencyRunning ? F("running") : F("stopped"));
+  for (uint8_t i = 0; i < latencyResults.count(); i++) {
+    const LatencySlot& slot = latencyResults.slot(i);
+    const PhaseStats& stats = slot.stats;
+    Serial.print(F("  ")); Serial.print(circuitNames[slot.circuit]);
+    Serial.print(F(": ")); Serial.print(stats.count);
+    Serial.print(F(" edges, ")); Serial.print(slot.timeouts);
+    Serial.print(F(" timeouts"));
+    if (stats.count) {
+      const double cyclesPerMicro = F_CPU / 1e6;
+      Serial.print(F(", min ")); Serial.print(stats.min / cyclesPerMicro, 2);
+      Serial.print(F(" mean ")); Serial.print((double)stats.total / stats.count / cyclesPerMicro, 2);
+      Serial.print(F(" max ")); Serial.print(stats.max / cyclesPerMicro, 2);
+      Serial.print(F(" us"));
+    }
+    Serial.println();
+  }
+}
+
+// ====================
+// MEMORY
+// ====================
+// The stack is painted from the end of .bss to RAMEND before the
+// constructors run; the lowest byte above the heap that lost its paint is
+// as deep as the stack has ever reached.
+const uint8_t stackPaint = 0xC5;
+
+struct __freelist {
+  size_t sz;
+  struct __freelist* nx;
+};
+
+extern uint8_t __data_start;
+extern uint8_t _end;
+extern uint8_t __stack;
+extern uint8_t __heap_start;
+extern char* __brkval;
+extern struct __freelist* __flp;
+
+void paintStack() __attribute__((naked, used, section(".init3")));
+
+void paintStack() {
+  for (uint8_t* p = &_end; p <= &__stack; p++) *p = stackPaint;
+}
+
+uint8_t* heapTop() {
+  return __brkval ? (uint8_t*)__brkval : &__heap_start;
+}
+
+void printBudgetLine(const char* name, uint16_t bytes, uint16_t budget, bool over) {
+  Serial.print(F("  ")); Serial.print(name);
+  Serial.print(F(": ")); Serial.print(bytes);
+  Serial.print(F(" / ")); Serial.print(budget);
+  Serial.println(over ? F(" B  OVER") : F(" B"));
+}
+
+// Static sizes per subsystem, heap use and fragmentation, and the stack
+// now and at its deepest, each against its budget
+void printMemory() {
+  uint8_t config = 0;
+#if PHASE_PROFILE
+  config |= MEMORY_PROFILE;
+#endif
+#if PHASE_TRACE
+  config |= MEMORY_TRACE;
+#endif
+  MemoryUsage usage[MEMORY_SUBSYSTEMS];
+  subsystemMemory(usage, config);
+  
+  uint16_t freeListTotal = 0;
+  uint16_t largestFree = 0;
+  uint8_t freeBlocks = 0;
+  noInterrupts();
+  for (struct __freelist* block = __flp; block; block = block->nx) {
+    freeListTotal += block->sz;
+    if (block->sz > largestFree) largestFree = block->sz;
+    freeBlocks++;
+  }
+  uint8_t* top = heapTop();
+  uint8_t* stackNow = (uint8_t*)SP;
+  interrupts();
+  uint8_t* deepest = top;
+  while (deepest <= &__stack && *deepest == stackPaint) deepest++;
+  
+  uint16_t staticBytes = &_end - &__data_start;
+  uint16_t heapBytes = top - &__heap_start;
+  uint16_t heapInUse = heapBytes - freeListTotal;
+  uint16_t untouched = deepest - top;
+  uint16_t gap = stackNow > top ? stackNow - top : 0;
+  bool over = false;
+  
+  Serial.print(F("Memory: ")); Serial.print(sramBytes); Serial.println(F(" B SRAM"));
+  printBudgetLine("static (.data + .bss)", staticBytes, staticBudget, staticBytes > staticBudget);
+  for (uint8_t i = 0; i < MEMORY_SUBSYSTEMS; i++) {
+    printBudgetLine(usage[i].name, usage[i].bytes, usage[i].budget, overBudget(usage[i]));
+    over = over || overBudget(usage[i]);
+  }
+  printBudgetLine("heap in use", heapInUse, heapBudget, heapInUse > heapBudget);
+  Serial.print(F("  heap free list: ")); Serial.print(freeListTotal);
+  Serial.print(F(" B in ")); Serial.print(freeBlocks);
+  Serial.print(F(" blocks, largest ")); Serial.print(largestFree); Serial.println(F(" B"));
+  Serial.print(F("  stack: ")); Serial.print(&__stack - stackNow);
+  Serial.print(F(" B now, ")); Serial.print(&__stack - deepest + 1); Serial.println(F(" B peak"));
+  Serial.print(F("  free: ")); Serial.print(gap + freeListTotal);
+  Serial.print(F(" B (")); Serial.print(gap); Serial.println(F(" B between heap and stack)"));
+  Serial.print(F("  never touched: ")); Serial.print(untouched);
+  Serial.print(F(" B, reserve ")); Serial.print(stackReserve);
+  Serial.println(untouched < stackReserve ? F(" B  LOW") : F(" B"));
+  over = over || staticBytes > staticBudget || heapInUse > heapBudget || untouched < stackReserve;
+  Serial.println(over ? F("Memory: over budget") : F("Memory: within budget"));
+}
+
+// ====================
+// PHASE STATISTICS AND TRACE
+// ====================
+#if PHASE_PROFILE || PHASE_TRACE
+void phaseBegin(uint8_t phase) {
+#if PHASE_PROFILE
+  phaseProfile.begin(phase, cycleCount());
+#endif
+  TRACE_BEGIN(phase);
+}
+
+void phaseEnd(uint8_t phase) {
+  TRACE_END(phase);
+#if PHASE_PROFILE
+  phaseProfile.end(phase, cycleCount());
+#endif
+}
+#endif
+
+#if PHASE_TRACE
+// Loop and interrupt handlers share the buffer, so the loop's writes
+// hold interrupts off
+void traceEvent(uint8_t id, uint8_t kind, uint16_t arg) {
+  uint8_t oldSREG = SREG;
+  cli();
+  traceBuffer.record(cycleCount(), id, kind, arg);
+  SREG = oldSREG;
+}
+
+void traceInputs(byte inputWord) {
+  if (inputWord == tracedInputs) return;
+  tracedInputs = inputWord;
+  traceEvent(TRACE_INPUT_EDGE, TRACE_KIND_INSTANT, inputWord);
+}
+#endif
+
+bool traceStreaming() {
+#if PHASE_TRACE
+  return traceBuffer.active();
+#else
+  return false;
+#endif
+}
+
+// Sends queued trace events, a couple of frames at a time
+void serviceTrace() {
+#if PHASE_TRACE
+  PROFILE_BEGIN(PHASE_TX);
+  FrameWriter writer(serialFrameByte);
+  for (uint8_t frames = 0; frames < 2; frames++) {
+    if (!traceBuffer.writeFrame(writer, F_CPU)) break;
+  }
+  PROFILE_END(PHASE_TX);
+#endif
+}
+
+void handleTraceCommand(String args) {
+  args.trim();
+#if PHASE_TRACE
+  if (args == "on") {
+    tracedInputs = -1;
+    traceBuffer.start();
+  }
+  else if (args == "off") {
+    traceBuffer.stop();
+    serviceTrace();
+    Serial.println();
+  }
+  else if (args.length() > 0) {
+    Serial.println(F("Trace: 'trace [on | off]'"));
+    return;
+  }
+  Serial.print(F("Trace: ")); Serial.print(traceBuffer.active() ? F("on") : F("off"));
+  Serial.print(F(" Frames: ")); Serial.print(traceBuffer.sequence());
+  Serial.print(F(" Lost: ")); Serial.println(traceBuffer.lostEvents());
+#else
+  Serial.println(F("Trace: not built in (set PHASE_TRACE to 1)"));
+#endif
+}
+
+void handleStatsCommand(String args) {
+  args.trim();
+#if PHASE_PROFILE
+  if (args == "reset") {
+    phaseProfile.reset();
+    Serial.println(F("Stats: cleared"));
+  }
+  else if (args.length() == 0) {
+    FrameWriter writer(serialFrameByte);
+    writeStatsFrame(writer, phaseProfile, F_CPU);
+    Serial.println();
+  }
+  else {
+    Serial.println(F("Stats: 'stats [reset]'"));
+  }
+#else
+  Serial.println(F("Stats: not built in (set PHASE_PROFILE to 1)"));
+#endif
+}
+
+// ====================
+// SYSTEM
+// ====================
+void resetSystem() {
+  // Reset all outputs
+  for (int i = 0; i < numOutputs; i++) {
+    digitalWrite(outputPins[i], LOW);
+  }
+  
+  // Reset 7-segment display
+  for (int i = 0; i < 7; i++) {
+    digitalWrite(segmentPins[i], LOW);
+  }
+  
+  // Reset state variables
+  fsmMachine.reset();
+  instanceBank.resetAll();
+  resetCounters();
+  noInterrupts();
+  shiftRegister.clear();
+  interrupts();
+  counterValue = 0;
+  lastPulseTime = millis();
+  for (uint8_t i = 0; i < numCircuits; i++) {
+    circuitSlots[i].saved = false;
+  }
 }
 
 void printMenu() {
-  Serial.println("\n==== Digital Logic Lab Simulator ====");
-  Serial.println("Available Circuits:");
-  Serial.println("Basic Gates: AND, OR, NOT, NAND, NOR, XOR, XNOR");
-  Serial.println("Combinational: Half Adder, Full Adder, Multiplexer (MUX)");
-  Serial.println("Sequential: D Flip-Flop, JK Flip-Flop");
-  Serial.println("Timers: Astable Multivibrator");
-  Serial.println("Counters: Binary Up Counter, Binary Down Counter");
-  Serial.println("Decoders: BCD Decoder with 7-Segment Display");
-  Serial.println("\nCommands: 'menu', 'reset', or circuit name");
-  Serial.println("===================================");
+  Serial.println(F("\n==== Digital Logic Lab Simulator ===="));
+  Serial.println(F("Available Circuits:"));
+  Serial.println(F("Basic Gates: AND, OR, NOT, NAND, NOR, XOR, XNOR"));
+  Serial.println(F("Combinational: Half Adder, Full Adder, Multiplexer (MUX)"));
+  Serial.println(F("Sequential: SR Latch (NAND), SR Latch (NOR), D Flip-Flop, JK Flip-Flop,"));
+  Serial.println(F("  T Flip-Flop, Sequence Detector (101), FSM"));
+  Serial.println(F("Timers: Astable Multivibrator"));
+  Serial.println(F("Counters: Binary Up Counter, Binary Down Counter, Decade Up Counter,"));
+  Serial.println(F("  Decade Down Counter, Gray Code Counter, Ring Counter, Johnson Counter,"));
+  Serial.println(F("  Frequency Divider (inputs 0-3 load data, input 6 LOW holds, input 7 LOW loads)"));
+  Serial.println(F("Registers: Shift Register (clock on pin 2, input 0 data, input 1 LOW shifts down,"));
+  Serial.println(F("  input 2 LOW holds, mode pin LOW loads inputs 0-7 in PISO)"));
+  Serial.println(F("Decoders: BCD Decoder with 7-Segment Display"));
+  Serial.println(F("Instances: runs the circuits added with 'inst', side by side"));
+  Serial.println(F("\nCommands: 'menu', 'reset', 'netlist', 'minimize', 'mem', or circuit name"));
+  Serial.println(F("Capture: 'capture [rate <hz> | pre <n> | mode raw|rle | post <n> | arm | stop]',"));
+  Serial.println(F("  'capture trigger now | pattern <mask> <value> | rise <bit> | fall <bit> | counter <0-255>'"));
+  Serial.println(F("  (bits 0-7 inputs, 8-15 outputs)"));
+  Serial.println(F("FSM: 'fsm new moore|mealy <states> <input bits> <output bits> [reset]',"));
+  Serial.println(F("  'fsm set <state> <inputs> <next> <output>', 'fsm data <index> <hex> ...', 'fsm'"));
+  Serial.println(F("Telemetry: 'stream [on | off | rate <hz> | baud <rate>]'"));
+  Serial.println(F("Clocks: 'clock [<domain> pin <n> | timer <ms> | host | pulse [n]]',"));
+  Serial.println(F("  'clock bind <domain>' (clocks the current circuit; main, aux, timer, host, gen)"));
+  Serial.println(F("Generator: 'gen [rate <hz> | run | burst <n> | step | stop]' (drives the gen domain)"));
+  Serial.println(F("Timing: 'timing [on | off | clear | setup <us> | hold <us>]'"));
+  Serial.println(F("  (setup/hold checks on the clocked circuit's data inputs, per circuit)"));
+  Serial.println(F("Profiling: 'stats [reset]' (phase cycle counts, PHASE_PROFILE builds)"));
+  Serial.println(F("  'trace [on | off]' (timeline events, PHASE_TRACE builds)"));
+  Serial.println(F("Latency: 'latency [start [trials] | stop | clear | report]'"));
+  Serial.println(F("  (jumper pin 46 to the input under test, the output under test to pin 48)"));
+  Serial.println(F("Shift: 'shift [width <4-64> | mode siso|sipo|piso|pipo | load <hex> | clear]'"));
+  Serial.println(F("Inst: 'inst [add <input bit> <output bit> <circuit> | remove <n> | clear]',"));
+  Serial.println(F("  'inst <n> on | off | reset | clock <domain>' (gates, combinational and clocked circuits)"));
+  Serial.println(F("Checkpoint: 'checkpoint' (state as a frame), 'restore <offset> <hex>', 'restore apply'"));
+  Serial.println(F("Config: 'config [save | erase]' (EEPROM; power-up restores the saved circuit)"));
+  Serial.println(F("==================================="));
 }
\ No newline at end of file
@@ -0,0 +1,221 @@
+/*
+ * Digital Logic Lab Simulator - Logic Analyzer Capture
+ */
+
+#include "Capture.h"
+
+LogicCapture::LogicCapture()
+  : counter(0), buffer(0), depth(0), preSamples(0), trigger(TRIGGER_NOW),
+    mask(0), value(0), state(CAPTURE_IDLE), fired(false), head(0), samples(0),
+    triggerSample(0), remaining(0), previous(0), mode(CAPTURE_RAW), postSamples(0),
+    bytes(0), byteDepth(0), tail(0), used(0), preBytes(0), preShare(0),
+    lastRecord(0), baseSample(0) {
+}
+
+void LogicCapture::begin(uint16_t* storage, uint16_t size) {
+  buffer = storage;
+  depth = size;
+  preSamples = size / 2;
+  bytes = (uint8_t*)storage;
+  byteDepth = size <= 0x7FFF ? 2 * size : 0xFFFE;
+  postSamples = 100UL * (size - preSamples);
+  state = CAPTURE_IDLE;
+  head = 0;
+  samples = 0;
+}
+
+void LogicCapture::setTrigger(uint8_t type, uint16_t triggerMask, uint16_t triggerValue) {
+  trigger = type;
+  mask = triggerMask;
+  value = triggerValue;
+}
+
+void LogicCapture::setPreTrigger(uint16_t count) {
+  preSamples = count < depth ? count : depth - 1;
+}
+
+void LogicCapture::setMode(uint8_t captureMode) {
+  mode = captureMode == CAPTURE_RLE ? CAPTURE_RLE : CAPTURE_RAW;
+}
+
+void LogicCapture::arm() {
+  state = CAPTURE_IDLE;
+  head = 0;
+  samples = 0;
+  triggerSample = 0;
+  fired = false;
+  remaining = 0;
+  previous = 0;
+  tail = 0;
+  used = 0;
+  preBytes = 0;
+  preShare = (uint16_t)((uint32_t)byteDepth * preSamples / (depth ? depth : 1));
+  lastRecord = 0;
+  baseSample = 0;
+  if (depth > 0) state = CAPTURE_ARMED;
+}
+
+void LogicCapture::stop() {
+  if (state == CAPTURE_ARMED || state == CAPTURE_TRIGGERED) state = CAPTURE_DONE;
+}
+
+uint16_t LogicCapture::count() const {
+  return samples < depth ? (uint16_t)samples : depth;
+}
+
+uint16_t LogicCapture::word(uint16_t index) const {
+  uint16_t oldest = samples < depth ? 0 : head;
+  uint32_t at = (uint32_t)oldest + index;
+  return buffer[at >= depth ? at - depth : at];
+}
+
+uint16_t LogicCapture::triggerIndex() const {
+  if (!fired) return noTrigger;
+  // The trigger word is this many words before the newest
+  uint32_t back = samples - 1 - triggerSample;
+  return back < count() ? (uint16_t)(count() - 1 - back) : noTrigger;
+}
+
+// ====================
+// RUN-LENGTH RECORDS
+// ====================
+bool LogicCapture::sampleRecord(uint16_t word) {
+  uint32_t now = samples++;
+  bool record = now == 0 || word != previous;
+  bool done = false;
+
+  if (state == CAPTURE_ARMED) {
+    if (triggered(word)) {
+      triggerSample = now;
+      fired = true;
+      preBytes = used;
+      state = CAPTURE_TRIGGERED;
+      record = true;  // The trigger word is always kept
+    }
+  }
+
+  if (record) {
+    if (writeRecord(now - lastRecord, word)) {
+      lastRecord = now;
+    }
+    else {
+      // Full of post-trigger records; this sample is not part of the capture
+      samples = now;
+      done = true;
+    }
+  }
+  if (state == CAPTURE_TRIGGERED && samples - triggerSample >= postSamples) done = true;
+  previous = word;
+  if (done) state = CAPTURE_DONE;
+  return done;
+}
+
+bool LogicCapture::writeRecord(uint32_t delta, uint16_t word) {
+  uint8_t record[7];
+  uint8_t length = 0;
+  do {
+    uint8_t low = delta & 0x7F;
+    delta >>= 7;
+    record[length++] = delta ? low | 0x80 : low;
+  } while (delta);
+  record[length++] = word & 0xFF;
+  record[length++] = word >> 8;
+
+  while (byteDepth - used < length) {
+    // Once triggered only the pre-trigger records above their share may go
+    if (state == CAPTURE_TRIGGERED && preBytes <= preShare) return false;
+    if (used == 0) return false;
+    dropOldestRecord();
+  }
+  uint16_t at = tail + used;
+  if (at >= byteDepth) at -= byteDepth;
+  for (uint8_t i = 0; i < length; i++) {
+    bytes[at] = record[i];
+    if (++at == byteDepth) at = 0;
+  }
+  used += length;
+  return true;
+}
+
+void LogicCapture::dropOldestRecord() {
+  uint32_t delta = 0;
+  uint8_t shift = 0;
+  uint8_t length = 0;
+  uint8_t byte;
+  do {
+    byte = bytes[tail];
+    if (++tail == byteDepth) tail = 0;
+    length++;
+    if (shift < 32) delta |= (uint32_t)(byte & 0x7F) << shift;
+    shift += 7;
+  } while ((byte & 0x80) && length < used);
+  length += 2;
+  tail += 2;
+  if (tail >= byteDepth) tail -= byteDepth;
+  used = length < used ? used - length : 0;
+  preBytes = length < preBytes ? preBytes - length : 0;
+  baseSample += delta;
+}
+
+uint8_t LogicCapture::recordByte(uint16_t index) const {
+  uint32_t at = (uint32_t)tail + index;
+  return bytes[at >= byteDepth ? at - byteDepth : at];
+}
+
+// ====================
+// CAPTURE FRAMES
+// ====================
+static void writeRleCaptureFrame(FrameWriter& writer, const LogicCapture& capture,
+                                 uint32_t rateHz, uint32_t elapsedMicros, uint32_t dropped,
+                                 uint16_t (*convert)(uint16_t word)) {
+  uint16_t length = capture.recordBytes();
+  writer.begin(FRAME_CAPTURE_RLE, rleCaptureHeaderBytes + length);
+  writer.put(captureFrameVersion);
+  writer.put(capture.triggerType());
+  writer.put32(rateHz);
+  writer.put32(elapsedMicros);
+  writer.put32(capture.sampleCount());
+  writer.put32(dropped);
+  writer.put32(capture.firstSample());
+  writer.put32(capture.triggerSampleNumber());
+  writer.put16(length);
+  // Copy the varints, convert the words; records keep their length
+  uint16_t i = 0;
+  while (i < length) {
+    uint8_t byte;
+    do {
+      byte = capture.recordByte(i++);
+      writer.put(byte);
+    } while ((byte & 0x80) && i < length);
+    if (i + 2 > length) break;
+    uint16_t word = capture.recordByte(i) | (uint16_t)capture.recordByte(i + 1) << 8;
+    writer.put16(convert ? convert(word) : word);
+    i += 2;
+  }
+  while (i++ < length) writer.put(0);  // Keep the announced length on damage
+  writer.end();
+}
+
+void writeCaptureFrame(FrameWriter& writer, const LogicCapture& capture,
+                       uint32_t rateHz, uint32_t elapsedMicros, uint32_t dropped,
+                       uint16_t (*convert)(uint16_t word)) {
+  if (capture.captureMode() == CAPTURE_RLE) {
+    writeRleCaptureFrame(writer, capture, rateHz, elapsedMicros, dropped, convert);
+    return;
+  }
+  uint16_t count = capture.count();
+  writer.begin(FRAME_CAPTURE, captureHeaderBytes + 2 * (uint16_t)count);
+  writer.put(captureFrameVersion);
+  writer.put(capture.triggerType());
+  writer.put32(rateHz);
+  writer.put32(elapsedMicros);
+  writer.put32(capture.sampleCount());
+  writer.put32(dropped);
+  writer.put16(count);
+  writer.put16(capture.triggerIndex());
+  for (uint16_t i = 0; i < count; i++) {
+    uint16_t word = capture.word(i);
+    writer.put16(convert ? convert(word) : word);
+  }
+  writer.end();
+}
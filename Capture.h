@@ -0,0 +1,203 @@
+/*
+ * Digital Logic Lab Simulator - Logic Analyzer Capture
+ * A ring buffer of 16-bit sample words filled from a timer interrupt, with
+ * a pre-trigger depth and one trigger condition. Until the trigger fires
+ * the buffer keeps the most recent samples; afterwards it records the
+ * post-trigger depth and stops, so the buffer holds the samples around the
+ * trigger.
+ *
+ * sample() is inline and cheap enough for 100+ kHz ISRs on a 16 MHz AVR.
+ * The class does not care what a word means; the firmware samples the raw
+ * PINA/PINC ports and converts to packed input/output words when dumping.
+ *
+ * In run-length mode the same storage is a byte ring of records
+ *
+ *   varint(samples since the previous record) | word (uint16)
+ *
+ * written only when the word changes (LEB128 varints: 7 bits per byte, high
+ * bit set on all but the last). Slow signals then cost a few bytes per edge
+ * instead of two bytes per sample. The sample that fires the trigger is
+ * always recorded, and after the trigger the oldest records are dropped
+ * only down to the pre-trigger share of the buffer.
+ */
+
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include "Frame.h"
+
+// ====================
+// CAPTURE DEFINITIONS
+// ====================
+enum CaptureTriggerType : uint8_t {
+  TRIGGER_NOW,       // First sample
+  TRIGGER_PATTERN,   // (word & mask) == value
+  TRIGGER_RISING,    // Any bit of mask goes 0 -> 1
+  TRIGGER_FALLING,   // Any bit of mask goes 1 -> 0
+  TRIGGER_COUNTER    // counter == value
+};
+
+enum CaptureState : uint8_t {
+  CAPTURE_IDLE,
+  CAPTURE_ARMED,     // Filling pre-trigger history, checking the trigger
+  CAPTURE_TRIGGERED, // Filling the post-trigger depth
+  CAPTURE_DONE
+};
+
+enum CaptureMode : uint8_t {
+  CAPTURE_RAW,       // One word per sample
+  CAPTURE_RLE        // Run-length records
+};
+
+const uint16_t noTrigger = 0xFFFF;
+const uint32_t noTriggerSample = 0xFFFFFFFF;
+
+// Payload of a FRAME_CAPTURE frame, followed by count sample words
+struct CaptureHeader {
+  uint8_t version;         // captureFrameVersion
+  uint8_t triggerType;
+  uint32_t rateHz;         // Nominal sample rate
+  uint32_t elapsedMicros;  // First to last sample
+  uint32_t samples;        // Samples taken
+  uint32_t dropped;        // Samples the rate called for but never taken
+  uint16_t count;          // Words in the frame
+  uint16_t triggerIndex;   // Word that fired the trigger, or noTrigger
+};
+const uint8_t captureFrameVersion = 1;
+const uint8_t captureHeaderBytes = 22;
+
+// Payload of a FRAME_CAPTURE_RLE frame, followed by the record bytes.
+// Sample numbers count from the first sample after arming.
+struct RleCaptureHeader {
+  uint8_t version;         // captureFrameVersion
+  uint8_t triggerType;
+  uint32_t rateHz;
+  uint32_t elapsedMicros;
+  uint32_t samples;        // Samples taken; the last word lasts to the end
+  uint32_t dropped;
+  uint32_t baseSample;     // The first record's delta counts from here
+  uint32_t triggerSample;  // Or noTriggerSample
+  uint16_t bytes;          // Record bytes in the frame
+};
+const uint8_t rleCaptureHeaderBytes = 28;
+
+// ====================
+// LOGIC CAPTURE
+// ====================
+class LogicCapture {
+public:
+  LogicCapture();
+
+  void begin(uint16_t* buffer, uint16_t depth);
+
+  void setTrigger(uint8_t type, uint16_t mask, uint16_t value);
+  void setPreTrigger(uint16_t samples);  // Clamped below the depth
+  uint16_t preTrigger() const { return preSamples; }
+  uint8_t triggerType() const { return trigger; }
+
+  // Run-length mode keeps recording after the trigger for this many
+  // samples, or until the post-trigger share of the buffer is full
+  void setMode(uint8_t captureMode);
+  uint8_t captureMode() const { return mode; }
+  void setPostTrigger(uint32_t samples) { postSamples = samples ? samples : 1; }
+  uint32_t postTrigger() const { return postSamples; }
+
+  void arm();
+  void stop();  // Ends the capture early; the trigger may not have fired
+
+  // Records one word. Returns true on the sample that completes the capture.
+  inline bool sample(uint16_t word) {
+    if (state != CAPTURE_ARMED && state != CAPTURE_TRIGGERED) return false;
+    if (mode == CAPTURE_RLE) return sampleRecord(word);
+    buffer[head] = word;
+    if (++head == depth) head = 0;
+    samples++;
+
+    bool done = false;
+    if (state == CAPTURE_ARMED) {
+      if (triggered(word)) {
+        triggerSample = samples - 1;
+        fired = true;
+        remaining = depth - preSamples - 1;
+        state = CAPTURE_TRIGGERED;
+        done = remaining == 0;
+      }
+    }
+    else {
+      done = --remaining == 0;
+    }
+    previous = word;
+    if (done) state = CAPTURE_DONE;
+    return done;
+  }
+
+  uint8_t status() const { return state; }
+  uint32_t sampleCount() const { return samples; }
+
+  // After a raw capture: words oldest first, and where the trigger fired
+  uint16_t count() const;
+  uint16_t word(uint16_t index) const;
+  uint16_t triggerIndex() const;
+
+  // After a run-length capture: record bytes oldest first
+  uint16_t recordBytes() const { return used; }
+  uint8_t recordByte(uint16_t index) const;
+  uint32_t firstSample() const { return baseSample; }
+  uint32_t triggerSampleNumber() const { return fired ? triggerSample : noTriggerSample; }
+
+  // Mirrored by the firmware for TRIGGER_COUNTER; one byte so the ISR
+  // never reads it half-written, so trigger values are 0-255
+  volatile uint8_t counter;
+
+private:
+  bool sampleRecord(uint16_t word);
+  bool writeRecord(uint32_t delta, uint16_t word);
+  void dropOldestRecord();
+
+  inline bool triggered(uint16_t word) const {
+    switch (trigger) {
+      case TRIGGER_NOW:     return true;
+      case TRIGGER_PATTERN: return (word & mask) == value;
+      case TRIGGER_RISING:  return samples > 1 && (~previous & word & mask);
+      case TRIGGER_FALLING: return samples > 1 && (previous & ~word & mask);
+      case TRIGGER_COUNTER: return counter == value;
+      default:              return false;
+    }
+  }
+
+  uint16_t* buffer;
+  uint16_t depth;
+  uint16_t preSamples;
+  uint8_t trigger;
+  uint16_t mask;
+  uint16_t value;
+
+  volatile uint8_t state;
+  volatile bool fired;
+  volatile uint16_t head;
+  volatile uint32_t samples;
+  volatile uint32_t triggerSample;
+  uint16_t remaining;
+  uint16_t previous;
+
+  // Run-length mode
+  uint8_t mode;
+  uint32_t postSamples;
+  uint8_t* bytes;          // The buffer as a byte ring
+  uint16_t byteDepth;
+  uint16_t tail;           // Oldest record
+  uint16_t used;
+  uint16_t preBytes;       // Record bytes from before the trigger
+  uint16_t preShare;       // Pre-trigger bytes kept once triggered
+  uint32_t lastRecord;     // Sample of the newest record
+  uint32_t baseSample;
+};
+
+// Writes the finished capture as one FRAME_CAPTURE or FRAME_CAPTURE_RLE
+// frame. convert maps each stored word to the word sent (0 to send them
+// as stored).
+void writeCaptureFrame(FrameWriter& writer, const LogicCapture& capture,
+                       uint32_t rateHz, uint32_t elapsedMicros, uint32_t dropped,
+                       uint16_t (*convert)(uint16_t word));
+
+#endif
@@ -0,0 +1,104 @@
+/*
+ * Digital Logic Lab Simulator - Checkpoints
+ */
+
+#include "Checkpoint.h"
+
+CheckpointBlob::CheckpointBlob() {
+  clear();
+}
+
+void CheckpointBlob::begin(uint8_t circuits) {
+  clear();
+  put(checkpointVersion);
+  put(circuits);
+}
+
+void CheckpointBlob::put(uint8_t byte) {
+  if (used < checkpointBytes) bytes[used] = byte;
+  else overrun = true;
+  used++;
+}
+
+void CheckpointBlob::put16(uint16_t value) {
+  put(value & 0xFF);
+  put(value >> 8);
+}
+
+void CheckpointBlob::put32(uint32_t value) {
+  put16(value & 0xFFFF);
+  put16(value >> 16);
+}
+
+void CheckpointBlob::put64(uint64_t value) {
+  put32((uint32_t)value);
+  put32((uint32_t)(value >> 32));
+}
+
+bool CheckpointBlob::finish() {
+  if (overrun || used + 2 > checkpointBytes) {
+    clear();
+    return false;
+  }
+  uint16_t crc = 0xFFFF;
+  for (uint16_t i = 0; i < used; i++) crc = crc16Update(crc, bytes[i]);
+  put16(crc);
+  return true;
+}
+
+void CheckpointBlob::clear() {
+  used = 0;
+  at = 0;
+  end = 0;
+  overrun = false;
+}
+
+bool CheckpointBlob::store(uint16_t offset, uint8_t byte) {
+  if (offset >= checkpointBytes) return false;
+  bytes[offset] = byte;
+  if (offset >= used) used = offset + 1;
+  return true;
+}
+
+bool CheckpointBlob::open() {
+  overrun = false;
+  if (used < checkpointHeaderBytes + 2 || bytes[0] != checkpointVersion) return false;
+  end = used - 2;
+  uint16_t crc = 0xFFFF;
+  for (uint16_t i = 0; i < end; i++) crc = crc16Update(crc, bytes[i]);
+  if (crc != (uint16_t)(bytes[end] | bytes[end + 1] << 8)) return false;
+  at = checkpointHeaderBytes;
+  return true;
+}
+
+uint8_t CheckpointBlob::get() {
+  if (at >= end) {
+    overrun = true;
+    return 0;
+  }
+  return bytes[at++];
+}
+
+uint16_t CheckpointBlob::get16() {
+  uint16_t low = get();
+  return low | (uint16_t)get() << 8;
+}
+
+uint32_t CheckpointBlob::get32() {
+  uint32_t low = get16();
+  return low | (uint32_t)get16() << 16;
+}
+
+uint64_t CheckpointBlob::get64() {
+  uint64_t low = get32();
+  return low | (uint64_t)get32() << 32;
+}
+
+// ====================
+// CHECKPOINT FRAME
+// ====================
+void writeCheckpointFrame(FrameWriter& writer, const CheckpointBlob& blob) {
+  writer.begin(FRAME_CHECKPOINT, blob.length());
+  for (uint16_t i = 0; i < blob.length(); i++) writer.put(blob.data()[i]);
+  writer.end();
+}
@@ -0,0 +1,74 @@
+/*
+ * Digital Logic Lab Simulator - Checkpoints
+ * A checkpoint is the simulator's whole state as one versioned blob:
+ *
+ *   version (uint8) | circuits (uint8) | fields | CRC-16 (uint16)
+ *
+ * with the CRC as in Frame.h, taken over everything before it, so a blob
+ * typed back in over the console is checked as well as a framed one. The
+ * sketch decides the fields; every one has a fixed size and order per
+ * version, so taking or restoring a checkpoint costs the same whatever the
+ * circuit. circuits is the length of the build's circuit list: a blob from
+ * a build with another list, or another version, is refused.
+ *
+ * writeCheckpointFrame() sends the blob as the payload of one
+ * FRAME_CHECKPOINT frame; it is never larger than checkpointBytes.
+ */
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "Frame.h"
+#include "Memory.h"
+
+// ====================
+// CHECKPOINT DEFINITIONS
+// ====================
+const uint8_t checkpointVersion = 2;   // 2 added the latch node values
+const uint8_t checkpointHeaderBytes = 2;
+
+// ====================
+// CHECKPOINT BLOB
+// ====================
+class CheckpointBlob {
+public:
+  CheckpointBlob();
+
+  // Writing: begin(), the fields, then finish() appends the CRC. finish()
+  // returns false, leaving the blob empty, if the fields did not fit.
+  void begin(uint8_t circuits);
+  void put(uint8_t byte);
+  void put16(uint16_t value);
+  void put32(uint32_t value);
+  void put64(uint64_t value);
+  bool finish();
+
+  // Loading a blob piecewise; the length is the furthest byte stored
+  void clear();
+  bool store(uint16_t offset, uint8_t byte);
+
+  // Reading: open() checks the version and the CRC and moves to the first
+  // field. Reads past the end return 0 and set overran().
+  bool open();
+  uint8_t get();
+  uint16_t get16();
+  uint32_t get32();
+  uint64_t get64();
+  bool overran() const { return overrun; }
+
+  uint8_t version() const { return used ? bytes[0] : 0; }
+  uint8_t circuits() const { return used > 1 ? bytes[1] : 0; }
+  const uint8_t* data() const { return bytes; }
+  uint16_t length() const { return used; }
+
+private:
+  uint8_t bytes[checkpointBytes];
+  uint16_t used;
+  uint16_t at;              // Read position
+  uint16_t end;             // Fields end, before the CRC
+  bool overrun;
+};
+
+void writeCheckpointFrame(FrameWriter& writer, const CheckpointBlob& blob);
+
+#endif
@@ -0,0 +1,84 @@
+/*
+ * Digital Logic Lab Simulator - Clock Domains
+ */
+
+#include "ClockDomain.h"
+
+ClockDomain::ClockDomain()
+  : edges(0), lost(0), kind(CLOCK_HOST), value(0), primed(false), lastLevel(false),
+    nextMillis(0), queued(0) {
+  label[0] = 0;
+}
+
+void ClockDomain::begin(const char* name, uint8_t source, uint16_t setting) {
+  uint8_t length = 0;
+  while (name[length] && length < clockNameLength) {
+    label[length] = name[length];
+    length++;
+  }
+  label[length] = 0;
+  edges = 0;
+  lost = 0;
+  setSource(source, setting);
+}
+
+void ClockDomain::setSource(uint8_t source, uint16_t setting) {
+  kind = source;
+  value = source == CLOCK_TIMER && setting == 0 ? 1 : setting;
+  primed = false;
+  queued = 0;
+}
+
+void ClockDomain::sample(bool level) {
+  if (primed && level && !lastLevel) pulse(1);
+  lastLevel = level;
+  primed = true;
+}
+
+void ClockDomain::tick(uint32_t millis) {
+  if (!primed) {
+    nextMillis = millis + value;
+    primed = true;
+    return;
+  }
+  if ((int32_t)(millis - nextMillis) < 0) return;
+  // Catch up in one step after a long stall; the excess counts as lost
+  uint32_t due = (millis - nextMillis) / value + 1;
+  nextMillis += due * value;
+  pulse(due > 0xFFFF ? 0xFFFF : (uint16_t)due);
+}
+
+void ClockDomain::pulse(uint16_t count) {
+  uint8_t room = clockQueueDepth - queued;
+  uint8_t taken = count < room ? count : room;
+  queued += taken;
+  edges += taken;
+  lost += count - taken;
+}
+
+void ClockDomain::flush() {
+  queued = 0;
+  primed = false;
+}
+
+uint8_t ClockDomain::take() {
+  uint8_t count = queued;
+  queued = 0;
+  return count;
+}
+
+ClockPhase ClockDomain::phase(uint32_t millis) const {
+  ClockPhase phase;
+  phase.pending = queued;
+  phase.primed = primed;
+  phase.level = lastLevel;
+  phase.untilNext = primed && (int32_t)(nextMillis - millis) > 0 ? nextMillis - millis : 0;
+  return phase;
+}
+
+void ClockDomain::resume(const ClockPhase& phase, uint32_t millis) {
+  queued = phase.pending < clockQueueDepth ? phase.pending : clockQueueDepth;
+  primed = phase.primed;
+  lastLevel = phase.level;
+  nextMillis = millis + phase.untilNext;
+}
@@ -0,0 +1,92 @@
+/*
+ * Digital Logic Lab Simulator - Clock Domains
+ * A named clock with its own rising-edge detector and queue of pending
+ * edges, so clocked circuits bound to different domains see independent
+ * clocks. A domain's edges come from one source:
+ *
+ *   CLOCK_PIN        rising edges of a sampled input pin
+ *   CLOCK_TIMER      a software clock, one edge every period
+ *   CLOCK_HOST       pulses requested over serial
+ *   CLOCK_GENERATOR  pulses of the hardware clock generator
+ *
+ * Edges carry nothing but their arrival, so the queue is a count: the
+ * consumer takes every pending edge at once and clocks the circuit that
+ * many times. Past clockQueueDepth pending edges, new ones are counted
+ * as lost.
+ */
+
+#ifndef CLOCK_DOMAIN_H
+#define CLOCK_DOMAIN_H
+
+#include <stdint.h>
+
+// ====================
+// CLOCK DOMAIN DEFINITIONS
+// ====================
+enum ClockSource : uint8_t {
+  CLOCK_PIN,
+  CLOCK_TIMER,
+  CLOCK_HOST,
+  CLOCK_GENERATOR
+};
+
+const uint8_t clockNameLength = 8;
+const uint8_t clockQueueDepth = 32;
+
+// Where a domain is between edges, enough to carry on from there later
+struct ClockPhase {
+  uint8_t pending;          // Edges queued, not yet taken
+  bool primed;              // Edge detector or timer running
+  bool level;               // CLOCK_PIN: level last sampled
+  uint32_t untilNext;       // CLOCK_TIMER: ms to the next edge
+};
+
+// ====================
+// CLOCK DOMAIN
+// ====================
+class ClockDomain {
+public:
+  ClockDomain();
+
+  // setting is the pin for CLOCK_PIN and the period in ms for CLOCK_TIMER.
+  // Names longer than clockNameLength are cut.
+  void begin(const char* name, uint8_t source, uint16_t setting);
+  void setSource(uint8_t source, uint16_t setting);
+
+  const char* name() const { return label; }
+  uint8_t source() const { return kind; }
+  uint16_t setting() const { return value; }
+
+  // CLOCK_PIN: one sample of the pin; a low-to-high change queues an edge
+  void sample(bool level);
+  // CLOCK_TIMER: queues the edges of every period ended by now
+  void tick(uint32_t millis);
+  // Queues edges directly (host pulses, or a hardware clock generator)
+  void pulse(uint16_t count);
+
+  // Drops pending edges; the next sample only primes the edge detector,
+  // so a clock that is already high is not taken for an edge
+  void flush();
+
+  // Pending edges, which are then gone
+  uint8_t take();
+  uint8_t pending() const { return queued; }
+
+  // Checkpoints; the timer phase is kept relative to millis
+  ClockPhase phase(uint32_t millis) const;
+  void resume(const ClockPhase& phase, uint32_t millis);
+
+  uint32_t edges;      // Queued since begin()
+  uint16_t lost;       // Dropped with the queue full
+
+private:
+  char label[clockNameLength + 1];
+  uint8_t kind;
+  uint16_t value;
+  bool primed;
+  bool lastLevel;
+  uint32_t nextMillis;
+  volatile uint8_t queued;
+};
+
+#endif
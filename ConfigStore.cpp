@@ -0,0 +1,106 @@
+/*
+ * Digital Logic Lab Simulator - Configuration Store
+ */
+
+#include "ConfigStore.h"
+#include "Frame.h"
+
+ConfigStore::ConfigStore(StoreRead read, StoreWrite write, uint8_t slots, uint16_t slotBytes)
+  : readByte(read), writeByte(write), slots(slots), slotBytes(slotBytes), newest(slots),
+    lastSequence(0), recordLength(0), target(0), written(0), crc(0xFFFF) {
+}
+
+uint16_t ConfigStore::read16(uint16_t address) const {
+  return readByte(address) | (uint16_t)readByte(address + 1) << 8;
+}
+
+void ConfigStore::write16(uint16_t address, uint16_t value) {
+  writeByte(address, value & 0xFF);
+  writeByte(address + 1, value >> 8);
+}
+
+uint16_t ConfigStore::recordCrc(uint8_t slot, uint16_t length) const {
+  uint16_t base = slot * slotBytes + storeHeaderBytes;
+  uint16_t sum = 0xFFFF;
+  for (uint16_t i = 0; i < length; i++) sum = crc16Update(sum, readByte(base + i));
+  return sum;
+}
+
+bool ConfigStore::begin() {
+  newest = slots;
+  for (uint8_t slot = 0; slot < slots; slot++) {
+    uint16_t base = slot * slotBytes;
+    if (read16(base) != storeMagic) continue;
+    uint16_t sequence = read16(base + 2);
+    uint16_t length = read16(base + 4);
+    if (length > capacity()) continue;
+    // Sequences wrap; newer is ahead by less than half the range
+    if (newest < slots && (int16_t)(sequence - lastSequence) <= 0) continue;
+    if (recordCrc(slot, length) != read16(base + 6)) continue;
+    newest = slot;
+    lastSequence = sequence;
+    recordLength = length;
+  }
+  if (!valid()) recordLength = 0;
+  return valid();
+}
+
+uint8_t ConfigStore::get(uint16_t offset) const {
+  if (!valid() || offset >= recordLength) return 0;
+  return readByte(newest * slotBytes + storeHeaderBytes + offset);
+}
+
+uint16_t ConfigStore::get16(uint16_t offset) const {
+  return get(offset) | (uint16_t)get(offset + 1) << 8;
+}
+
+uint32_t ConfigStore::get32(uint16_t offset) const {
+  return get16(offset) | (uint32_t)get16(offset + 2) << 16;
+}
+
+void ConfigStore::start() {
+  target = valid() ? (newest + 1) % slots : 0;
+  // The slot's old header must not pass for the new record while the
+  // body is half written
+  write16(target * slotBytes, 0xFFFF);
+  written = 0;
+  crc = 0xFFFF;
+}
+
+void ConfigStore::put(uint8_t byte) {
+  if (written < capacity()) {
+    writeByte(target * slotBytes + storeHeaderBytes + written, byte);
+    crc = crc16Update(crc, byte);
+  }
+  written++;
+}
+
+void ConfigStore::put16(uint16_t value) {
+  put(value & 0xFF);
+  put(value >> 8);
+}
+
+void ConfigStore::put32(uint32_t value) {
+  put16(value & 0xFFFF);
+  put16(value >> 16);
+}
+
+bool ConfigStore::commit() {
+  if (written > capacity()) return false;
+  uint16_t base = target * slotBytes;
+  uint16_t sequence = valid() ? lastSequence + 1 : 0;
+  write16(base + 2, sequence);
+  write16(base + 4, written);
+  write16(base + 6, crc);
+  write16(base, storeMagic);
+  newest = target;
+  lastSequence = sequence;
+  recordLength = written;
+  return true;
+}
+
+void ConfigStore::erase() {
+  for (uint8_t slot = 0; slot < slots; slot++) write16(slot * slotBytes, 0xFFFF);
+  newest = slots;
+  recordLength = 0;
+}
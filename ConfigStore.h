@@ -0,0 +1,82 @@
+/*
+ * Digital Logic Lab Simulator - Configuration Store
+ * Keeps one record (the saved configuration) in EEPROM, spread over a
+ * ring of slots so repeated saves wear every slot in turn rather than the
+ * same cells. Each slot is
+ *
+ *   magic (uint16) | sequence (uint16) | length (uint16) | CRC-16 (uint16) | record
+ *
+ * with the CRC as in Frame.h, over the record. A save goes to the slot
+ * after the newest, clears that slot's magic before writing the body and
+ * writes the header last, so a save cut short by a reset leaves the
+ * previous record the newest valid one. begin() picks the
+ * slot with the highest sequence whose CRC checks out.
+ *
+ * The EEPROM is reached through read and write functions, so the store
+ * runs the same on the Mega and against a byte array in host builds.
+ */
+
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+#include <stdint.h>
+
+// ====================
+// STORE DEFINITIONS
+// ====================
+typedef uint8_t (*StoreRead)(uint16_t address);
+typedef void (*StoreWrite)(uint16_t address, uint8_t byte);
+
+const uint16_t storeMagic = 0x4C44;     // "DL"
+const uint8_t storeHeaderBytes = 8;
+
+// ====================
+// CONFIGURATION STORE
+// ====================
+class ConfigStore {
+public:
+  ConfigStore(StoreRead read, StoreWrite write, uint8_t slots, uint16_t slotBytes);
+
+  // Finds the newest valid record; false if there is none
+  bool begin();
+
+  bool valid() const { return newest < slots; }
+  uint8_t slot() const { return newest; }
+  uint16_t sequence() const { return lastSequence; }
+  uint16_t length() const { return recordLength; }
+  uint16_t capacity() const { return slotBytes - storeHeaderBytes; }
+
+  // Byte of the newest record; 0 past its end
+  uint8_t get(uint16_t offset) const;
+  uint16_t get16(uint16_t offset) const;
+  uint32_t get32(uint16_t offset) const;
+
+  // Writing a new record: start(), the bytes, then commit(). commit()
+  // returns false, leaving the previous record, if they did not fit.
+  void start();
+  void put(uint8_t byte);
+  void put16(uint16_t value);
+  void put32(uint32_t value);
+  bool commit();
+
+  // Invalidates every slot
+  void erase();
+
+private:
+  uint16_t read16(uint16_t address) const;
+  void write16(uint16_t address, uint16_t value);
+  uint16_t recordCrc(uint8_t slot, uint16_t length) const;
+
+  StoreRead readByte;
+  StoreWrite writeByte;
+  uint8_t slots;
+  uint16_t slotBytes;
+  uint8_t newest;           // slots when there is no valid record
+  uint16_t lastSequence;
+  uint16_t recordLength;
+  uint8_t target;           // Slot being written
+  uint16_t written;
+  uint16_t crc;
+};
+
+#endif
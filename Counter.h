@@ -0,0 +1,267 @@
+/*
+ * Digital Logic Lab Simulator - Counter Family
+ * Synchronous counters as one template, specialized at compile time:
+ *
+ *   Counter<Width, Modulus, Direction, Encoding>
+ *
+ *   COUNT_BINARY   modulus up to 2^Width (0 picks 2^Width)
+ *   COUNT_BCD      packed decimal digits, Width a multiple of 4, modulus up
+ *                  to 10^(Width / 4) (0 picks that); decade counters
+ *   COUNT_GRAY     binary count read out as its Gray code; one output bit
+ *                  changes per edge (and at the wrap only for 2^Width)
+ *   COUNT_RING     one-hot rotating bit, modulus Width
+ *   COUNT_JOHNSON  twisted ring, modulus 2 * Width
+ *
+ * Each has a synchronous parallel load (of an output word), a count
+ * enable and a ripple carry: edge() returns whether this edge passed the
+ * terminal count with the count enabled, which is the enable of the next
+ * stage when counters are cascaded. The state lives in the smallest
+ * native word holding Width bits, and the wrap, enable and load are
+ * applied as masks rather than branches, so an edge is the same short
+ * straight-line code whatever the inputs.
+ */
+
+#ifndef COUNTER_H
+#define COUNTER_H
+
+#include <stdint.h>
+
+// ====================
+// COUNTER DEFINITIONS
+// ====================
+enum CountDirection : uint8_t {
+  COUNT_UP,
+  COUNT_DOWN
+};
+
+enum CountEncoding : uint8_t {
+  COUNT_BINARY,
+  COUNT_BCD,
+  COUNT_GRAY,
+  COUNT_RING,
+  COUNT_JOHNSON
+};
+
+// Smallest unsigned type with at least Width bits, up to 64
+template <uint8_t Bytes> struct WordBytes;
+template <> struct WordBytes<1> { typedef uint8_t Type; };
+template <> struct WordBytes<2> { typedef uint16_t Type; };
+template <> struct WordBytes<4> { typedef uint32_t Type; };
+template <> struct WordBytes<8> { typedef uint64_t Type; };
+
+template <uint8_t Width>
+struct BitWord {
+  static_assert(Width >= 1 && Width <= 64, "1 to 64 bits");
+  typedef typename WordBytes<(Width <= 8 ? 1 : Width <= 16 ? 2 : Width <= 32 ? 4 : 8)>::Type Type;
+  static constexpr Type mask = (Type)(~(uint64_t)0 >> (64 - Width));
+};
+
+constexpr uint64_t powerOf10(uint8_t exponent) {
+  return exponent ? 10 * powerOf10(exponent - 1) : 1;
+}
+
+constexpr uint64_t toBcd(uint64_t value) {
+  return value < 10 ? value : toBcd(value / 10) << 4 | value % 10;
+}
+
+// Every bit of a nibble pattern, e.g. repeatNibble(0x6, 8) = 0x66
+constexpr uint64_t repeatNibble(uint8_t nibble, uint8_t width) {
+  return width < 4 ? 0 : (repeatNibble(nibble, width - 4) << 4) | nibble;
+}
+
+// ====================
+// ENCODINGS
+// ====================
+// Each encoding gives the first and last state counting up, the step in
+// each direction away from the wrap, whether the counter wraps by
+// compare (ring and Johnson wrap by themselves) and the conversion
+// between the state and the output word.
+template <uint8_t Width, uint32_t Modulus, uint8_t Encoding>
+struct CounterCode;
+
+template <uint8_t Width, uint32_t Modulus>
+struct CounterCode<Width, Modulus, COUNT_BINARY> {
+  typedef typename BitWord<Width>::Type Word;
+  // A full 2^Width count wraps by itself in the masked add
+  static constexpr bool wraps = Modulus != 0 && Modulus - 1 != BitWord<Width>::mask;
+  static constexpr Word first = 0;
+  static constexpr Word last = Modulus ? (Word)(Modulus - 1) : BitWord<Width>::mask;
+  static Word up(Word state) { return (Word)(state + 1) & BitWord<Width>::mask; }
+  static Word down(Word state) { return (Word)(state - 1) & BitWord<Width>::mask; }
+  static Word output(Word state) { return state; }
+  static Word fromOutput(Word word) { return word; }
+};
+
+template <uint8_t Width, uint32_t Modulus>
+struct CounterCode<Width, Modulus, COUNT_GRAY> : CounterCode<Width, Modulus, COUNT_BINARY> {
+  typedef typename BitWord<Width>::Type Word;
+  static Word output(Word state) { return state ^ (state >> 1); }
+  static Word fromOutput(Word word) {
+    for (uint8_t shift = 1; shift < Width; shift <<= 1) word ^= word >> shift;
+    return word;
+  }
+};
+
+template <uint8_t Width, uint32_t Modulus>
+struct CounterCode<Width, Modulus, COUNT_BCD> {
+  static_assert(Width % 4 == 0, "BCD counters take whole digits");
+  typedef typename BitWord<Width>::Type Word;
+  static constexpr bool wraps = true;
+  static constexpr Word first = 0;
+  static constexpr Word last = (Word)toBcd((Modulus ? Modulus : powerOf10(Width / 4)) - 1);
+  // Packed BCD add of 1: add 6 to every digit so a 9 carries, then take
+  // the 6 back from the digits that did not carry. The top digit never
+  // carries below the last state, which wraps instead. A loaded digit
+  // above 9 steps on through the hex values and carries at 0xF, so the
+  // count finds its way back into range.
+  static Word up(Word state) {
+    Word biased = state + (Word)repeatNibble(0x6, Width);
+    Word sum = biased + 1;
+    Word carried = sum ^ biased ^ 1;
+    Word kept = ~carried & (Word)(repeatNibble(0x1, Width) & ~(uint64_t)1);
+    return (Word)(sum - (Word)(kept >> 2 | kept >> 3) - (Word)((uint64_t)6 << (Width - 4))) &
+           BitWord<Width>::mask;
+  }
+  static Word down(Word state) {
+    // Digits that borrowed read 0xF; take 6 from each to make them 9
+    Word difference = state - 1;
+    Word borrowed = difference & difference >> 1 & difference >> 2 & difference >> 3 &
+                    (Word)repeatNibble(0x1, Width);
+    return (Word)(difference - (Word)(borrowed << 2 | borrowed << 1)) & BitWord<Width>::mask;
+  }
+  static Word output(Word state) { return state; }
+  static Word fromOutput(Word word) { return word; }
+};
+
+template <uint8_t Width, uint32_t Modulus>
+struct CounterCode<Width, Modulus, COUNT_RING> {
+  static_assert(Modulus == 0 || Modulus == Width, "a ring counter has Width states");
+  typedef typename BitWord<Width>::Type Word;
+  static constexpr bool wraps = false;
+  static constexpr Word first = 1;
+  static constexpr Word last = (Word)1 << (Width - 1);
+  static Word up(Word state) {
+    return (Word)(state << 1 | state >> (Width - 1)) & BitWord<Width>::mask;
+  }
+  static Word down(Word state) {
+    return (Word)(state >> 1 | state << (Width - 1)) & BitWord<Width>::mask;
+  }
+  static Word output(Word state) { return state; }
+  // A load keeps only the lowest set bit (the first state if none), so a
+  // word that is not one-hot cannot lock the ring up
+  static Word fromOutput(Word word) {
+    Word lowest = word & (Word)(0 - word);
+    return lowest | (Word)(lowest == 0);
+  }
+};
+
+template <uint8_t Width, uint32_t Modulus>
+struct CounterCode<Width, Modulus, COUNT_JOHNSON> {
+  static_assert(Modulus == 0 || Modulus == 2 * Width, "a Johnson counter has 2 * Width states");
+  typedef typename BitWord<Width>::Type Word;
+  static constexpr bool wraps = false;
+  static constexpr Word first = 0;
+  static constexpr Word last = (Word)1 << (Width - 1);
+  static Word up(Word state) {
+    return (Word)(state << 1 | (~state >> (Width - 1) & 1)) & BitWord<Width>::mask;
+  }
+  static Word down(Word state) {
+    return (Word)(state >> 1 | (~state & 1) << (Width - 1)) & BitWord<Width>::mask;
+  }
+  static Word output(Word state) { return state; }
+  // The states are the ones run up from bit 0 (0001, 0011, ...) and the
+  // ones run down from the top bit (1110, 1100, ...). A load of any other
+  // word keeps its run of ones from bit 0, which is a state, so an
+  // illegal pattern never circulates.
+  static Word fromOutput(Word word) {
+    Word inverse = ~word & BitWord<Width>::mask;
+    bool valid = lowRun(word) == word || lowRun(inverse) == inverse;
+    return valid ? word : lowRun(word);
+  }
+
+private:
+  // The ones from bit 0 up to the first zero
+  static Word lowRun(Word word) { return word & (Word)~(Word)(word + 1); }
+};
+
+// ====================
+// COUNTER
+// ====================
+template <uint8_t Width, uint32_t Modulus = 0, uint8_t Direction = COUNT_UP,
+          uint8_t Encoding = COUNT_BINARY>
+class Counter {
+public:
+  typedef CounterCode<Width, Modulus, Encoding> Code;
+  typedef typename BitWord<Width>::Type Word;
+
+  Counter() { reset(); }
+
+  // Asynchronous clear to the first state (the last one counting down)
+  void reset() { state = start; }
+
+  // One rising clock edge. A load takes the output word from data and
+  // beats the count; a count needs enable. Returns the ripple carry. A
+  // load past the last state (a BCD digit above 9, or a binary word at
+  // or over the modulus) wraps to the start on the next count, and
+  // counting up it gives the carry as the terminal count would.
+  bool edge(bool enable, bool load, Word data) {
+    bool carry = enable & !load & atTerminal();
+    Word next = Code::wraps ? select(state == terminal || beyondLast(), start, step(state))
+                            : step(state);
+    next = select(enable, next, state);
+    state = select(load, Code::fromOutput(data & BitWord<Width>::mask), next);
+    return carry;
+  }
+
+  Word value() const { return Code::output(state); }
+
+  // At the terminal count: the carry the next enabled edge gives
+  bool terminalCount() const { return atTerminal(); }
+
+private:
+  static constexpr Word start = Direction == COUNT_UP ? Code::first : Code::last;
+  static constexpr Word terminal = Direction == COUNT_UP ? Code::last : Code::first;
+
+  // Only the compare-wrapped codes have states past the last one
+  bool beyondLast() const { return Code::wraps && state > Code::last; }
+
+  bool atTerminal() const {
+    return state == terminal || (Direction == COUNT_UP && beyondLast());
+  }
+
+  static Word step(Word value) {
+    return Direction == COUNT_UP ? Code::up(value) : Code::down(value);
+  }
+
+  // when ? a : b, as masks
+  static Word select(bool when, Word a, Word b) {
+    Word pick = (Word)0 - (Word)when;
+    return (a & pick) | (b & ~pick);
+  }
+
+  Word state;
+};
+
+// One loop pass of a counter: asynchronous reset, or on a rising edge a
+// load or count. carry is set when the edge passed the terminal count.
+struct CounterControl {
+  bool reset;
+  bool edge;
+  bool enable;
+  bool load;
+  uint64_t data;
+  bool carry;
+};
+
+template <typename CounterType>
+uint64_t runCounter(CounterType& counter, CounterControl& control) {
+  control.carry = false;
+  if (control.reset) counter.reset();
+  else if (control.edge) {
+    control.carry = counter.edge(control.enable, control.load,
+                                 (typename CounterType::Word)control.data);
+  }
+  return counter.value();
+}
+
+#endif
@@ -0,0 +1,56 @@
+/*
+ * Digital Logic Lab Simulator - Binary Serial Frames
+ */
+
+#include "Frame.h"
+
+uint16_t crc16Update(uint16_t crc, uint8_t byte) {
+  crc ^= (uint16_t)byte << 8;
+  for (uint8_t i = 0; i < 8; i++) {
+    crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+  }
+  return crc;
+}
+
+uint8_t varintBytes(uint32_t value) {
+  uint8_t count = 1;
+  while (value >>= 7) count++;
+  return count;
+}
+
+void FrameWriter::begin(uint8_t type, uint16_t length) {
+  sink(frameSync0);
+  sink(frameSync1);
+  crc = 0xFFFF;
+  put(type);
+  put16(length);
+}
+
+void FrameWriter::put(uint8_t byte) {
+  crc = crc16Update(crc, byte);
+  sink(byte);
+}
+
+void FrameWriter::put16(uint16_t value) {
+  put(value & 0xFF);
+  put(value >> 8);
+}
+
+void FrameWriter::put32(uint32_t value) {
+  put16(value & 0xFFFF);
+  put16(value >> 16);
+}
+
+void FrameWriter::putVarint(uint32_t value) {
+  while (value > 0x7F) {
+    put((value & 0x7F) | 0x80);
+    value >>= 7;
+  }
+  put(value);
+}
+
+void FrameWriter::end() {
+  uint16_t sum = crc;
+  sink(sum & 0xFF);
+  sink(sum >> 8);
+}
@@ -0,0 +1,64 @@
+/*
+ * Digital Logic Lab Simulator - Binary Serial Frames
+ * Bulk data (captures, statistics) leaves the Mega as binary frames mixed
+ * into the text console. A frame is
+ *
+ *   0xA5 0x5A | type | length (uint16) | payload | CRC-16 (uint16)
+ *
+ * with multi-byte fields little-endian and the CRC (CCITT, initial 0xFFFF)
+ * taken over type, length and payload. Receivers resynchronize on the two
+ * sync bytes and drop frames whose CRC does not match. Varints are LEB128:
+ * 7 bits per byte, least significant first, high bit set on all but the
+ * last byte.
+ */
+
+#ifndef FRAME_H
+#define FRAME_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ====================
+// FRAME DEFINITIONS
+// ====================
+const uint8_t frameSync0 = 0xA5;
+const uint8_t frameSync1 = 0x5A;
+const uint8_t frameHeaderBytes = 5;  // Sync, type, length
+const uint8_t frameTrailerBytes = 2; // CRC
+
+enum FrameType : uint8_t {
+  FRAME_CAPTURE = 1,      // LogicCapture buffer, see Capture.h
+  FRAME_CAPTURE_RLE = 2,  // LogicCapture run-length records
+  FRAME_TELEMETRY = 3,    // TelemetryStream events, see Telemetry.h
+  FRAME_STATS = 4,        // PhaseProfile statistics, see Profile.h
+  FRAME_TRACE = 5,        // TraceBuffer events, see Trace.h
+  FRAME_LATENCY = 6,      // LatencyResults histograms, see Latency.h
+  FRAME_CHECKPOINT = 7    // CheckpointBlob, see Checkpoint.h
+};
+
+uint16_t crc16Update(uint16_t crc, uint8_t byte);
+uint8_t varintBytes(uint32_t value);
+
+// ====================
+// FRAME WRITER
+// ====================
+// Streams one frame at a time to a byte sink (Serial.write on the Mega)
+class FrameWriter {
+public:
+  typedef void (*Sink)(uint8_t byte);
+
+  explicit FrameWriter(Sink sink) : sink(sink), crc(0xFFFF) {}
+
+  void begin(uint8_t type, uint16_t length);
+  void put(uint8_t byte);
+  void put16(uint16_t value);
+  void put32(uint32_t value);
+  void putVarint(uint32_t value);
+  void end();
+
+private:
+  Sink sink;
+  uint16_t crc;
+};
+
+#endif
@@ -0,0 +1,74 @@
+/*
+ * Digital Logic Lab Simulator - FSM Engine
+ */
+
+#include "Fsm.h"
+
+FsmMachine::FsmMachine() : transitions(0), read(0), inputMask(0), current(0), latched(0) {
+  spec.entries = 0;
+  spec.states = 0;
+  spec.inputBits = 0;
+  spec.outputBits = 0;
+  spec.kind = FSM_MOORE;
+  spec.resetState = 0;
+  spec.resetOutput = 0;
+}
+
+bool FsmMachine::begin(const FsmTable& table, FsmRead reader) {
+  if (!table.entries || table.states == 0 || table.states > fsmMaxStates ||
+      table.inputBits > fsmMaxInputBits || table.outputBits == 0 || table.outputBits > 8 ||
+      table.kind > FSM_MEALY || table.resetState >= table.states) {
+    return false;
+  }
+  uint32_t count = fsmTableEntries(table.states, table.inputBits);
+  for (uint32_t i = 0; i < count; i++) {
+    uint16_t value = reader ? reader(table.entries + i) : table.entries[i];
+    if (fsmNext(value) >= table.states) return false;
+  }
+  spec = table;
+  read = reader;
+  inputMask = (uint8_t)((1u << table.inputBits) - 1);
+  transitions = 0;
+  reset();
+  return true;
+}
+
+void FsmMachine::reset() {
+  current = spec.resetState;
+  latched = spec.resetOutput;
+}
+
+bool FsmMachine::resume(uint8_t state, uint8_t latchedOutput) {
+  if (state >= spec.states) {
+    reset();
+    return false;
+  }
+  current = state;
+  latched = latchedOutput;
+  return true;
+}
+
+void FsmMachine::setResetOutput(uint8_t output) {
+  spec.resetOutput = output;
+  if (transitions == 0 && current == spec.resetState) latched = output;
+}
+
+uint16_t FsmMachine::entry(uint8_t inputs) const {
+  // At most 255 << 8 | 255, so the index fits 16 bits
+  const uint16_t* at = spec.entries + ((uint16_t)current << spec.inputBits | (inputs & inputMask));
+  return read ? read(at) : *at;
+}
+
+void FsmMachine::clock(uint8_t inputs) {
+  if (!spec.entries) return;
+  uint16_t value = entry(inputs);
+  current = fsmNext(value);
+  latched = fsmOutput(value);
+  transitions++;
+}
+
+uint8_t FsmMachine::output(uint8_t inputs) const {
+  if (!spec.entries) return 0;
+  uint8_t word = spec.kind == FSM_MEALY ? fsmOutput(entry(inputs)) : latched;
+  return spec.outputBits == 8 ? word : word & ((1u << spec.outputBits) - 1);
+}
@@ -0,0 +1,103 @@
+/*
+ * Digital Logic Lab Simulator - FSM Engine
+ * Table-driven Mealy/Moore state machines for clocked circuits: flip-flops,
+ * counters, sequence detectors or any table loaded over serial. A table has
+ * one row per state and one entry per input combination:
+ *
+ *   entries[state << inputBits | inputs] = next state | output word << 8
+ *
+ * so a clock edge is a single lookup that gives both the next state and
+ * the output word. In a Moore machine the output is that of the next state
+ * and is latched on the edge; in a Mealy machine it is the output while in
+ * the state with those inputs, so output() looks it up again as the inputs
+ * change between edges. Up to 256 states and 8 input bits.
+ *
+ * Tables may sit in SRAM or in flash: begin() takes an optional function
+ * that reads one entry (pgm_read_word on the Mega), so the engine itself
+ * never touches program memory. Flash tables must lie in the low 64 KB.
+ */
+
+#ifndef FSM_H
+#define FSM_H
+
+#include <stdint.h>
+
+// ====================
+// FSM DEFINITIONS
+// ====================
+enum FsmKind : uint8_t {
+  FSM_MOORE,
+  FSM_MEALY
+};
+
+const uint16_t fsmMaxStates = 256;
+const uint8_t fsmMaxInputBits = 8;
+
+constexpr uint16_t fsmEntry(uint8_t next, uint8_t output) {
+  return next | (uint16_t)output << 8;
+}
+
+inline uint8_t fsmNext(uint16_t entry) { return entry & 0xFF; }
+inline uint8_t fsmOutput(uint16_t entry) { return entry >> 8; }
+
+struct FsmTable {
+  const uint16_t* entries;  // states << inputBits entries
+  uint16_t states;          // 1..256
+  uint8_t inputBits;        // 0..8, taken from the low bits of the input word
+  uint8_t outputBits;       // 1..8 output pins driven
+  uint8_t kind;
+  uint8_t resetState;
+  uint8_t resetOutput;      // Moore output in the reset state
+};
+
+inline uint32_t fsmTableEntries(uint16_t states, uint8_t inputBits) {
+  return (uint32_t)states << inputBits;
+}
+
+typedef uint16_t (*FsmRead)(const uint16_t* entry);
+
+// ====================
+// FSM MACHINE
+// ====================
+class FsmMachine {
+public:
+  FsmMachine();
+
+  // Checks the shape and every next state, then resets. read is null for
+  // tables in SRAM. Returns false, keeping the previous table, if invalid.
+  bool begin(const FsmTable& table, FsmRead read = 0);
+
+  void reset();
+
+  // Rising clock edge: takes the transition for these inputs
+  void clock(uint8_t inputs);
+
+  // Output word for these inputs; only Mealy machines look at them
+  uint8_t output(uint8_t inputs) const;
+
+  // Picks up where state() and latchedOutput() of the same table left
+  // off; resets instead, returning false, if the state is out of range
+  bool resume(uint8_t state, uint8_t latchedOutput);
+
+  // Takes a new Moore reset output after the table's entries were
+  // edited in place; a machine still in its reset state shows it now
+  void setResetOutput(uint8_t output);
+
+  bool loaded() const { return spec.entries != 0; }
+  uint8_t state() const { return current; }
+  uint8_t latchedOutput() const { return latched; }
+  const FsmTable& table() const { return spec; }
+
+  uint32_t transitions;     // Clock edges taken since begin()
+
+private:
+  uint16_t entry(uint8_t inputs) const;
+
+  FsmTable spec;
+  FsmRead read;
+  uint8_t inputMask;
+  uint8_t current;
+  uint8_t latched;          // Moore output since the last edge
+};
+
+#endif
@@ -0,0 +1,76 @@
+/*
+ * Digital Logic Lab Simulator - Circuit Instances
+ */
+
+#include "Instances.h"
+
+static uint8_t rangeMask(uint8_t shift, uint8_t bits) {
+  return (uint8_t)(((1u << bits) - 1) << shift);
+}
+
+InstanceBank::InstanceBank() : used(0) {
+}
+
+CircuitInstance* InstanceBank::add(uint8_t circuit, uint8_t kind, uint8_t inputShift,
+                                   uint8_t inputBits, uint8_t outputShift, uint8_t outputBits,
+                                   uint8_t clock) {
+  if (used == circuitInstances || outputBits == 0) return 0;
+  if (inputShift + inputBits > 8 || outputShift + outputBits > 8) return 0;
+  if (kind == INSTANCE_TABLE && inputBits > instanceTableInputs) return 0;
+  if (outputMask() & rangeMask(outputShift, outputBits)) return 0;
+
+  CircuitInstance& added = instances[used++];
+  added.circuit = circuit;
+  added.kind = kind;
+  added.inputShift = inputShift;
+  added.inputBits = inputBits;
+  added.outputShift = outputShift;
+  added.outputBits = outputBits;
+  added.clock = clock;
+  added.enabled = true;
+  for (uint8_t i = 0; i < instanceTableEntries; i++) added.table[i] = 0;
+  added.machine = FsmMachine();
+  return &added;
+}
+
+bool InstanceBank::remove(uint8_t index) {
+  if (index >= used) return false;
+  for (uint8_t i = index; i + 1 < used; i++) instances[i] = instances[i + 1];
+  used--;
+  return true;
+}
+
+void InstanceBank::reset(uint8_t index) {
+  if (index < used && instances[index].kind == INSTANCE_FSM) instances[index].machine.reset();
+}
+
+void InstanceBank::resetAll() {
+  for (uint8_t i = 0; i < used; i++) reset(i);
+}
+
+uint8_t InstanceBank::evaluate(uint8_t inputWord, const uint8_t* edges) {
+  uint8_t word = 0;
+  for (uint8_t i = 0; i < used; i++) {
+    CircuitInstance& instance = instances[i];
+    if (!instance.enabled) continue;
+    uint8_t inputs = (inputWord >> instance.inputShift) & (uint8_t)((1u << instance.inputBits) - 1);
+    uint8_t outputs;
+    if (instance.kind == INSTANCE_TABLE) {
+      outputs = instance.table[inputs];
+    }
+    else {
+      for (uint8_t n = edges[instance.clock]; n > 0; n--) instance.machine.clock(inputs);
+      outputs = instance.machine.output(inputs);
+    }
+    word |= (outputs << instance.outputShift) & rangeMask(instance.outputShift, instance.outputBits);
+  }
+  return word;
+}
+
+uint8_t InstanceBank::outputMask() const {
+  uint8_t mask = 0;
+  for (uint8_t i = 0; i < used; i++) {
+    mask |= rangeMask(instances[i].outputShift, instances[i].outputBits);
+  }
+  return mask;
+}
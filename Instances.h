@@ -0,0 +1,83 @@
+/*
+ * Digital Logic Lab Simulator - Circuit Instances
+ * Several circuits at once, each on its own slice of the packed I/O
+ * words: an instance reads inputBits inputs from bit inputShift of the
+ * input word and drives outputBits outputs from bit outputShift of the
+ * output word. One evaluate() pass runs every enabled instance on the
+ * same input word and assembles the whole output word.
+ *
+ *   INSTANCE_TABLE  combinational; a truth table over its inputs, at most
+ *                   instanceTableInputs of them, filled in by the caller
+ *   INSTANCE_FSM    clocked; its own FsmMachine, stepped once per pending
+ *                   edge of its clock domain
+ *
+ * Output ranges may not overlap. Input ranges may, so instances can share
+ * a signal. A disabled instance drives 0 and ignores its clock.
+ */
+
+#ifndef INSTANCES_H
+#define INSTANCES_H
+
+#include "Fsm.h"
+#include "Memory.h"
+
+// ====================
+// INSTANCE DEFINITIONS
+// ====================
+enum InstanceKind : uint8_t {
+  INSTANCE_TABLE,
+  INSTANCE_FSM
+};
+
+const uint8_t instanceTableInputs = 5;
+const uint8_t instanceTableEntries = 1 << instanceTableInputs;
+
+struct CircuitInstance {
+  uint8_t circuit;          // The caller's circuit number
+  uint8_t kind;
+  uint8_t inputShift;
+  uint8_t inputBits;
+  uint8_t outputShift;
+  uint8_t outputBits;
+  uint8_t clock;            // Clock domain (INSTANCE_FSM)
+  bool enabled;
+  uint8_t table[instanceTableEntries];
+  FsmMachine machine;
+};
+
+// ====================
+// INSTANCE BANK
+// ====================
+class InstanceBank {
+public:
+  InstanceBank();
+
+  void clear() { used = 0; }
+
+  // Adds an enabled instance; returns it, or 0 when the bank is full or
+  // the ranges do not fit the 8-bit words or overlap another's outputs.
+  // The caller then fills in the table or begins the machine.
+  CircuitInstance* add(uint8_t circuit, uint8_t kind, uint8_t inputShift, uint8_t inputBits,
+                       uint8_t outputShift, uint8_t outputBits, uint8_t clock);
+  bool remove(uint8_t index);
+
+  uint8_t count() const { return used; }
+  CircuitInstance& instance(uint8_t index) { return instances[index]; }
+  const CircuitInstance& instance(uint8_t index) const { return instances[index]; }
+
+  void reset(uint8_t index);
+  void resetAll();
+
+  // One pass; edges[d] is the number of edges domain d gave since the last
+  // pass. Returns the output word.
+  uint8_t evaluate(uint8_t inputWord, const uint8_t* edges);
+
+  // Output bits some instance drives
+  uint8_t outputMask() const;
+
+private:
+  CircuitInstance instances[circuitInstances];
+  uint8_t used;
+};
+
+#endif
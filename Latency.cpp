@@ -0,0 +1,68 @@
+/*
+ * Digital Logic Lab Simulator - Loopback Latency
+ */
+
+#include "Latency.h"
+
+LatencyResults::LatencyResults() {
+  clear();
+}
+
+void LatencyResults::clear() {
+  used = 0;
+  active = latencySlots;
+}
+
+void LatencyResults::select(uint8_t circuit) {
+  for (uint8_t i = 0; i < used; i++) {
+    if (slots[i].circuit == circuit) {
+      active = i;
+      return;
+    }
+  }
+  if (used < latencySlots) {
+    active = used++;
+  }
+  else {
+    active = 0;
+    for (uint8_t i = 1; i < used; i++) {
+      if (slots[i].stats.count + slots[i].timeouts <
+          slots[active].stats.count + slots[active].timeouts) active = i;
+    }
+  }
+  slots[active].circuit = circuit;
+  slots[active].timeouts = 0;
+  clearStats(slots[active].stats);
+}
+
+void LatencyResults::addLatency(uint32_t cycles) {
+  if (active < used) addCycles(slots[active].stats, cycles);
+}
+
+void LatencyResults::addTimeout() {
+  if (active < used) slots[active].timeouts++;
+}
+
+// ====================
+// LATENCY FRAME
+// ====================
+void writeLatencyFrame(FrameWriter& writer, const LatencyResults& results,
+                       uint32_t cyclesPerSecond) {
+  uint16_t length = 7;
+  for (uint8_t i = 0; i < results.count(); i++) {
+    const LatencySlot& slot = results.slot(i);
+    length += 1 + varintBytes(slot.timeouts) + statsBytes(slot.stats);
+  }
+  writer.begin(FRAME_LATENCY, length);
+  writer.put32(cyclesPerSecond);
+  writer.put(results.count());
+  writer.put(profileBuckets);
+  writer.put(profileBucketShift);
+  for (uint8_t i = 0; i < results.count(); i++) {
+    const LatencySlot& slot = results.slot(i);
+    writer.put(slot.circuit);
+    writer.putVarint(slot.timeouts);
+    putStats(writer, slot.stats);
+  }
+  writer.end();
+}
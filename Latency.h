@@ -0,0 +1,62 @@
+/*
+ * Digital Logic Lab Simulator - Loopback Latency
+ * Input-to-output latency histograms, one per circuit under test. A
+ * stimulus edge is driven into a circuit input through a loopback wire
+ * (or a virtual pin in host builds), the resulting output edge is
+ * timestamped, and the difference in cycles lands in the circuit's
+ * histogram; trials where the output never moved count as timeouts.
+ * The statistics are PhaseStats, so buckets match the phase profile.
+ *
+ * writeLatencyFrame() sends every circuit tested as one FRAME_LATENCY
+ * frame:
+ *
+ *   cycles per second (uint32) | circuits (uint8) | buckets (uint8) | shift (uint8)
+ *   circuits x [ circuit number (uint8) | varint timeouts | stats as in Profile.h ]
+ */
+
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include "Profile.h"
+
+// ====================
+// LATENCY DEFINITIONS
+// ====================
+const uint8_t latencySlots = 4;          // Circuits kept at once
+
+struct LatencySlot {
+  uint8_t circuit;
+  uint32_t timeouts;
+  PhaseStats stats;
+};
+
+// ====================
+// LATENCY RESULTS
+// ====================
+class LatencyResults {
+public:
+  LatencyResults();
+
+  void clear();
+
+  // Results go to this circuit's slot; a new circuit takes a free slot or
+  // the one with the fewest trials
+  void select(uint8_t circuit);
+
+  void addLatency(uint32_t cycles);
+  void addTimeout();
+
+  uint8_t count() const { return used; }
+  const LatencySlot& slot(uint8_t index) const { return slots[index]; }
+  const LatencySlot* current() const { return active < used ? &slots[active] : 0; }
+
+private:
+  LatencySlot slots[latencySlots];
+  uint8_t used;
+  uint8_t active;
+};
+
+void writeLatencyFrame(FrameWriter& writer, const LatencyResults& results,
+                       uint32_t cyclesPerSecond);
+
+#endif
@@ -0,0 +1,42 @@
+/*
+ * Digital Logic Lab Simulator - Memory Budget
+ */
+
+#include "Memory.h"
+#include "Aig.h"
+#include "Capture.h"
+#include "Checkpoint.h"
+#include "Fsm.h"
+#include "Instances.h"
+#include "Latency.h"
+#include "Netlist.h"
+#include "Profile.h"
+#include "Telemetry.h"
+#include "Trace.h"
+
+static void setUsage(MemoryUsage& usage, const char* name, uint32_t bytes, uint16_t budget) {
+  usage.name = name;
+  usage.bytes = bytes > 0xFFFF ? 0xFFFF : (uint16_t)bytes;
+  usage.budget = budget;
+}
+
+void subsystemMemory(MemoryUsage* usage, uint8_t config) {
+  setUsage(usage[MEMORY_CAPTURE], "capture",
+           captureDepth * sizeof(uint16_t) + sizeof(LogicCapture), 2304);
+  setUsage(usage[MEMORY_TELEMETRY], "telemetry",
+           telemetryQueueDepth * sizeof(TelemetryEvent) + sizeof(TelemetryStream), 640);
+  setUsage(usage[MEMORY_NETLIST], "netlist",
+           netlistArenaBytes + loweredGateCount * sizeof(NetlistGate) + sizeof(Netlist) +
+           sizeof(AigStats), 1024);
+  setUsage(usage[MEMORY_FSM], "fsm",
+           fsmRamEntries * sizeof(uint16_t) + sizeof(FsmMachine) + sizeof(FsmTable), 640);
+
+  uint32_t profiling = 0;
+  if (config & MEMORY_PROFILE) profiling += sizeof(PhaseProfile);
+  if (config & MEMORY_TRACE) profiling += traceDepth * sizeof(TraceEvent) + sizeof(TraceBuffer);
+  setUsage(usage[MEMORY_PROFILING], "profiling", profiling, 1280);
+
+  setUsage(usage[MEMORY_LATENCY], "latency", sizeof(LatencyResults), 512);
+  setUsage(usage[MEMORY_INSTANCES], "instances", sizeof(InstanceBank), 512);
+  setUsage(usage[MEMORY_CHECKPOINT], "checkpoint", sizeof(CheckpointBlob), 448);
+}
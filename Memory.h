@@ -0,0 +1,77 @@
+/*
+ * Digital Logic Lab Simulator - Memory Budget
+ * The Mega's 8 KB of SRAM holds the globals, the heap the String commands
+ * allocate from and the stack, growing down towards the heap. The buffer
+ * depths of the subsystems live here, next to a budget for each, so the
+ * sketch and the host agree on what every subsystem may take:
+ *
+ *   - subsystemMemory() lists each subsystem's static bytes in a build
+ *     configuration (PHASE_PROFILE and PHASE_TRACE add buffers);
+ *   - the sketch's 'mem' command prints them with the whole static image
+ *     (.data + .bss), the stack high-water mark (the stack is painted at
+ *     boot) and the heap's free list;
+ *   - host/mem_budget checks every configuration, and the .data and .bss
+ *     of the built sketch, and fails on anything over budget.
+ *
+ * Subsystem sizes are sizeof() on the compiler at hand, so a host build
+ * counts wider pointers and ints than the AVR does and errs on the large
+ * side. They leave out everything else static: the other globals, the
+ * core's Serial buffers and any string literal not kept in flash with
+ * F(), which the AVR copies into .data. Only the image's own section
+ * sizes, against staticBudget, account for those.
+ */
+
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include <stdint.h>
+
+// ====================
+// BUFFER DEPTHS
+// ====================
+const uint16_t captureDepth = 1024;      // Logic analyzer words
+const uint8_t telemetryQueueDepth = 64;  // Telemetry events between drains
+const uint8_t traceDepth = 64;           // Trace events between drains
+const uint16_t netlistArenaBytes = 512;  // Netlist engine and lowering scratch
+const uint8_t loweredGateCount = 32;     // Gates of an AIG-lowered circuit
+const uint16_t fsmRamEntries = 256;      // State table entries loaded over serial
+const uint8_t circuitInstances = 4;      // Circuits running side by side
+const uint16_t checkpointBytes = 384;    // Largest checkpoint blob
+
+// ====================
+// BUDGETS
+// ====================
+const uint16_t sramBytes = 8192;
+const uint16_t stackReserve = 1024;      // Never-touched stack headroom 'mem' asks for
+const uint16_t heapBudget = 512;         // Heap in use (Strings) 'mem' allows
+const uint16_t staticBudget = sramBytes - stackReserve - heapBudget;  // .data + .bss
+
+enum MemoryConfig : uint8_t {
+  MEMORY_PROFILE = 1,                    // Built with PHASE_PROFILE
+  MEMORY_TRACE = 2                       // Built with PHASE_TRACE
+};
+
+enum MemorySubsystem : uint8_t {
+  MEMORY_CAPTURE,
+  MEMORY_TELEMETRY,
+  MEMORY_NETLIST,
+  MEMORY_FSM,
+  MEMORY_PROFILING,
+  MEMORY_LATENCY,
+  MEMORY_INSTANCES,
+  MEMORY_CHECKPOINT,
+  MEMORY_SUBSYSTEMS
+};
+
+struct MemoryUsage {
+  const char* name;
+  uint16_t bytes;                        // Static buffers and objects
+  uint16_t budget;
+};
+
+// Fills usage[MEMORY_SUBSYSTEMS] for a build configuration
+void subsystemMemory(MemoryUsage* usage, uint8_t config);
+
+inline bool overBudget(const MemoryUsage& usage) { return usage.bytes > usage.budget; }
+
+#endif
@@ -0,0 +1,554 @@
+/*
+ * Digital Logic Lab Simulator - Two-Level Logic Minimizer
+ * See Minimizer.h for the truth table and cube conventions.
+ */
+
+#include "Minimizer.h"
+
+#include <string.h>
+
+// Prime implicants kept for the exact cover; beyond this the heuristic runs
+const uint16_t primeCapacity = 1024;
+
+// Branch-and-bound nodes before the best cover so far is accepted
+const uint32_t exactSearchLimit = 20000;
+
+// Reduce / expand passes over the heuristic cover
+const uint8_t heuristicPasses = 4;
+
+static inline bool tableBit(const uint8_t* table, uint32_t i) {
+  return table[i >> 3] & (1 << (i & 7));
+}
+
+static inline void setTableBit(uint8_t* table, uint32_t i) {
+  table[i >> 3] |= 1 << (i & 7);
+}
+
+static uint16_t power3(uint8_t n) {
+  uint16_t p = 1;
+  while (n--) p *= 3;
+  return p;
+}
+
+static uint16_t primeSlots(uint8_t numInputs) {
+  uint16_t cubes = power3(numInputs);
+  return cubes < primeCapacity ? cubes : primeCapacity;
+}
+
+uint8_t cubeLiterals(Cube cube) {
+  uint8_t count = 0;
+  for (uint16_t care = cube.care; care; care &= care - 1) count++;
+  return count;
+}
+
+uint16_t coverLiterals(const Cube* cover, uint16_t count) {
+  uint16_t literals = 0;
+  for (uint16_t i = 0; i < count; i++) literals += cubeLiterals(cover[i]);
+  return literals;
+}
+
+uint16_t coverGates(const Cube* cover, uint16_t count, bool productOfSums) {
+  uint16_t gates = count > 1 ? count - 1 : 0;
+  uint16_t negated = 0;
+  for (uint16_t i = 0; i < count; i++) {
+    uint8_t literals = cubeLiterals(cover[i]);
+    if (literals > 1) gates += literals - 1;
+    negated |= productOfSums ? cover[i].value : cover[i].care & ~cover[i].value;
+  }
+  return gates + cubeLiterals({negated, 0});
+}
+
+// ====================
+// MINIMIZER STATE
+// ====================
+struct MinimizerState {
+  uint8_t numInputs;
+  uint16_t mask;          // All inputs
+  uint32_t minterms;
+  size_t tableBytes;
+  const uint8_t* onSet;
+  uint8_t* careSet;       // On-set and don't-cares: where a cube may go
+  uint8_t* uncovered;
+
+  // Exact search only
+  uint8_t* implicants;    // One bit per ternary cube
+  uint8_t* coverCounts;   // Primes containing each minterm, saturating
+  Cube* primes;
+  uint16_t numPrimes;
+  uint8_t* levels;        // Uncovered minterms per search depth
+  uint16_t* chosen;       // Prime chosen at each depth
+  uint32_t searchNodes;
+  bool searchComplete;
+  Cube* cover;
+  uint16_t capacity;
+  uint16_t bestCount;
+  uint16_t bestLiterals;
+};
+
+// Visits every minterm of a cube; stops early if visit returns false
+template <typename Visit>
+static bool forEachMinterm(const MinimizerState& s, Cube cube, Visit visit) {
+  uint16_t free = s.mask & ~cube.care;
+  uint16_t sub = 0;
+  do {
+    if (!visit((uint16_t)(cube.value | sub))) return false;
+    sub = (uint16_t)(sub - free) & free;
+  } while (sub);
+  return true;
+}
+
+static bool isImplicant(const MinimizerState& s, Cube cube) {
+  return forEachMinterm(s, cube, [&](uint16_t m) { return tableBit(s.careSet, m); });
+}
+
+static uint32_t countIn(const MinimizerState& s, Cube cube, const uint8_t* table) {
+  uint32_t count = 0;
+  forEachMinterm(s, cube, [&](uint16_t m) {
+    if (tableBit(table, m)) count++;
+    return true;
+  });
+  return count;
+}
+
+static void clearCube(const MinimizerState& s, Cube cube, uint8_t* table) {
+  forEachMinterm(s, cube, [&](uint16_t m) {
+    table[m >> 3] &= ~(1 << (m & 7));
+    return true;
+  });
+}
+
+// ====================
+// EXACT MINIMIZATION
+// ====================
+// Marks every ternary cube (digit 0, 1 or 2 = don't care per input) that
+// lies inside the care set. A cube with a don't care is an implicant iff
+// both of its halves are, and both halves have smaller indices.
+static void findImplicants(MinimizerState& s) {
+  uint16_t cubes = power3(s.numInputs);
+  uint16_t weights[minimizerExactInputs];
+  uint8_t digits[minimizerExactInputs];
+  for (uint8_t i = 0; i < s.numInputs; i++) {
+    weights[i] = power3(i);
+    digits[i] = 0;
+  }
+  memset(s.implicants, 0, (cubes + 7) / 8);
+
+  for (uint16_t index = 0; index < cubes; index++) {
+    int8_t free = -1;
+    uint16_t minterm = 0;
+    for (uint8_t i = 0; i < s.numInputs; i++) {
+      if (digits[i] == 2) {
+        if (free < 0) free = i;
+      }
+      else if (digits[i] == 1) minterm |= 1 << i;
+    }
+    bool implicant = free < 0 ? tableBit(s.careSet, minterm)
+                              : tableBit(s.implicants, index - 2 * weights[free]) &&
+                                tableBit(s.implicants, index - weights[free]);
+    if (implicant) setTableBit(s.implicants, index);
+
+    for (uint8_t i = 0; i < s.numInputs && ++digits[i] == 3; i++) digits[i] = 0;
+  }
+}
+
+// Collects the primes that cover some on-set minterm, fewest literals first
+static bool findPrimes(MinimizerState& s, uint16_t slots) {
+  uint16_t cubes = power3(s.numInputs);
+  s.numPrimes = 0;
+  for (uint8_t literals = 0; literals <= s.numInputs; literals++) {
+    for (uint16_t index = 0; index < cubes; index++) {
+      if (!tableBit(s.implicants, index)) continue;
+
+      Cube cube = {0, 0};
+      bool prime = true;
+      uint16_t rest = index;
+      uint16_t weight = 1;
+      for (uint8_t i = 0; i < s.numInputs; i++, rest /= 3, weight *= 3) {
+        uint8_t digit = rest % 3;
+        if (digit == 2) continue;
+        cube.care |= 1 << i;
+        if (digit) cube.value |= 1 << i;
+        // Prime: no literal can be dropped
+        if (tableBit(s.implicants, index + (2 - digit) * weight)) prime = false;
+      }
+      if (!prime || cubeLiterals(cube) != literals) continue;
+      if (!countIn(s, cube, s.onSet)) continue;
+      if (s.numPrimes == slots) return false;
+      s.primes[s.numPrimes++] = cube;
+    }
+  }
+  return true;
+}
+
+// Branches on the uncovered minterm with the fewest primes, keeping the
+// cover with the fewest terms, then literals
+static void searchCover(MinimizerState& s, uint16_t depth) {
+  if (++s.searchNodes > exactSearchLimit) {
+    s.searchComplete = false;
+    return;
+  }
+  uint8_t* uncovered = s.levels + depth * s.tableBytes;
+  int32_t pick = -1;
+  uint8_t fewest = 0xFF;
+  for (uint32_t m = 0; m < s.minterms && fewest > 1; m++) {
+    if (tableBit(uncovered, m) && s.coverCounts[m] <= fewest) {
+      if (pick < 0 || s.coverCounts[m] < fewest) pick = m;
+      fewest = s.coverCounts[m];
+    }
+  }
+
+  if (pick < 0) {
+    uint16_t literals = 0;
+    for (uint16_t i = 0; i < depth; i++) literals += cubeLiterals(s.primes[s.chosen[i]]);
+    if (depth < s.bestCount || literals < s.bestLiterals) {
+      for (uint16_t i = 0; i < depth; i++) s.cover[i] = s.primes[s.chosen[i]];
+      s.bestCount = depth;
+      s.bestLiterals = literals;
+    }
+    return;
+  }
+  // Another term cannot beat the best cover on terms
+  if (depth + 1 > s.bestCount || depth + 1 > s.capacity) return;
+
+  uint8_t* next = uncovered + s.tableBytes;
+  for (uint16_t p = 0; p < s.numPrimes && s.searchComplete; p++) {
+    if (!cubeContains(s.primes[p], (uint16_t)pick)) continue;
+    memcpy(next, uncovered, s.tableBytes);
+    clearCube(s, s.primes[p], next);
+    s.chosen[depth] = p;
+    searchCover(s, depth + 1);
+  }
+}
+
+static bool exactCover(MinimizerState& s, uint16_t slots, uint16_t& count, bool& exact) {
+  findImplicants(s);
+  if (!findPrimes(s, slots)) return false;
+
+  memset(s.coverCounts, 0, s.minterms);
+  for (uint16_t p = 0; p < s.numPrimes; p++) {
+    forEachMinterm(s, s.primes[p], [&](uint16_t m) {
+      if (s.coverCounts[m] < 0xFF) s.coverCounts[m]++;
+      return true;
+    });
+  }
+
+  memcpy(s.levels, s.onSet, s.tableBytes);
+  s.searchNodes = 0;
+  s.searchComplete = true;
+  s.bestCount = 0xFFFF;
+  s.bestLiterals = 0xFFFF;
+  searchCover(s, 0);
+  if (s.bestCount == 0xFFFF) return false;
+  count = s.bestCount;
+  exact = s.searchComplete;
+  return true;
+}
+
+// ====================
+// HEURISTIC MINIMIZATION
+// ====================
+// Raises literals one at a time while the cube stays an implicant, taking
+// the direction that covers the most minterms of weight
+static Cube expandCube(const MinimizerState& s, Cube cube, const uint8_t* weight) {
+  for (;;) {
+    int8_t bestInput = -1;
+    uint32_t bestGain = 0;
+    for (uint8_t i = 0; i < s.numInputs; i++) {
+      uint16_t bit = 1 << i;
+      if (!(cube.care & bit)) continue;
+      Cube half = {cube.care, (uint16_t)(cube.value ^ bit)};
+      if (!isImplicant(s, half)) continue;
+      uint32_t gain = countIn(s, half, weight) + 1;
+      if (gain > bestGain) {
+        bestGain = gain;
+        bestInput = i;
+      }
+    }
+    if (bestInput < 0) return cube;
+    cube.care &= ~(1 << bestInput);
+    cube.value &= ~(1 << bestInput);
+  }
+}
+
+static bool coveredByOthers(const Cube* cover, uint16_t count, uint16_t skip, uint16_t minterm) {
+  for (uint16_t j = 0; j < count; j++) {
+    if (j != skip && cubeContains(cover[j], minterm)) return true;
+  }
+  return false;
+}
+
+static void removeCube(Cube* cover, uint16_t& count, uint16_t index) {
+  for (uint16_t j = index + 1; j < count; j++) cover[j - 1] = cover[j];
+  count--;
+}
+
+// Drops terms whose on-set minterms are all covered by other terms
+static void makeIrredundant(const MinimizerState& s, Cube* cover, uint16_t& count) {
+  for (uint16_t i = count; i-- > 0;) {
+    bool needed = !forEachMinterm(s, cover[i], [&](uint16_t m) {
+      return !tableBit(s.onSet, m) || coveredByOthers(cover, count, i, m);
+    });
+    if (!needed) removeCube(cover, count, i);
+  }
+}
+
+// Shrinks each term to the smallest cube holding the minterms only it
+// covers, then expands it again, possibly in a better direction
+static void reduceAndExpand(const MinimizerState& s, Cube* cover, uint16_t& count) {
+  for (uint16_t i = count; i-- > 0;) {
+    uint16_t all = 0xFFFF, any = 0;
+    bool essential = false;
+    forEachMinterm(s, cover[i], [&](uint16_t m) {
+      if (tableBit(s.onSet, m) && !coveredByOthers(cover, count, i, m)) {
+        all &= m;
+        any |= m;
+        essential = true;
+      }
+      return true;
+    });
+    if (!essential) {
+      removeCube(cover, count, i);
+      continue;
+    }
+    Cube reduced;
+    reduced.care = s.mask & ~(all ^ any);
+    reduced.value = all & reduced.care;
+    cover[i] = expandCube(s, reduced, s.onSet);
+  }
+}
+
+static bool heuristicCover(MinimizerState& s, uint16_t& count) {
+  memcpy(s.uncovered, s.onSet, s.tableBytes);
+  count = 0;
+  for (uint32_t m = 0; m < s.minterms; m++) {
+    if (!tableBit(s.uncovered, m)) continue;
+    if (count == s.capacity) return false;
+    Cube start = {s.mask, (uint16_t)m};
+    Cube cube = expandCube(s, start, s.uncovered);
+    clearCube(s, cube, s.uncovered);
+    s.cover[count++] = cube;
+  }
+  makeIrredundant(s, s.cover, count);
+
+  for (uint8_t pass = 0; pass < heuristicPasses; pass++) {
+    uint16_t terms = count;
+    uint16_t literals = coverLiterals(s.cover, count);
+    reduceAndExpand(s, s.cover, count);
+    makeIrredundant(s, s.cover, count);
+    uint16_t newLiterals = coverLiterals(s.cover, count);
+    if (count > terms || (count == terms && newLiterals >= literals)) break;
+  }
+  return true;
+}
+
+// ====================
+// ENTRY POINTS
+// ====================
+// Tables every run needs: off-set, care set, uncovered; plus alignment
+static size_t heuristicBytes(uint8_t numInputs) {
+  return 3 * truthTableBytes(numInputs) + 1;
+}
+
+// Exact search tables other than the prime list
+static size_t exactBytes(uint8_t numInputs) {
+  uint32_t levels = ((uint32_t)1 << numInputs) + 1;
+  return levels * sizeof(uint16_t)
+       + (power3(numInputs) + 7) / 8
+       + ((size_t)1 << numInputs)
+       + levels * truthTableBytes(numInputs);
+}
+
+size_t minimizerScratchBytes(uint8_t numInputs) {
+  if (numInputs > minimizerMaxInputs) return 0;
+  size_t bytes = heuristicBytes(numInputs);
+  if (numInputs <= minimizerExactInputs) {
+    bytes += exactBytes(numInputs) + (size_t)primeSlots(numInputs) * sizeof(Cube);
+  }
+  return bytes;
+}
+
+static bool minimizeCover(const uint8_t* onSet, const uint8_t* dcSet, uint8_t numInputs,
+                          bool productOfSums, Cube* cover, uint16_t capacity,
+                          uint16_t& count, uint8_t* scratch, size_t scratchSize, bool* exact) {
+  if (numInputs > minimizerMaxInputs || scratchSize < heuristicBytes(numInputs)) return false;
+  if ((uintptr_t)scratch & 1) scratch++;
+
+  MinimizerState s;
+  memset(&s, 0, sizeof(s));
+  s.numInputs = numInputs;
+  s.mask = (uint16_t)(((uint32_t)1 << numInputs) - 1);
+  s.minterms = (uint32_t)1 << numInputs;
+  s.tableBytes = truthTableBytes(numInputs);
+  s.cover = cover;
+  s.capacity = capacity;
+
+  // The prime list takes whatever scratch is left over; if it is too
+  // short for the function the heuristic runs instead
+  uint16_t slots = 0;
+  size_t fixed = heuristicBytes(numInputs) + exactBytes(numInputs);
+  if (numInputs <= minimizerExactInputs && scratchSize > fixed) {
+    size_t spare = (scratchSize - fixed) / sizeof(Cube);
+    slots = spare < primeSlots(numInputs) ? (uint16_t)spare : primeSlots(numInputs);
+  }
+
+  // Word-aligned arrays first, then bitmaps
+  bool tryExact = slots > 0;
+  uint32_t levels = s.minterms + 1;
+  if (tryExact) {
+    s.primes = (Cube*)scratch;
+    scratch += (size_t)slots * sizeof(Cube);
+    s.chosen = (uint16_t*)scratch;
+    scratch += levels * sizeof(uint16_t);
+  }
+  uint8_t* offSet = scratch;
+  s.careSet = offSet + s.tableBytes;
+  s.uncovered = s.careSet + s.tableBytes;
+  scratch = s.uncovered + s.tableBytes;
+
+  for (size_t b = 0; b < s.tableBytes; b++) {
+    uint8_t dc = dcSet ? dcSet[b] : 0;
+    s.careSet[b] = onSet[b] | dc;
+    offSet[b] = ~(onSet[b] | dc);
+  }
+  if (s.minterms < 8) {
+    s.careSet[0] &= (1 << s.minterms) - 1;
+    offSet[0] &= (1 << s.minterms) - 1;
+  }
+  s.onSet = onSet;
+  if (productOfSums) {
+    // Off-set terms may grow into don't-cares, never into the on-set
+    for (size_t b = 0; b < s.tableBytes; b++) s.careSet[b] = ~onSet[b];
+    if (s.minterms < 8) s.careSet[0] &= (1 << s.minterms) - 1;
+    s.onSet = offSet;
+  }
+
+  bool isExact = false;
+  bool found = false;
+  if (tryExact) {
+    s.implicants = scratch;
+    s.coverCounts = s.implicants + (power3(numInputs) + 7) / 8;
+    s.levels = s.coverCounts + s.minterms;
+    found = exactCover(s, slots, count, isExact);
+  }
+  if (!found) found = heuristicCover(s, count);
+  if (exact) *exact = found && isExact;
+  return found;
+}
+
+bool minimizeSop(const uint8_t* onSet, const uint8_t* dcSet, uint8_t numInputs,
+                 Cube* cover, uint16_t capacity, uint16_t& count,
+                 uint8_t* scratch, size_t scratchSize, bool* exact) {
+  return minimizeCover(onSet, dcSet, numInputs, false, cover, capacity, count,
+                       scratch, scratchSize, exact);
+}
+
+bool minimizePos(const uint8_t* onSet, const uint8_t* dcSet, uint8_t numInputs,
+                 Cube* cover, uint16_t capacity, uint16_t& count,
+                 uint8_t* scratch, size_t scratchSize, bool* exact) {
+  return minimizeCover(onSet, dcSet, numInputs, true, cover, capacity, count,
+                       scratch, scratchSize, exact);
+}
+
+// ====================
+// NETLIST BRIDGES
+// ====================
+bool netlistTruthTable(Netlist& engine, uint16_t output,
+                       const uint16_t* support, uint8_t numSupport, uint8_t* table) {
+  if (output >= engine.outputCount() || numSupport > minimizerMaxInputs) return false;
+  uint16_t saved = 0;
+  for (uint8_t i = 0; i < numSupport; i++) {
+    if (support[i] >= engine.inputCount()) return false;
+    if (engine.value(engine.sourceNode(support[i]))) saved |= 1 << i;
+  }
+
+  uint32_t minterms = (uint32_t)1 << numSupport;
+  memset(table, 0, truthTableBytes(numSupport));
+  for (uint32_t m = 0; m < minterms; m++) {
+    for (uint8_t i = 0; i < numSupport; i++) engine.setInput(support[i], (m >> i) & 1);
+    engine.update();
+    if (engine.output(output)) setTableBit(table, m);
+  }
+
+  for (uint8_t i = 0; i < numSupport; i++) engine.setInput(support[i], (saved >> i) & 1);
+  engine.update();
+  return true;
+}
+
+uint16_t faninConeGates(const Netlist& engine, NodeId node, uint8_t* marks, uint16_t& literals) {
+  if (marks[node >> 3] & (1 << (node & 7))) return 0;
+  marks[node >> 3] |= 1 << (node & 7);
+  const NetlistGate& g = engine.gate(node);
+  if (isSourceGate(g.type)) return 0;
+  uint16_t gates = 1;
+  for (uint8_t i = 0; i < 2; i++) {
+    if (g.in[i] == noNode) continue;
+    literals++;
+    gates += faninConeGates(engine, g.in[i], marks, literals);
+  }
+  return gates;
+}
+
+bool outputSupport(const Netlist& engine, uint16_t output,
+                   uint16_t* support, uint8_t maxSupport, uint8_t& numSupport) {
+  if (output >= engine.outputCount()) return false;
+  NodeId node = engine.outputNode(output);
+  numSupport = 0;
+  uint16_t sources = engine.inputCount() + engine.flipFlopCount();
+  for (uint16_t source = 0; source < sources; source++) {
+    if (!engine.inCone(source, node)) continue;
+    if (source >= engine.inputCount() || numSupport == maxSupport) return false;
+    support[numSupport++] = source;
+  }
+  return true;
+}
+
+static bool appendGate(NetlistGate* gates, uint16_t& numNodes, uint16_t capacity,
+                       uint8_t type, NodeId a, NodeId b, NodeId& id) {
+  if (numNodes >= capacity) return false;
+  gates[numNodes].type = type;
+  gates[numNodes].in[0] = a;
+  gates[numNodes].in[1] = b;
+  id = numNodes++;
+  return true;
+}
+
+bool appendCover(const Cube* cover, uint16_t count, bool productOfSums,
+                 const NodeId* inputNodes, NodeId* inverters,
+                 NetlistGate* gates, uint16_t& numNodes, uint16_t capacity,
+                 NodeId& output) {
+  uint8_t termGate = productOfSums ? GATE_OR : GATE_AND;
+  uint8_t joinGate = productOfSums ? GATE_AND : GATE_OR;
+  output = noNode;
+
+  for (uint16_t i = 0; i < count; i++) {
+    NodeId term = noNode;
+    for (uint8_t v = 0; v < minimizerMaxInputs; v++) {
+      uint16_t bit = 1 << v;
+      if (!(cover[i].care & bit)) continue;
+      NodeId literal = inputNodes[v];
+      bool negated = productOfSums == ((cover[i].value & bit) != 0);
+      if (negated) {
+        if (inverters[v] == noNode &&
+            !appendGate(gates, numNodes, capacity, GATE_NOT, literal, noNode, inverters[v])) {
+          return false;
+        }
+        literal = inverters[v];
+      }
+      if (term == noNode) term = literal;
+      else if (!appendGate(gates, numNodes, capacity, termGate, term, literal, term)) return false;
+    }
+    // A term without literals is the whole function
+    if (term == noNode) {
+      return appendGate(gates, numNodes, capacity, productOfSums ? GATE_CONST0 : GATE_CONST1,
+                        noNode, noNode, output);
+    }
+    if (output == noNode) output = term;
+    else if (!appendGate(gates, numNodes, capacity, joinGate, output, term, output)) return false;
+  }
+
+  if (output == noNode) {
+    return appendGate(gates, numNodes, capacity, productOfSums ? GATE_CONST1 : GATE_CONST0,
+                      noNode, noNode, output);
+  }
+  return true;
+}
@@ -0,0 +1,100 @@
+/*
+ * Digital Logic Lab Simulator - Two-Level Logic Minimizer
+ * Turns a truth table into a minimal sum-of-products (or product-of-sums)
+ * cover. Functions of up to 8 inputs are minimized exactly (Quine-McCluskey
+ * primes and a branch-and-bound cover); wider ones use an Espresso-style
+ * expand / irredundant / reduce loop.
+ *
+ * Truth tables are bitmaps: bit m (byte m / 8, bit m % 8) is minterm m, and
+ * bit i of a minterm is input i. Storage is supplied by the caller.
+ */
+
+#ifndef MINIMIZER_H
+#define MINIMIZER_H
+
+#include "Netlist.h"
+
+// ====================
+// CUBES AND COVERS
+// ====================
+const uint8_t minimizerMaxInputs = 16;
+const uint8_t minimizerExactInputs = 8;
+
+// A product term: input i is a literal when bit i of care is set, true
+// if bit i of value is set. In a product-of-sums cover each cube is an
+// off-set term and stands for the sum of its negated literals.
+struct Cube {
+  uint16_t care;
+  uint16_t value;
+};
+
+inline bool cubeContains(Cube cube, uint16_t minterm) {
+  return (minterm & cube.care) == cube.value;
+}
+
+uint8_t cubeLiterals(Cube cube);
+uint16_t coverLiterals(const Cube* cover, uint16_t count);
+
+// Two-input gates needed to build the cover: each term's AND (or OR) chain,
+// the final OR (or AND) chain and one inverter per complemented input
+uint16_t coverGates(const Cube* cover, uint16_t count, bool productOfSums);
+
+// Value of the function on one input word
+inline bool coverValue(const Cube* cover, uint16_t count, uint16_t word, bool productOfSums) {
+  for (uint16_t i = 0; i < count; i++) {
+    if (cubeContains(cover[i], word)) return !productOfSums;
+  }
+  return productOfSums;
+}
+
+// ====================
+// MINIMIZATION
+// ====================
+inline size_t truthTableBytes(uint8_t numInputs) {
+  return ((size_t)1 << numInputs) < 8 ? 1 : ((size_t)1 << numInputs) / 8;
+}
+
+// Scratch for an exact run of up to 8 inputs. Less still works down to
+// three truth tables, with the heuristic taking over when the prime
+// implicants do not fit.
+size_t minimizerScratchBytes(uint8_t numInputs);
+
+// Minimizes onSet with optional don't-cares (dcSet may be 0). Returns false
+// if the inputs, scratch or cover capacity are too small. exact is set when
+// the cover is provably minimal (fewest terms, then fewest literals).
+bool minimizeSop(const uint8_t* onSet, const uint8_t* dcSet, uint8_t numInputs,
+                 Cube* cover, uint16_t capacity, uint16_t& count,
+                 uint8_t* scratch, size_t scratchSize, bool* exact);
+
+// Same, minimizing the off-set into a product of sums
+bool minimizePos(const uint8_t* onSet, const uint8_t* dcSet, uint8_t numInputs,
+                 Cube* cover, uint16_t capacity, uint16_t& count,
+                 uint8_t* scratch, size_t scratchSize, bool* exact);
+
+// ====================
+// NETLIST BRIDGES
+// ====================
+// Truth table of one output over the given sources (inputs, then
+// flip-flops, as numbered by the engine; only inputs can be driven here).
+// The other inputs keep their values, which are restored afterwards.
+bool netlistTruthTable(Netlist& engine, uint16_t output,
+                       const uint16_t* support, uint8_t numSupport, uint8_t* table);
+
+// Inputs (by index) whose fanout cone reaches the output. Returns false if
+// a flip-flop does, or there are more than maxSupport inputs.
+bool outputSupport(const Netlist& engine, uint16_t output,
+                   uint16_t* support, uint8_t maxSupport, uint8_t& numSupport);
+
+// Gates in the fanin cone of a node and their connected inputs (added to
+// literals). marks holds one bit per node, zeroed by the caller; nodes
+// already marked are not counted again, so shared logic counts once.
+uint16_t faninConeGates(const Netlist& engine, NodeId node, uint8_t* marks, uint16_t& literals);
+
+// Appends the cover as gates. Variable i of the cover is node inputNodes[i].
+// inverters caches one NOT per variable across calls (fill with noNode).
+bool appendCover(const Cube* cover, uint16_t count, bool productOfSums,
+                 const NodeId* inputNodes, NodeId* inverters,
+                 NetlistGate* gates, uint16_t& numNodes, uint16_t capacity,
+                 NodeId& output);
+
+#endif
@@ -0,0 +1,453 @@
+/*
+ * Digital Logic Lab Simulator - Netlist Engine
+ * See Netlist.h for the arena layout and update model.
+ */
+
+#include "Netlist.h"
+
+#include <string.h>
+
+// values[] bit 0 is the settled value; during begin() and while settling a
+// cycle the upper bits are borrowed as scratch
+const uint8_t valueBit = 0x01;
+const uint8_t nextBit = 0x02;      // Staged value while settling a cycle
+const uint8_t onStackBit = 0x04;   // Component search: node is on the stack
+const uint8_t edgeMask = 0x18;     // Component search: next fanin to visit
+const uint8_t edgeShift = 3;
+
+Netlist::Netlist()
+  : lastEvaluated(0), totalEvaluated(0), updateCount(0), oscillationCount(0),
+    gates(0), outputList(0), numNodes(0), numGates(0), numInputs(0),
+    numSources(0), numOutputs(0), numLevels(0), numCycles(0), coneBytes(0),
+    iterationLimit(16), unstable(false), poweringUp(false),
+    order(0), slot(0), sourceNodes(0), values(0), cones(0), dirty(0),
+    cyclic(0), cycleStart(0) {
+}
+
+size_t Netlist::arenaBytes(uint16_t numNodes, uint16_t numSources) {
+  size_t bitsetBytes = ((size_t)(numNodes - numSources) + 7) / 8;
+  return (size_t)(numNodes - numSources) * sizeof(NodeId) // order
+       + (size_t)numNodes * sizeof(uint16_t)                 // slot
+       + (size_t)numSources * sizeof(NodeId)                 // sourceNodes
+       + numNodes                                            // values
+       + (size_t)numSources * bitsetBytes                    // cones
+       + 3 * bitsetBytes                                     // dirty, cyclic, cycleStart
+       + 1 + 3 * (size_t)numNodes * sizeof(uint16_t);        // load-time scratch
+}
+
+bool Netlist::begin(const NetlistGate* gateList, uint16_t nodeCount,
+                    const NodeId* outputs, uint16_t outputCount,
+                    uint8_t* arena, size_t arenaSize) {
+  gates = gateList;
+  outputList = outputs;
+  numNodes = nodeCount;
+  numOutputs = outputCount;
+  numInputs = 0;
+  numSources = 0;
+  for (uint16_t n = 0; n < numNodes; n++) {
+    if (gates[n].type == GATE_INPUT) numInputs++;
+    if (isSourceGate(gates[n].type)) numSources++;
+    for (uint8_t i = 0; i < 2; i++) {
+      NodeId f = gates[n].in[i];
+      if (f != noNode && f >= numNodes) return false;
+    }
+  }
+  for (uint16_t i = 0; i < numOutputs; i++) {
+    if (outputList[i] >= numNodes) return false;
+  }
+  numGates = numNodes - numSources;
+  coneBytes = (numGates + 7) / 8;
+  if (arenaSize < arenaBytes(numNodes, numSources)) return false;
+
+  // Carve the arena: 16-bit tables first to keep them aligned
+  order = (NodeId*)arena;
+  slot = (uint16_t*)(order + numGates);
+  sourceNodes = (NodeId*)(slot + numNodes);
+  values = (uint8_t*)(sourceNodes + numSources);
+  cones = values + numNodes;
+  dirty = cones + (size_t)numSources * coneBytes;
+  cyclic = dirty + coneBytes;
+  cycleStart = cyclic + coneBytes;
+  uint8_t* scratch = cycleStart + coneBytes;
+  if ((uintptr_t)scratch & 1) scratch++;
+  uint16_t* scratchA = (uint16_t*)scratch;
+  uint16_t* scratchB = scratchA + numNodes;
+  uint16_t* scratchC = scratchB + numNodes;
+
+  // Component search: slot[] holds the visit index, scratchA ends up with
+  // each gate's component id and order[] with the gates in emission order
+  memset(values, 0, numNodes);
+  findComponents(slot, scratchA, scratchB, scratchC, order);
+  levelize(order, scratchA, scratchB, scratchC);
+
+  uint16_t input = 0;
+  uint16_t flipFlop = numInputs;
+  for (uint16_t n = 0; n < numNodes; n++) {
+    if (gates[n].type == GATE_INPUT) {
+      sourceNodes[input] = n;
+      slot[n] = input++;
+    }
+    else if (gates[n].type == GATE_DFF) {
+      sourceNodes[flipFlop] = n;
+      slot[n] = flipFlop++;
+    }
+  }
+  for (uint16_t s = 0; s < numGates; s++) {
+    slot[order[s]] = s;
+  }
+
+  // Mark the cyclic components, which levelize() kept contiguous
+  memset(cyclic, 0, coneBytes);
+  memset(cycleStart, 0, coneBytes);
+  numCycles = 0;
+  uint16_t start = 0;
+  while (start < numGates) {
+    uint16_t component = scratchA[order[start]];
+    uint16_t end = start + 1;
+    while (end < numGates && scratchA[order[end]] == component) end++;
+
+    const NetlistGate& g = gates[order[start]];
+    bool selfLoop = g.in[0] == order[start] || g.in[1] == order[start];
+    if (end - start > 1 || selfLoop) {
+      for (uint16_t s = start; s < end; s++) cyclic[s >> 3] |= 1 << (s & 7);
+      cycleStart[start >> 3] |= 1 << (start & 7);
+      numCycles++;
+    }
+    start = end;
+  }
+
+  buildCones();
+  memset(values, 0, numNodes);
+  memset(dirty, 0, coneBytes);
+  lastEvaluated = 0;
+  totalEvaluated = 0;
+  updateCount = 0;
+  oscillationCount = 0;
+  preset(0);
+  return true;
+}
+
+// Iterative Tarjan over fanin edges. Components are emitted after every
+// component feeding them, so the emission order is already topological.
+// On return component[] holds each gate's component id.
+void Netlist::findComponents(uint16_t* index, uint16_t* component,
+                             NodeId* stack, NodeId* calls, NodeId* emitted) {
+  uint16_t* low = component;  // A node's low link becomes its component id
+  uint16_t nextIndex = 1;     // 0 = not visited
+  uint16_t stackTop = 0;
+  uint16_t emitCount = 0;
+  uint16_t componentId = 0;
+  for (uint16_t n = 0; n < numNodes; n++) index[n] = 0;
+
+  for (uint16_t root = 0; root < numNodes; root++) {
+    if (isSourceGate(gates[root].type) || index[root]) continue;
+    uint16_t callTop = 0;
+    calls[callTop++] = root;
+    index[root] = low[root] = nextIndex++;
+    stack[stackTop++] = root;
+    values[root] |= onStackBit;
+
+    while (callTop) {
+      NodeId v = calls[callTop - 1];
+      uint8_t edge = (values[v] & edgeMask) >> edgeShift;
+      if (edge < 2) {
+        values[v] = (values[v] & ~edgeMask) | ((edge + 1) << edgeShift);
+        NodeId w = gates[v].in[edge];
+        if (w == noNode || isSourceGate(gates[w].type)) continue;
+        if (!index[w]) {
+          index[w] = low[w] = nextIndex++;
+          stack[stackTop++] = w;
+          values[w] |= onStackBit;
+          calls[callTop++] = w;
+        }
+        else if ((values[w] & onStackBit) && index[w] < low[v]) {
+          low[v] = index[w];
+        }
+        continue;
+      }
+
+      // All fanins visited
+      callTop--;
+      if (low[v] == index[v]) {
+        NodeId m;
+        do {
+          m = stack[--stackTop];
+          values[m] &= ~onStackBit;
+          emitted[emitCount++] = m;
+          component[m] = componentId;
+        } while (m != v);
+        componentId++;
+      }
+      else if (callTop) {
+        NodeId parent = calls[callTop - 1];
+        if (low[v] < low[parent]) low[parent] = low[v];
+      }
+    }
+  }
+}
+
+// Gives every component 1 + the highest level among the gates feeding it
+// from outside, then sorts the gates by level. Members of a component share
+// a level and stay contiguous because the sort is stable.
+void Netlist::levelize(NodeId* emitted, uint16_t* component,
+                       uint16_t* level, NodeId* sorted) {
+  numLevels = 0;
+  uint16_t start = 0;
+  while (start < numGates) {
+    uint16_t id = component[emitted[start]];
+    uint16_t end = start + 1;
+    while (end < numGates && component[emitted[end]] == id) end++;
+
+    uint16_t l = 0;
+    for (uint16_t s = start; s < end; s++) {
+      const NetlistGate& g = gates[emitted[s]];
+      for (uint8_t i = 0; i < 2; i++) {
+        NodeId f = g.in[i];
+        if (f == noNode || isSourceGate(gates[f].type)) continue;
+        if (component[f] != id && level[f] > l) l = level[f];
+      }
+    }
+    l++;
+    for (uint16_t s = start; s < end; s++) level[emitted[s]] = l;
+    if (l > numLevels) numLevels = l;
+    start = end;
+  }
+
+  uint16_t count = 0;
+  for (uint16_t l = 1; l <= numLevels; l++) {
+    for (uint16_t s = 0; s < numGates; s++) {
+      if (level[emitted[s]] == l) sorted[count++] = emitted[s];
+    }
+  }
+  memcpy(emitted, sorted, (size_t)numGates * sizeof(NodeId));
+}
+
+// Walks the gates in level order; a gate belongs to a source's cone if any
+// of its fanins is that source or is already in the cone. A cyclic component
+// joins a cone as a whole.
+void Netlist::buildCones() {
+  memset(cones, 0, (size_t)numSources * coneBytes);
+  for (uint16_t k = 0; k < numSources; k++) {
+    uint8_t* cone = cones + (size_t)k * coneBytes;
+    NodeId source = sourceNodes[k];
+    uint16_t s = 0;
+    while (s < numGates) {
+      uint16_t end = s + 1;
+      if (isCycleStart(s)) {
+        while (end < numGates && isCyclic(end) && !isCycleStart(end)) end++;
+      }
+
+      bool reached = false;
+      for (uint16_t m = s; m < end && !reached; m++) {
+        const NetlistGate& g = gates[order[m]];
+        for (uint8_t i = 0; i < 2; i++) {
+          NodeId f = g.in[i];
+          if (f == noNode) continue;
+          if (f == source ||
+              (!isSourceGate(gates[f].type) && (cone[slot[f] >> 3] & (1 << (slot[f] & 7))))) {
+            reached = true;
+            break;
+          }
+        }
+      }
+      if (reached) {
+        for (uint16_t m = s; m < end; m++) cone[m >> 3] |= 1 << (m & 7);
+      }
+      s = end;
+    }
+  }
+}
+
+void Netlist::setInput(uint16_t index, bool value) {
+  if (index >= numInputs) return;
+  NodeId node = sourceNodes[index];
+  if (values[node] == (uint8_t)value) return;
+  values[node] = value;
+  markCone(index);
+}
+
+void Netlist::markCone(uint16_t source) {
+  const uint8_t* cone = cones + (size_t)source * coneBytes;
+  for (uint16_t b = 0; b < coneBytes; b++) {
+    dirty[b] |= cone[b];
+  }
+}
+
+void Netlist::applyInputWord(uint32_t word) {
+  uint16_t count = numInputs < 32 ? numInputs : 32;
+  for (uint16_t i = 0; i < count; i++) {
+    setInput(i, (word >> i) & 1);
+  }
+}
+
+// Evaluates the acyclic gate or the whole cyclic component starting at
+// slot s and returns the number of slots covered. Gate evaluations are
+// added to lastEvaluated.
+uint16_t Netlist::evaluateSlot(uint16_t s) {
+  if (isCycleStart(s)) {
+    uint16_t end = s + 1;
+    while (end < numGates && isCyclic(end) && !isCycleStart(end)) end++;
+    lastEvaluated += settleCycle(s, end);
+    return end - s;
+  }
+  NodeId node = order[s];
+  const NetlistGate& g = gates[node];
+  uint8_t a = g.in[0] != noNode ? values[g.in[0]] : 0;
+  uint8_t b = g.in[1] != noNode ? values[g.in[1]] : 0;
+  values[node] = evaluateGate(g.type, a, b);
+  lastEvaluated++;
+  return 1;
+}
+
+// Settles the cyclic component in slots [start, end) and returns the number
+// of gate evaluations. All members first switch together; if that never
+// reaches a fixed point the component is reported and resolved by
+// switching members one at a time.
+uint16_t Netlist::settleCycle(uint16_t start, uint16_t end) {
+  bool settled = false;
+  uint16_t evaluated = 0;
+  if (!poweringUp) {
+    evaluated = iterateCycle(start, end, true, settled);
+    if (settled) return evaluated;
+    unstable = true;
+    oscillationCount++;
+  }
+  return evaluated + iterateCycle(start, end, false, settled);
+}
+
+uint16_t Netlist::iterateCycle(uint16_t start, uint16_t end, bool together, bool& settled) {
+  uint16_t evaluated = 0;
+  for (uint8_t iteration = 0; iteration < iterationLimit; iteration++) {
+    bool changed = false;
+    for (uint16_t s = start; s < end; s++) {
+      NodeId node = order[s];
+      const NetlistGate& g = gates[node];
+      uint8_t a = g.in[0] != noNode ? values[g.in[0]] & valueBit : 0;
+      uint8_t b = g.in[1] != noNode ? values[g.in[1]] & valueBit : 0;
+      uint8_t next = evaluateGate(g.type, a, b);
+      if (next != (values[node] & valueBit)) changed = true;
+      values[node] = together ? (values[node] | (next ? nextBit : 0)) : next;
+    }
+    if (together) {
+      for (uint16_t s = start; s < end; s++) {
+        NodeId node = order[s];
+        values[node] = (values[node] & nextBit) ? 1 : 0;
+      }
+    }
+    evaluated += end - start;
+    if (!changed) {
+      settled = true;
+      return evaluated;
+    }
+  }
+  settled = false;
+  return evaluated;
+}
+
+uint16_t Netlist::update() {
+  lastEvaluated = 0;
+  unstable = false;
+  uint16_t s = 0;
+  while (s < numGates) {
+    if (!(s & 7) && !dirty[s >> 3]) {
+      s += 8;
+      continue;
+    }
+    if (!(dirty[s >> 3] & (1 << (s & 7)))) {
+      s++;
+      continue;
+    }
+    uint16_t covered = evaluateSlot(s);
+    for (uint16_t m = s; m < s + covered; m++) dirty[m >> 3] &= ~(1 << (m & 7));
+    s += covered;
+  }
+  totalEvaluated += lastEvaluated;
+  updateCount++;
+  return lastEvaluated;
+}
+
+uint16_t Netlist::clock() {
+  // Every flip-flop samples D before any of them changes
+  for (uint16_t k = numInputs; k < numSources; k++) {
+    NodeId node = sourceNodes[k];
+    NodeId d = gates[node].in[0];
+    if (d != noNode && (values[d] & valueBit)) values[node] |= nextBit;
+  }
+  uint16_t changed = 0;
+  for (uint16_t k = numInputs; k < numSources; k++) {
+    NodeId node = sourceNodes[k];
+    uint8_t next = (values[node] & nextBit) ? 1 : 0;
+    if (next != (values[node] & valueBit)) {
+      markCone(k);
+      changed++;
+    }
+    values[node] = next;
+  }
+  return changed;
+}
+
+void Netlist::preset(uint32_t word) {
+  uint16_t count = numInputs < 32 ? numInputs : 32;
+  for (uint16_t i = 0; i < count; i++) {
+    values[sourceNodes[i]] = (word >> i) & 1;
+  }
+  poweringUp = true;
+  evaluateAll();
+  poweringUp = false;
+}
+
+uint32_t Netlist::nodeWord() const {
+  if (numNodes > 32) return 0;
+  uint32_t word = 0;
+  for (NodeId n = 0; n < numNodes; n++) {
+    if (values[n]) word |= (uint32_t)1 << n;
+  }
+  return word;
+}
+
+void Netlist::loadNodeWord(uint32_t word) {
+  if (numNodes > 32) return;
+  for (NodeId n = 0; n < numNodes; n++) {
+    values[n] = (word >> n) & 1;
+  }
+  memset(dirty, 0, coneBytes);
+}
+
+void Netlist::evaluateAll() {
+  lastEvaluated = 0;
+  unstable = false;
+  uint16_t s = 0;
+  while (s < numGates) {
+    s += evaluateSlot(s);
+  }
+  memset(dirty, 0, coneBytes);
+  totalEvaluated += lastEvaluated;
+  updateCount++;
+}
+
+uint32_t Netlist::outputWord() const {
+  uint32_t word = 0;
+  uint16_t count = numOutputs < 32 ? numOutputs : 32;
+  for (uint16_t i = 0; i < count; i++) {
+    if (values[outputList[i]]) word |= (uint32_t)1 << i;
+  }
+  return word;
+}
+
+// A source is in its own cone; other sources never are
+bool Netlist::inCone(uint16_t source, NodeId node) const {
+  if (source >= numSources || node >= numNodes) return false;
+  if (isSourceGate(gates[node].type)) return sourceNodes[source] == node;
+  uint16_t s = slot[node];
+  return cones[(size_t)source * coneBytes + (s >> 3)] & (1 << (s & 7));
+}
+
+uint16_t Netlist::coneSize(uint16_t source) const {
+  if (source >= numSources) return 0;
+  const uint8_t* cone = cones + (size_t)source * coneBytes;
+  uint16_t count = 0;
+  for (uint16_t b = 0; b < coneBytes; b++) {
+    for (uint8_t v = cone[b]; v; v &= v - 1) count++;
+  }
+  return count;
+}
@@ -0,0 +1,192 @@
+/*
+ * Digital Logic Lab Simulator - Netlist Engine
+ * Levelized two-input gate netlist shared by the firmware and the host tools.
+ * Each input's transitive fanout cone is precomputed as a bitset so that a
+ * change on the packed input word only re-evaluates the gates it can reach.
+ *
+ * Feedback (latches, cross-coupled gates) is allowed: strongly connected
+ * components are found at load time and kept contiguous in the level order.
+ * Each component is settled by bounded fixed-point iteration, with all of
+ * its gates switching together (unit delay). A component that never settles
+ * is reported as oscillating and then resolved by switching its gates one at
+ * a time, the way a real race ends in one state. Acyclic gates are
+ * evaluated once.
+ *
+ * Flip-flops (GATE_DFF, D on in[0]) break feedback the same way inputs do:
+ * they are sources with their own fanout cones, and clock() latches every
+ * D at once and re-dirties the cones of the flip-flops that changed.
+ *
+ * The engine never allocates: derived tables live in a caller-supplied arena
+ * (a static array on the Mega, a std::vector on the host).
+ */
+
+#ifndef NETLIST_H
+#define NETLIST_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ====================
+// NETLIST DEFINITIONS
+// ====================
+typedef uint16_t NodeId;
+const NodeId noNode = 0xFFFF;
+
+enum GateType : uint8_t {
+  GATE_INPUT,   // Primary input, numbered in order of appearance
+  GATE_CONST0,
+  GATE_CONST1,
+  GATE_BUF,
+  GATE_NOT,
+  GATE_AND,
+  GATE_OR,
+  GATE_NAND,
+  GATE_NOR,
+  GATE_XOR,
+  GATE_XNOR,
+  GATE_DFF,     // Rising-edge flip-flop, D on in[0], updated by clock()
+  GATE_ANDNOT   // in[0] AND NOT in[1], emitted by AIG lowering
+};
+
+// Inputs and flip-flops are the sources every gate is evaluated from
+inline bool isSourceGate(uint8_t type) {
+  return type == GATE_INPUT || type == GATE_DFF;
+}
+
+// One node of the netlist. Inputs refer to other nodes by index;
+// unused inputs are noNode.
+struct NetlistGate {
+  uint8_t type;
+  NodeId in[2];
+};
+
+// Evaluates a single gate on 0/1 operands
+inline uint8_t evaluateGate(uint8_t type, uint8_t a, uint8_t b) {
+  switch (type) {
+    case GATE_CONST1: return 1;
+    case GATE_BUF:    return a;
+    case GATE_NOT:    return a ^ 1;
+    case GATE_AND:    return a & b;
+    case GATE_OR:     return a | b;
+    case GATE_NAND:   return (a & b) ^ 1;
+    case GATE_NOR:    return (a | b) ^ 1;
+    case GATE_XOR:    return a ^ b;
+    case GATE_XNOR:   return (a ^ b) ^ 1;
+    case GATE_ANDNOT: return a & (b ^ 1);
+    default:          return 0;
+  }
+}
+
+// ====================
+// NETLIST ENGINE
+// ====================
+class Netlist {
+public:
+  Netlist();
+
+  // Arena size needed by begin() for a netlist of this shape, where
+  // numSources counts both inputs and flip-flops
+  static size_t arenaBytes(uint16_t numNodes, uint16_t numSources);
+
+  // Levelizes the gates, builds the fanout cones and evaluates everything
+  // once. Returns false if the arena is too small or a fanin is out of
+  // range. The gate and output arrays must outlive the engine.
+  bool begin(const NetlistGate* gates, uint16_t numNodes,
+             const NodeId* outputs, uint16_t numOutputs,
+             uint8_t* arena, size_t arenaSize);
+
+  // Input changes only mark cones dirty; update() does the work
+  void setInput(uint16_t index, bool value);
+  void applyInputWord(uint32_t word);  // Inputs 0..31, bit i = input i
+
+  // Latches every flip-flop's D input and marks the cones of those that
+  // changed. Returns the number of flip-flops that changed.
+  uint16_t clock();
+
+  // Loads an input word as the power-up state and evaluates everything.
+  // Cycles are resolved without being reported, since there is no history.
+  void preset(uint32_t word);
+
+  // Every node's value, bit n = node n, for netlists of up to 32 nodes
+  // (the sketch's built-in circuits); 0 for larger ones
+  uint32_t nodeWord() const;
+
+  // Puts back a nodeWord() of the same netlist as the settled state, so
+  // the value a latch holds survives reloading the engine. Does nothing
+  // on a netlist of more than 32 nodes.
+  void loadNodeWord(uint32_t word);
+
+  // Re-evaluates the union of dirty cones in level order.
+  // Returns the number of gates evaluated.
+  uint16_t update();
+  void evaluateAll();
+
+  bool value(NodeId node) const { return values[node]; }
+  bool output(uint16_t index) const { return values[outputList[index]]; }
+  uint32_t outputWord() const;  // Outputs 0..31
+
+  uint16_t nodeCount() const { return numNodes; }
+  uint16_t gateCount() const { return numGates; }
+  uint16_t inputCount() const { return numInputs; }
+  NodeId sourceNode(uint16_t index) const { return sourceNodes[index]; }
+  uint16_t flipFlopCount() const { return numSources - numInputs; }
+  bool flipFlop(uint16_t index) const { return values[sourceNodes[numInputs + index]]; }
+  uint16_t outputCount() const { return numOutputs; }
+  NodeId outputNode(uint16_t index) const { return outputList[index]; }
+  const NetlistGate& gate(NodeId node) const { return gates[node]; }
+  uint16_t levelCount() const { return numLevels; }
+  uint16_t coneSize(uint16_t source) const;  // Inputs, then flip-flops
+  bool inCone(uint16_t source, NodeId node) const;
+  uint16_t cycleCount() const { return numCycles; }
+
+  // Fixed-point iterations allowed per cyclic component and update
+  void setIterationLimit(uint8_t limit) { iterationLimit = limit; }
+
+  // True if a cyclic component did not settle during the last update
+  bool oscillating() const { return unstable; }
+
+  // Evaluation counters, for measuring the savings of cone updates
+  uint16_t lastEvaluated;
+  uint32_t totalEvaluated;
+  uint32_t updateCount;
+  uint32_t oscillationCount;
+
+private:
+  void findComponents(uint16_t* index, uint16_t* low, NodeId* stack,
+                      NodeId* calls, NodeId* emitted);
+  void levelize(NodeId* emitted, uint16_t* component,
+                uint16_t* level, NodeId* sorted);
+  void buildCones();
+  void markCone(uint16_t source);
+  uint16_t evaluateSlot(uint16_t s);
+  uint16_t settleCycle(uint16_t start, uint16_t end);
+  uint16_t iterateCycle(uint16_t start, uint16_t end, bool together, bool& settled);
+
+  bool isCyclic(uint16_t s) const { return cyclic[s >> 3] & (1 << (s & 7)); }
+  bool isCycleStart(uint16_t s) const { return cycleStart[s >> 3] & (1 << (s & 7)); }
+
+  const NetlistGate* gates;
+  const NodeId* outputList;
+  uint16_t numNodes;
+  uint16_t numGates;     // Non-source nodes, in evaluation order
+  uint16_t numInputs;
+  uint16_t numSources;   // Inputs followed by flip-flops
+  uint16_t numOutputs;
+  uint16_t numLevels;
+  uint16_t numCycles;    // Cyclic components
+  uint16_t coneBytes;    // Bytes per cone bitset
+  uint8_t iterationLimit;
+  bool unstable;
+  bool poweringUp;
+
+  NodeId* order;         // Evaluation slot -> node, sorted by level
+  uint16_t* slot;        // Node -> evaluation slot (sources: source index)
+  NodeId* sourceNodes;   // Source index -> node
+  uint8_t* values;       // Node -> 0/1
+  uint8_t* cones;        // numSources bitsets over evaluation slots
+  uint8_t* dirty;        // Union of cones touched since the last update
+  uint8_t* cyclic;       // Slots that belong to a cyclic component
+  uint8_t* cycleStart;   // First slot of each cyclic component
+};
+
+#endif
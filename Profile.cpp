@@ -0,0 +1,107 @@
+/*
+ * Digital Logic Lab Simulator - Phase Profiling
+ */
+
+#include "Profile.h"
+
+uint8_t profileBucket(uint32_t cycles) {
+  uint8_t bucket = 0;
+  cycles >>= profileBucketShift + 1;
+  while (cycles && bucket < profileBuckets - 1) {
+    cycles >>= 1;
+    bucket++;
+  }
+  return bucket;
+}
+
+void clearStats(PhaseStats& stats) {
+  stats.count = 0;
+  stats.min = 0xFFFFFFFFUL;
+  stats.max = 0;
+  stats.total = 0;
+  for (uint8_t b = 0; b < profileBuckets; b++) stats.buckets[b] = 0;
+}
+
+void addCycles(PhaseStats& stats, uint32_t cycles) {
+  stats.count++;
+  stats.total += cycles;
+  if (cycles < stats.min) stats.min = cycles;
+  if (cycles > stats.max) stats.max = cycles;
+  uint16_t& bucket = stats.buckets[profileBucket(cycles)];
+  if (bucket != 0xFFFF) bucket++;
+}
+
+PhaseProfile::PhaseProfile() {
+  reset();
+}
+
+void PhaseProfile::reset() {
+  for (uint8_t p = 0; p < PHASE_COUNT; p++) clearStats(phases[p]);
+  depth = 0;
+  unmatched = 0;
+}
+
+void PhaseProfile::begin(uint8_t phase, uint32_t now) {
+  if (depth == profileMaxDepth || phase >= PHASE_COUNT) {
+    unmatched++;
+    return;
+  }
+  // The enclosing phase pauses until this one ends
+  if (depth > 0) spent[depth - 1] += now - started[depth - 1];
+  open[depth] = phase;
+  started[depth] = now;
+  spent[depth] = 0;
+  depth++;
+}
+
+void PhaseProfile::end(uint8_t phase, uint32_t now) {
+  if (depth == 0 || open[depth - 1] != phase) {
+    unmatched++;
+    return;
+  }
+  depth--;
+  add(phase, spent[depth] + (now - started[depth]));
+  if (depth > 0) started[depth - 1] = now;
+}
+
+void PhaseProfile::add(uint8_t phase, uint32_t cycles) {
+  if (phase < PHASE_COUNT) addCycles(phases[phase], cycles);
+}
+
+// ====================
+// STATS FRAME
+// ====================
+static uint32_t meanCycles(const PhaseStats& stats) {
+  return stats.count ? (uint32_t)(stats.total / stats.count) : 0;
+}
+
+uint16_t statsBytes(const PhaseStats& stats) {
+  uint16_t length = varintBytes(stats.count) + varintBytes(stats.count ? stats.min : 0) +
+                    varintBytes(stats.max) + varintBytes(meanCycles(stats));
+  for (uint8_t b = 0; b < profileBuckets; b++) length += varintBytes(stats.buckets[b]);
+  return length;
+}
+
+void putStats(FrameWriter& writer, const PhaseStats& stats) {
+  writer.putVarint(stats.count);
+  writer.putVarint(stats.count ? stats.min : 0);
+  writer.putVarint(stats.max);
+  writer.putVarint(meanCycles(stats));
+  for (uint8_t b = 0; b < profileBuckets; b++) writer.putVarint(stats.buckets[b]);
+}
+
+uint16_t statsFrameLength(const PhaseProfile& profile) {
+  uint16_t length = 7;
+  for (uint8_t p = 0; p < PHASE_COUNT; p++) length += statsBytes(profile.stats(p));
+  return length;
+}
+
+void writeStatsFrame(FrameWriter& writer, const PhaseProfile& profile, uint32_t cyclesPerSecond) {
+  writer.begin(FRAME_STATS, statsFrameLength(profile));
+  writer.put32(cyclesPerSecond);
+  writer.put(PHASE_COUNT);
+  writer.put(profileBuckets);
+  writer.put(profileBucketShift);
+  for (uint8_t p = 0; p < PHASE_COUNT; p++) putStats(writer, profile.stats(p));
+  writer.end();
+}
@@ -0,0 +1,95 @@
+/*
+ * Digital Logic Lab Simulator - Phase Profiling
+ * Cycle statistics for the phases of the main loop: how long input
+ * sampling, debouncing, evaluation, output writes and serial traffic take
+ * on each pass. Trace points call begin() and end() with a free-running
+ * cycle count; time spent in a nested phase (a TX inside a command
+ * handler) is charged to the nested phase only. Each phase keeps its
+ * count, min, max, total and a log2 histogram:
+ *
+ *   bucket 0: fewer than 2^(profileBucketShift + 1) cycles
+ *   bucket k: [2^(profileBucketShift + k), 2^(profileBucketShift + k + 1))
+ *   last bucket: everything longer
+ *
+ * writeStatsFrame() sends them as one FRAME_STATS frame:
+ *
+ *   cycles per second (uint32) | phases (uint8) | buckets (uint8) | shift (uint8)
+ *   phases x [ varint count | varint min | varint max | varint mean |
+ *              buckets x varint ]
+ *
+ * The sketch wires the trace points through macros that compile to
+ * nothing unless PHASE_PROFILE is set.
+ */
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "Frame.h"
+
+// ====================
+// PROFILE DEFINITIONS
+// ====================
+enum ProfilePhase : uint8_t {
+  PHASE_SAMPLE,       // Reading the input pins
+  PHASE_DEBOUNCE,     // Conditioning them into the input word
+  PHASE_EVALUATE,     // Running the circuit
+  PHASE_OUTPUT,       // Writing output pins and the display
+  PHASE_RX_PARSE,     // Reading and dispatching a command
+  PHASE_TX,           // Console text and binary frames
+  PHASE_COUNT
+};
+
+const uint8_t profileBuckets = 16;
+const uint8_t profileBucketShift = 4;
+const uint8_t profileMaxDepth = 4;       // Nested phases tracked at once
+
+struct PhaseStats {
+  uint32_t count;
+  uint32_t min;
+  uint32_t max;
+  uint64_t total;
+  uint16_t buckets[profileBuckets];      // Saturate at 65535
+};
+
+uint8_t profileBucket(uint32_t cycles);
+void clearStats(PhaseStats& stats);
+void addCycles(PhaseStats& stats, uint32_t cycles);
+
+// One PhaseStats as sent in frames: varint count, min, max, mean, buckets
+uint16_t statsBytes(const PhaseStats& stats);
+void putStats(FrameWriter& writer, const PhaseStats& stats);
+
+// ====================
+// PHASE PROFILE
+// ====================
+class PhaseProfile {
+public:
+  PhaseProfile();
+
+  void reset();
+
+  // now is a free-running cycle count; differences wrap cleanly
+  void begin(uint8_t phase, uint32_t now);
+  void end(uint8_t phase, uint32_t now);
+
+  // Records one measurement directly
+  void add(uint8_t phase, uint32_t cycles);
+
+  const PhaseStats& stats(uint8_t phase) const { return phases[phase]; }
+
+  // begin() calls past profileMaxDepth, and end() calls that matched no
+  // open phase; both are left out of the statistics
+  uint16_t unmatched;
+
+private:
+  PhaseStats phases[PHASE_COUNT];
+  uint8_t open[profileMaxDepth];
+  uint32_t started[profileMaxDepth];     // When the phase last resumed
+  uint32_t spent[profileMaxDepth];       // Its cycles before nested phases
+  uint8_t depth;
+};
+
+uint16_t statsFrameLength(const PhaseProfile& profile);
+void writeStatsFrame(FrameWriter& writer, const PhaseProfile& profile, uint32_t cyclesPerSecond);
+
+#endif
@@ -0,0 +1,54 @@
+/*
+ * Digital Logic Lab Simulator - Shift Register
+ */
+
+#include "ShiftRegister.h"
+
+UniversalShiftRegister::UniversalShiftRegister() : bits(0) {
+  setWidth(8);
+}
+
+bool UniversalShiftRegister::setWidth(uint8_t width) {
+  if (width < shiftMinWidth || width > shiftMaxWidth) return false;
+  uint64_t kept = value();
+  bits = width;
+  if (width <= 8) byteRegister.setWidth(width);
+  else if (width <= 16) shortRegister.setWidth(width);
+  else if (width <= 32) longRegister.setWidth(width);
+  else wideRegister.setWidth(width);
+  load(kept);
+  return true;
+}
+
+void UniversalShiftRegister::clear() {
+  load(0);
+}
+
+void UniversalShiftRegister::load(uint64_t value) {
+  if (bits <= 8) byteRegister.load((uint8_t)value);
+  else if (bits <= 16) shortRegister.load((uint16_t)value);
+  else if (bits <= 32) longRegister.load((uint32_t)value);
+  else wideRegister.load(value);
+}
+
+bool UniversalShiftRegister::shift(bool up, bool in) {
+  if (bits <= 8) return up ? byteRegister.shiftUp(in) : byteRegister.shiftDown(in);
+  if (bits <= 16) return up ? shortRegister.shiftUp(in) : shortRegister.shiftDown(in);
+  if (bits <= 32) return up ? longRegister.shiftUp(in) : longRegister.shiftDown(in);
+  return up ? wideRegister.shiftUp(in) : wideRegister.shiftDown(in);
+}
+
+uint64_t UniversalShiftRegister::value() const {
+  if (bits == 0) return 0;
+  if (bits <= 8) return byteRegister.value();
+  if (bits <= 16) return shortRegister.value();
+  if (bits <= 32) return longRegister.value();
+  return wideRegister.value();
+}
+
+bool UniversalShiftRegister::endBit(bool up) const {
+  if (bits <= 8) return byteRegister.endBit(up);
+  if (bits <= 16) return shortRegister.endBit(up);
+  if (bits <= 32) return longRegister.endBit(up);
+  return wideRegister.endBit(up);
+}
@@ -0,0 +1,111 @@
+/*
+ * Digital Logic Lab Simulator - Shift Register
+ * Bidirectional universal shift register with parallel load. The state is
+ * one native word, so a shift is a shift of that word plus a mask and the
+ * bit entering at the far end; ShiftRegister<Word> is that engine for one
+ * word type, and UniversalShiftRegister picks the smallest word for any
+ * width from 4 to 64 bits at run time (an 8-bit register on the Mega is a
+ * single byte shift, a 64-bit one eight).
+ *
+ * The four classic modes only choose which paths are in use:
+ *
+ *   SISO  serial in, serial out        SIPO  serial in, parallel out
+ *   PISO  parallel in, serial out      PIPO  parallel in, parallel out
+ *
+ * Shifting "up" moves bit k to bit k + 1 with the serial input entering
+ * bit 0 and the top bit leaving; shifting "down" is the reverse.
+ */
+
+#ifndef SHIFT_REGISTER_H
+#define SHIFT_REGISTER_H
+
+#include <stdint.h>
+
+// ====================
+// SHIFT REGISTER DEFINITIONS
+// ====================
+enum ShiftMode : uint8_t {
+  SHIFT_SISO,
+  SHIFT_SIPO,
+  SHIFT_PISO,
+  SHIFT_PIPO
+};
+
+const uint8_t shiftMinWidth = 4;
+const uint8_t shiftMaxWidth = 64;
+
+inline bool shiftSerialIn(uint8_t mode) { return mode != SHIFT_PIPO; }
+inline bool shiftParallelIn(uint8_t mode) { return mode == SHIFT_PISO || mode == SHIFT_PIPO; }
+inline bool shiftParallelOut(uint8_t mode) { return mode == SHIFT_SIPO || mode == SHIFT_PIPO; }
+
+// ====================
+// SHIFT REGISTER
+// ====================
+template <typename Word>
+class ShiftRegister {
+public:
+  static const uint8_t maxWidth = 8 * sizeof(Word);
+
+  ShiftRegister() : state(0), mask((Word)~(Word)0), top((Word)1 << (maxWidth - 1)) {}
+
+  // Keeps the low bits of the state; false if width is out of range
+  bool setWidth(uint8_t width) {
+    if (width == 0 || width > maxWidth) return false;
+    mask = (Word)((Word)~(Word)0 >> (maxWidth - width));
+    top = (Word)1 << (width - 1);
+    state &= mask;
+    return true;
+  }
+
+  void clear() { state = 0; }
+  void load(Word value) { state = value & mask; }
+
+  // Each returns the bit shifted out
+  bool shiftUp(bool in) {
+    bool out = (state & top) != 0;
+    state = (Word)(state << 1 | (Word)in) & mask;
+    return out;
+  }
+
+  bool shiftDown(bool in) {
+    bool out = state & 1;
+    state = (Word)(state >> 1) | (((Word)0 - (Word)in) & top);
+    return out;
+  }
+
+  Word value() const { return state; }
+
+  // The bit a shift in that direction would put out next
+  bool endBit(bool up) const { return up ? (state & top) != 0 : (state & 1); }
+
+private:
+  Word state;
+  Word mask;
+  Word top;
+};
+
+// Any width from shiftMinWidth to shiftMaxWidth bits, in the smallest
+// word that holds it
+class UniversalShiftRegister {
+public:
+  UniversalShiftRegister();
+
+  // Changes the width, keeping the low bits; false if out of range
+  bool setWidth(uint8_t width);
+  uint8_t width() const { return bits; }
+
+  void clear();
+  void load(uint64_t value);
+  bool shift(bool up, bool in);
+  uint64_t value() const;
+  bool endBit(bool up) const;
+
+private:
+  uint8_t bits;
+  ShiftRegister<uint8_t> byteRegister;
+  ShiftRegister<uint16_t> shortRegister;
+  ShiftRegister<uint32_t> longRegister;
+  ShiftRegister<uint64_t> wideRegister;
+};
+
+#endif
@@ -0,0 +1,116 @@
+/*
+ * Digital Logic Lab Simulator - Telemetry Streaming
+ */
+
+#include "Telemetry.h"
+
+TelemetryStream::TelemetryStream()
+  : counter(0), events(0), capacity(0), mask(0), head(0), tail(0), lost(0),
+    running(false), primed(false), lastWord(0), lastCounter(0), frames(0) {
+}
+
+void TelemetryStream::begin(TelemetryEvent* storage, uint8_t size) {
+  // Round down to a power of two so the free-running indices wrap cleanly
+  uint8_t rounded = 1;
+  while (rounded <= size / 2 && rounded < 128) rounded <<= 1;
+  events = storage;
+  capacity = size ? rounded : 0;
+  mask = capacity - 1;
+  running = false;
+}
+
+void TelemetryStream::start() {
+  running = false;
+  head = 0;
+  tail = 0;
+  primed = false;
+  if (capacity > 0) running = true;
+}
+
+uint16_t TelemetryStream::lostEvents() const {
+  // Not atomic on 8-bit targets; read until two reads agree
+  uint16_t count;
+  do {
+    count = lost;
+  } while (count != lost);
+  return count;
+}
+
+// Also stands in for record(), so the event carries any change as well
+void TelemetryStream::mark(uint32_t micros, uint16_t word, uint8_t flags) {
+  if (!running) return;
+  uint8_t count = counter;
+  lastWord = word;
+  lastCounter = count;
+  primed = true;
+  if ((uint8_t)(head - tail) >= capacity) {
+    lost++;
+    return;
+  }
+  TelemetryEvent& event = events[head & mask];
+  event.micros = micros;
+  event.word = word;
+  event.counter = count;
+  event.mark = flags;
+  head++;
+}
+
+// Fields that differ from the previous event, on the words as sent
+static uint8_t changedFields(uint16_t word, uint8_t counter, uint16_t previousWord,
+                             uint8_t previousCounter) {
+  uint8_t fields = 0;
+  if ((word ^ previousWord) & 0x00FF) fields |= TELEMETRY_LOW;
+  if ((word ^ previousWord) & 0xFF00) fields |= TELEMETRY_HIGH;
+  if (counter != previousCounter) fields |= TELEMETRY_COUNTER;
+  return fields;
+}
+
+bool TelemetryStream::writeFrame(FrameWriter& writer, uint16_t (*convert)(uint16_t word)) {
+  uint8_t count = pending();
+  if (count == 0) return false;
+  if (count > telemetryMaxEvents) count = telemetryMaxEvents;
+  uint8_t first = tail;
+
+  // Two passes: the frame header carries the payload length
+  uint16_t length = 0;
+  for (uint8_t pass = 0; pass < 2; pass++) {
+    if (pass == 1) {
+      writer.begin(FRAME_TELEMETRY, length);
+      writer.put16(frames++);
+      writer.put16(lostEvents());
+      writer.put32(events[first & mask].micros);
+      writer.put(count);
+    }
+    length = telemetryHeaderBytes;
+    uint32_t previousMicros = events[first & mask].micros;
+    uint16_t previousWord = 0;
+    uint8_t previousCounter = 0;
+    for (uint8_t i = 0; i < count; i++) {
+      const TelemetryEvent& event = events[(uint8_t)(first + i) & mask];
+      uint16_t word = convert ? convert(event.word) : event.word;
+      uint8_t fields = i == 0 ? (uint8_t)TELEMETRY_ALL
+                              : changedFields(word, event.counter, previousWord, previousCounter);
+      if (event.mark) fields |= TELEMETRY_MARK;
+      uint32_t delta = event.micros - previousMicros;
+      if (pass == 0) {
+        length += varintBytes(delta) + 1 + (fields & TELEMETRY_LOW ? 1 : 0) +
+                  (fields & TELEMETRY_HIGH ? 1 : 0) + (fields & TELEMETRY_COUNTER ? 1 : 0) +
+                  (fields & TELEMETRY_MARK ? 1 : 0);
+      }
+      else {
+        writer.putVarint(delta);
+        writer.put(fields);
+        if (fields & TELEMETRY_LOW) writer.put(word & 0xFF);
+        if (fields & TELEMETRY_HIGH) writer.put(word >> 8);
+        if (fields & TELEMETRY_COUNTER) writer.put(event.counter);
+        if (fields & TELEMETRY_MARK) writer.put(event.mark);
+      }
+      previousMicros = event.micros;
+      previousWord = word;
+      previousCounter = event.counter;
+    }
+  }
+  writer.end();
+  tail = first + count;
+  return true;
+}
@@ -0,0 +1,108 @@
+/*
+ * Digital Logic Lab Simulator - Telemetry Streaming
+ * Continuous change-only stream of the I/O word and the counter. A timer
+ * interrupt calls record() with the time in microseconds; it queues an
+ * event only when the word or the counter differs from the last one seen.
+ * The main loop drains the queue into FRAME_TELEMETRY frames:
+ *
+ *   sequence (uint16) | lost (uint16) | base micros (uint32) | count (uint8)
+ *   count x [ varint(micros since the previous event) | fields | changed ]
+ *
+ * where fields has bit 0 set when the low byte of the word follows, bit 1
+ * for the high byte and bit 2 for the counter. The first event of a frame
+ * carries every one of those (delta 0 from the base), so each frame decodes
+ * on its own. Bit 3 marks an event queued by mark(): a byte of flags (the
+ * setup/hold violations of Timing.h) follows the other fields. sequence
+ * counts frames, so the host sees frames lost on the wire; lost is the
+ * running count of events dropped because the queue was full.
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include "Frame.h"
+
+// ====================
+// TELEMETRY DEFINITIONS
+// ====================
+struct TelemetryEvent {
+  uint32_t micros;
+  uint16_t word;
+  uint8_t counter;
+  uint8_t mark;
+};
+
+enum TelemetryField : uint8_t {
+  TELEMETRY_LOW = 1,
+  TELEMETRY_HIGH = 2,
+  TELEMETRY_COUNTER = 4,
+  TELEMETRY_ALL = 7,
+  TELEMETRY_MARK = 8
+};
+
+const uint8_t telemetryHeaderBytes = 9;
+const uint8_t telemetryMaxEvents = 32;   // Per frame, bounds the frame to 9 + 32 * 10 bytes
+
+// ====================
+// TELEMETRY STREAM
+// ====================
+class TelemetryStream {
+public:
+  TelemetryStream();
+
+  // capacity is a power of two up to 128
+  void begin(TelemetryEvent* events, uint8_t capacity);
+  void start();  // Clears the queue; the next record() is always queued
+  void stop() { running = false; }
+  bool active() const { return running; }
+
+  // Queues an event if the word or counter changed. Single producer (ISR).
+  inline void record(uint32_t micros, uint16_t word) {
+    if (!running) return;
+    uint8_t count = counter;
+    if (primed && word == lastWord && count == lastCounter) return;
+    lastWord = word;
+    lastCounter = count;
+    primed = true;
+    if ((uint8_t)(head - tail) >= capacity) {
+      lost++;
+      return;
+    }
+    TelemetryEvent& event = events[head & mask];
+    event.micros = micros;
+    event.word = word;
+    event.counter = count;
+    event.mark = 0;
+    head++;
+  }
+
+  // Queues an event carrying flags even if nothing changed. Same producer.
+  void mark(uint32_t micros, uint16_t word, uint8_t flags);
+
+  uint8_t pending() const { return head - tail; }
+
+  // Sends up to telemetryMaxEvents queued events as one frame; returns
+  // false when nothing was pending. convert maps each word as it is sent.
+  bool writeFrame(FrameWriter& writer, uint16_t (*convert)(uint16_t word));
+
+  uint16_t sequence() const { return frames; }
+  uint16_t lostEvents() const;
+
+  // Mirrored by the firmware
+  volatile uint8_t counter;
+
+private:
+  TelemetryEvent* events;
+  uint8_t capacity;
+  uint8_t mask;
+  volatile uint8_t head;
+  volatile uint8_t tail;
+  volatile uint16_t lost;
+  volatile bool running;
+  bool primed;
+  uint16_t lastWord;
+  uint8_t lastCounter;
+  uint16_t frames;
+};
+
+#endif
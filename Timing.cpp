@@ -0,0 +1,64 @@
+/*
+ * Digital Logic Lab Simulator - Setup/Hold Checking
+ */
+
+#include "Timing.h"
+
+TimingCheck::TimingCheck()
+  : edges(0), setupViolations(0), holdViolations(0), lastViolationMicros(0), lastViolation(0),
+    mask(0), limits(defaultTimingWindow), primed(false), lastWord(0), lastClock(false),
+    changeSeen(false), changeMicros(0), holding(false), edgeMicros(0) {
+}
+
+void TimingCheck::begin(uint16_t dataMask, TimingWindow window) {
+  mask = dataMask;
+  limits = window;
+  primed = false;
+  changeSeen = false;
+  holding = false;
+}
+
+void TimingCheck::clear() {
+  edges = 0;
+  setupViolations = 0;
+  holdViolations = 0;
+  lastViolationMicros = 0;
+  lastViolation = 0;
+}
+
+uint8_t TimingCheck::sample(uint32_t micros, uint16_t word, bool clock) {
+  if (!primed) {
+    primed = true;
+    lastWord = word;
+    lastClock = clock;
+    return 0;
+  }
+  uint16_t changed = (word ^ lastWord) & mask;
+  bool rising = clock && !lastClock;
+  lastWord = word;
+  lastClock = clock;
+
+  // Windows are closed once passed, so old times never wrap into them
+  if (holding && micros - edgeMicros > limits.holdMicros) holding = false;
+  if (changeSeen && micros - changeMicros > limits.setupMicros) changeSeen = false;
+
+  uint8_t found = 0;
+  if (changed) {
+    if (holding) found |= TIMING_HOLD;
+    changeSeen = true;
+    changeMicros = micros;
+  }
+  if (rising && mask) {
+    edges++;
+    if (changeSeen) found |= TIMING_SETUP;
+    holding = true;
+    edgeMicros = micros;
+  }
+  if (found) {
+    if (found & TIMING_SETUP) setupViolations++;
+    if (found & TIMING_HOLD) holdViolations++;
+    lastViolationMicros = micros;
+    lastViolation = found;
+  }
+  return found;
+}
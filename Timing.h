@@ -0,0 +1,72 @@
+/*
+ * Digital Logic Lab Simulator - Setup/Hold Checking
+ * Checks a flip-flop's data inputs against its clock the way a static
+ * timing checker would, on timestamped samples of the port word and the
+ * clock pin taken by a timer interrupt:
+ *
+ *   setup  a data bit changed no more than setupMicros before a rising
+ *          clock edge (a change in the same sample as the edge counts)
+ *   hold   a data bit changed no more than holdMicros after one
+ *
+ * Changes are dated to the sample that first sees them, so windows are
+ * only as exact as the sample period.
+ */
+
+#ifndef TIMING_H
+#define TIMING_H
+
+#include <stdint.h>
+
+// ====================
+// TIMING DEFINITIONS
+// ====================
+enum TimingViolation : uint8_t {
+  TIMING_SETUP = 1,
+  TIMING_HOLD = 2
+};
+
+struct TimingWindow {
+  uint16_t setupMicros;
+  uint16_t holdMicros;
+};
+
+const TimingWindow defaultTimingWindow = {2000, 1000};
+
+// ====================
+// TIMING CHECK
+// ====================
+class TimingCheck {
+public:
+  TimingCheck();
+
+  // Watches the dataMask bits of the sampled word (0 checks nothing)
+  // and forgets the sample history; the counts are kept
+  void begin(uint16_t dataMask, TimingWindow window);
+  void clear();
+
+  // One sample; returns the TimingViolation bits it found. Single caller (ISR).
+  uint8_t sample(uint32_t micros, uint16_t word, bool clock);
+
+  uint16_t watched() const { return mask; }
+  const TimingWindow& window() const { return limits; }
+
+  // Written by sample(); read with interrupts off
+  uint32_t edges;
+  uint16_t setupViolations;
+  uint16_t holdViolations;
+  uint32_t lastViolationMicros;
+  uint8_t lastViolation;
+
+private:
+  uint16_t mask;
+  TimingWindow limits;
+  bool primed;
+  uint16_t lastWord;
+  bool lastClock;
+  bool changeSeen;
+  uint32_t changeMicros;
+  bool holding;
+  uint32_t edgeMicros;
+};
+
+#endif
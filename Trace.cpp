@@ -0,0 +1,90 @@
+/*
+ * Digital Logic Lab Simulator - Event Tracing
+ */
+
+#include "Trace.h"
+
+const char* traceName(uint8_t id) {
+  static const char* const names[TRACE_ID_COUNT] = {
+    "sample", "debounce", "evaluate", "output", "rx_parse", "tx",
+    "capture_isr", "telemetry_isr", "read_line", "input_edge"
+  };
+  return id < TRACE_ID_COUNT ? names[id] : "unknown";
+}
+
+TraceBuffer::TraceBuffer()
+  : events(0), capacity(0), mask(0), head(0), tail(0), lost(0), running(false), frames(0) {
+}
+
+void TraceBuffer::begin(TraceEvent* storage, uint8_t size) {
+  // Round down to a power of two so the free-running indices wrap cleanly
+  uint8_t rounded = 1;
+  while (rounded <= size / 2 && rounded < 128) rounded <<= 1;
+  events = storage;
+  capacity = size ? rounded : 0;
+  mask = capacity - 1;
+  running = false;
+}
+
+void TraceBuffer::start() {
+  running = false;
+  head = 0;
+  tail = 0;
+  lost = 0;
+  frames = 0;
+  if (capacity > 0) running = true;
+}
+
+uint16_t TraceBuffer::lostEvents() const {
+  // Not atomic on 8-bit targets; read until two reads agree
+  uint16_t count;
+  do {
+    count = lost;
+  } while (count != lost);
+  return count;
+}
+
+bool TraceBuffer::read(TraceEvent& event) {
+  if (head == tail) return false;
+  event = events[tail & mask];
+  tail++;
+  return true;
+}
+
+bool TraceBuffer::writeFrame(FrameWriter& writer, uint32_t ticksPerSecond) {
+  uint8_t count = pending();
+  if (count == 0) return false;
+  if (count > traceMaxEvents) count = traceMaxEvents;
+  uint8_t first = tail;
+  uint32_t base = events[first & mask].ticks;
+
+  // Two passes: the frame header carries the payload length
+  uint16_t length = traceHeaderBytes;
+  for (uint8_t pass = 0; pass < 2; pass++) {
+    if (pass == 1) {
+      writer.begin(FRAME_TRACE, length);
+      writer.put16(frames++);
+      writer.put16(lostEvents());
+      writer.put32(ticksPerSecond);
+      writer.put32(base);
+      writer.put(count);
+    }
+    uint32_t previous = base;
+    for (uint8_t i = 0; i < count; i++) {
+      const TraceEvent& event = events[(uint8_t)(first + i) & mask];
+      uint32_t delta = event.ticks - previous;
+      if (pass == 0) {
+        length += varintBytes(delta) + 1 + varintBytes(event.arg);
+      }
+      else {
+        writer.putVarint(delta);
+        writer.put(event.kind << 6 | (event.id & 0x3F));
+        writer.putVarint(event.arg);
+      }
+      previous = event.ticks;
+    }
+  }
+  writer.end();
+  tail = first + count;
+  return true;
+}
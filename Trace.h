@@ -0,0 +1,108 @@
+/*
+ * Digital Logic Lab Simulator - Event Tracing
+ * Timeline of what the simulator was doing: begin and end events for the
+ * loop phases, interrupt handlers and command handling, and instant marks
+ * such as input edges, queued in a ring buffer with a free-running tick
+ * count. The firmware drains the buffer into FRAME_TRACE frames; host
+ * simulators read it back from memory. Either way the host turns the
+ * events into a Chrome trace (host/TraceExport.h) so a blocking read or a
+ * full TX buffer shows up against the input edges around it.
+ *
+ *   sequence (uint16) | lost (uint16) | ticks per second (uint32) |
+ *   base ticks (uint32) | count (uint8)
+ *   count x [ varint(ticks since the previous event) | kind << 6 | id |
+ *             varint(arg) ]
+ *
+ * The first event's delta is 0 from the base. sequence counts frames and
+ * lost is the running count of events dropped because the buffer was full.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "Frame.h"
+#include "Profile.h"
+
+// ====================
+// TRACE DEFINITIONS
+// ====================
+enum TraceKind : uint8_t {
+  TRACE_KIND_BEGIN = 0,
+  TRACE_KIND_END = 1,
+  TRACE_KIND_INSTANT = 2
+};
+
+// Loop phases keep their ProfilePhase numbers
+enum TraceId : uint8_t {
+  TRACE_CAPTURE_ISR = PHASE_COUNT,
+  TRACE_TELEMETRY_ISR,
+  TRACE_READ_LINE,      // Serial.readStringUntil
+  TRACE_INPUT_EDGE,     // Instant; arg is the new input word
+  TRACE_ID_COUNT
+};
+
+struct TraceEvent {
+  uint32_t ticks;
+  uint16_t arg;
+  uint8_t id;
+  uint8_t kind;
+};
+
+const uint8_t traceHeaderBytes = 13;
+const uint8_t traceMaxEvents = 32;     // Per frame
+
+const char* traceName(uint8_t id);
+
+// ====================
+// TRACE BUFFER
+// ====================
+class TraceBuffer {
+public:
+  TraceBuffer();
+
+  // capacity is a power of two up to 128
+  void begin(TraceEvent* events, uint8_t capacity);
+  void start();  // Clears the buffer and the counts
+  void stop() { running = false; }
+  bool active() const { return running; }
+
+  // Queues one event, or counts it lost when the buffer is full. Callers
+  // that can be interrupted by another producer must hold interrupts off.
+  inline void record(uint32_t ticks, uint8_t id, uint8_t kind, uint16_t arg) {
+    if (!running) return;
+    if ((uint8_t)(head - tail) >= capacity) {
+      lost++;
+      return;
+    }
+    TraceEvent& event = events[head & mask];
+    event.ticks = ticks;
+    event.arg = arg;
+    event.id = id;
+    event.kind = kind;
+    head++;
+  }
+
+  uint8_t pending() const { return head - tail; }
+
+  // Takes the oldest event, for readers in the same memory
+  bool read(TraceEvent& event);
+
+  // Sends up to traceMaxEvents events as one frame; false when none were
+  // pending
+  bool writeFrame(FrameWriter& writer, uint32_t ticksPerSecond);
+
+  uint16_t sequence() const { return frames; }
+  uint16_t lostEvents() const;
+
+private:
+  TraceEvent* events;
+  uint8_t capacity;
+  uint8_t mask;
+  volatile uint8_t head;
+  volatile uint8_t tail;
+  volatile uint16_t lost;
+  volatile bool running;
+  uint16_t frames;
+};
+
+#endif
@@ -0,0 +1,337 @@
+"""
+Generates the netlist benchmark corpus used to size the simulation engines.
+
+c17 and s27 are the original ISCAS-85/89 circuits. The rest are generated
+equivalents of the ISCAS arithmetic benchmarks, from lab-sized adders up to
+c6288/c7552-sized multipliers and adder/comparators, plus sequential
+counters and LFSRs. Every circuit is written as .bench; a few are also
+written as BLIF to exercise that importer.
+
+Usage: python benchmarks/generate_corpus.py [output_dir]
+"""
+
+import os
+import sys
+
+
+class Circuit:
+    """Accumulates a gate-level netlist and writes it as .bench or BLIF"""
+
+    def __init__(self, name, description):
+        self.name = name
+        self.description = description
+        self.inputs = []
+        self.outputs = []
+        self.gates = []  # (output, type, [inputs])
+        self.counter = 0
+
+    def input(self, name):
+        self.inputs.append(name)
+        return name
+
+    def output(self, name):
+        self.outputs.append(name)
+
+    def gate(self, gate_type, *operands, name=None):
+        if name is None:
+            self.counter += 1
+            name = f"n{self.counter}"
+        self.gates.append((name, gate_type, list(operands)))
+        return name
+
+    def gate_count(self):
+        return sum(1 for _, gate_type, _ in self.gates if gate_type != "DFF")
+
+    def write_bench(self, path):
+        with open(path, "w") as f:
+            f.write(f"# {self.name}: {self.description}\n")
+            f.write(f"# {len(self.inputs)} inputs, {len(self.outputs)} outputs, "
+                    f"{self.gate_count()} gates, "
+                    f"{len(self.gates) - self.gate_count()} flip-flops\n\n")
+            for name in self.inputs:
+                f.write(f"INPUT({name})\n")
+            f.write("\n")
+            for name in self.outputs:
+                f.write(f"OUTPUT({name})\n")
+            f.write("\n")
+            for name, gate_type, operands in self.gates:
+                f.write(f"{name} = {gate_type}({', '.join(operands)})\n")
+
+    def write_blif(self, path):
+        covers = {
+            "AND": lambda n: [("1" * n, "1")],
+            "NAND": lambda n: [("1" * n, "0")],
+            "OR": lambda n: [("-" * i + "1" + "-" * (n - i - 1), "1") for i in range(n)],
+            "NOR": lambda n: [("0" * n, "1")],
+            "XOR": lambda n: [("01", "1"), ("10", "1")],
+            "XNOR": lambda n: [("00", "1"), ("11", "1")],
+            "NOT": lambda n: [("0", "1")],
+            "BUFF": lambda n: [("1", "1")],
+        }
+        with open(path, "w") as f:
+            f.write(f"# {self.name}: {self.description}\n")
+            f.write(f".model {self.name}\n")
+            f.write(".inputs " + " ".join(self.inputs) + "\n")
+            f.write(".outputs " + " ".join(self.outputs) + "\n")
+            for name, gate_type, operands in self.gates:
+                if gate_type == "DFF":
+                    f.write(f".latch {operands[0]} {name} re clk 0\n")
+                    continue
+                f.write(f".names {' '.join(operands)} {name}\n")
+                for cube, value in covers[gate_type](len(operands)):
+                    f.write(f"{cube} {value}\n")
+            f.write(".end\n")
+
+
+# ====================
+# BUILDING BLOCKS
+# ====================
+def full_adder_xor(c, a, b, cin):
+    x = c.gate("XOR", a, b)
+    s = c.gate("XOR", x, cin)
+    carry = c.gate("OR", c.gate("AND", a, b), c.gate("AND", x, cin))
+    return s, carry
+
+
+def full_adder_nand(c, a, b, cin):
+    # Nine NAND gates, as in the ISCAS arithmetic circuits
+    t1 = c.gate("NAND", a, b)
+    x = c.gate("NAND", c.gate("NAND", a, t1), c.gate("NAND", b, t1))
+    t4 = c.gate("NAND", x, cin)
+    s = c.gate("NAND", c.gate("NAND", x, t4), c.gate("NAND", cin, t4))
+    carry = c.gate("NAND", t4, t1)
+    return s, carry
+
+
+def half_adder(c, a, b):
+    return c.gate("XOR", a, b), c.gate("AND", a, b)
+
+
+def operands(c, width):
+    a = [c.input(f"A{i}") for i in range(width)]
+    b = [c.input(f"B{i}") for i in range(width)]
+    return a, b
+
+
+# ====================
+# CIRCUITS
+# ====================
+def c17():
+    c = Circuit("c17", "ISCAS-85 c17")
+    for name in ["1", "2", "3", "6", "7"]:
+        c.input(name)
+    c.output("22")
+    c.output("23")
+    c.gate("NAND", "1", "3", name="10")
+    c.gate("NAND", "3", "6", name="11")
+    c.gate("NAND", "2", "11", name="16")
+    c.gate("NAND", "11", "7", name="19")
+    c.gate("NAND", "10", "16", name="22")
+    c.gate("NAND", "16", "19", name="23")
+    return c
+
+
+def s27():
+    c = Circuit("s27", "ISCAS-89 s27")
+    for name in ["G0", "G1", "G2", "G3"]:
+        c.input(name)
+    c.output("G17")
+    c.gate("DFF", "G10", name="G5")
+    c.gate("DFF", "G11", name="G6")
+    c.gate("DFF", "G13", name="G7")
+    c.gate("NOT", "G0", name="G14")
+    c.gate("NOT", "G11", name="G17")
+    c.gate("AND", "G14", "G6", name="G8")
+    c.gate("OR", "G12", "G8", name="G15")
+    c.gate("OR", "G3", "G8", name="G16")
+    c.gate("NAND", "G16", "G15", name="G9")
+    c.gate("NOR", "G14", "G11", name="G10")
+    c.gate("NOR", "G5", "G9", name="G11")
+    c.gate("NOR", "G1", "G7", name="G12")
+    c.gate("NOR", "G2", "G12", name="G13")
+    return c
+
+
+def ripple_adder(width, nand=False):
+    c = Circuit(f"rca{width}", f"{width}-bit ripple-carry adder")
+    a, b = operands(c, width)
+    carry = c.input("CIN")
+    adder = full_adder_nand if nand else full_adder_xor
+    for i in range(width):
+        s, carry = adder(c, a[i], b[i], carry)
+        c.output(c.gate("BUFF", s, name=f"S{i}"))
+    c.output(c.gate("BUFF", carry, name="COUT"))
+    return c
+
+
+def lookahead_adder(width, group=4):
+    c = Circuit(f"cla{width}", f"{width}-bit carry-lookahead adder, {group}-bit groups")
+    a, b = operands(c, width)
+    carry = c.input("CIN")
+    for base in range(0, width, group):
+        g = [c.gate("AND", a[i], b[i]) for i in range(base, base + group)]
+        p = [c.gate("XOR", a[i], b[i]) for i in range(base, base + group)]
+        carries = [carry]
+        for i in range(1, group + 1):
+            # c[i] = g[i-1] | p[i-1]g[i-2] | ... | p[i-1]..p[0]c[0]
+            terms = [g[i - 1]]
+            for j in range(i - 2, -2, -1):
+                chain = p[j + 1:i]
+                terms.append(c.gate("AND", *chain, g[j] if j >= 0 else carry))
+            carries.append(c.gate("OR", *terms))
+        for i in range(group):
+            c.output(c.gate("XOR", p[i], carries[i], name=f"S{base + i}"))
+        carry = carries[group]
+    c.output(c.gate("BUFF", carry, name="COUT"))
+    return c
+
+
+def comparator(c, a, b):
+    width = len(a)
+    eq = [c.gate("XNOR", a[i], b[i]) for i in range(width)]
+    greater, less = [], []
+    for i in range(width):
+        higher = eq[i + 1:]
+        greater.append(c.gate("AND", a[i], c.gate("NOT", b[i]), *higher))
+        less.append(c.gate("AND", c.gate("NOT", a[i]), b[i], *higher))
+    return c.gate("OR", *greater), c.gate("AND", *eq), c.gate("OR", *less)
+
+
+def magnitude_comparator(width):
+    c = Circuit(f"cmp{width}", f"{width}-bit magnitude comparator")
+    a, b = operands(c, width)
+    gt, eq, lt = comparator(c, a, b)
+    c.output(c.gate("BUFF", gt, name="AGTB"))
+    c.output(c.gate("BUFF", eq, name="AEQB"))
+    c.output(c.gate("BUFF", lt, name="ALTB"))
+    return c
+
+
+def adder_comparator(width):
+    # Same function as c7552: adder plus magnitude comparator and parity
+    c = Circuit(f"addcmp{width}", f"{width}-bit adder with magnitude comparator "
+                f"and operand parity (c7552 equivalent)")
+    a, b = operands(c, width)
+    carry = c.input("CIN")
+    for i in range(width):
+        s, carry = full_adder_nand(c, a[i], b[i], carry)
+        c.output(c.gate("BUFF", s, name=f"S{i}"))
+    c.output(c.gate("BUFF", carry, name="COUT"))
+    gt, eq, lt = comparator(c, a, b)
+    c.output(c.gate("BUFF", gt, name="AGTB"))
+    c.output(c.gate("BUFF", eq, name="AEQB"))
+    c.output(c.gate("BUFF", lt, name="ALTB"))
+    for name, bits in (("PA", a), ("PB", b)):
+        parity = bits[0]
+        for bit in bits[1:]:
+            parity = c.gate("XOR", parity, bit)
+        c.output(c.gate("BUFF", parity, name=name))
+    return c
+
+
+def add_bits(c, bits):
+    """Adds up to three bits of equal weight; returns (sum, carry or None)"""
+    if len(bits) == 1:
+        return bits[0], None
+    if len(bits) == 2:
+        return half_adder(c, *bits)
+    return full_adder_nand(c, *bits)
+
+
+def array_multiplier(width):
+    # Carry-save array of NAND full adders, the structure of c6288
+    c = Circuit(f"mul{width}", f"{width}x{width} array multiplier")
+    a, b = operands(c, width)
+    pp = [[c.gate("AND", a[i], b[j]) for i in range(width)] for j in range(width)]
+
+    # After row j, sums[i] has weight i + j and carries[i] weight i + j + 1
+    sums = pp[0][:]
+    carries = [None] * width
+    c.output(c.gate("BUFF", sums[0], name="P0"))
+    for j in range(1, width):
+        row_sums, row_carries = [], []
+        for i in range(width):
+            bits = [pp[j][i]]
+            if i + 1 < width:
+                bits.append(sums[i + 1])
+            if carries[i]:
+                bits.append(carries[i])
+            s, carry = add_bits(c, bits)
+            row_sums.append(s)
+            row_carries.append(carry)
+        sums, carries = row_sums, row_carries
+        c.output(c.gate("BUFF", sums[0], name=f"P{j}"))
+
+    # Ripple stage merges the remaining sums and carries
+    carry = None
+    for k in range(width):
+        bits = [bit for bit in (sums[k + 1] if k + 1 < width else None, carries[k], carry) if bit]
+        s, carry = add_bits(c, bits)
+        c.output(c.gate("BUFF", s, name=f"P{width + k}"))
+    return c
+
+
+def counter(width):
+    c = Circuit(f"cnt{width}", f"{width}-bit synchronous counter with enable and reset")
+    enable = c.input("EN")
+    reset = c.input("RST")
+    keep = c.gate("NOT", reset)
+    carry = enable
+    for i in range(width):
+        q = f"Q{i}"
+        t = c.gate("XOR", q, carry)
+        c.gate("DFF", c.gate("AND", t, keep), name=q)
+        carry = c.gate("AND", q, carry)
+        c.output(q)
+    c.output(c.gate("BUFF", carry, name="CARRY"))
+    return c
+
+
+def lfsr(width, taps):
+    c = Circuit(f"lfsr{width}", f"{width}-bit Fibonacci LFSR, taps {taps}")
+    seed = c.input("SEED")
+    feedback = f"Q{taps[0] - 1}"
+    for tap in taps[1:]:
+        feedback = c.gate("XOR", feedback, f"Q{tap - 1}")
+    c.gate("DFF", c.gate("XOR", feedback, seed), name="Q0")
+    for i in range(1, width):
+        c.gate("DFF", f"Q{i - 1}", name=f"Q{i}")
+    for i in range(width):
+        c.output(f"Q{i}")
+    return c
+
+
+CORPUS = [
+    (c17, (), ("bench", "blif")),
+    (s27, (), ("bench", "blif")),
+    (ripple_adder, (8,), ("bench", "blif")),
+    (ripple_adder, (32,), ("bench",)),
+    (lookahead_adder, (64,), ("bench",)),
+    (magnitude_comparator, (32,), ("bench",)),
+    (array_multiplier, (4,), ("bench", "blif")),
+    (array_multiplier, (8,), ("bench",)),
+    (array_multiplier, (16,), ("bench",)),
+    (adder_comparator, (32,), ("bench",)),
+    (array_multiplier, (20,), ("bench",)),
+    (counter, (16,), ("bench", "blif")),
+    (lfsr, (32, (32, 22, 2, 1)), ("bench",)),
+]
+
+
+def main():
+    out_dir = sys.argv[1] if len(sys.argv) > 1 else os.path.dirname(os.path.abspath(__file__))
+    os.makedirs(out_dir, exist_ok=True)
+    for factory, args, formats in CORPUS:
+        circuit = factory(*args)
+        for fmt in formats:
+            path = os.path.join(out_dir, f"{circuit.name}.{fmt}")
+            if fmt == "bench":
+                circuit.write_bench(path)
+            else:
+                circuit.write_blif(path)
+        print(f"{circuit.name:10s} {len(circuit.inputs):4d} in {len(circuit.outputs):4d} out "
+              f"{circuit.gate_count():6d} gates")
+
+
+if __name__ == "__main__":
+    main()
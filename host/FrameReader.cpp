@@ -0,0 +1,333 @@
+/*
+ * Digital Logic Lab Simulator - Serial Frame Decoding (host tools)
+ */
+
+#include "FrameReader.h"
+
+FrameReader::FrameReader()
+  : skippedBytes(0), crcErrors(0), stage(SYNC0), frameType(0), length(0),
+    crc(0xFFFF), received(0) {
+}
+
+bool FrameReader::feed(uint8_t byte) {
+  switch (stage) {
+    case SYNC0:
+      if (byte == frameSync0) stage = SYNC1;
+      else skippedBytes++;
+      return false;
+    case SYNC1:
+      if (byte == frameSync1) {
+        stage = TYPE;
+        crc = 0xFFFF;
+      }
+      else {
+        skippedBytes++;
+        if (byte != frameSync0) stage = SYNC0;
+      }
+      return false;
+    case TYPE:
+      frameType = byte;
+      crc = crc16Update(crc, byte);
+      stage = LENGTH0;
+      return false;
+    case LENGTH0:
+      length = byte;
+      crc = crc16Update(crc, byte);
+      stage = LENGTH1;
+      return false;
+    case LENGTH1:
+      length |= (uint16_t)byte << 8;
+      crc = crc16Update(crc, byte);
+      data.clear();
+      data.reserve(length);
+      received = 0;
+      stage = length ? PAYLOAD : CRC0;
+      return false;
+    case PAYLOAD:
+      data.push_back(byte);
+      crc = crc16Update(crc, byte);
+      if (++received == length) stage = CRC0;
+      return false;
+    case CRC0:
+      received = byte;
+      stage = CRC1;
+      return false;
+    case CRC1:
+      stage = SYNC0;
+      if ((uint16_t)(received | (uint16_t)byte << 8) == crc) return true;
+      crcErrors++;
+      return false;
+  }
+  return false;
+}
+
+uint16_t payload16(const std::vector<uint8_t>& payload, size_t offset) {
+  return payload[offset] | (uint16_t)payload[offset + 1] << 8;
+}
+
+uint32_t payload32(const std::vector<uint8_t>& payload, size_t offset) {
+  return payload16(payload, offset) | (uint32_t)payload16(payload, offset + 2) << 16;
+}
+
+bool payloadVarint(const std::vector<uint8_t>& payload, size_t& offset, uint32_t& value) {
+  value = 0;
+  for (unsigned shift = 0; shift < 35 && offset < payload.size(); shift += 7) {
+    uint8_t byte = payload[offset++];
+    value |= (uint32_t)(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) return true;
+  }
+  return false;
+}
+
+bool decodeCapture(const std::vector<uint8_t>& payload, CaptureHeader& header,
+                   std::vector<uint16_t>& words, std::string& error) {
+  if (payload.size() < captureHeaderBytes) {
+    error = "capture frame too short";
+    return false;
+  }
+  header.version = payload[0];
+  header.triggerType = payload[1];
+  header.rateHz = payload32(payload, 2);
+  header.elapsedMicros = payload32(payload, 6);
+  header.samples = payload32(payload, 10);
+  header.dropped = payload32(payload, 14);
+  header.count = payload16(payload, 18);
+  header.triggerIndex = payload16(payload, 20);
+  if (header.version != captureFrameVersion) {
+    error = "unsupported capture frame version " + std::to_string(header.version);
+    return false;
+  }
+  if (payload.size() != captureHeaderBytes + 2 * (size_t)header.count) {
+    error = "capture frame length does not match its sample count";
+    return false;
+  }
+  words.resize(header.count);
+  for (uint16_t i = 0; i < header.count; i++) {
+    words[i] = payload16(payload, captureHeaderBytes + 2 * i);
+  }
+  return true;
+}
+
+bool decodeRleCapture(const std::vector<uint8_t>& payload, RleCaptureHeader& header,
+                      std::vector<CaptureTransition>& transitions, std::string& error) {
+  if (payload.size() < rleCaptureHeaderBytes) {
+    error = "rle capture frame too short";
+    return false;
+  }
+  header.version = payload[0];
+  header.triggerType = payload[1];
+  header.rateHz = payload32(payload, 2);
+  header.elapsedMicros = payload32(payload, 6);
+  header.samples = payload32(payload, 10);
+  header.dropped = payload32(payload, 14);
+  header.baseSample = payload32(payload, 18);
+  header.triggerSample = payload32(payload, 22);
+  header.bytes = payload16(payload, 26);
+  if (header.version != captureFrameVersion) {
+    error = "unsupported capture frame version " + std::to_string(header.version);
+    return false;
+  }
+  if (payload.size() != rleCaptureHeaderBytes + (size_t)header.bytes) {
+    error = "rle capture frame length does not match its record bytes";
+    return false;
+  }
+
+  transitions.clear();
+  uint64_t sample = header.baseSample;
+  size_t at = rleCaptureHeaderBytes;
+  while (at < payload.size()) {
+    uint64_t delta = 0;
+    unsigned shift = 0;
+    uint8_t byte;
+    do {
+      byte = payload[at++];
+      delta |= (uint64_t)(byte & 0x7F) << shift;
+      shift += 7;
+    } while ((byte & 0x80) && at < payload.size() && shift < 35);
+    if ((byte & 0x80) || at + 2 > payload.size()) {
+      error = "rle capture record truncated";
+      return false;
+    }
+    sample += delta;
+    if (sample >= header.samples) {
+      error = "rle capture record past the last sample";
+      return false;
+    }
+    CaptureTransition transition = {(uint32_t)sample, payload16(payload, at)};
+    transitions.push_back(transition);
+    at += 2;
+  }
+  return true;
+}
+
+bool expandRleCapture(const RleCaptureHeader& header,
+                      const std::vector<CaptureTransition>& transitions,
+                      std::vector<uint16_t>& words, size_t maxWords, std::string& error) {
+  words.clear();
+  if (transitions.empty()) return true;
+  size_t count = header.samples - transitions.front().sample;
+  if (count > maxWords) {
+    error = "rle capture expands to " + std::to_string(count) + " samples";
+    return false;
+  }
+  words.reserve(count);
+  for (size_t i = 0; i < transitions.size(); i++) {
+    uint32_t end = i + 1 < transitions.size() ? transitions[i + 1].sample : header.samples;
+    words.insert(words.end(), end - transitions[i].sample, transitions[i].word);
+  }
+  return true;
+}
+
+bool decodeTelemetry(const std::vector<uint8_t>& payload, TelemetryFrame& frame,
+                     std::string& error) {
+  if (payload.size() < telemetryHeaderBytes) {
+    error = "telemetry frame too short";
+    return false;
+  }
+  frame.sequence = payload16(payload, 0);
+  frame.lost = payload16(payload, 2);
+  uint32_t micros = payload32(payload, 4);
+  uint8_t count = payload[8];
+  frame.events.clear();
+  frame.events.reserve(count);
+
+  TelemetryEvent event = {micros, 0, 0, 0};
+  size_t at = telemetryHeaderBytes;
+  for (uint8_t i = 0; i < count; i++) {
+    uint32_t delta = 0;
+    unsigned shift = 0;
+    uint8_t byte = 0x80;
+    while ((byte & 0x80) && at < payload.size() && shift < 35) {
+      byte = payload[at++];
+      delta |= (uint32_t)(byte & 0x7F) << shift;
+      shift += 7;
+    }
+    if ((byte & 0x80) || at >= payload.size()) {
+      error = "telemetry event truncated";
+      return false;
+    }
+    uint8_t fields = payload[at++];
+    if (i == 0 && (fields & TELEMETRY_ALL) != TELEMETRY_ALL) {
+      error = "telemetry frame does not start with a full event";
+      return false;
+    }
+    size_t needed = (fields & TELEMETRY_LOW ? 1 : 0) + (fields & TELEMETRY_HIGH ? 1 : 0) +
+                    (fields & TELEMETRY_COUNTER ? 1 : 0) + (fields & TELEMETRY_MARK ? 1 : 0);
+    if (at + needed > payload.size()) {
+      error = "telemetry event truncated";
+      return false;
+    }
+    event.micros += delta;
+    if (fields & TELEMETRY_LOW) event.word = (event.word & 0xFF00) | payload[at++];
+    if (fields & TELEMETRY_HIGH) event.word = (event.word & 0x00FF) | (uint16_t)payload[at++] << 8;
+    if (fields & TELEMETRY_COUNTER) event.counter = payload[at++];
+    event.mark = fields & TELEMETRY_MARK ? payload[at++] : 0;
+    frame.events.push_back(event);
+  }
+  if (at != payload.size()) {
+    error = "telemetry frame length does not match its events";
+    return false;
+  }
+  return true;
+}
+
+// One PhaseStats as putStats() sends it
+static bool payloadSummary(const std::vector<uint8_t>& payload, size_t& at, uint8_t buckets,
+                           PhaseSummary& summary) {
+  summary.buckets.resize(buckets);
+  bool ok = payloadVarint(payload, at, summary.count) && payloadVarint(payload, at, summary.min) &&
+            payloadVarint(payload, at, summary.max) && payloadVarint(payload, at, summary.mean);
+  for (uint8_t b = 0; ok && b < buckets; b++) ok = payloadVarint(payload, at, summary.buckets[b]);
+  return ok;
+}
+
+bool decodeStats(const std::vector<uint8_t>& payload, StatsFrame& frame, std::string& error) {
+  if (payload.size() < 7) {
+    error = "stats frame too short";
+    return false;
+  }
+  frame.cyclesPerSecond = payload32(payload, 0);
+  uint8_t phases = payload[4];
+  uint8_t buckets = payload[5];
+  frame.bucketShift = payload[6];
+  frame.phases.assign(phases, PhaseSummary());
+  size_t at = 7;
+  for (PhaseSummary& phase : frame.phases) {
+    if (!payloadSummary(payload, at, buckets, phase)) {
+      error = "stats frame truncated";
+      return false;
+    }
+  }
+  if (at != payload.size()) {
+    error = "stats frame length does not match its phases";
+    return false;
+  }
+  return true;
+}
+
+bool decodeLatency(const std::vector<uint8_t>& payload, LatencyFrame& frame, std::string& error) {
+  if (payload.size() < 7) {
+    error = "latency frame too short";
+    return false;
+  }
+  frame.cyclesPerSecond = payload32(payload, 0);
+  uint8_t circuits = payload[4];
+  uint8_t buckets = payload[5];
+  frame.bucketShift = payload[6];
+  frame.circuits.assign(circuits, LatencyCircuit());
+  size_t at = 7;
+  for (LatencyCircuit& circuit : frame.circuits) {
+    if (at >= payload.size()) {
+      error = "latency frame truncated";
+      return false;
+    }
+    circuit.circuit = payload[at++];
+    if (!payloadVarint(payload, at, circuit.timeouts) ||
+        !payloadSummary(payload, at, buckets, circuit.latency)) {
+      error = "latency frame truncated";
+      return false;
+    }
+  }
+  if (at != payload.size()) {
+    error = "latency frame length does not match its circuits";
+    return false;
+  }
+  return true;
+}
+
+bool decodeTrace(const std::vector<uint8_t>& payload, TraceFrame& frame, std::string& error) {
+  if (payload.size() < traceHeaderBytes) {
+    error = "trace frame too short";
+    return false;
+  }
+  frame.sequence = payload16(payload, 0);
+  frame.lost = payload16(payload, 2);
+  frame.ticksPerSecond = payload32(payload, 4);
+  uint32_t ticks = payload32(payload, 8);
+  uint8_t count = payload[12];
+  frame.events.clear();
+  frame.events.reserve(count);
+
+  size_t at = traceHeaderBytes;
+  for (uint8_t i = 0; i < count; i++) {
+    uint32_t delta;
+    uint32_t arg;
+    if (!payloadVarint(payload, at, delta) || at >= payload.size()) {
+      error = "trace event truncated";
+      return false;
+    }
+    uint8_t kindAndId = payload[at++];
+    if (!payloadVarint(payload, at, arg)) {
+      error = "trace event truncated";
+      return false;
+    }
+    ticks += delta;
+    TraceEvent event = {ticks, (uint16_t)arg, (uint8_t)(kindAndId & 0x3F), (uint8_t)(kindAndId >> 6)};
+    frame.events.push_back(event);
+  }
+  if (at != payload.size()) {
+    error = "trace frame length does not match its events";
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,123 @@
+/*
+ * Digital Logic Lab Simulator - Serial Frame Decoding (host tools)
+ * Picks the binary frames described in Frame.h out of a serial byte
+ * stream that also carries the firmware's text console, and decodes their
+ * payloads.
+ */
+
+#ifndef FRAME_READER_H
+#define FRAME_READER_H
+
+#include "../Capture.h"
+#include "../Frame.h"
+#include "../Profile.h"
+#include "../Telemetry.h"
+#include "../Trace.h"
+
+#include <string>
+#include <vector>
+
+// Incremental frame parser; text and damaged frames are skipped
+class FrameReader {
+public:
+  FrameReader();
+
+  // Returns true when byte completes a frame with a valid CRC
+  bool feed(uint8_t byte);
+
+  uint8_t type() const { return frameType; }
+  const std::vector<uint8_t>& payload() const { return data; }
+
+  uint64_t skippedBytes;  // Bytes outside frames (console text, noise)
+  uint32_t crcErrors;
+
+private:
+  enum Stage { SYNC0, SYNC1, TYPE, LENGTH0, LENGTH1, PAYLOAD, CRC0, CRC1 };
+
+  Stage stage;
+  uint8_t frameType;
+  uint16_t length;
+  uint16_t crc;
+  uint16_t received;
+  std::vector<uint8_t> data;
+};
+
+// Little-endian field access into a payload
+uint16_t payload16(const std::vector<uint8_t>& payload, size_t offset);
+uint32_t payload32(const std::vector<uint8_t>& payload, size_t offset);
+
+// Reads a varint at offset and moves past it; false if it runs off the end
+bool payloadVarint(const std::vector<uint8_t>& payload, size_t& offset, uint32_t& value);
+
+bool decodeCapture(const std::vector<uint8_t>& payload, CaptureHeader& header,
+                   std::vector<uint16_t>& words, std::string& error);
+
+// One run-length record with its delta resolved to a sample number
+struct CaptureTransition {
+  uint32_t sample;
+  uint16_t word;
+};
+
+bool decodeRleCapture(const std::vector<uint8_t>& payload, RleCaptureHeader& header,
+                      std::vector<CaptureTransition>& transitions, std::string& error);
+
+// Expands transitions back to one word per sample, from the first record
+// to the last sample taken. Fails past maxWords.
+bool expandRleCapture(const RleCaptureHeader& header,
+                      const std::vector<CaptureTransition>& transitions,
+                      std::vector<uint16_t>& words, size_t maxWords, std::string& error);
+
+// One FRAME_TELEMETRY frame with every event's fields filled in
+struct TelemetryFrame {
+  uint16_t sequence;
+  uint16_t lost;       // Running count of events the device dropped
+  std::vector<TelemetryEvent> events;
+};
+
+bool decodeTelemetry(const std::vector<uint8_t>& payload, TelemetryFrame& frame,
+                     std::string& error);
+
+// One FRAME_STATS frame; phases and buckets are as many as the device sent
+struct PhaseSummary {
+  uint32_t count;
+  uint32_t min;
+  uint32_t max;
+  uint32_t mean;
+  std::vector<uint32_t> buckets;
+};
+
+struct StatsFrame {
+  uint32_t cyclesPerSecond;
+  uint8_t bucketShift;
+  std::vector<PhaseSummary> phases;
+};
+
+bool decodeStats(const std::vector<uint8_t>& payload, StatsFrame& frame, std::string& error);
+
+// One FRAME_LATENCY frame: per circuit tested its number, the trials that
+// timed out and the latency statistics
+struct LatencyCircuit {
+  uint8_t circuit;
+  uint32_t timeouts;
+  PhaseSummary latency;
+};
+
+struct LatencyFrame {
+  uint32_t cyclesPerSecond;
+  uint8_t bucketShift;
+  std::vector<LatencyCircuit> circuits;
+};
+
+bool decodeLatency(const std::vector<uint8_t>& payload, LatencyFrame& frame, std::string& error);
+
+// One FRAME_TRACE frame with every event's ticks resolved
+struct TraceFrame {
+  uint16_t sequence;
+  uint16_t lost;       // Running count of events the device dropped
+  uint32_t ticksPerSecond;
+  std::vector<TraceEvent> events;
+};
+
+bool decodeTrace(const std::vector<uint8_t>& payload, TraceFrame& frame, std::string& error);
+
+#endif
@@ -0,0 +1,585 @@
+/*
+ * Digital Logic Lab Simulator - Netlist Import (host tools)
+ * See NetlistReader.h for the supported subset.
+ */
+
+#include "NetlistReader.h"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+namespace {
+
+const uint8_t undefinedGate = 0xFF;  // Net referenced before it is driven
+const size_t maxNodes = noNode;      // NodeId 0xFFFF is reserved
+
+std::string trim(const std::string& text) {
+  size_t start = 0;
+  size_t end = text.size();
+  while (start < end && isspace((unsigned char)text[start])) start++;
+  while (end > start && isspace((unsigned char)text[end - 1])) end--;
+  return text.substr(start, end - start);
+}
+
+std::string upper(std::string text) {
+  for (char& c : text) c = toupper((unsigned char)c);
+  return text;
+}
+
+std::string location(const std::string& path, int line) {
+  return path + ":" + std::to_string(line) + ": ";
+}
+
+// Collects named nets and decomposes wide gates into two-input trees
+class NetlistBuilder {
+public:
+  explicit NetlistBuilder(HostNetlist& target) : netlist(target) {
+    netlist.gates.clear();
+    netlist.outputs.clear();
+    netlist.nodeNames.clear();
+  }
+
+  // Looks a net up by name, creating an undriven placeholder
+  bool net(const std::string& name, NodeId& id, std::string& error) {
+    std::map<std::string, NodeId>::const_iterator found = names.find(name);
+    if (found != names.end()) {
+      id = found->second;
+      return true;
+    }
+    if (!newNode(undefinedGate, noNode, noNode, id, error)) return false;
+    netlist.nodeNames[id] = name;
+    names[name] = id;
+    return true;
+  }
+
+  bool input(const std::string& name, std::string& error) {
+    NodeId id;
+    if (!net(name, id, error)) return false;
+    if (netlist.gates[id].type != undefinedGate) {
+      error = "net '" + name + "' is driven twice";
+      return false;
+    }
+    netlist.gates[id].type = GATE_INPUT;
+    inputOrder.push_back(id);
+    return true;
+  }
+
+  void output(const std::string& name) {
+    outputNames.push_back(name);
+  }
+
+  // Drives target with op over the operands, inverted if requested.
+  // AND, OR and XOR accept any number of operands.
+  bool assign(NodeId target, uint8_t op, bool invert,
+              std::vector<NodeId> operands, std::string& error) {
+    if (netlist.gates[target].type != undefinedGate) {
+      error = "net '" + netlist.nodeNames[target] + "' is driven twice";
+      return false;
+    }
+    if (operands.empty()) {
+      error = "gate driving '" + netlist.nodeNames[target] + "' has no inputs";
+      return false;
+    }
+    while (operands.size() > 2) {
+      std::vector<NodeId> reduced;
+      for (size_t i = 0; i + 1 < operands.size(); i += 2) {
+        NodeId id;
+        if (!newNode(op, operands[i], operands[i + 1], id, error)) return false;
+        reduced.push_back(id);
+      }
+      if (operands.size() & 1) reduced.push_back(operands.back());
+      operands.swap(reduced);
+    }
+
+    NetlistGate& g = netlist.gates[target];
+    if (operands.size() == 1) {
+      g.type = invert ? GATE_NOT : GATE_BUF;
+      g.in[0] = operands[0];
+      g.in[1] = noNode;
+    }
+    else {
+      g.type = invert ? invertedGate(op) : op;
+      g.in[0] = operands[0];
+      g.in[1] = operands[1];
+    }
+    return true;
+  }
+
+  bool assignFlipFlop(NodeId target, NodeId d, std::string& error) {
+    if (netlist.gates[target].type != undefinedGate) {
+      error = "net '" + netlist.nodeNames[target] + "' is driven twice";
+      return false;
+    }
+    netlist.gates[target].type = GATE_DFF;
+    netlist.gates[target].in[0] = d;
+    return true;
+  }
+
+  bool assignConstant(NodeId target, bool value, std::string& error) {
+    if (netlist.gates[target].type != undefinedGate) {
+      error = "net '" + netlist.nodeNames[target] + "' is driven twice";
+      return false;
+    }
+    netlist.gates[target].type = value ? GATE_CONST1 : GATE_CONST0;
+    return true;
+  }
+
+  // Shared inverter per net, for negative literals in BLIF covers
+  bool inverted(NodeId source, NodeId& id, std::string& error) {
+    std::map<NodeId, NodeId>::const_iterator found = inverters.find(source);
+    if (found != inverters.end()) {
+      id = found->second;
+      return true;
+    }
+    if (!newNode(GATE_NOT, source, noNode, id, error)) return false;
+    inverters[source] = id;
+    return true;
+  }
+
+  bool newGate(uint8_t op, const std::vector<NodeId>& operands,
+               NodeId& id, std::string& error) {
+    if (operands.size() == 1) {
+      id = operands[0];
+      return true;
+    }
+    if (!newNode(undefinedGate, noNode, noNode, id, error)) return false;
+    return assign(id, op, false, operands, error);
+  }
+
+  // Checks every net is driven and renumbers the nodes so that inputs come
+  // first, in declaration order
+  bool finish(std::string& error) {
+    for (size_t n = 0; n < netlist.gates.size(); n++) {
+      if (netlist.gates[n].type == undefinedGate) {
+        error = "net '" + netlist.nodeNames[n] + "' is never driven";
+        return false;
+      }
+    }
+
+    std::vector<NodeId> renumbered(netlist.gates.size(), noNode);
+    NodeId next = 0;
+    for (NodeId id : inputOrder) renumbered[id] = next++;
+    for (size_t n = 0; n < netlist.gates.size(); n++) {
+      if (renumbered[n] == noNode) renumbered[n] = next++;
+    }
+
+    std::vector<NetlistGate> gates(netlist.gates.size());
+    std::vector<std::string> nodeNames(netlist.gates.size());
+    for (size_t n = 0; n < netlist.gates.size(); n++) {
+      NetlistGate g = netlist.gates[n];
+      for (uint8_t i = 0; i < 2; i++) {
+        if (g.in[i] != noNode) g.in[i] = renumbered[g.in[i]];
+      }
+      gates[renumbered[n]] = g;
+      nodeNames[renumbered[n]].swap(netlist.nodeNames[n]);
+    }
+    netlist.gates.swap(gates);
+    netlist.nodeNames.swap(nodeNames);
+
+    for (const std::string& name : outputNames) {
+      std::map<std::string, NodeId>::const_iterator found = names.find(name);
+      if (found == names.end()) {
+        error = "output '" + name + "' is never driven";
+        return false;
+      }
+      netlist.outputs.push_back(renumbered[found->second]);
+    }
+    return true;
+  }
+
+private:
+  static uint8_t invertedGate(uint8_t op) {
+    switch (op) {
+      case GATE_AND: return GATE_NAND;
+      case GATE_OR:  return GATE_NOR;
+      case GATE_XOR: return GATE_XNOR;
+      default:       return GATE_NOT;
+    }
+  }
+
+  bool newNode(uint8_t type, NodeId a, NodeId b, NodeId& id, std::string& error) {
+    if (netlist.gates.size() >= maxNodes) {
+      error = "netlist exceeds " + std::to_string(maxNodes) + " nodes";
+      return false;
+    }
+    NetlistGate g;
+    g.type = type;
+    g.in[0] = a;
+    g.in[1] = b;
+    id = (NodeId)netlist.gates.size();
+    netlist.gates.push_back(g);
+    netlist.nodeNames.push_back(std::string());
+    return true;
+  }
+
+  HostNetlist& netlist;
+  std::map<std::string, NodeId> names;
+  std::map<NodeId, NodeId> inverters;
+  std::vector<NodeId> inputOrder;
+  std::vector<std::string> outputNames;
+};
+
+bool benchGateType(const std::string& name, uint8_t& op, bool& invert) {
+  invert = false;
+  if (name == "AND")       op = GATE_AND;
+  else if (name == "OR")   op = GATE_OR;
+  else if (name == "XOR")  op = GATE_XOR;
+  else if (name == "BUF" || name == "BUFF") op = GATE_BUF;
+  else if (name == "NAND") { op = GATE_AND; invert = true; }
+  else if (name == "NOR")  { op = GATE_OR; invert = true; }
+  else if (name == "XNOR") { op = GATE_XOR; invert = true; }
+  else if (name == "NOT")  { op = GATE_BUF; invert = true; }
+  else if (name == "DFF")  op = GATE_DFF;
+  else return false;
+  return true;
+}
+
+std::string baseName(const std::string& path) {
+  size_t slash = path.find_last_of("/\\");
+  std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+  size_t dot = name.find_last_of('.');
+  return dot == std::string::npos ? name : name.substr(0, dot);
+}
+
+// Reads logical BLIF lines: comments stripped, '\' continuations joined
+bool nextBlifLine(std::istream& in, std::string& line, int& lineNumber) {
+  line.clear();
+  std::string raw;
+  while (std::getline(in, raw)) {
+    lineNumber++;
+    size_t hash = raw.find('#');
+    if (hash != std::string::npos) raw.erase(hash);
+    raw = trim(raw);
+    bool continued = !raw.empty() && raw[raw.size() - 1] == '\\';
+    if (continued) raw.erase(raw.size() - 1);
+    if (!line.empty() && !raw.empty()) line += ' ';
+    line += raw;
+    if (continued) continue;
+    if (!line.empty()) return true;
+  }
+  return !line.empty();
+}
+
+std::vector<std::string> tokenize(const std::string& line) {
+  std::vector<std::string> tokens;
+  std::istringstream stream(line);
+  std::string token;
+  while (stream >> token) tokens.push_back(token);
+  return tokens;
+}
+
+// Turns a single-output cover into a sum of products driving target
+bool buildCover(NetlistBuilder& builder, NodeId target,
+                const std::vector<NodeId>& inputs,
+                const std::vector<std::string>& rows, std::string& error) {
+  if (rows.empty()) return builder.assignConstant(target, false, error);
+
+  char phase = 0;
+  std::vector<NodeId> terms;
+  bool tautology = false;
+  for (const std::string& row : rows) {
+    std::vector<std::string> fields = tokenize(row);
+    std::string cube = inputs.empty() ? "" : (fields.size() == 2 ? fields[0] : "");
+    std::string value = fields.empty() ? "" : fields.back();
+    if (fields.size() != (inputs.empty() ? 1u : 2u) || cube.size() != inputs.size() ||
+        (value != "0" && value != "1")) {
+      error = "malformed cover row '" + row + "'";
+      return false;
+    }
+    if (phase && phase != value[0]) {
+      error = "cover mixes on-set and off-set rows";
+      return false;
+    }
+    phase = value[0];
+
+    std::vector<NodeId> literals;
+    for (size_t i = 0; i < cube.size(); i++) {
+      if (cube[i] == '1') {
+        literals.push_back(inputs[i]);
+      }
+      else if (cube[i] == '0') {
+        NodeId id;
+        if (!builder.inverted(inputs[i], id, error)) return false;
+        literals.push_back(id);
+      }
+      else if (cube[i] != '-') {
+        error = "bad literal in cover row '" + row + "'";
+        return false;
+      }
+    }
+    if (literals.empty()) {
+      tautology = true;
+      continue;
+    }
+    NodeId term;
+    if (!builder.newGate(GATE_AND, literals, term, error)) return false;
+    terms.push_back(term);
+  }
+
+  if (tautology) return builder.assignConstant(target, phase == '1', error);
+  return builder.assign(target, GATE_OR, phase == '0', terms, error);
+}
+
+} // namespace
+
+bool HostNetlist::build(std::string& error) {
+  arena.assign(Netlist::arenaBytes((uint16_t)gates.size(), (uint16_t)sourceCount()), 0);
+  if (!engine.begin(gates.data(), (uint16_t)gates.size(),
+                    outputs.data(), (uint16_t)outputs.size(),
+                    arena.data(), arena.size())) {
+    error = name + ": netlist could not be levelized";
+    return false;
+  }
+  return true;
+}
+
+size_t HostNetlist::sourceCount() const {
+  size_t count = 0;
+  for (const NetlistGate& g : gates) {
+    if (isSourceGate(g.type)) count++;
+  }
+  return count;
+}
+
+size_t HostNetlist::gateBytes() const {
+  return gates.size() * sizeof(NetlistGate) + outputs.size() * sizeof(NodeId);
+}
+
+bool readBench(const std::string& path, HostNetlist& netlist, std::string& error) {
+  std::ifstream in(path.c_str());
+  if (!in) {
+    error = path + ": cannot open";
+    return false;
+  }
+  netlist.name = baseName(path);
+  NetlistBuilder builder(netlist);
+
+  std::string raw;
+  int lineNumber = 0;
+  while (std::getline(in, raw)) {
+    lineNumber++;
+    size_t hash = raw.find('#');
+    if (hash != std::string::npos) raw.erase(hash);
+    std::string line = trim(raw);
+    if (line.empty()) continue;
+
+    size_t open = line.find('(');
+    size_t close = line.rfind(')');
+    if (open == std::string::npos || close == std::string::npos || close < open) {
+      error = location(path, lineNumber) + "expected '(...)'";
+      return false;
+    }
+    std::string args = line.substr(open + 1, close - open - 1);
+    std::vector<std::string> operands;
+    std::stringstream split(args);
+    std::string operand;
+    while (std::getline(split, operand, ',')) {
+      operand = trim(operand);
+      if (!operand.empty()) operands.push_back(operand);
+    }
+
+    size_t equals = line.find('=');
+    if (equals == std::string::npos || equals > open) {
+      std::string keyword = upper(trim(line.substr(0, open)));
+      if (operands.size() != 1) {
+        error = location(path, lineNumber) + keyword + " takes one net";
+        return false;
+      }
+      if (keyword == "INPUT") {
+        if (!builder.input(operands[0], error)) {
+          error = location(path, lineNumber) + error;
+          return false;
+        }
+      }
+      else if (keyword == "OUTPUT") {
+        builder.output(operands[0]);
+      }
+      else {
+        error = location(path, lineNumber) + "unknown declaration '" + keyword + "'";
+        return false;
+      }
+      continue;
+    }
+
+    std::string target = trim(line.substr(0, equals));
+    std::string typeName = upper(trim(line.substr(equals + 1, open - equals - 1)));
+    uint8_t op;
+    bool invert;
+    if (!benchGateType(typeName, op, invert)) {
+      error = location(path, lineNumber) + "unknown gate type '" + typeName + "'";
+      return false;
+    }
+
+    NodeId targetId;
+    std::vector<NodeId> fanins;
+    bool ok = builder.net(target, targetId, error);
+    for (size_t i = 0; ok && i < operands.size(); i++) {
+      NodeId id;
+      ok = builder.net(operands[i], id, error);
+      fanins.push_back(id);
+    }
+    if (ok && op == GATE_DFF) {
+      if (fanins.size() != 1) {
+        error = "DFF takes one input";
+        ok = false;
+      }
+      else {
+        ok = builder.assignFlipFlop(targetId, fanins[0], error);
+      }
+    }
+    else if (ok) {
+      if (op == GATE_BUF && fanins.size() != 1) {
+        error = typeName + " takes one input";
+        ok = false;
+      }
+      else {
+        ok = builder.assign(targetId, op, invert, fanins, error);
+      }
+    }
+    if (!ok) {
+      error = location(path, lineNumber) + error;
+      return false;
+    }
+  }
+
+  if (!builder.finish(error)) {
+    error = path + ": " + error;
+    return false;
+  }
+  return true;
+}
+
+bool readBlif(const std::string& path, HostNetlist& netlist, std::string& error) {
+  std::ifstream in(path.c_str());
+  if (!in) {
+    error = path + ": cannot open";
+    return false;
+  }
+  netlist.name = baseName(path);
+  NetlistBuilder builder(netlist);
+
+  std::string line;
+  int lineNumber = 0;
+  bool pending = nextBlifLine(in, line, lineNumber);
+  while (pending) {
+    std::vector<std::string> tokens = tokenize(line);
+    const std::string& directive = tokens[0];
+    int directiveLine = lineNumber;
+    pending = nextBlifLine(in, line, lineNumber);
+
+    bool ok = true;
+    if (directive == ".model") {
+      if (tokens.size() > 1) netlist.name = tokens[1];
+    }
+    else if (directive == ".inputs") {
+      for (size_t i = 1; ok && i < tokens.size(); i++) ok = builder.input(tokens[i], error);
+    }
+    else if (directive == ".outputs") {
+      for (size_t i = 1; i < tokens.size(); i++) builder.output(tokens[i]);
+    }
+    else if (directive == ".names") {
+      if (tokens.size() < 2) {
+        error = ".names needs an output";
+        ok = false;
+      }
+      std::vector<NodeId> inputs;
+      NodeId target = noNode;
+      for (size_t i = 1; ok && i < tokens.size(); i++) {
+        NodeId id;
+        ok = builder.net(tokens[i], id, error);
+        if (i + 1 < tokens.size()) inputs.push_back(id);
+        else target = id;
+      }
+      std::vector<std::string> rows;
+      while (pending && line[0] != '.') {
+        rows.push_back(line);
+        pending = nextBlifLine(in, line, lineNumber);
+      }
+      if (ok) ok = buildCover(builder, target, inputs, rows, error);
+    }
+    else if (directive == ".latch") {
+      // .latch <input> <output> [<type> <control>] [<init>]
+      // Initial values are not modelled; flip-flops power up as 0.
+      if (tokens.size() < 3 || tokens.size() > 6) {
+        error = ".latch needs an input and an output";
+        ok = false;
+      }
+      NodeId d = noNode;
+      NodeId q = noNode;
+      if (ok) ok = builder.net(tokens[1], d, error) && builder.net(tokens[2], q, error);
+      if (ok) ok = builder.assignFlipFlop(q, d, error);
+    }
+    else if (directive == ".end") {
+      break;
+    }
+    else if (directive == ".subckt" || directive == ".gate" ||
+             directive == ".mlatch" || directive == ".search") {
+      error = directive + " is not supported";
+      ok = false;
+    }
+    else if (directive[0] != '.') {
+      error = "cover row outside .names";
+      ok = false;
+    }
+    // Other directives (.clock, timing annotations) do not affect logic
+
+    if (!ok) {
+      error = location(path, directiveLine) + error;
+      return false;
+    }
+  }
+
+  if (!builder.finish(error)) {
+    error = path + ": " + error;
+    return false;
+  }
+  return true;
+}
+
+bool loadNetlistFile(const std::string& path, HostNetlist& netlist, std::string& error) {
+  std::string extension;
+  size_t dot = path.find_last_of('.');
+  if (dot != std::string::npos) extension = path.substr(dot);
+  std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+
+  bool ok;
+  if (extension == ".bench") ok = readBench(path, netlist, error);
+  else if (extension == ".blif") ok = readBlif(path, netlist, error);
+  else {
+    error = path + ": unknown netlist format";
+    return false;
+  }
+  return ok && netlist.build(error);
+}
+
+bool lowerToAig(const HostNetlist& source, HostNetlist& lowered,
+                AigStats& stats, std::string& error) {
+  const NetlistGate* gates = source.gates.data();
+  uint16_t numNodes = (uint16_t)source.gates.size();
+  uint16_t numOutputs = (uint16_t)source.outputs.size();
+
+  std::vector<uint8_t> scratch(aigScratchBytes(gates, numNodes));
+  lowered.name = source.name;
+  lowered.gates.resize(aigLoweredBound(gates, numNodes, numOutputs));
+  lowered.outputs.resize(numOutputs);
+  uint16_t loweredNodes = 0;
+  if (!lowerNetlist(gates, numNodes, source.outputs.data(), numOutputs,
+                    lowered.gates.data(), (uint16_t)lowered.gates.size(),
+                    lowered.outputs.data(), loweredNodes,
+                    scratch.data(), scratch.size(), &stats)) {
+    error = source.name + ": cannot lower to an AIG (combinational loop or too large)";
+    return false;
+  }
+  lowered.gates.resize(loweredNodes);
+
+  // Inputs come first in both netlists
+  lowered.nodeNames.assign(loweredNodes, std::string());
+  size_t inputs = 0;
+  for (size_t n = 0; n < source.gates.size(); n++) {
+    if (source.gates[n].type == GATE_INPUT) lowered.nodeNames[inputs++] = source.nodeNames[n];
+  }
+  return lowered.build(error);
+}
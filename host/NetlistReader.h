@@ -0,0 +1,53 @@
+/*
+ * Digital Logic Lab Simulator - Netlist Import (host tools)
+ * Reads ISCAS-85/89 .bench files and a combinational/sequential BLIF
+ * subset into the gate arrays used by the Netlist engine.
+ *
+ * Gates wider than two inputs are decomposed into balanced two-input trees,
+ * BLIF covers become sums of products and .latch / DFF become GATE_DFF.
+ * Inputs are numbered in declaration order, so input i of the file is bit i
+ * of Netlist::applyInputWord().
+ */
+
+#ifndef NETLIST_READER_H
+#define NETLIST_READER_H
+
+#include "../Aig.h"
+#include "../Netlist.h"
+
+#include <string>
+#include <vector>
+
+// A netlist loaded on the host together with the engine running it. The
+// engine points into the vectors, so instances are not copyable.
+struct HostNetlist {
+  HostNetlist() {}
+  HostNetlist(const HostNetlist&) = delete;
+  HostNetlist& operator=(const HostNetlist&) = delete;
+
+  std::string name;
+  std::vector<NetlistGate> gates;
+  std::vector<NodeId> outputs;
+  std::vector<std::string> nodeNames;  // Empty for decomposition nodes
+  std::vector<uint8_t> arena;
+  Netlist engine;
+
+  // Sizes the arena and levelizes the netlist
+  bool build(std::string& error);
+
+  size_t sourceCount() const;
+  size_t gateBytes() const;  // Gate and output tables, excluding the arena
+};
+
+bool readBench(const std::string& path, HostNetlist& netlist, std::string& error);
+bool readBlif(const std::string& path, HostNetlist& netlist, std::string& error);
+
+// Picks the reader from the extension (.bench or .blif) and builds
+bool loadNetlistFile(const std::string& path, HostNetlist& netlist, std::string& error);
+
+// Rebuilds source through an AIG (see Aig.h) into lowered and builds it.
+// Input names and numbering are kept.
+bool lowerToAig(const HostNetlist& source, HostNetlist& lowered,
+                AigStats& stats, std::string& error);
+
+#endif
@@ -0,0 +1,82 @@
+/*
+ * Digital Logic Lab Simulator - Trace Export (host tools)
+ */
+
+#include "TraceExport.h"
+
+namespace {
+
+const uint32_t loopTrack = 1;
+const uint32_t isrTrack = 2;
+
+bool isInterrupt(uint8_t id) {
+  return id == TRACE_CAPTURE_ISR || id == TRACE_TELEMETRY_ISR;
+}
+
+} // namespace
+
+ChromeTraceWriter::ChromeTraceWriter() : file(0), first(true), events(0) {
+}
+
+ChromeTraceWriter::~ChromeTraceWriter() {
+  std::string error;
+  finish(error);
+}
+
+bool ChromeTraceWriter::open(const std::string& path, std::string& error) {
+  finish(error);
+  file = fopen(path.c_str(), "wb");
+  if (!file) {
+    error = path + ": cannot create";
+    return false;
+  }
+  fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n", file);
+  first = true;
+  events = 0;
+  return true;
+}
+
+void ChromeTraceWriter::record(const std::string& json) {
+  if (!file) return;
+  if (!first) fputs(",\n", file);
+  fputs(json.c_str(), file);
+  first = false;
+}
+
+void ChromeTraceWriter::addProcess(uint32_t pid, const std::string& name) {
+  std::string process = std::to_string(pid);
+  record("{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":" + process +
+         ",\"args\":{\"name\":\"" + name + "\"}}");
+  record("{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":" + process + ",\"tid\":" +
+         std::to_string(loopTrack) + ",\"args\":{\"name\":\"loop\"}}");
+  record("{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":" + process + ",\"tid\":" +
+         std::to_string(isrTrack) + ",\"args\":{\"name\":\"isr\"}}");
+}
+
+void ChromeTraceWriter::event(uint32_t pid, const TraceEvent& event, double micros) {
+  const char* phase = event.kind == TRACE_KIND_BEGIN ? "B" : event.kind == TRACE_KIND_END ? "E" : "i";
+  char json[256];
+  int length = snprintf(json, sizeof(json),
+                        "{\"ph\":\"%s\",\"name\":\"%s\",\"pid\":%u,\"tid\":%u,\"ts\":%.3f",
+                        phase, traceName(event.id), pid,
+                        isInterrupt(event.id) ? isrTrack : loopTrack, micros);
+  if (event.kind == TRACE_KIND_INSTANT) {
+    snprintf(json + length, sizeof(json) - length, ",\"s\":\"p\",\"args\":{\"value\":\"0x%02X\"}}",
+             event.arg);
+  }
+  else {
+    snprintf(json + length, sizeof(json) - length, "}");
+  }
+  record(json);
+  events++;
+}
+
+bool ChromeTraceWriter::finish(std::string& error) {
+  if (!file) return true;
+  fputs("\n]}\n", file);
+  bool ok = fflush(file) == 0 && !ferror(file);
+  fclose(file);
+  file = 0;
+  if (!ok) error = "trace file write failed";
+  return ok;
+}
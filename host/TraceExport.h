@@ -0,0 +1,64 @@
+/*
+ * Digital Logic Lab Simulator - Trace Export (host tools)
+ * Writes TraceBuffer events (Trace.h) as a Chrome Trace Event Format JSON
+ * file, which chrome://tracing and the Perfetto UI (ui.perfetto.dev) both
+ * open. Each source is a process; loop phases, serial reads and input
+ * edges go on its "loop" track and interrupt handlers on an "isr" track,
+ * so a handler shows up inside the phase it interrupted. Events are
+ * streamed to the file as they arrive.
+ */
+
+#ifndef TRACE_EXPORT_H
+#define TRACE_EXPORT_H
+
+#include "../Trace.h"
+
+#include <stdio.h>
+
+#include <string>
+
+// Extends 32-bit tick counts that wrap into a 64-bit count from the first
+class TraceTimeline {
+public:
+  TraceTimeline() : started(false), last(0), total(0) {}
+
+  uint64_t extend(uint32_t ticks) {
+    if (started) total += (uint32_t)(ticks - last);
+    started = true;
+    last = ticks;
+    return total;
+  }
+
+private:
+  bool started;
+  uint32_t last;
+  uint64_t total;
+};
+
+class ChromeTraceWriter {
+public:
+  ChromeTraceWriter();
+  ~ChromeTraceWriter();
+  ChromeTraceWriter(const ChromeTraceWriter&) = delete;
+  ChromeTraceWriter& operator=(const ChromeTraceWriter&) = delete;
+
+  bool open(const std::string& path, std::string& error);
+
+  // Names process pid and its loop and isr tracks
+  void addProcess(uint32_t pid, const std::string& name);
+
+  void event(uint32_t pid, const TraceEvent& event, double micros);
+
+  bool finish(std::string& error);
+
+  uint64_t eventCount() const { return events; }
+
+private:
+  void record(const std::string& json);
+
+  FILE* file;
+  bool first;
+  uint64_t events;
+};
+
+#endif
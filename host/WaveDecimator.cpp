@@ -0,0 +1,222 @@
+/*
+ * Digital Logic Lab Simulator - Waveform Decimation (host tools)
+ */
+
+#include "WaveDecimator.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const uint32_t planeWords = waveChunkSamples / 64;
+const uint32_t levelShift[2] = {9, 12};  // 512 and 4096 samples
+
+// Bit i set where sample 64 * w + i differs from the one before; bit 0 of
+// the chunk's first word is the chunk boundary and stays clear
+uint64_t diffWord(const uint64_t* bits, uint32_t w) {
+  uint64_t carry = w ? bits[w - 1] >> 63 : bits[0] & 1;
+  return bits[w] ^ (bits[w] << 1 | carry);
+}
+
+// Bits [from, to) of a word, 0 <= from < to <= 64
+uint64_t bitRange(uint32_t from, uint32_t to) {
+  uint64_t upper = to == 64 ? ~0ULL : (1ULL << to) - 1;
+  return upper & ~((1ULL << from) - 1);
+}
+
+} // namespace
+
+WaveDecimator::WaveDecimator(WaveStore& store, size_t summaryChunks)
+  : summariesBuilt(0), store(store), capacity(summaryChunks ? summaryChunks : 1), useClock(0) {
+}
+
+// ====================
+// CHUNK SUMMARIES
+// ====================
+WaveDecimator::Summary* WaveDecimator::summary(uint64_t chunk, uint16_t signal) {
+  useClock++;
+  uint64_t samples = store.sampleCount();
+  bool partial = (chunk + 1) * waveChunkSamples > samples;
+  Summary* found = 0;
+  size_t oldest = 0;
+  for (size_t i = 0; i < cache.size(); i++) {
+    if (cache[i]->chunk == chunk && cache[i]->signal == signal) found = cache[i].get();
+    if (cache[i]->used < cache[oldest]->used) oldest = i;
+  }
+  // A partial chunk may have grown since
+  if (found && (!partial || found->samples == samples)) {
+    found->used = useClock;
+    return found;
+  }
+
+  // Reuse the stale entry or the least recently used one
+  if (!found) {
+    if (cache.size() < capacity) {
+      cache.push_back(std::unique_ptr<Summary>(new Summary));
+      found = cache.back().get();
+      found->words.resize(planeWords);
+      for (int l = 0; l < 2; l++) found->levels[l].resize(waveChunkSamples >> levelShift[l]);
+    }
+    else {
+      found = cache[oldest].get();
+    }
+  }
+  found->chunk = chunk;
+  found->signal = signal;
+  found->samples = samples;
+  found->used = useClock;
+  memset(found->pageBuilt, 0, sizeof(found->pageBuilt));
+  return found;
+}
+
+// Word and block counts of one page, from its plane bits
+bool WaveDecimator::buildPage(Summary& sum, uint32_t page) {
+  const uint64_t* bits = store.plane(sum.chunk, sum.signal);
+  if (!bits) return false;
+  store.stats.planePages++;
+  uint64_t length = sum.samples - sum.chunk * waveChunkSamples;
+  if (length > waveChunkSamples) length = waveChunkSamples;
+  uint32_t w = page * (wavePageSamples / 64);
+  for (int l = 0; l < 2; l++) {
+    uint32_t blocks = wavePageSamples >> levelShift[l];
+    std::fill(sum.levels[l].begin() + page * blocks, sum.levels[l].begin() + (page + 1) * blocks, 0);
+  }
+  for (uint32_t end = w + wavePageSamples / 64; w < end; w++) {
+    uint64_t diff = diffWord(bits, w);
+    // Past the last sample the plane is zero, not a falling edge
+    if ((uint64_t)w * 64 + 64 > length) {
+      diff = (uint64_t)w * 64 >= length ? 0 : diff & bitRange(0, length - (uint64_t)w * 64);
+    }
+    uint8_t count = (uint8_t)__builtin_popcountll(diff);
+    sum.words[w] = count;
+    for (int l = 0; l < 2; l++) sum.levels[l][(w * 64) >> levelShift[l]] += count;
+  }
+  sum.pageBuilt[page] = 1;
+  summariesBuilt++;
+  return true;
+}
+
+uint64_t WaveDecimator::countInChunk(uint64_t chunk, uint16_t signal,
+                                     const WaveChunkSignal& entry, uint32_t from, uint32_t to) {
+  Summary* sum = 0;
+  const uint64_t* bits = 0;
+  uint64_t count = 0;
+  uint32_t i = from;
+  while (i < to) {
+    // Whole pages come from the index; quiet pages need nothing more
+    uint32_t page = i / wavePageSamples;
+    uint32_t pageEnd = (page + 1) * wavePageSamples;
+    if ((i % wavePageSamples == 0 && to >= pageEnd) || entry.pageTransitions[page] == 0) {
+      if (i % wavePageSamples == 0 && to >= pageEnd) count += entry.pageTransitions[page];
+      i = pageEnd < to ? pageEnd : to;
+      continue;
+    }
+    if (!sum) sum = summary(chunk, signal);
+    if (!sum->pageBuilt[page] && !buildPage(*sum, page)) return count;
+
+    // The largest aligned block that fits
+    if ((i & 63) == 0 && to - i >= 64) {
+      int l = 1;
+      while (l >= 0 && ((i & ((1u << levelShift[l]) - 1)) || to - i < (1u << levelShift[l]))) l--;
+      if (l >= 0) {
+        count += sum->levels[l][i >> levelShift[l]];
+        i += 1u << levelShift[l];
+      }
+      else {
+        count += sum->words[i >> 6];
+        i += 64;
+      }
+      continue;
+    }
+
+    // A partial word at either edge
+    uint32_t w = i >> 6;
+    uint32_t stop = (w + 1) * 64 < to ? (w + 1) * 64 : to;
+    if (sum->words[w]) {
+      if (!bits) bits = store.plane(chunk, signal);
+      count += __builtin_popcountll(diffWord(bits, w) & bitRange(i & 63, stop - w * 64));
+    }
+    i = stop;
+  }
+  return count;
+}
+
+// ====================
+// QUERIES
+// ====================
+uint64_t WaveDecimator::countTransitions(uint16_t signal, uint64_t begin, uint64_t end) {
+  uint64_t samples = store.sampleCount();
+  if (end > samples) end = samples;
+  if (signal >= store.signalCount() || begin + 1 >= end) return 0;
+
+  uint64_t count = 0;
+  uint8_t last = 0;
+  for (uint64_t chunk = begin / waveChunkSamples; chunk * waveChunkSamples < end; chunk++) {
+    uint64_t chunkStart = chunk * waveChunkSamples;
+    const WaveChunkSignal* entry = store.chunkIndex(chunk, signal);
+    if (!entry) break;
+    // The boundary into this chunk
+    if (chunkStart > begin && entry->first != last) count++;
+    last = entry->last;
+    if (entry->transitions == 0) continue;
+
+    uint64_t length = samples - chunkStart < waveChunkSamples ? samples - chunkStart : waveChunkSamples;
+    uint32_t from = begin >= chunkStart ? (uint32_t)(begin - chunkStart) + 1 : 1;
+    uint32_t to = end - chunkStart < length ? (uint32_t)(end - chunkStart) : (uint32_t)length;
+    if (from == 1 && to == length) count += entry->transitions;
+    else if (from < to) count += countInChunk(chunk, signal, *entry, from, to);
+  }
+  return count;
+}
+
+bool WaveDecimator::decimate(uint16_t signal, uint64_t begin, uint64_t end, uint32_t width,
+                             std::vector<WavePixel>& pixels) {
+  pixels.clear();
+  if (signal >= store.signalCount()) return false;
+  if (end > store.sampleCount()) end = store.sampleCount();
+  if (begin >= end || width == 0) return true;
+  uint64_t span = end - begin;
+  if (width > span) width = (uint32_t)span;
+
+  pixels.resize(width);
+  for (uint32_t p = 0; p < width; p++) {
+    WavePixel& pixel = pixels[p];
+    pixel.begin = begin + (uint64_t)((unsigned __int128)span * p / width);
+    pixel.end = begin + (uint64_t)((unsigned __int128)span * (p + 1) / width);
+    uint64_t count = countTransitions(signal, pixel.begin, pixel.end);
+    pixel.transitions = count > 0xFFFFFFFFULL ? 0xFFFFFFFFU : (uint32_t)count;
+    pixel.first = store.value(signal, pixel.begin) ? 1 : 0;
+    pixel.last = pixel.first ^ (count & 1);
+    pixel.min = count ? 0 : pixel.first;
+    pixel.max = count ? 1 : pixel.first;
+    pixel.glitch = count >= 2;
+  }
+  return true;
+}
+
+// ====================
+// PLOT SERIES
+// ====================
+void buildSeries(const std::vector<WavePixel>& pixels, WaveSeries& series) {
+  series.times.clear();
+  series.values.clear();
+  series.glitches.clear();
+  auto point = [&](uint64_t time, uint8_t value) {
+    series.times.push_back(time);
+    series.values.push_back(value);
+  };
+
+  // Step points only where the level moves; a pixel with transitions
+  // becomes a vertical bar, and a spike when it ends where it started
+  for (size_t p = 0; p < pixels.size(); p++) {
+    const WavePixel& pixel = pixels[p];
+    if (p == 0 || pixel.first != series.values.back()) point(pixel.begin, pixel.first);
+    if (pixel.transitions) {
+      point(pixel.begin, !pixel.first);
+      if (pixel.last == pixel.first) point(pixel.begin, pixel.last);
+    }
+    if (pixel.glitch) series.glitches.push_back(pixel.begin);
+  }
+  if (!pixels.empty()) point(pixels.back().end, pixels.back().last);
+}
@@ -0,0 +1,84 @@
+/*
+ * Digital Logic Lab Simulator - Waveform Decimation (host tools)
+ * Reduces a window of a WaveStore signal to one entry per pixel column for
+ * plotting. Each pixel keeps its first and last value and the number of
+ * transitions inside it, so min and max are exact and a pulse narrower
+ * than a pixel is never lost: a pixel with two or more transitions is
+ * flagged as a glitch.
+ *
+ * Transition counts come from the store index for whole chunks and pages,
+ * and below that from summaries cached per chunk: counts per 64-sample
+ * word and per 512 and 4096 samples, built from the plane a page at a time
+ * the first time a pixel edge lands in the page. A pixel costs a handful
+ * of summary lookups plus the plane words at its two edges, so a query
+ * takes time in proportion to its width, not to the samples or edges in
+ * the window. Pixels wider than a chunk add one index read per chunk.
+ */
+
+#ifndef WAVE_DECIMATOR_H
+#define WAVE_DECIMATOR_H
+
+#include "WaveStore.h"
+
+#include <memory>
+
+struct WavePixel {
+  uint64_t begin;         // First sample in the pixel
+  uint64_t end;           // One past the last
+  uint32_t transitions;   // Changes after begin, up to end - 1
+  uint8_t first;
+  uint8_t last;
+  uint8_t min;
+  uint8_t max;
+  bool glitch;            // At least one complete pulse inside the pixel
+};
+
+// A plotting series: the points to draw and where glitches hide
+struct WaveSeries {
+  std::vector<uint64_t> times;     // Sample numbers
+  std::vector<uint8_t> values;
+  std::vector<uint64_t> glitches;  // Pixel begins
+};
+
+class WaveDecimator {
+public:
+  // summaryChunks bounds the cache, about 5 KB per chunk and signal
+  explicit WaveDecimator(WaveStore& store, size_t summaryChunks = 256);
+
+  // Pixels of [begin, end) split into width columns (fewer when the window
+  // has fewer samples)
+  bool decimate(uint16_t signal, uint64_t begin, uint64_t end, uint32_t width,
+                std::vector<WavePixel>& pixels);
+
+  // Changes of the signal in [begin, end), as decimate() would count them
+  uint64_t countTransitions(uint16_t signal, uint64_t begin, uint64_t end);
+
+  uint64_t summariesBuilt;        // Pages summarised, for checking the cache
+
+private:
+  struct Summary {
+    uint64_t chunk;
+    uint16_t signal;
+    uint64_t samples;         // Store samples when built; partial chunks go stale
+    uint64_t used;
+    uint8_t pageBuilt[wavePagesPerChunk];
+    std::vector<uint8_t> words;       // Per 64 samples
+    std::vector<uint16_t> levels[2];  // Per 512 and 4096 samples
+  };
+
+  Summary* summary(uint64_t chunk, uint16_t signal);
+  bool buildPage(Summary& sum, uint32_t page);
+  uint64_t countInChunk(uint64_t chunk, uint16_t signal, const WaveChunkSignal& entry,
+                        uint32_t from, uint32_t to);
+
+  WaveStore& store;
+  size_t capacity;
+  uint64_t useClock;
+  std::vector<std::unique_ptr<Summary> > cache;
+};
+
+// Points for a step plot of the pixels, with min/max pairs where a pixel
+// has transitions
+void buildSeries(const std::vector<WavePixel>& pixels, WaveSeries& series);
+
+#endif
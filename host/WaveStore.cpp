@@ -0,0 +1,321 @@
+/*
+ * Digital Logic Lab Simulator - Waveform Store (host tools)
+ */
+
+#include "WaveStore.h"
+
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static_assert(sizeof(WaveFileHeader) <= wavePageBytes, "header must fit its page");
+static_assert(sizeof(WaveChunkSignal) * waveMaxSignals <= wavePageBytes, "index must fit its page");
+
+namespace {
+
+const char waveMagic[8] = {'D', 'L', 'L', 'W', 'A', 'V', 'E', 0};
+const uint32_t waveVersion = 1;
+const size_t waveCacheChunks = 4;
+const uint32_t planeWords = wavePageSamples * wavePagesPerChunk / 64;
+
+// Sets bits [from, from + count) of a plane that is still zero there
+void setBits(uint64_t* words, uint64_t from, uint64_t count) {
+  uint64_t end = from + count;
+  while (from < end && (from & 63)) {
+    words[from >> 6] |= 1ULL << (from & 63);
+    from++;
+  }
+  while (from + 64 <= end) {
+    words[from >> 6] = ~0ULL;
+    from += 64;
+  }
+  while (from < end) {
+    words[from >> 6] |= 1ULL << (from & 63);
+    from++;
+  }
+}
+
+bool bitAt(const uint64_t* words, uint64_t index) {
+  return words[index >> 6] >> (index & 63) & 1;
+}
+
+} // namespace
+
+WaveStore::WaveStore()
+  : fd(-1), writable(false), header(0), useClock(0), previous(0) {
+  memset(&stats, 0, sizeof(stats));
+}
+
+WaveStore::~WaveStore() {
+  std::string error;
+  close(error);
+}
+
+size_t WaveStore::chunkBytes() const {
+  return wavePageBytes + (size_t)header->signals * (waveChunkSamples / 8);
+}
+
+bool WaveStore::create(const std::string& path, const std::vector<std::string>& names,
+                       uint64_t period, const std::string& timescale, std::string& error) {
+  close(error);
+  if (names.empty() || names.size() > waveMaxSignals) {
+    error = "a wave store holds 1 to 64 signals";
+    return false;
+  }
+  fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0 || ftruncate(fd, wavePageBytes) != 0) {
+    error = path + ": cannot create";
+    return false;
+  }
+  void* page = mmap(0, wavePageBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (page == MAP_FAILED) {
+    error = path + ": cannot map";
+    return false;
+  }
+  writable = true;
+  header = (WaveFileHeader*)page;
+  memcpy(header->magic, waveMagic, sizeof(waveMagic));
+  header->version = waveVersion;
+  header->signals = (uint32_t)names.size();
+  header->chunkSamples = waveChunkSamples;
+  header->samples = 0;
+  header->period = period ? period : 1;
+  strncpy(header->timescale, timescale.c_str(), sizeof(header->timescale) - 1);
+  for (size_t i = 0; i < names.size(); i++) {
+    strncpy(header->names[i], names[i].c_str(), waveNameBytes - 1);
+  }
+  previous = 0;
+  return true;
+}
+
+bool WaveStore::open(const std::string& path, bool forWriting, std::string& error) {
+  close(error);
+  fd = ::open(path.c_str(), forWriting ? O_RDWR : O_RDONLY);
+  struct stat info;
+  if (fd < 0 || fstat(fd, &info) != 0) {
+    error = path + ": cannot open";
+    return false;
+  }
+  if ((uint64_t)info.st_size < wavePageBytes) {
+    error = path + ": not a wave store";
+    return false;
+  }
+  int protection = forWriting ? PROT_READ | PROT_WRITE : PROT_READ;
+  void* page = mmap(0, wavePageBytes, protection, MAP_SHARED, fd, 0);
+  if (page == MAP_FAILED) {
+    error = path + ": cannot map";
+    return false;
+  }
+  writable = forWriting;
+  header = (WaveFileHeader*)page;
+  if (memcmp(header->magic, waveMagic, sizeof(waveMagic)) != 0 ||
+      header->version != waveVersion || header->chunkSamples != waveChunkSamples ||
+      header->signals == 0 || header->signals > waveMaxSignals ||
+      (uint64_t)info.st_size < wavePageBytes + chunkCount() * chunkBytes()) {
+    error = path + ": not a wave store, or truncated";
+    munmap(header, wavePageBytes);
+    header = 0;
+    return false;
+  }
+
+  // Appending carries on from the last word
+  previous = 0;
+  if (header->samples) {
+    for (uint16_t s = 0; s < header->signals; s++) {
+      if (value(s, header->samples - 1)) previous |= 1ULL << s;
+    }
+  }
+  return true;
+}
+
+bool WaveStore::close(std::string& error) {
+  bool ok = true;
+  unmapAll();
+  if (header) {
+    if (writable && msync(header, wavePageBytes, MS_SYNC) != 0) {
+      error = "wave store: header write failed";
+      ok = false;
+    }
+    munmap(header, wavePageBytes);
+    header = 0;
+  }
+  if (fd >= 0) {
+    ::close(fd);
+    fd = -1;
+  }
+  return ok;
+}
+
+void WaveStore::unmapAll() {
+  for (MappedChunk& mapped : cache) munmap(mapped.base, chunkBytes());
+  cache.clear();
+}
+
+std::string WaveStore::signalName(uint16_t signal) const {
+  if (!header || signal >= header->signals) return std::string();
+  return std::string(header->names[signal], strnlen(header->names[signal], waveNameBytes));
+}
+
+std::string WaveStore::timescale() const {
+  if (!header) return std::string();
+  return std::string(header->timescale, strnlen(header->timescale, sizeof(header->timescale)));
+}
+
+// ====================
+// CHUNK MAPPING
+// ====================
+uint8_t* WaveStore::mapChunk(uint64_t chunk) {
+  useClock++;
+  for (MappedChunk& mapped : cache) {
+    if (mapped.chunk == chunk) {
+      mapped.used = useClock;
+      return mapped.base;
+    }
+  }
+
+  // Least recently used goes; its pages leave the resident set with it
+  if (cache.size() == waveCacheChunks) {
+    size_t oldest = 0;
+    for (size_t i = 1; i < cache.size(); i++) {
+      if (cache[i].used < cache[oldest].used) oldest = i;
+    }
+    munmap(cache[oldest].base, chunkBytes());
+    cache.erase(cache.begin() + oldest);
+  }
+  off_t offset = (off_t)(wavePageBytes + chunk * chunkBytes());
+  int protection = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+  void* base = mmap(0, chunkBytes(), protection, MAP_SHARED, fd, offset);
+  if (base == MAP_FAILED) return 0;
+  stats.chunkMaps++;
+  MappedChunk mapped = {chunk, (uint8_t*)base, useClock};
+  cache.push_back(mapped);
+  return mapped.base;
+}
+
+bool WaveStore::extendTo(uint64_t chunk) {
+  off_t size = (off_t)(wavePageBytes + (chunk + 1) * chunkBytes());
+  return ftruncate(fd, size) == 0;
+}
+
+const WaveChunkSignal* WaveStore::chunkIndex(uint64_t chunk, uint16_t signal) {
+  if (!header || chunk >= chunkCount() || signal >= header->signals) return 0;
+  uint8_t* base = mapChunk(chunk);
+  if (!base) return 0;
+  stats.indexPages++;
+  return (const WaveChunkSignal*)base + signal;
+}
+
+const uint64_t* WaveStore::plane(uint64_t chunk, uint16_t signal) {
+  if (!header || chunk >= chunkCount() || signal >= header->signals) return 0;
+  uint8_t* base = mapChunk(chunk);
+  if (!base) return 0;
+  return (const uint64_t*)(base + wavePageBytes + (size_t)signal * (waveChunkSamples / 8));
+}
+
+// ====================
+// APPEND
+// ====================
+bool WaveStore::appendRun(uint64_t word, uint64_t count) {
+  if (!header || !writable) return false;
+  while (count > 0) {
+    uint64_t chunk = header->samples / waveChunkSamples;
+    uint64_t offset = header->samples % waveChunkSamples;
+    if (offset == 0 && !extendTo(chunk)) return false;
+    uint8_t* base = mapChunk(chunk);
+    if (!base) return false;
+    uint64_t run = waveChunkSamples - offset;
+    if (run > count) run = count;
+
+    WaveChunkSignal* index = (WaveChunkSignal*)base;
+    uint64_t* planes = (uint64_t*)(base + wavePageBytes);
+    for (uint16_t s = 0; s < header->signals; s++) {
+      uint8_t bit = word >> s & 1;
+      WaveChunkSignal& entry = index[s];
+      if (offset == 0) {
+        entry.first = bit;
+      }
+      else if (bit != (previous >> s & 1)) {
+        entry.transitions++;
+        entry.pageTransitions[offset / wavePageSamples]++;
+      }
+      entry.last = bit;
+      if (bit) setBits(planes + (size_t)s * planeWords, offset, run);
+    }
+    previous = word;
+    header->samples += run;
+    count -= run;
+  }
+  return true;
+}
+
+// ====================
+// QUERIES
+// ====================
+bool WaveStore::value(uint16_t signal, uint64_t sample) {
+  if (!header || signal >= header->signals || sample >= header->samples) return false;
+  uint64_t chunk = sample / waveChunkSamples;
+  uint32_t offset = sample % waveChunkSamples;
+  const WaveChunkSignal* entry = chunkIndex(chunk, signal);
+  if (!entry) return false;
+
+  // A page without transitions takes the value its predecessors leave
+  uint32_t page = offset / wavePageSamples;
+  if (entry->pageTransitions[page] == 0) {
+    uint32_t before = 0;
+    for (uint32_t p = 0; p < page; p++) before += entry->pageTransitions[p];
+    return (entry->first ^ before) & 1;
+  }
+  stats.planePages++;
+  return bitAt(plane(chunk, signal), offset);
+}
+
+bool WaveStore::transitions(uint16_t signal, uint64_t begin, uint64_t end, bool& initial,
+                            std::vector<uint64_t>& changes) {
+  changes.clear();
+  initial = false;
+  if (!header || signal >= header->signals) return false;
+  if (end > header->samples) end = header->samples;
+  if (begin >= end) {
+    initial = value(signal, begin);
+    return true;
+  }
+  initial = value(signal, begin);
+
+  uint8_t last = initial;
+  for (uint64_t chunk = begin / waveChunkSamples; chunk * waveChunkSamples < end; chunk++) {
+    uint64_t chunkStart = chunk * waveChunkSamples;
+    const WaveChunkSignal* entry = chunkIndex(chunk, signal);
+    if (!entry) return false;
+    // The boundary into this chunk
+    if (chunkStart > begin && entry->first != last) changes.push_back(chunkStart);
+    last = entry->last;
+    if (entry->transitions == 0) continue;
+
+    uint64_t from = begin > chunkStart ? begin - chunkStart : 0;
+    uint64_t to = end - chunkStart < waveChunkSamples ? end - chunkStart : waveChunkSamples;
+    const uint64_t* bits = 0;
+    for (uint32_t page = from / wavePageSamples; page * wavePageSamples < to; page++) {
+      if (entry->pageTransitions[page] == 0) continue;
+      if (!bits) bits = plane(chunk, signal);
+      stats.planePages++;
+      uint64_t pageFrom = page * wavePageSamples;
+      uint64_t lo = from > pageFrom ? from : pageFrom;
+      uint64_t hi = to < pageFrom + wavePageSamples ? to : pageFrom + wavePageSamples;
+      if (lo == 0) lo = 1;  // Sample 0 is the chunk boundary, handled above
+      // Bit i of diff is set where sample i differs from sample i - 1
+      for (uint64_t w = lo >> 6; w <= (hi - 1) >> 6; w++) {
+        uint64_t carry = w ? bits[w - 1] >> 63 : bits[0] & 1;
+        uint64_t diff = bits[w] ^ (bits[w] << 1 | carry);
+        while (diff) {
+          uint64_t i = w * 64 + __builtin_ctzll(diff);
+          diff &= diff - 1;
+          if (i >= lo && i < hi && i > from) changes.push_back(chunkStart + i);
+        }
+      }
+    }
+  }
+  return true;
+}
@@ -0,0 +1,127 @@
+/*
+ * Digital Logic Lab Simulator - Waveform Store (host tools)
+ * Long waveform histories on disk as bit planes: up to 64 signals sampled
+ * together, one bit per signal per sample. The file is a header page and
+ * then fixed-size chunks of waveChunkSamples samples:
+ *
+ *   index page | plane of signal 0 | plane of signal 1 | ...
+ *
+ * The index page holds, per signal, the value at the chunk's first sample,
+ * its last value and the number of transitions in each 4 KB plane page, so
+ * a query skips chunks and pages where a signal does not change and reads
+ * only the plane pages holding its edges. Chunks are mapped one at a time
+ * through a small cache, so the resident footprint stays constant however
+ * long the file grows. Appends are O(1) per sample and runs of one value
+ * are filled a word at a time.
+ *
+ * The layout uses native byte order; files move between little-endian
+ * hosts only.
+ */
+
+#ifndef WAVE_STORE_H
+#define WAVE_STORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+// ====================
+// STORE LAYOUT
+// ====================
+const uint32_t wavePageBytes = 4096;
+const uint32_t wavePageSamples = wavePageBytes * 8;
+const uint32_t wavePagesPerChunk = 8;
+const uint32_t waveChunkSamples = wavePageSamples * wavePagesPerChunk;
+const uint16_t waveMaxSignals = 64;
+const uint8_t waveNameBytes = 40;
+
+struct WaveFileHeader {
+  char magic[8];            // "DLLWAVE"
+  uint32_t version;
+  uint32_t signals;
+  uint32_t chunkSamples;
+  uint32_t reserved;
+  uint64_t samples;
+  uint64_t period;          // Time between samples, in timescale units
+  char timescale[16];       // VCD style, "1us"
+  char names[waveMaxSignals][waveNameBytes];
+};
+
+struct WaveChunkSignal {
+  uint32_t transitions;     // Within the chunk, not counting its first sample
+  uint8_t first;
+  uint8_t last;
+  uint16_t reserved;
+  uint16_t pageTransitions[wavePagesPerChunk];
+};
+
+// Pages a store has mapped in (index and plane pages), for checking that
+// queries stay local
+struct WaveStoreStats {
+  uint64_t chunkMaps;
+  uint64_t indexPages;
+  uint64_t planePages;
+};
+
+// ====================
+// WAVE STORE
+// ====================
+class WaveStore {
+public:
+  WaveStore();
+  ~WaveStore();
+  WaveStore(const WaveStore&) = delete;
+  WaveStore& operator=(const WaveStore&) = delete;
+
+  bool create(const std::string& path, const std::vector<std::string>& names,
+              uint64_t period, const std::string& timescale, std::string& error);
+  bool open(const std::string& path, bool writable, std::string& error);
+  bool close(std::string& error);
+
+  // Bit s of word is signal s
+  bool append(uint64_t word) { return appendRun(word, 1); }
+  bool appendRun(uint64_t word, uint64_t count);
+
+  uint16_t signalCount() const { return header ? header->signals : 0; }
+  std::string signalName(uint16_t signal) const;
+  uint64_t sampleCount() const { return header ? header->samples : 0; }
+  uint64_t period() const { return header ? header->period : 0; }
+  std::string timescale() const;
+  uint64_t chunkCount() const { return (sampleCount() + waveChunkSamples - 1) / waveChunkSamples; }
+
+  bool value(uint16_t signal, uint64_t sample);
+
+  // Value at begin and every sample in (begin, end) where the signal
+  // changes, in order
+  bool transitions(uint16_t signal, uint64_t begin, uint64_t end, bool& initial,
+                   std::vector<uint64_t>& changes);
+
+  // The chunk index, mapped in; 0 past the end
+  const WaveChunkSignal* chunkIndex(uint64_t chunk, uint16_t signal);
+  const uint64_t* plane(uint64_t chunk, uint16_t signal);
+
+  WaveStoreStats stats;
+
+private:
+  struct MappedChunk {
+    uint64_t chunk;
+    uint8_t* base;
+    uint64_t used;          // For eviction
+  };
+
+  size_t chunkBytes() const;
+  uint8_t* mapChunk(uint64_t chunk);
+  bool extendTo(uint64_t chunk);
+  void unmapAll();
+
+  int fd;
+  bool writable;
+  WaveFileHeader* header;
+  std::vector<MappedChunk> cache;
+  uint64_t useClock;
+  uint64_t previous;        // Last word appended
+};
+
+#endif
@@ -0,0 +1,279 @@
+/*
+ * Digital Logic Lab Simulator - Waveform Files (host tools)
+ */
+
+#include "WaveformWriter.h"
+
+#include <cstdio>
+#include <cstring>
+
+#ifdef WAVEFORM_FST
+#include "fstapi.h"
+#include <sys/stat.h>
+#endif
+
+uint16_t WaveformWriter::addSignal(const std::string& scope, const std::string& name, uint8_t width) {
+  Signal signal = {scope, name, (uint8_t)(width < 1 ? 1 : width > 64 ? 64 : width), 0, false};
+  signals.push_back(signal);
+  return (uint16_t)(signals.size() - 1);
+}
+
+bool WaveformWriter::change(uint64_t at, uint16_t index, uint64_t value) {
+  if (finished || index >= signals.size()) return false;
+  if (!started) {
+    writeHeader();
+    started = true;
+    time = at;
+    timePending = true;
+  }
+  else if (at < time) {
+    return false;
+  }
+  else if (at > time) {
+    time = at;
+    timePending = true;
+  }
+
+  Signal& signal = signals[index];
+  if (signal.width < 64) value &= (1ULL << signal.width) - 1;
+  if (signal.known && signal.value == value) return true;
+  if (timePending) {
+    writeTime(time);
+    timePending = false;
+  }
+  signal.value = value;
+  signal.known = true;
+  writeValue(index, value);
+  changes++;
+  return true;
+}
+
+bool WaveformWriter::finish(uint64_t endTime, std::string& error) {
+  if (finished) return true;
+  if (!started) {
+    writeHeader();
+    started = true;
+  }
+  if (endTime > time || (changes == 0 && endTime == time)) writeTime(endTime);
+  finished = true;
+  return writeEnd(error);
+}
+
+uint16_t addPortSignals(WaveformWriter& writer) {
+  uint16_t first = writer.addSignal("inputs", "in0", 1);
+  for (int i = 1; i < 8; i++) writer.addSignal("inputs", "in" + std::to_string(i), 1);
+  for (int i = 0; i < 8; i++) writer.addSignal("outputs", "out" + std::to_string(i), 1);
+  return first;
+}
+
+void changePortWord(WaveformWriter& writer, uint64_t time, uint16_t first, uint16_t word) {
+  for (uint16_t bit = 0; bit < 16; bit++) writer.change(time, first + bit, word >> bit & 1);
+}
+
+namespace {
+
+// ====================
+// VALUE CHANGE DUMP
+// ====================
+class VcdWriter : public WaveformWriter {
+public:
+  VcdWriter(FILE* file, const std::string& module, const std::string& timescale)
+    : file(file), module(module), timescale(timescale), used(0) {}
+
+  ~VcdWriter() {
+    if (!file) return;
+    flush();
+    fclose(file);
+  }
+
+private:
+  static const size_t bufferBytes = 1 << 16;
+
+  // Identifier codes are base-94 numbers in the printable characters
+  void putCode(uint16_t index) {
+    do {
+      put((char)('!' + index % 94));
+      index /= 94;
+    } while (index);
+  }
+
+  void put(char c) {
+    if (used == bufferBytes) flush();
+    buffer[used++] = c;
+  }
+
+  void put(const std::string& text) {
+    for (char c : text) put(c);
+  }
+
+  void flush() {
+    if (used && file) fwrite(buffer, 1, used, file);
+    bytes += used;
+    used = 0;
+  }
+
+  void writeHeader() {
+    put("$version Digital Logic Lab Simulator $end\n");
+    put("$timescale " + timescale + " $end\n");
+    put("$scope module " + module + " $end\n");
+    std::vector<bool> declared(signals.size(), false);
+    for (size_t i = 0; i < signals.size(); i++) {
+      if (declared[i]) continue;
+      // Each scope once, with all of its signals
+      const std::string& scope = signals[i].scope;
+      if (!scope.empty()) put("$scope module " + scope + " $end\n");
+      for (size_t j = i; j < signals.size(); j++) {
+        if (declared[j] || signals[j].scope != scope) continue;
+        declared[j] = true;
+        put("$var wire " + std::to_string(signals[j].width) + " ");
+        putCode((uint16_t)j);
+        put(" " + signals[j].name + " $end\n");
+      }
+      if (!scope.empty()) put("$upscope $end\n");
+    }
+    put("$upscope $end\n$enddefinitions $end\n");
+  }
+
+  void writeTime(uint64_t at) {
+    char digits[24];
+    int count = 0;
+    do {
+      digits[count++] = (char)('0' + at % 10);
+      at /= 10;
+    } while (at);
+    put('#');
+    while (count) put(digits[--count]);
+    put('\n');
+  }
+
+  void writeValue(uint16_t index, uint64_t value) {
+    uint8_t width = signals[index].width;
+    if (width == 1) {
+      put(value ? '1' : '0');
+    }
+    else {
+      // Leading zeros may be left out
+      put('b');
+      int bit = 63;
+      while (bit > 0 && !(value >> bit & 1)) bit--;
+      for (; bit >= 0; bit--) put(value >> bit & 1 ? '1' : '0');
+      put(' ');
+    }
+    putCode(index);
+    put('\n');
+  }
+
+  bool writeEnd(std::string& error) {
+    flush();
+    bool ok = fflush(file) == 0 && !ferror(file);
+    ok = fclose(file) == 0 && ok;
+    file = 0;
+    if (!ok) error = "waveform write failed";
+    return ok;
+  }
+
+  FILE* file;
+  std::string module;
+  std::string timescale;
+  char buffer[bufferBytes];
+  size_t used;
+};
+
+#ifdef WAVEFORM_FST
+// ====================
+// FST (GTKWAVE)
+// ====================
+class FstWriter : public WaveformWriter {
+public:
+  FstWriter(void* context, const std::string& path, const std::string& module)
+    : context(context), path(path), module(module) {}
+
+  ~FstWriter() {
+    if (context) fstWriterClose(context);
+  }
+
+private:
+  void writeHeader() {
+    fstWriterSetScope(context, FST_ST_VCD_MODULE, module.c_str(), 0);
+    std::vector<bool> declared(signals.size(), false);
+    handles.resize(signals.size());
+    for (size_t i = 0; i < signals.size(); i++) {
+      if (declared[i]) continue;
+      const std::string& scope = signals[i].scope;
+      if (!scope.empty()) fstWriterSetScope(context, FST_ST_VCD_MODULE, scope.c_str(), 0);
+      for (size_t j = i; j < signals.size(); j++) {
+        if (declared[j] || signals[j].scope != scope) continue;
+        declared[j] = true;
+        handles[j] = fstWriterCreateVar(context, FST_VT_VCD_WIRE, FST_VD_IMPLICIT,
+                                        signals[j].width, signals[j].name.c_str(), 0);
+      }
+      if (!scope.empty()) fstWriterSetUpscope(context);
+    }
+    fstWriterSetUpscope(context);
+  }
+
+  void writeTime(uint64_t at) {
+    fstWriterEmitTimeChange(context, at);
+  }
+
+  void writeValue(uint16_t index, uint64_t value) {
+    char bits[65];
+    uint8_t width = signals[index].width;
+    for (uint8_t i = 0; i < width; i++) bits[i] = value >> (width - 1 - i) & 1 ? '1' : '0';
+    bits[width] = 0;
+    fstWriterEmitValueChange(context, handles[index], bits);
+  }
+
+  bool writeEnd(std::string& error) {
+    fstWriterClose(context);
+    context = 0;
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) {
+      error = path + ": waveform write failed";
+      return false;
+    }
+    bytes = info.st_size;
+    return true;
+  }
+
+  void* context;
+  std::string path;
+  std::string module;
+  std::vector<fstHandle> handles;
+};
+#endif
+
+bool endsWith(const std::string& text, const char* suffix) {
+  size_t length = strlen(suffix);
+  return text.size() >= length && text.compare(text.size() - length, length, suffix) == 0;
+}
+
+} // namespace
+
+std::unique_ptr<WaveformWriter> openWaveform(const std::string& path, const std::string& module,
+                                             const std::string& timescale, std::string& error) {
+  if (endsWith(path, ".fst")) {
+#ifdef WAVEFORM_FST
+    void* context = fstWriterCreate(path.c_str(), 1);
+    if (!context) {
+      error = path + ": cannot write";
+      return std::unique_ptr<WaveformWriter>();
+    }
+    fstWriterSetTimescaleFromString(context, timescale.c_str());
+    return std::unique_ptr<WaveformWriter>(new FstWriter(context, path, module));
+#else
+    error = path + ": built without FST support (needs -DWAVEFORM_FST and GTKWave's fstapi)";
+    return std::unique_ptr<WaveformWriter>();
+#endif
+  }
+  if (!endsWith(path, ".vcd")) {
+    error = path + ": waveform files must end in .vcd or .fst";
+    return std::unique_ptr<WaveformWriter>();
+  }
+  FILE* file = fopen(path.c_str(), "wb");
+  if (!file) {
+    error = path + ": cannot write";
+    return std::unique_ptr<WaveformWriter>();
+  }
+  return std::unique_ptr<WaveformWriter>(new VcdWriter(file, module, timescale));
+}
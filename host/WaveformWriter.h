@@ -0,0 +1,75 @@
+/*
+ * Digital Logic Lab Simulator - Waveform Files (host tools)
+ * Streams value changes to a Value Change Dump that GTKWave and most
+ * simulators open, or to GTKWave's compact FST format. Signals are declared
+ * up front; changes are then written as they arrive with non-decreasing
+ * times, so memory stays bounded by the output buffer and one value per
+ * signal however long the recording runs. Repeated values are dropped.
+ *
+ * FST needs GTKWave's fstapi (fstapi.c, lz4.c, fastlz.c from the GTKWave
+ * sources, linked with -lz) and -DWAVEFORM_FST; without it only VCD is
+ * available.
+ */
+
+#ifndef WAVEFORM_WRITER_H
+#define WAVEFORM_WRITER_H
+
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+class WaveformWriter {
+public:
+  virtual ~WaveformWriter() {}
+
+  // Signals up to 64 bits wide, grouped under scope (empty for the top)
+  uint16_t addSignal(const std::string& scope, const std::string& name, uint8_t width);
+
+  // Returns false, and writes nothing, if time goes backwards
+  bool change(uint64_t time, uint16_t signal, uint64_t value);
+
+  // Marks endTime as the end of the recording, flushes and closes the file
+  bool finish(uint64_t endTime, std::string& error);
+
+  uint64_t changeCount() const { return changes; }
+  uint64_t bytesWritten() const { return bytes; }
+
+protected:
+  WaveformWriter()
+    : started(false), finished(false), timePending(false), time(0), changes(0), bytes(0) {}
+
+  struct Signal {
+    std::string scope;
+    std::string name;
+    uint8_t width;
+    uint64_t value;
+    bool known;
+  };
+
+  virtual void writeHeader() = 0;
+  virtual void writeTime(uint64_t time) = 0;
+  virtual void writeValue(uint16_t signal, uint64_t value) = 0;
+  virtual bool writeEnd(std::string& error) = 0;
+
+  std::vector<Signal> signals;
+  bool started;
+  bool finished;
+  bool timePending;  // time has no timestamp in the file yet
+  uint64_t time;
+  uint64_t changes;
+  uint64_t bytes;
+};
+
+// Picks the format from the extension (.vcd or .fst). timescale is a VCD
+// timescale such as "1us" or "10ns".
+std::unique_ptr<WaveformWriter> openWaveform(const std::string& path, const std::string& module,
+                                             const std::string& timescale, std::string& error);
+
+// The Mega's packed I/O word as in0..in7 under "inputs" and out0..out7
+// under "outputs"; bit k of the word is signal first + k
+uint16_t addPortSignals(WaveformWriter& writer);
+void changePortWord(WaveformWriter& writer, uint64_t time, uint16_t first, uint16_t word);
+
+#endif
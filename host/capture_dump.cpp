@@ -0,0 +1,238 @@
+/*
+ * Digital Logic Lab Simulator - Logic Analyzer Dump (host tool)
+ * Reads a recorded serial stream (or a serial device already configured
+ * with stty) and prints every capture frame in it: the rate achieved, the
+ * samples dropped and the samples themselves, one row per sample with the
+ * trigger marked. -csv prints time, input and output bits as CSV instead.
+ * Run-length captures print one row per change; -expand turns them back
+ * into one row per sample. -o writes the first capture as a waveform file
+ * (.vcd, or .fst when built with FST support) with a trigger marker.
+ *
+ * Build: g++ -O2 -std=c++11 -o capture_dump host/capture_dump.cpp \
+ *            host/FrameReader.cpp host/WaveformWriter.cpp Frame.cpp
+ * Usage: capture_dump [-csv] [-expand] [-n frames] [-o capture.vcd] serial.log|/dev/ttyACM0
+ */
+
+#include "FrameReader.h"
+#include "WaveformWriter.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+const char* triggerNames[] = {"now", "pattern", "rise", "fall", "counter"};
+
+void printBits(uint8_t value, char separator) {
+  for (int bit = 0; bit < 8; bit++) {
+    if (separator && bit) putchar(separator);
+    putchar((value >> bit) & 1 ? '1' : '0');
+  }
+}
+
+const size_t maxExpandedSamples = 50000000;
+
+// Rows are (sample number, word); times are relative to the trigger sample
+void printRows(const std::vector<CaptureTransition>& rows, bool fired, uint32_t triggerSample,
+               uint32_t rateHz, bool csv) {
+  double period = rateHz ? 1e6 / rateHz : 0;
+  if (csv) {
+    printf("time_us");
+    for (int i = 0; i < 8; i++) printf(",in%d", i);
+    for (int i = 0; i < 8; i++) printf(",out%d", i);
+    printf(",trigger\n");
+  }
+  else {
+    printf("%8s %10s  %-8s  %-8s\n", "sample", "time_us", "in 0..7", "out 0..7");
+  }
+
+  long origin = fired ? (long)triggerSample : 0;
+  for (const CaptureTransition& row : rows) {
+    double time = ((long)row.sample - origin) * period;
+    bool trigger = fired && row.sample == triggerSample;
+    if (csv) {
+      printf("%.2f,", time);
+      printBits(row.word & 0xFF, ',');
+      putchar(',');
+      printBits(row.word >> 8, ',');
+      printf(",%d\n", trigger ? 1 : 0);
+    }
+    else {
+      printf("%8u %10.2f  ", row.sample, time);
+      printBits(row.word & 0xFF, 0);
+      printf("  ");
+      printBits(row.word >> 8, 0);
+      printf("%s\n", trigger ? "  <- trigger" : "");
+    }
+  }
+}
+
+void printRate(uint32_t rateHz, uint32_t elapsedMicros, uint32_t samples, uint32_t dropped) {
+  double achieved = elapsedMicros ? samples * 1e6 / elapsedMicros : 0;
+  printf("rate: %u Hz programmed, %.0f Hz achieved, %u dropped\n", rateHz, achieved, dropped);
+}
+
+void printCapture(const CaptureHeader& header, const std::vector<uint16_t>& words, bool csv) {
+  bool fired = header.triggerIndex != noTrigger;
+  if (!csv) {
+    printf("capture: %u samples kept of %u, trigger %s", header.count, header.samples,
+           header.triggerType < 5 ? triggerNames[header.triggerType] : "?");
+    if (!fired) printf(" (did not fire)");
+    printf("\n");
+    printRate(header.rateHz, header.elapsedMicros, header.samples, header.dropped);
+  }
+  std::vector<CaptureTransition> rows(words.size());
+  for (size_t i = 0; i < words.size(); i++) {
+    rows[i].sample = (uint32_t)i;
+    rows[i].word = words[i];
+  }
+  printRows(rows, fired, header.triggerIndex, header.rateHz, csv);
+}
+
+bool printRleCapture(const RleCaptureHeader& header,
+                     const std::vector<CaptureTransition>& transitions, bool csv, bool expand,
+                     std::string& error) {
+  bool fired = header.triggerSample != noTriggerSample;
+  uint32_t first = transitions.empty() ? header.samples : transitions.front().sample;
+  if (!csv) {
+    uint32_t covered = header.samples - first;
+    printf("capture (rle): %zu changes in %u bytes cover %u samples of %u, trigger %s",
+           transitions.size(), header.bytes, covered, header.samples,
+           header.triggerType < 5 ? triggerNames[header.triggerType] : "?");
+    if (!fired) printf(" (did not fire)");
+    printf("\n");
+    printRate(header.rateHz, header.elapsedMicros, header.samples, header.dropped);
+  }
+  if (!expand) {
+    printRows(transitions, fired, header.triggerSample, header.rateHz, csv);
+    return true;
+  }
+  std::vector<uint16_t> words;
+  if (!expandRleCapture(header, transitions, words, maxExpandedSamples, error)) return false;
+  std::vector<CaptureTransition> rows(words.size());
+  for (size_t i = 0; i < words.size(); i++) {
+    rows[i].sample = first + (uint32_t)i;
+    rows[i].word = words[i];
+  }
+  printRows(rows, fired, header.triggerSample, header.rateHz, csv);
+  return true;
+}
+
+// Rows as changes on a nanosecond timeline starting at the first row
+bool writeWave(const std::string& path, const std::vector<CaptureTransition>& rows, bool fired,
+               uint32_t triggerSample, uint32_t rateHz, uint32_t endSample, std::string& error) {
+  std::unique_ptr<WaveformWriter> wave = openWaveform(path, "capture", "1ns", error);
+  if (!wave) return false;
+  uint16_t port = addPortSignals(*wave);
+  uint16_t trigger = wave->addSignal("", "trigger", 1);
+  uint32_t first = rows.empty() ? 0 : rows.front().sample;
+  uint64_t rate = rateHz ? rateHz : 1;
+  auto timeOf = [&](uint32_t sample) { return (uint64_t)(sample - first) * 1000000000ULL / rate; };
+
+  // The trigger marker is high for the one trigger sample
+  std::vector<CaptureTransition> marks;
+  CaptureTransition low = {first, 0};
+  marks.push_back(low);
+  if (fired) {
+    CaptureTransition high = {triggerSample, 1};
+    CaptureTransition after = {triggerSample + 1, 0};
+    marks.push_back(high);
+    marks.push_back(after);
+  }
+  size_t mark = 0;
+  for (const CaptureTransition& row : rows) {
+    for (; mark < marks.size() && marks[mark].sample <= row.sample; mark++) {
+      wave->change(timeOf(marks[mark].sample), trigger, marks[mark].word);
+    }
+    changePortWord(*wave, timeOf(row.sample), port, row.word);
+  }
+  for (; mark < marks.size() && marks[mark].sample < endSample; mark++) {
+    wave->change(timeOf(marks[mark].sample), trigger, marks[mark].word);
+  }
+  if (!wave->finish(timeOf(endSample), error)) return false;
+  printf("%s: %llu changes, %llu bytes\n", path.c_str(),
+         (unsigned long long)wave->changeCount(), (unsigned long long)wave->bytesWritten());
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  bool csv = false;
+  bool expand = false;
+  std::string wavePath;
+  long maxFrames = 0;
+  const char* path = 0;
+  for (int arg = 1; arg < argc; arg++) {
+    if (!strcmp(argv[arg], "-csv")) csv = true;
+    else if (!strcmp(argv[arg], "-expand")) expand = true;
+    else if (!strcmp(argv[arg], "-o") && arg + 1 < argc) wavePath = argv[++arg];
+    else if (!strcmp(argv[arg], "-n") && arg + 1 < argc) maxFrames = atol(argv[++arg]);
+    else path = argv[arg];
+  }
+  if (!path) {
+    fprintf(stderr, "usage: %s [-csv] [-expand] [-n frames] [-o capture.vcd] serial.log|/dev/ttyACM0\n", argv[0]);
+    return 2;
+  }
+  FILE* in = fopen(path, "rb");
+  if (!in) {
+    fprintf(stderr, "%s: cannot open\n", path);
+    return 1;
+  }
+
+  if (!wavePath.empty()) maxFrames = 1;
+  FrameReader reader;
+  long frames = 0;
+  int failures = 0;
+  int c;
+  while ((maxFrames == 0 || frames < maxFrames) && (c = fgetc(in)) != EOF) {
+    if (!reader.feed((uint8_t)c)) continue;
+    std::string error;
+    if (reader.type() == FRAME_CAPTURE) {
+      CaptureHeader header;
+      std::vector<uint16_t> words;
+      if (!decodeCapture(reader.payload(), header, words, error)) {
+        fprintf(stderr, "%s: %s\n", path, error.c_str());
+        failures++;
+        continue;
+      }
+      if (wavePath.empty()) {
+        printCapture(header, words, csv);
+      }
+      else {
+        std::vector<CaptureTransition> rows(words.size());
+        for (size_t i = 0; i < words.size(); i++) {
+          rows[i].sample = (uint32_t)i;
+          rows[i].word = words[i];
+        }
+        if (!writeWave(wavePath, rows, header.triggerIndex != noTrigger, header.triggerIndex,
+                       header.rateHz, header.count, error)) {
+          fprintf(stderr, "%s\n", error.c_str());
+          failures++;
+        }
+      }
+    }
+    else if (reader.type() == FRAME_CAPTURE_RLE) {
+      RleCaptureHeader header;
+      std::vector<CaptureTransition> transitions;
+      bool ok = decodeRleCapture(reader.payload(), header, transitions, error);
+      if (ok && wavePath.empty()) ok = printRleCapture(header, transitions, csv, expand, error);
+      else if (ok) ok = writeWave(wavePath, transitions, header.triggerSample != noTriggerSample,
+                                  header.triggerSample, header.rateHz, header.samples, error);
+      if (!ok) {
+        fprintf(stderr, "%s: %s\n", path, error.c_str());
+        failures++;
+        continue;
+      }
+    }
+    else {
+      continue;
+    }
+    frames++;
+  }
+  fclose(in);
+  if (reader.crcErrors) fprintf(stderr, "%s: %u frames failed the CRC\n", path, reader.crcErrors);
+  if (frames == 0) fprintf(stderr, "%s: no capture frames found\n", path);
+  return failures || frames == 0 ? 1 : 0;
+}
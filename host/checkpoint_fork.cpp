@@ -0,0 +1,106 @@
+/*
+ * Digital Logic Lab Simulator - Checkpoint Fork (host tool)
+ * Picks the last checkpoint frame out of a recorded serial stream and
+ * turns it into the 'restore' lines that load it back into the firmware.
+ * Every script given becomes a run of its own: script.run holds the
+ * restore lines, 'restore apply' and then the script, so any number of
+ * experiments start from the same state. Without scripts the lines and
+ * 'restore apply' go to stdout. The checkpoint's version, size and
+ * circuit number are printed to stderr.
+ *
+ * Build: g++ -O2 -std=c++11 -o checkpoint_fork host/checkpoint_fork.cpp \
+ *            host/FrameReader.cpp Checkpoint.cpp Frame.cpp
+ * Usage: checkpoint_fork serial.log [script ...]
+ */
+
+#include "FrameReader.h"
+#include "../Checkpoint.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Bytes per restore line, short enough for the firmware's String heap
+const size_t restoreLineBytes = 32;
+
+std::string restoreLines(const std::vector<uint8_t>& blob) {
+  std::string lines;
+  char hex[3];
+  for (size_t offset = 0; offset < blob.size(); offset += restoreLineBytes) {
+    lines += "restore " + std::to_string(offset) + " ";
+    for (size_t i = offset; i < blob.size() && i < offset + restoreLineBytes; i++) {
+      snprintf(hex, sizeof(hex), "%02X", blob[i]);
+      lines += hex;
+    }
+    lines += "\n";
+  }
+  return lines + "restore apply\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s serial.log [script ...]\n", argv[0]);
+    return 2;
+  }
+  FILE* in = fopen(argv[1], "rb");
+  if (!in) {
+    fprintf(stderr, "%s: cannot open\n", argv[1]);
+    return 1;
+  }
+
+  FrameReader reader;
+  std::vector<uint8_t> blob;
+  int c;
+  while ((c = fgetc(in)) != EOF) {
+    if (reader.feed((uint8_t)c) && reader.type() == FRAME_CHECKPOINT) blob = reader.payload();
+  }
+  fclose(in);
+  if (blob.empty()) {
+    fprintf(stderr, "%s: no checkpoint frame\n", argv[1]);
+    return 1;
+  }
+
+  CheckpointBlob checkpoint;
+  for (size_t i = 0; i < blob.size(); i++) {
+    if (!checkpoint.store((uint16_t)i, blob[i])) {
+      fprintf(stderr, "%s: checkpoint of %zu bytes, at most %u\n", argv[1], blob.size(),
+              (unsigned)checkpointBytes);
+      return 1;
+    }
+  }
+  if (!checkpoint.open()) {
+    fprintf(stderr, "%s: checkpoint version %u, this tool reads version %u\n", argv[1],
+            checkpoint.version(), checkpointVersion);
+    return 1;
+  }
+  fprintf(stderr, "checkpoint: version %u, %zu bytes, %u circuits, circuit %u\n",
+          checkpoint.version(), blob.size(), checkpoint.circuits(), checkpoint.get());
+
+  std::string lines = restoreLines(blob);
+  if (argc == 2) {
+    fputs(lines.c_str(), stdout);
+    return 0;
+  }
+  int failures = 0;
+  for (int arg = 2; arg < argc; arg++) {
+    std::ifstream script(argv[arg]);
+    std::string runPath = std::string(argv[arg]) + ".run";
+    std::ofstream run(runPath);
+    if (!script || !run) {
+      fprintf(stderr, "%s: cannot open\n", script ? runPath.c_str() : argv[arg]);
+      failures++;
+      continue;
+    }
+    std::ostringstream body;
+    body << script.rdbuf();
+    run << lines << body.str();
+    fprintf(stderr, "%s\n", runPath.c_str());
+  }
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,157 @@
+/*
+ * Digital Logic Lab Simulator - Counter Benchmark (host tool)
+ * Per-edge cost of each Counter<> variant (Counter.h), driven by a
+ * recorded stream of random enables with an occasional parallel load,
+ * next to the modulo-and-branch counter the sketch used before. The
+ * check column is the final output word, so the work is not optimized
+ * away and runs can be compared. Before timing, every 4-bit load is
+ * checked to bring the decade counters back into 0-9 and the ring and
+ * Johnson counters back into their own states (the data inputs idle
+ * high, so a plain load puts 0xF on them).
+ *
+ * Build: g++ -O2 -std=c++11 -o counter_bench host/counter_bench.cpp
+ * Usage: counter_bench [edges]
+ */
+
+#include "../Counter.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// Control per edge: bit 0 enable, bit 1 load, upper bits data
+std::vector<uint32_t> controls;
+
+template <typename CounterType>
+void bench(const char* name, uint64_t edges) {
+  CounterType counter;
+  uint64_t carries = 0;
+  size_t mask = controls.size() - 1;
+  Clock::time_point start = Clock::now();
+  for (uint64_t i = 0; i < edges; i++) {
+    uint32_t control = controls[i & mask];
+    carries += counter.edge(control & 1, (control >> 1) & 1, control >> 2);
+  }
+  double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  printf("%-26s %10.2f %12llu %18llx\n", name, seconds * 1e9 / edges,
+         (unsigned long long)carries, (unsigned long long)counter.value());
+}
+
+// The sketch's former counter: counterValue = (counterValue + 1) % 16
+struct ModuloCounter {
+  typedef uint16_t Word;
+  int count = 0;
+  bool edge(bool enable, bool load, Word data) {
+    if (load) {
+      count = data & 0x0F;
+      return false;
+    }
+    if (!enable) return false;
+    bool carry = count == 15;
+    count = (count + 1) % 16;
+    return carry;
+  }
+  Word value() const { return count; }
+};
+
+// After a load of any 4-bit word, a decade counter must be back in 0-9
+// within one count and then wrap every ten edges. Returns false (and
+// says which load) if not.
+template <typename CounterType>
+bool checkDecadeLoads(const char* name) {
+  for (uint8_t data = 0; data < 16; data++) {
+    CounterType counter;
+    counter.edge(false, true, data);
+    unsigned carries = 0;
+    for (int i = 0; i < 21; i++) {
+      carries += counter.edge(true, false, 0);
+      if (counter.value() > 9) {
+        printf("%s: load of %x ran to %x\n", name, data, (unsigned)counter.value());
+        return false;
+      }
+    }
+    if (carries < 2) {
+      printf("%s: load of %x never wrapped\n", name, data);
+      return false;
+    }
+  }
+  return true;
+}
+
+// After a load of any word, a ring or Johnson counter must only show
+// its own states and come back to where it started every modulus edges.
+template <typename CounterType>
+bool checkSequenceLoads(const char* name, uint16_t modulus, uint64_t loads) {
+  // The states, counting up from reset
+  std::vector<uint64_t> states;
+  CounterType reference;
+  for (uint16_t i = 0; i < modulus; i++) {
+    states.push_back(reference.value());
+    reference.edge(true, false, 0);
+  }
+  for (uint64_t data = 0; data < loads; data++) {
+    CounterType counter;
+    counter.edge(false, true, (typename CounterType::Word)data);
+    uint64_t loaded = counter.value();
+    for (uint16_t i = 0; i < modulus; i++) {
+      bool known = false;
+      for (uint64_t state : states) known |= counter.value() == state;
+      if (!known) {
+        printf("%s: load of %llx ran to %llx\n", name, (unsigned long long)data,
+               (unsigned long long)counter.value());
+        return false;
+      }
+      counter.edge(true, false, 0);
+    }
+    if (counter.value() != loaded) {
+      printf("%s: load of %llx does not cycle\n", name, (unsigned long long)data);
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  uint64_t edges = argc > 1 ? strtoull(argv[1], 0, 0) : 50000000ULL;
+  std::mt19937 random(12345);
+  controls.resize(4096);
+  for (uint32_t& control : controls) {
+    bool load = random() % 64 == 0;
+    control = (random() & 1) | load << 1 | (random() & 0x0F) << 2;
+  }
+
+  if (!checkDecadeLoads<Counter<4, 10, COUNT_UP, COUNT_BCD>>("bcd decade up") ||
+      !checkDecadeLoads<Counter<4, 10, COUNT_DOWN, COUNT_BCD>>("bcd decade down") ||
+      !checkSequenceLoads<Counter<4, 0, COUNT_UP, COUNT_RING>>("ring 4-bit", 4, 16) ||
+      !checkSequenceLoads<Counter<8, 0, COUNT_DOWN, COUNT_RING>>("ring 8-bit down", 8, 256) ||
+      !checkSequenceLoads<Counter<4, 0, COUNT_UP, COUNT_JOHNSON>>("johnson 4-bit", 8, 16) ||
+      !checkSequenceLoads<Counter<8, 0, COUNT_UP, COUNT_JOHNSON>>("johnson 8-bit", 16, 256)) {
+    return 1;
+  }
+
+  printf("%-26s %10s %12s %18s\n", "variant", "ns/edge", "carries", "final");
+  bench<ModuloCounter>("modulo 4-bit (old)", edges);
+  bench<Counter<4>>("binary 4-bit up", edges);
+  bench<Counter<4, 0, COUNT_DOWN>>("binary 4-bit down", edges);
+  bench<Counter<16, 1000>>("binary 16-bit mod 1000", edges);
+  bench<Counter<64>>("binary 64-bit", edges);
+  bench<Counter<4, 10, COUNT_UP, COUNT_BCD>>("bcd decade up", edges);
+  bench<Counter<4, 10, COUNT_DOWN, COUNT_BCD>>("bcd decade down", edges);
+  bench<Counter<32, 0, COUNT_UP, COUNT_BCD>>("bcd 8-digit up", edges);
+  bench<Counter<64, 0, COUNT_DOWN, COUNT_BCD>>("bcd 16-digit down", edges);
+  bench<Counter<4, 0, COUNT_UP, COUNT_GRAY>>("gray 4-bit", edges);
+  bench<Counter<16, 0, COUNT_UP, COUNT_GRAY>>("gray 16-bit", edges);
+  bench<Counter<8, 0, COUNT_UP, COUNT_RING>>("ring 8-bit", edges);
+  bench<Counter<8, 0, COUNT_DOWN, COUNT_RING>>("ring 8-bit down", edges);
+  bench<Counter<8, 0, COUNT_UP, COUNT_JOHNSON>>("johnson 8-bit", edges);
+  bench<Counter<64, 0, COUNT_UP, COUNT_JOHNSON>>("johnson 64-bit", edges);
+  return 0;
+}
@@ -0,0 +1,134 @@
+/*
+ * Digital Logic Lab Simulator - FSM Loader (host tool)
+ * Turns a KISS2 state table into the 'fsm' commands that build it in the
+ * firmware's SRAM table, ready to send to the serial port; select the
+ * "FSM" circuit afterwards to run it. Input column k is input pin k and
+ * output column k output pin k; '-' inputs expand to every combination,
+ * '-' outputs are 0, and transitions the file leaves out hold the state
+ * with all outputs 0. The machine is loaded as Mealy, as KISS2 describes.
+ *
+ * Build: g++ -O2 -std=c++11 -o fsm_load host/fsm_load.cpp Fsm.cpp
+ * Usage: fsm_load machine.kiss2 > /dev/ttyACM0
+ */
+
+#include "../Fsm.h"
+#include "../Memory.h"
+
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Transition {
+  std::string inputs;
+  std::string from;
+  std::string to;
+  std::string outputs;
+};
+
+bool readKiss(const char* path, std::vector<Transition>& transitions, unsigned& inputBits,
+              unsigned& outputBits, std::string& reset, std::string& error) {
+  std::ifstream in(path);
+  if (!in) {
+    error = std::string(path) + ": cannot open";
+    return false;
+  }
+  std::string line;
+  unsigned number = 0;
+  while (std::getline(in, line)) {
+    number++;
+    std::istringstream fields(line.substr(0, line.find('#')));
+    std::string first;
+    if (!(fields >> first)) continue;
+    if (first == ".i") fields >> inputBits;
+    else if (first == ".o") fields >> outputBits;
+    else if (first == ".r") fields >> reset;
+    else if (first == ".e" || first == ".end") break;
+    else if (first[0] == '.') continue;   // .p and .s are implied by the rows
+    else {
+      Transition row;
+      row.inputs = first;
+      if (!(fields >> row.from >> row.to >> row.outputs) ||
+          row.inputs.size() != inputBits || row.outputs.size() != outputBits) {
+        error = std::string(path) + ":" + std::to_string(number) + ": malformed transition";
+        return false;
+      }
+      transitions.push_back(row);
+    }
+  }
+  if (inputBits > fsmMaxInputBits || outputBits == 0 || outputBits > 8) {
+    error = std::string(path) + ": needs at most 8 inputs and 1-8 outputs";
+    return false;
+  }
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  if (argc != 2) {
+    fprintf(stderr, "usage: %s machine.kiss2 > /dev/ttyACM0\n", argv[0]);
+    return 2;
+  }
+  std::vector<Transition> transitions;
+  unsigned inputBits = 0;
+  unsigned outputBits = 0;
+  std::string reset;
+  std::string error;
+  if (!readKiss(argv[1], transitions, inputBits, outputBits, reset, error)) {
+    fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+
+  // States are numbered in order of appearance, the reset state first
+  std::map<std::string, unsigned> numbers;
+  if (!reset.empty()) numbers[reset] = 0;
+  for (const Transition& row : transitions) {
+    for (const std::string* name : {&row.from, &row.to}) {
+      if (!numbers.count(*name)) {
+        unsigned next = numbers.size();
+        numbers[*name] = next;
+      }
+    }
+  }
+  unsigned states = numbers.size();
+  if (states == 0 || fsmTableEntries(states, inputBits) > fsmRamEntries) {
+    fprintf(stderr, "%s: %u states x 2^%u inputs do not fit the %u-entry table\n", argv[1],
+            states, inputBits, fsmRamEntries);
+    return 1;
+  }
+
+  std::vector<uint16_t> table(fsmTableEntries(states, inputBits));
+  for (size_t i = 0; i < table.size(); i++) table[i] = fsmEntry(i >> inputBits, 0);
+  for (const Transition& row : transitions) {
+    uint8_t output = 0;
+    for (unsigned k = 0; k < outputBits; k++) {
+      if (row.outputs[k] == '1') output |= 1 << k;
+    }
+    uint16_t entry = fsmEntry(numbers[row.to], output);
+    unsigned from = numbers[row.from];
+    for (unsigned inputs = 0; inputs < (1u << inputBits); inputs++) {
+      bool match = true;
+      for (unsigned k = 0; k < inputBits && match; k++) {
+        char want = row.inputs[k];
+        match = want == '-' || (want == '1') == ((inputs >> k) & 1);
+      }
+      if (match) table[from << inputBits | inputs] = entry;
+    }
+  }
+
+  // Short lines, so the board's 64-byte receive buffer keeps up
+  printf("fsm new mealy %u %u %u 0\n", states, inputBits, outputBits);
+  for (size_t i = 0; i < table.size(); i += 8) {
+    printf("fsm data %zu", i);
+    for (size_t j = i; j < i + 8 && j < table.size(); j++) printf(" %x", table[j]);
+    printf("\n");
+  }
+  fprintf(stderr, "%s: %u states, %u inputs, %u outputs, %zu entries\n", argv[1], states,
+          inputBits, outputBits, table.size());
+  return 0;
+}
@@ -0,0 +1,215 @@
+/*
+ * Digital Logic Lab Simulator - Loopback Latency (host tool)
+ * The host build of the 'latency' self-test, with the loopback wires made
+ * of virtual pins. Each netlist runs on a board thread that, like the
+ * sketch's loop(), samples the virtual input word, evaluates and publishes
+ * the output word once per loop period. The main thread plays the wire:
+ * it toggles one input at a random point of the pass and timestamps when
+ * the output under test follows, giving up after the timeout as the
+ * firmware does. Input and output default to the first pair where the
+ * toggle reaches an output, with the other inputs held where it does;
+ * circuits are numbered by argument position.
+ *
+ * Per circuit it prints the trials, timeouts and min, p50, p99, max and
+ * mean latency in microseconds from the raw samples. The same trials also
+ * go into LatencyResults in microsecond ticks, and -o writes them as a
+ * FRAME_LATENCY frame (the last four circuits) that phase_stats prints
+ * like one from the board.
+ *
+ * Build: g++ -O2 -std=c++11 -pthread -o latency_loopback host/latency_loopback.cpp \
+ *            host/NetlistReader.cpp Netlist.cpp Aig.cpp Latency.cpp Profile.cpp Frame.cpp
+ * Usage: latency_loopback [-period us] [-trials n] [-timeout ms] [-input i] [-output o]
+ *            [-o frames.bin] netlist.bench|netlist.blif...
+ */
+
+#include "NetlistReader.h"
+#include "../Latency.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+struct Options {
+  uint32_t periodMicros = 10000;  // The sketch's delay(10) per pass
+  uint32_t trials = 200;
+  uint32_t timeoutMillis = 50;
+  int input = -1;                 // -1 picks the first input that reaches an output
+  int output = -1;
+};
+
+struct VirtualPins {
+  std::atomic<uint32_t> inputs;
+  std::atomic<uint32_t> outputs;
+  std::atomic<bool> running;
+};
+
+// One loop pass per period: sample, evaluate, write the outputs
+void runBoard(Netlist& engine, VirtualPins& pins, uint32_t periodMicros) {
+  while (pins.running.load(std::memory_order_relaxed)) {
+    engine.applyInputWord(pins.inputs.load(std::memory_order_acquire));
+    engine.update();
+    pins.outputs.store(engine.outputWord(), std::memory_order_release);
+    if (periodMicros) std::this_thread::sleep_for(std::chrono::microseconds(periodMicros));
+  }
+}
+
+// First input whose toggle moves an output from the held input word, and
+// the lowest output it moves. Tries all zeros, all ones and then random
+// words; false if no toggle moves anything (e.g. only flip-flops follow).
+bool findPath(Netlist& engine, std::mt19937& random, uint32_t& held, uint16_t& input,
+              uint16_t& output) {
+  uint16_t inputs = std::min<uint16_t>(engine.inputCount(), 32);
+  for (int attempt = 0; attempt < 18; attempt++) {
+    held = attempt == 0 ? 0 : attempt == 1 ? 0xFFFFFFFFUL : (uint32_t)random();
+    engine.applyInputWord(held);
+    engine.update();
+    uint32_t before = engine.outputWord();
+    for (uint16_t i = 0; i < inputs; i++) {
+      engine.applyInputWord(held ^ (1UL << i));
+      engine.update();
+      uint32_t changed = engine.outputWord() ^ before;
+      engine.applyInputWord(held);
+      engine.update();
+      if (!changed) continue;
+      input = i;
+      for (output = 0; !(changed & (1UL << output)); output++) {}
+      return true;
+    }
+  }
+  return false;
+}
+
+double percentileMicros(const std::vector<double>& sorted, double share) {
+  if (sorted.empty()) return 0;
+  size_t index = (size_t)(share * (sorted.size() - 1) + 0.5);
+  return sorted[index];
+}
+
+FILE* frameFile = 0;
+
+void fileFrameByte(uint8_t byte) {
+  fputc(byte, frameFile);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  const char* framePath = 0;
+  std::vector<const char*> paths;
+  for (int arg = 1; arg < argc; arg++) {
+    bool value = arg + 1 < argc;
+    if (!strcmp(argv[arg], "-period") && value) options.periodMicros = strtoul(argv[++arg], 0, 0);
+    else if (!strcmp(argv[arg], "-trials") && value) options.trials = strtoul(argv[++arg], 0, 0);
+    else if (!strcmp(argv[arg], "-timeout") && value) options.timeoutMillis = strtoul(argv[++arg], 0, 0);
+    else if (!strcmp(argv[arg], "-input") && value) options.input = atoi(argv[++arg]);
+    else if (!strcmp(argv[arg], "-output") && value) options.output = atoi(argv[++arg]);
+    else if (!strcmp(argv[arg], "-o") && value) framePath = argv[++arg];
+    else paths.push_back(argv[arg]);
+  }
+  if (paths.empty() || options.trials == 0) {
+    fprintf(stderr, "usage: %s [-period us] [-trials n] [-timeout ms] [-input i] [-output o]\n"
+                    "           [-o frames.bin] netlist.bench|netlist.blif...\n", argv[0]);
+    return 2;
+  }
+
+  printf("%-3s %-14s %-10s %-10s %7s %8s %9s %9s %9s %9s %9s\n", "#", "circuit", "input",
+         "output", "trials", "timeouts", "min_us", "p50_us", "p99_us", "max_us", "mean_us");
+
+  LatencyResults results;
+  std::mt19937 random(12345);
+  int failures = 0;
+  for (size_t index = 0; index < paths.size(); index++) {
+    HostNetlist netlist;
+    std::string error;
+    if (!loadNetlistFile(paths[index], netlist, error)) {
+      fprintf(stderr, "%s\n", error.c_str());
+      failures++;
+      continue;
+    }
+    Netlist& engine = netlist.engine;
+    uint32_t held = 0;
+    uint16_t input = 0;
+    uint16_t output = 0;
+    bool found = findPath(engine, random, held, input, output);
+    if (options.input >= 0) input = options.input;
+    if (options.output >= 0) output = options.output;
+    if ((!found && (options.input < 0 || options.output < 0)) ||
+        input >= std::min<uint16_t>(engine.inputCount(), 32) ||
+        output >= std::min<uint16_t>(engine.outputCount(), 32)) {
+      fprintf(stderr, "%s: no input-to-output path to test\n", netlist.name.c_str());
+      failures++;
+      continue;
+    }
+
+    engine.applyInputWord(held);
+    engine.update();
+    VirtualPins pins;
+    pins.inputs.store(held);
+    pins.outputs.store(engine.outputWord());
+    pins.running.store(true);
+    std::thread board(runBoard, std::ref(engine), std::ref(pins), options.periodMicros);
+
+    results.select((uint8_t)index);
+    std::vector<double> micros;
+    uint32_t timeouts = 0;
+    // Pauses up to two passes long, so toggles land at every point of one
+    std::uniform_int_distribution<uint32_t> pause(100, 100 + 2 * options.periodMicros);
+    const auto timeout = std::chrono::milliseconds(options.timeoutMillis);
+    for (uint32_t trial = 0; trial < options.trials; trial++) {
+      std::this_thread::sleep_for(std::chrono::microseconds(pause(random)));
+      bool level = (pins.outputs.load(std::memory_order_acquire) >> output) & 1;
+      Clock::time_point sent = Clock::now();
+      pins.inputs.fetch_xor(1UL << input, std::memory_order_release);
+      Clock::time_point now = sent;
+      bool followed = false;
+      while (!followed && now - sent < timeout) {
+        followed = ((pins.outputs.load(std::memory_order_acquire) >> output) & 1) != level;
+        now = Clock::now();
+        if (!followed) std::this_thread::yield();
+      }
+      if (!followed) {
+        timeouts++;
+        results.addTimeout();
+        continue;
+      }
+      uint64_t nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(now - sent).count();
+      micros.push_back(nanos / 1e3);
+      results.addLatency((uint32_t)(nanos / 1000));
+    }
+    pins.running.store(false);
+    board.join();
+
+    std::sort(micros.begin(), micros.end());
+    double total = 0;
+    for (double latency : micros) total += latency;
+    const std::string& inputName = netlist.nodeNames[engine.sourceNode(input)];
+    const std::string& outputName = netlist.nodeNames[netlist.outputs[output]];
+    printf("%-3zu %-14s %-10s %-10s %7u %8u %9.2f %9.2f %9.2f %9.2f %9.2f\n", index,
+           netlist.name.c_str(), inputName.c_str(), outputName.c_str(), options.trials, timeouts,
+           percentileMicros(micros, 0), percentileMicros(micros, 0.5),
+           percentileMicros(micros, 0.99), percentileMicros(micros, 1),
+           micros.empty() ? 0 : total / micros.size());
+  }
+
+  if (framePath) {
+    frameFile = fopen(framePath, "wb");
+    if (!frameFile) {
+      fprintf(stderr, "%s: cannot open\n", framePath);
+      return 1;
+    }
+    FrameWriter writer(fileFrameByte);
+    writeLatencyFrame(writer, results, 1000000UL);
+    fclose(frameFile);
+  }
+  return failures ? 1 : 0;
+}
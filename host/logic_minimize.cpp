@@ -0,0 +1,193 @@
+/*
+ * Digital Logic Lab Simulator - Two-Level Minimizer (host tool)
+ * Minimizes each output of a .bench / .blif netlist over the inputs in its
+ * cone and reports literals and gates before (the netlist cone) and after
+ * (the two-level cover), plus the evaluation time per input vector.
+ * With -o the covers are written as a BLIF model, one .names per output.
+ *
+ * Build: g++ -O2 -std=c++11 -o logic_minimize host/logic_minimize.cpp \
+ *            host/NetlistReader.cpp Netlist.cpp Aig.cpp Minimizer.cpp
+ * Usage: logic_minimize [-pos] [-o minimized.blif] netlist.bench|netlist.blif...
+ */
+
+#include "NetlistReader.h"
+#include "../Minimizer.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double secondsSince(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Runs step() until at least minSeconds have passed; returns calls/second
+template <typename Step>
+double measureRate(Step step, double minSeconds) {
+  uint64_t calls = 0;
+  Clock::time_point start = Clock::now();
+  double elapsed = 0;
+  do {
+    step();
+    calls++;
+    elapsed = secondsSince(start);
+  } while (elapsed < minSeconds);
+  return calls / elapsed;
+}
+
+struct MinimizedOutput {
+  std::string name;
+  std::vector<uint16_t> support;
+  std::vector<Cube> cover;
+};
+
+std::string nodeName(const HostNetlist& netlist, NodeId node, const char* prefix) {
+  if (node < netlist.nodeNames.size() && !netlist.nodeNames[node].empty()) {
+    return netlist.nodeNames[node];
+  }
+  return prefix + std::to_string(node);
+}
+
+// One .names block per output: the on-set cover, or the off-set for -pos
+bool writeBlif(const std::string& path, const HostNetlist& netlist,
+               const std::vector<MinimizedOutput>& outputs, bool productOfSums,
+               std::string& error) {
+  std::ofstream out(path.c_str());
+  if (!out) {
+    error = path + ": cannot write";
+    return false;
+  }
+  const Netlist& engine = netlist.engine;
+  out << ".model " << netlist.name << "_min\n.inputs";
+  for (uint16_t i = 0; i < engine.inputCount(); i++) {
+    out << " " << nodeName(netlist, engine.sourceNode(i), "in");
+  }
+  out << "\n.outputs";
+  for (const MinimizedOutput& o : outputs) out << " " << o.name;
+  out << "\n";
+
+  for (const MinimizedOutput& o : outputs) {
+    out << ".names";
+    for (uint16_t source : o.support) out << " " << nodeName(netlist, engine.sourceNode(source), "in");
+    out << " " << o.name << "\n";
+    for (const Cube& cube : o.cover) {
+      for (size_t v = 0; v < o.support.size(); v++) {
+        uint16_t bit = 1 << v;
+        out << (!(cube.care & bit) ? '-' : (cube.value & bit) ? '1' : '0');
+      }
+      out << (o.support.empty() ? "" : " ") << (productOfSums ? "0" : "1") << "\n";
+    }
+    // An empty product of sums is constant 1
+    if (productOfSums && o.cover.empty()) out << "1\n";
+  }
+  out << ".end\n";
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  bool productOfSums = false;
+  std::string outputPath;
+  std::vector<std::string> paths;
+  for (int arg = 1; arg < argc; arg++) {
+    if (!strcmp(argv[arg], "-pos")) productOfSums = true;
+    else if (!strcmp(argv[arg], "-o") && arg + 1 < argc) outputPath = argv[++arg];
+    else paths.push_back(argv[arg]);
+  }
+  if (paths.empty() || (!outputPath.empty() && paths.size() != 1)) {
+    fprintf(stderr, "usage: %s [-pos] [-o minimized.blif] netlist.bench|netlist.blif...\n", argv[0]);
+    return 2;
+  }
+
+  printf("%-10s %-10s %4s %6s %6s %6s %6s %6s %5s %9s %9s %7s\n",
+         "circuit", "output", "vars", "gates", "lits", "terms", "lits", "gates",
+         "exact", "net_ns", "cover_ns", "speedup");
+
+  int failures = 0;
+  for (const std::string& path : paths) {
+    HostNetlist netlist;
+    std::string error;
+    if (!loadNetlistFile(path, netlist, error)) {
+      fprintf(stderr, "%s\n", error.c_str());
+      failures++;
+      continue;
+    }
+    Netlist& engine = netlist.engine;
+    std::vector<MinimizedOutput> minimized;
+    std::vector<uint8_t> marks((engine.nodeCount() + 7) / 8);
+
+    for (uint16_t o = 0; o < engine.outputCount(); o++) {
+      MinimizedOutput result;
+      result.name = nodeName(netlist, engine.outputNode(o), "out");
+      uint16_t support[minimizerMaxInputs];
+      uint8_t numSupport = 0;
+      if (!outputSupport(engine, o, support, minimizerMaxInputs, numSupport)) {
+        printf("%-10s %-10s skipped: depends on a flip-flop or more than %u inputs\n",
+               netlist.name.c_str(), result.name.c_str(), minimizerMaxInputs);
+        continue;
+      }
+      result.support.assign(support, support + numSupport);
+
+      std::vector<uint8_t> table(truthTableBytes(numSupport));
+      double tableRate = measureRate([&]() {
+        netlistTruthTable(engine, o, support, numSupport, table.data());
+      }, 0.05);
+
+      std::vector<uint8_t> scratch(minimizerScratchBytes(numSupport));
+      result.cover.resize(1u << numSupport);
+      uint16_t count = 0;
+      bool exact = false;
+      bool ok = productOfSums
+        ? minimizePos(table.data(), 0, numSupport, result.cover.data(),
+                      (uint16_t)result.cover.size(), count, scratch.data(), scratch.size(), &exact)
+        : minimizeSop(table.data(), 0, numSupport, result.cover.data(),
+                      (uint16_t)result.cover.size(), count, scratch.data(), scratch.size(), &exact);
+      if (!ok) {
+        printf("%-10s %-10s skipped: cover does not fit\n", netlist.name.c_str(), result.name.c_str());
+        continue;
+      }
+      result.cover.resize(count);
+
+      uint32_t minterms = 1u << numSupport;
+      volatile uint32_t sink = 0;
+      double coverRate = measureRate([&]() {
+        uint32_t ones = 0;
+        for (uint32_t m = 0; m < minterms; m++) {
+          ones += coverValue(result.cover.data(), count, (uint16_t)m, productOfSums);
+        }
+        sink = sink + ones;
+      }, 0.05);
+
+      std::fill(marks.begin(), marks.end(), 0);
+      uint16_t coneLiterals = 0;
+      uint16_t coneGates = faninConeGates(engine, engine.outputNode(o), marks.data(), coneLiterals);
+      double netNs = 1e9 / (tableRate * minterms);
+      double coverNs = 1e9 / (coverRate * minterms);
+      printf("%-10s %-10s %4u %6u %6u %6u %6u %6u %5s %9.1f %9.1f %6.1fx\n",
+             netlist.name.c_str(), result.name.c_str(), numSupport, coneGates, coneLiterals,
+             count, coverLiterals(result.cover.data(), count),
+             coverGates(result.cover.data(), count, productOfSums),
+             exact ? "yes" : "no", netNs, coverNs, netNs / coverNs);
+      minimized.push_back(result);
+    }
+
+    if (!outputPath.empty()) {
+      if (minimized.size() != engine.outputCount()) {
+        fprintf(stderr, "%s: not every output was minimized, nothing written\n", path.c_str());
+        failures++;
+      }
+      else if (!writeBlif(outputPath, netlist, minimized, productOfSums, error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        failures++;
+      }
+    }
+  }
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,127 @@
+/*
+ * Digital Logic Lab Simulator - Memory Budget Check (host tool)
+ * Prints the static SRAM of each subsystem (Memory.h) in every build
+ * configuration of the sketch, plain and with PHASE_PROFILE and
+ * PHASE_TRACE, and fails when a subsystem is over its budget or the
+ * subsystems together leave less than the stack reserve and heap budget
+ * of the 8 KB. Sizes are the host compiler's, an overestimate of the
+ * AVR's buffers.
+ *
+ * The subsystems are not all of the static SRAM: the other globals, the
+ * core's Serial buffers and every string literal not wrapped in F() go
+ * in too. So the check also reads the section headers of the built
+ * sketch (the .elf the Arduino build leaves behind, one per
+ * configuration) and fails when its .data, .bss and .noinit come to more
+ * than staticBudget. Without an image the static check cannot pass.
+ *
+ * Build: g++ -O2 -std=c++11 -o mem_budget host/mem_budget.cpp Memory.cpp
+ * Usage: mem_budget sketch.elf [sketch.elf ...]
+ */
+
+#include "../Memory.h"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+// Little-endian field of an ELF header (the AVR and x86 images both are)
+uint64_t field(const std::vector<uint8_t>& image, size_t at, size_t bytes) {
+  uint64_t value = 0;
+  for (size_t i = 0; i < bytes && at + i < image.size(); i++) {
+    value |= (uint64_t)image[at + i] << (8 * i);
+  }
+  return value;
+}
+
+// .data + .bss + .noinit of an ELF image, false if it cannot be read
+bool staticSections(const char* path, uint32_t& bytes) {
+  FILE* file = fopen(path, "rb");
+  if (!file) return false;
+  std::vector<uint8_t> image;
+  uint8_t buffer[4096];
+  size_t got;
+  while ((got = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    image.insert(image.end(), buffer, buffer + got);
+  }
+  fclose(file);
+  if (image.size() < 64 || memcmp(image.data(), "\x7f" "ELF", 4) != 0 || image[5] != 1) {
+    return false;
+  }
+
+  // Offsets differ between ELF32 (the AVR) and ELF64
+  bool wide = image[4] == 2;
+  uint64_t sections = field(image, wide ? 0x28 : 0x20, wide ? 8 : 4);
+  size_t entryBytes = field(image, wide ? 0x3A : 0x2E, 2);
+  size_t count = field(image, wide ? 0x3C : 0x30, 2);
+  size_t names = field(image, wide ? 0x3E : 0x32, 2);
+  if (count == 0 || names >= count || sections + count * entryBytes > image.size()) return false;
+  size_t nameEntry = sections + names * entryBytes;
+  uint64_t nameTable = field(image, nameEntry + (wide ? 0x18 : 0x10), wide ? 8 : 4);
+
+  bytes = 0;
+  for (size_t i = 0; i < count; i++) {
+    size_t entry = sections + i * entryBytes;
+    uint64_t name = nameTable + field(image, entry, 4);
+    uint64_t size = field(image, entry + (wide ? 0x20 : 0x14), wide ? 8 : 4);
+    if (name >= image.size()) return false;
+    const char* text = (const char*)image.data() + name;
+    size_t room = image.size() - name;
+    if (strncmp(text, ".data", room) == 0 || strncmp(text, ".bss", room) == 0 ||
+        strncmp(text, ".noinit", room) == 0) {
+      bytes += size;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  static const char* configNames[] = {"plain", "profile", "trace", "profile+trace"};
+  const uint32_t shared = sramBytes - stackReserve - heapBudget;
+  int failures = 0;
+
+  printf("%-14s %-10s %7s %7s\n", "config", "subsystem", "bytes", "budget");
+  for (uint8_t config = 0; config < 4; config++) {
+    MemoryUsage usage[MEMORY_SUBSYSTEMS];
+    subsystemMemory(usage, config);
+    uint32_t total = 0;
+    for (const MemoryUsage& subsystem : usage) {
+      bool over = overBudget(subsystem);
+      printf("%-14s %-10s %7u %7u%s\n", configNames[config], subsystem.name, subsystem.bytes,
+             subsystem.budget, over ? "  OVER" : "");
+      total += subsystem.bytes;
+      failures += over;
+    }
+    bool over = total > shared;
+    printf("%-14s %-10s %7u %7u%s\n", configNames[config], "total", total, shared,
+           over ? "  OVER" : "");
+    failures += over;
+  }
+
+  printf("\n%-40s %7s %7s\n", "image", "static", "budget");
+  if (argc < 2) {
+    fprintf(stderr, "no sketch image given: .data + .bss not checked\n");
+    failures++;
+  }
+  for (int i = 1; i < argc; i++) {
+    uint32_t bytes;
+    if (!staticSections(argv[i], bytes)) {
+      fprintf(stderr, "%s: not a readable ELF image\n", argv[i]);
+      failures++;
+      continue;
+    }
+    bool over = bytes > staticBudget;
+    printf("%-40s %7u %7u%s\n", argv[i], bytes, staticBudget, over ? "  OVER" : "");
+    failures += over;
+  }
+
+  if (failures) {
+    fprintf(stderr, "%d over budget or unchecked\n", failures);
+    return 1;
+  }
+  printf("all within budget\n");
+  return 0;
+}
@@ -0,0 +1,109 @@
+/*
+ * Digital Logic Lab Simulator - Netlist Benchmark (host tool)
+ * Loads each .bench / .blif file and reports load time, memory per gate
+ * and evaluation throughput for full passes and single-input cone updates.
+ * Each circuit is reported again as <name>/aig after AIG lowering, with
+ * load_ms covering the lowering.
+ *
+ * Build: g++ -O2 -std=c++11 -o netlist_bench host/netlist_bench.cpp \
+ *            host/NetlistReader.cpp Netlist.cpp Aig.cpp
+ * Usage: netlist_bench benchmarks/c17.bench benchmarks/mul16.bench ...
+ */
+
+#include "NetlistReader.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double secondsSince(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Runs step() until at least minSeconds have passed; returns calls/second
+template <typename Step>
+double measureRate(Step step, double minSeconds) {
+  uint64_t calls = 0;
+  Clock::time_point start = Clock::now();
+  double elapsed = 0;
+  do {
+    for (int i = 0; i < 64; i++) step();
+    calls += 64;
+    elapsed = secondsSince(start);
+  } while (elapsed < minSeconds);
+  return calls / elapsed;
+}
+
+// Measures one loaded netlist and prints its row
+void report(HostNetlist& netlist, const std::string& name, double loadMs, std::mt19937& random) {
+  Netlist& engine = netlist.engine;
+  uint16_t gates = engine.gateCount() ? engine.gateCount() : 1;
+  double bytesPerGate = (double)(netlist.gateBytes() + netlist.arena.size()) / gates;
+
+  // Full passes with random inputs (and a clock edge for sequential ones)
+  uint16_t inputs = engine.inputCount();
+  double fullRate = measureRate([&]() {
+    for (uint16_t i = 0; i < inputs; i++) engine.setInput(i, random() & 1);
+    engine.clock();
+    engine.evaluateAll();
+  }, 0.2);
+
+  // Single-input toggles through the fanout cones
+  uint32_t updatesBefore = engine.updateCount;
+  uint32_t evaluatedBefore = engine.totalEvaluated;
+  double coneRate = inputs == 0 ? 0 : measureRate([&]() {
+    uint16_t input = random() % inputs;
+    engine.setInput(input, !engine.value(input));  // Inputs are nodes 0..n-1
+    engine.update();
+  }, 0.2);
+  uint32_t updates = engine.updateCount - updatesBefore;
+  double coneAverage = updates ? (double)(engine.totalEvaluated - evaluatedBefore) / updates : 0;
+
+  printf("%-14s %6u %6u %5u %5u %5u %6u %9.3f %8.1f %8zu %10.1f %9.1f %10.3f\n",
+         name.c_str(), engine.nodeCount(), engine.gateCount(),
+         engine.inputCount(), engine.outputCount(), engine.flipFlopCount(),
+         engine.levelCount(), loadMs, bytesPerGate, netlist.arena.size(),
+         fullRate * engine.gateCount() / 1e6, coneAverage, coneRate / 1e6);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s netlist.bench|netlist.blif...\n", argv[0]);
+    return 2;
+  }
+
+  printf("%-14s %6s %6s %5s %5s %5s %6s %9s %8s %8s %10s %9s %10s\n",
+         "circuit", "nodes", "gates", "in", "out", "ff", "levels", "load_ms",
+         "B/gate", "arena_B", "full_Mg/s", "cone_avg", "cone_Mupd/s");
+
+  int failures = 0;
+  std::mt19937 random(12345);
+  for (int arg = 1; arg < argc; arg++) {
+    HostNetlist netlist;
+    std::string error;
+    Clock::time_point loadStart = Clock::now();
+    if (!loadNetlistFile(argv[arg], netlist, error)) {
+      fprintf(stderr, "%s\n", error.c_str());
+      failures++;
+      continue;
+    }
+    report(netlist, netlist.name, secondsSince(loadStart) * 1000.0, random);
+
+    HostNetlist lowered;
+    AigStats stats;
+    Clock::time_point lowerStart = Clock::now();
+    if (!lowerToAig(netlist, lowered, stats, error)) {
+      fprintf(stderr, "%s\n", error.c_str());
+      failures++;
+      continue;
+    }
+    report(lowered, netlist.name + "/aig", secondsSince(lowerStart) * 1000.0, random);
+  }
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,140 @@
+/*
+ * Digital Logic Lab Simulator - Phase Statistics (host tool)
+ * Prints the loop phase timings the firmware sends for 'stats' (built
+ * with PHASE_PROFILE 1): per phase the passes measured, min, mean and max
+ * in cycles and microseconds, the 50th and 99th percentile read off the
+ * histogram (upper bucket bounds) and the histogram itself. Latency
+ * frames from 'latency report' (or latency_loopback -o) are printed the
+ * same way, one row per circuit number with its timeouts. Reads a
+ * recorded serial stream or a serial device configured with stty; the
+ * last frame of each kind in the stream is printed unless -all is given.
+ *
+ * Build: g++ -O2 -std=c++11 -o phase_stats host/phase_stats.cpp \
+ *            host/FrameReader.cpp Frame.cpp
+ * Usage: phase_stats [-all] serial.log|/dev/ttyACM0
+ */
+
+#include "FrameReader.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+const char* phaseNames[] = {"sample", "debounce", "evaluate", "output", "rx_parse", "tx"};
+
+// Upper bound of the bucket holding the given share of the passes
+uint64_t percentile(const PhaseSummary& phase, uint8_t shift, double share) {
+  uint64_t seen = 0;
+  uint64_t total = 0;
+  for (uint32_t count : phase.buckets) total += count;
+  if (total == 0) return 0;
+  for (size_t b = 0; b < phase.buckets.size(); b++) {
+    seen += phase.buckets[b];
+    if (seen >= share * total) {
+      if (b + 1 == phase.buckets.size()) return phase.max;
+      return (2ULL << (shift + b)) - 1;
+    }
+  }
+  return phase.max;
+}
+
+void printHeader(const char* what, uint8_t shift) {
+  printf("%-9s %9s %9s %9s %9s %9s %9s %10s %9s  histogram (bucket 0 < %u cycles, x2 each)\n",
+         what, "count", "min", "mean", "max", "p50<=", "p99<=", "mean_us", "max_us", 2u << shift);
+}
+
+void printRow(const std::string& name, const PhaseSummary& phase, uint8_t shift,
+              double usPerCycle) {
+  printf("%-9s %9u %9u %9u %9u %9llu %9llu %10.2f %9.2f ", name.c_str(), phase.count, phase.min,
+         phase.mean, phase.max,
+         (unsigned long long)percentile(phase, shift, 0.5),
+         (unsigned long long)percentile(phase, shift, 0.99),
+         phase.mean * usPerCycle, phase.max * usPerCycle);
+  for (uint32_t count : phase.buckets) printf(" %u", count);
+  printf("\n");
+}
+
+void printStats(const StatsFrame& frame) {
+  double usPerCycle = frame.cyclesPerSecond ? 1e6 / frame.cyclesPerSecond : 0;
+  printHeader("phase", frame.bucketShift);
+  for (size_t p = 0; p < frame.phases.size(); p++) {
+    std::string name = p < sizeof(phaseNames) / sizeof(phaseNames[0]) ? phaseNames[p]
+                                                                       : "phase" + std::to_string(p);
+    printRow(name, frame.phases[p], frame.bucketShift, usPerCycle);
+  }
+}
+
+void printLatency(const LatencyFrame& frame) {
+  double usPerCycle = frame.cyclesPerSecond ? 1e6 / frame.cyclesPerSecond : 0;
+  printHeader("circuit", frame.bucketShift);
+  for (const LatencyCircuit& circuit : frame.circuits) {
+    printRow("#" + std::to_string(circuit.circuit), circuit.latency, frame.bucketShift, usPerCycle);
+    if (circuit.timeouts) printf("%-9s %9u timeouts\n", "", circuit.timeouts);
+  }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  bool all = false;
+  const char* path = 0;
+  for (int arg = 1; arg < argc; arg++) {
+    if (!strcmp(argv[arg], "-all")) all = true;
+    else path = argv[arg];
+  }
+  if (!path) {
+    fprintf(stderr, "usage: %s [-all] serial.log|/dev/ttyACM0\n", argv[0]);
+    return 2;
+  }
+  FILE* in = fopen(path, "rb");
+  if (!in) {
+    fprintf(stderr, "%s: cannot open\n", path);
+    return 1;
+  }
+
+  FrameReader reader;
+  StatsFrame frame;
+  StatsFrame last;
+  LatencyFrame latency;
+  LatencyFrame lastLatency;
+  uint32_t frames = 0;
+  uint32_t latencyFrames = 0;
+  std::string error;
+  int c;
+  while ((c = fgetc(in)) != EOF) {
+    if (!reader.feed((uint8_t)c)) continue;
+    if (reader.type() == FRAME_STATS) {
+      if (!decodeStats(reader.payload(), frame, error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        continue;
+      }
+      frames++;
+      if (all) {
+        printf("stats frame %u\n", frames);
+        printStats(frame);
+      }
+      last = frame;
+    }
+    else if (reader.type() == FRAME_LATENCY) {
+      if (!decodeLatency(reader.payload(), latency, error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        continue;
+      }
+      latencyFrames++;
+      if (all) {
+        printf("latency frame %u\n", latencyFrames);
+        printLatency(latency);
+      }
+      lastLatency = latency;
+    }
+  }
+  fclose(in);
+  if (!frames && !latencyFrames) {
+    fprintf(stderr, "%s: no stats or latency frames (%u CRC errors)\n", path, reader.crcErrors);
+    return 1;
+  }
+  if (!all && frames) printStats(last);
+  if (!all && latencyFrames) printLatency(lastLatency);
+  return 0;
+}
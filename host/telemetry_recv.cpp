@@ -0,0 +1,312 @@
+/*
+ * Digital Logic Lab Simulator - Telemetry Receiver (host tool)
+ * Receives the firmware's 'stream on' telemetry from a serial device (or
+ * a recorded stream), checks frame sequence numbers for gaps and prints
+ * line throughput once a second. -csv writes every event as time, inputs,
+ * outputs, counter and setup/hold violation flags, and -o writes them as a
+ * waveform file (.vcd, or .fst when built with FST support), the flags as
+ * a 2-bit "violation" signal that holds until the next event; times are
+ * unwrapped past the 32-bit micros() wrap. Violations are also counted.
+ *
+ * A reader thread does nothing but move bytes from the device into memory,
+ * so a slow disk or terminal never backs up into the kernel's small tty
+ * buffer; decoding and writing happen on the main thread.
+ *
+ * Build: g++ -O2 -std=c++11 -pthread -o telemetry_recv host/telemetry_recv.cpp \
+ *            host/FrameReader.cpp host/WaveformWriter.cpp Frame.cpp
+ * Usage: telemetry_recv [-b baud] [-t seconds] [-csv events.csv] [-o events.vcd]
+ *                       /dev/ttyACM0|stream.log
+ */
+
+#include "FrameReader.h"
+#include "WaveformWriter.h"
+#include "../Timing.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double secondsSince(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+bool baudConstant(long baud, speed_t& speed) {
+  static const struct { long baud; speed_t speed; } rates[] = {
+    {9600, B9600}, {19200, B19200}, {38400, B38400}, {57600, B57600},
+    {115200, B115200}, {230400, B230400},
+#ifdef B500000
+    {500000, B500000}, {1000000, B1000000}, {2000000, B2000000},
+#endif
+  };
+  for (size_t i = 0; i < sizeof(rates) / sizeof(rates[0]); i++) {
+    if (rates[i].baud == baud) {
+      speed = rates[i].speed;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Opens a serial device in raw mode at baud; other files are read as they are
+int openStream(const char* path, long baud, bool& device, std::string& error) {
+  int fd = open(path, O_RDONLY | O_NOCTTY);
+  if (fd < 0) {
+    error = std::string(path) + ": cannot open";
+    return -1;
+  }
+  device = isatty(fd);
+  if (!device) return fd;
+
+  speed_t speed;
+  termios tty;
+  if (!baudConstant(baud, speed)) {
+    error = "unsupported baud rate " + std::to_string(baud);
+  }
+  else if (tcgetattr(fd, &tty) != 0) {
+    error = std::string(path) + ": not a configurable serial device";
+  }
+  else {
+    cfmakeraw(&tty);
+    cfsetispeed(&tty, speed);
+    cfsetospeed(&tty, speed);
+    tty.c_cflag |= CLOCAL | CREAD;
+    tty.c_cc[VMIN] = 1;
+    tty.c_cc[VTIME] = 0;
+    if (tcsetattr(fd, TCSANOW, &tty) == 0) {
+      tcflush(fd, TCIFLUSH);
+      return fd;
+    }
+    error = std::string(path) + ": cannot set the line speed";
+  }
+  close(fd);
+  return -1;
+}
+
+// Bytes handed from the reader thread to the decoder
+class ChunkQueue {
+public:
+  ChunkQueue() : finished(false) {}
+
+  void push(std::vector<uint8_t>& chunk) {
+    std::lock_guard<std::mutex> lock(mutex);
+    chunks.push_back(std::vector<uint8_t>());
+    chunks.back().swap(chunk);
+    ready.notify_one();
+  }
+
+  void finish() {
+    std::lock_guard<std::mutex> lock(mutex);
+    finished = true;
+    ready.notify_one();
+  }
+
+  // Waits up to timeout; returns false once finished and drained
+  bool pop(std::vector<uint8_t>& chunk, std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex);
+    ready.wait_for(lock, timeout, [this]() { return !chunks.empty() || finished; });
+    chunk.clear();
+    if (chunks.empty()) return !finished;
+    chunk.swap(chunks.front());
+    chunks.pop_front();
+    return true;
+  }
+
+private:
+  std::mutex mutex;
+  std::condition_variable ready;
+  std::deque<std::vector<uint8_t> > chunks;
+  bool finished;
+};
+
+struct Totals {
+  uint64_t bytes;
+  uint64_t frames;
+  uint64_t events;
+  uint64_t gapFrames;     // Frames missing by sequence number
+  uint64_t badFrames;
+  uint64_t setupViolations;
+  uint64_t holdViolations;
+  uint16_t firstLost;
+  uint16_t lastLost;
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+  long baud = 115200;
+  double duration = 0;
+  const char* csvPath = 0;
+  const char* wavePath = 0;
+  const char* path = 0;
+  for (int arg = 1; arg < argc; arg++) {
+    if (!strcmp(argv[arg], "-b") && arg + 1 < argc) baud = atol(argv[++arg]);
+    else if (!strcmp(argv[arg], "-t") && arg + 1 < argc) duration = atof(argv[++arg]);
+    else if (!strcmp(argv[arg], "-csv") && arg + 1 < argc) csvPath = argv[++arg];
+    else if (!strcmp(argv[arg], "-o") && arg + 1 < argc) wavePath = argv[++arg];
+    else path = argv[arg];
+  }
+  if (!path) {
+    fprintf(stderr, "usage: %s [-b baud] [-t seconds] [-csv events.csv] [-o events.vcd] "
+            "/dev/ttyACM0|stream.log\n",
+            argv[0]);
+    return 2;
+  }
+
+  bool device = false;
+  std::string error;
+  int fd = openStream(path, baud, device, error);
+  if (fd < 0) {
+    fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+  FILE* csv = 0;
+  if (csvPath) {
+    csv = fopen(csvPath, "w");
+    if (!csv) {
+      fprintf(stderr, "%s: cannot write\n", csvPath);
+      close(fd);
+      return 1;
+    }
+    static char csvBuffer[1 << 20];
+    setvbuf(csv, csvBuffer, _IOFBF, sizeof(csvBuffer));
+    fprintf(csv, "time_us,inputs,outputs,counter,violation\n");
+  }
+  std::unique_ptr<WaveformWriter> wave;
+  uint16_t port = 0;
+  uint16_t counter = 0;
+  uint16_t violation = 0;
+  if (wavePath) {
+    wave = openWaveform(wavePath, "telemetry", "1us", error);
+    if (!wave) {
+      fprintf(stderr, "%s\n", error.c_str());
+      close(fd);
+      if (csv) fclose(csv);
+      return 1;
+    }
+    port = addPortSignals(*wave);
+    counter = wave->addSignal("", "counter", 8);
+    violation = wave->addSignal("", "violation", 2);
+  }
+
+  ChunkQueue queue;
+  std::atomic<bool> stopReading(false);
+  std::thread reader([&]() {
+    std::vector<uint8_t> chunk;
+    while (!stopReading) {
+      pollfd wait = {fd, POLLIN, 0};
+      if (poll(&wait, 1, 100) == 0) continue;
+      chunk.resize(1 << 16);
+      ssize_t got = read(fd, chunk.data(), chunk.size());
+      if (got <= 0) break;
+      chunk.resize(got);
+      queue.push(chunk);
+    }
+    queue.finish();
+  });
+
+  FrameReader frames;
+  TelemetryFrame frame;
+  Totals totals = {0, 0, 0, 0, 0, 0, 0, 0, 0};
+  bool haveSequence = false;
+  uint16_t sequence = 0;
+  uint64_t epoch = 0;           // micros() wraps every 71.6 minutes
+  uint32_t lastMicros = 0;
+  bool haveTime = false;
+  uint64_t startMicros = 0;
+
+  Clock::time_point start = Clock::now();
+  Clock::time_point reportAt = start + std::chrono::seconds(1);
+  Clock::time_point lastReport = start;
+  uint64_t reportBytes = 0;
+  double decodeSeconds = 0;
+  std::vector<uint8_t> chunk;
+  while (queue.pop(chunk, std::chrono::milliseconds(100))) {
+    Clock::time_point decodeStart = Clock::now();
+    for (uint8_t byte : chunk) {
+      if (!frames.feed(byte) || frames.type() != FRAME_TELEMETRY) continue;
+      if (!decodeTelemetry(frames.payload(), frame, error)) {
+        totals.badFrames++;
+        continue;
+      }
+      if (haveSequence) totals.gapFrames += (uint16_t)(frame.sequence - sequence - 1);
+      else totals.firstLost = frame.lost;
+      haveSequence = true;
+      sequence = frame.sequence;
+      totals.lastLost = frame.lost;
+      totals.frames++;
+      totals.events += frame.events.size();
+      for (const TelemetryEvent& event : frame.events) {
+        if (haveTime && event.micros < lastMicros && lastMicros - event.micros > 0x80000000UL) {
+          epoch += 1ULL << 32;
+        }
+        uint64_t time = epoch + event.micros;
+        if (!haveTime) startMicros = time;
+        haveTime = true;
+        lastMicros = event.micros;
+        if (event.mark & TIMING_SETUP) totals.setupViolations++;
+        if (event.mark & TIMING_HOLD) totals.holdViolations++;
+        if (csv) {
+          fprintf(csv, "%llu,%u,%u,%u,%u\n", (unsigned long long)(time - startMicros),
+                  event.word & 0xFF, event.word >> 8, event.counter, event.mark);
+        }
+        if (wave) {
+          changePortWord(*wave, time - startMicros, port, event.word);
+          wave->change(time - startMicros, counter, event.counter);
+          wave->change(time - startMicros, violation, event.mark);
+        }
+      }
+    }
+    decodeSeconds += secondsSince(decodeStart);
+    totals.bytes += chunk.size();
+
+    if (device && Clock::now() >= reportAt) {
+      double rate = (totals.bytes - reportBytes) / secondsSince(lastReport);
+      fprintf(stderr, "%7.1fs %9.0f B/s %5.1f%% line  frames %llu  events %llu  gaps %llu  lost %u  crc %u\n",
+              secondsSince(start), rate, 100.0 * rate * 10 / baud,
+              (unsigned long long)totals.frames, (unsigned long long)totals.events,
+              (unsigned long long)totals.gapFrames, (uint16_t)(totals.lastLost - totals.firstLost),
+              frames.crcErrors);
+      reportBytes = totals.bytes;
+      lastReport = Clock::now();
+      reportAt = lastReport + std::chrono::seconds(1);
+    }
+    if (duration > 0 && secondsSince(start) >= duration) break;
+  }
+  stopReading = true;
+  reader.join();
+  close(fd);
+  if (csv) fclose(csv);
+  bool written = !wave || wave->finish(haveTime ? epoch + lastMicros - startMicros : 0, error);
+  if (!written) fprintf(stderr, "%s\n", error.c_str());
+
+  double elapsed = secondsSince(start);
+  printf("bytes %llu  frames %llu  events %llu  missing frames %llu  lost events %u  crc errors %u  bad frames %llu\n",
+         (unsigned long long)totals.bytes, (unsigned long long)totals.frames,
+         (unsigned long long)totals.events, (unsigned long long)totals.gapFrames,
+         (uint16_t)(totals.lastLost - totals.firstLost), frames.crcErrors,
+         (unsigned long long)totals.badFrames);
+  if (totals.setupViolations || totals.holdViolations) {
+    printf("setup violations %llu  hold violations %llu\n",
+           (unsigned long long)totals.setupViolations, (unsigned long long)totals.holdViolations);
+  }
+  printf("received %.0f B/s, decoded %.1f MB/s (%.0fx a %ld baud line)\n",
+         elapsed > 0 ? totals.bytes / elapsed : 0,
+         decodeSeconds > 0 ? totals.bytes / decodeSeconds / 1e6 : 0,
+         decodeSeconds > 0 ? totals.bytes / decodeSeconds / (baud / 10.0) : 0, baud);
+  return totals.gapFrames || totals.badFrames || frames.crcErrors || !written ? 1 : 0;
+}
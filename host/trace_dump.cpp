@@ -0,0 +1,127 @@
+/*
+ * Digital Logic Lab Simulator - Trace Dump (host tool)
+ * Converts the trace frames the firmware streams after 'trace on' (built
+ * with PHASE_TRACE 1) into a Chrome trace for chrome://tracing or
+ * ui.perfetto.dev, and prints a summary: per event name the spans seen,
+ * their total and mean time, and the longest one with when it started,
+ * which is where stalls such as a blocking command read stand out. Frames
+ * missing on the wire and events the device dropped are reported too.
+ *
+ * Build: g++ -O2 -std=c++11 -o trace_dump host/trace_dump.cpp \
+ *            host/TraceExport.cpp host/FrameReader.cpp Trace.cpp Frame.cpp
+ * Usage: trace_dump [-o trace.json] serial.log|/dev/ttyACM0
+ */
+
+#include "FrameReader.h"
+#include "TraceExport.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+struct SpanStats {
+  uint64_t spans;
+  double totalMicros;
+  double longestMicros;
+  double longestAt;
+  double openAt;       // Negative when no span is open
+  uint64_t instants;
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+  std::string tracePath = "trace.json";
+  const char* path = 0;
+  for (int arg = 1; arg < argc; arg++) {
+    if (!strcmp(argv[arg], "-o") && arg + 1 < argc) tracePath = argv[++arg];
+    else path = argv[arg];
+  }
+  if (!path) {
+    fprintf(stderr, "usage: %s [-o trace.json] serial.log|/dev/ttyACM0\n", argv[0]);
+    return 2;
+  }
+  FILE* in = fopen(path, "rb");
+  if (!in) {
+    fprintf(stderr, "%s: cannot open\n", path);
+    return 1;
+  }
+  ChromeTraceWriter writer;
+  std::string error;
+  if (!writer.open(tracePath, error)) {
+    fprintf(stderr, "%s\n", error.c_str());
+    fclose(in);
+    return 1;
+  }
+  writer.addProcess(1, "firmware");
+
+  FrameReader reader;
+  TraceFrame frame;
+  TraceTimeline timeline;
+  std::vector<SpanStats> stats(TRACE_ID_COUNT, SpanStats{0, 0, 0, 0, -1, 0});
+  uint32_t frames = 0;
+  uint32_t missing = 0;
+  uint16_t expected = 0;
+  uint16_t lost = 0;
+  double endMicros = 0;
+  int c;
+  while ((c = fgetc(in)) != EOF) {
+    if (!reader.feed((uint8_t)c) || reader.type() != FRAME_TRACE) continue;
+    if (!decodeTrace(reader.payload(), frame, error)) {
+      fprintf(stderr, "%s\n", error.c_str());
+      continue;
+    }
+    if (frames && frame.sequence != expected) missing += (uint16_t)(frame.sequence - expected);
+    expected = frame.sequence + 1;
+    lost = frame.lost;
+    frames++;
+
+    double microsPerTick = frame.ticksPerSecond ? 1e6 / frame.ticksPerSecond : 1;
+    for (const TraceEvent& event : frame.events) {
+      double micros = timeline.extend(event.ticks) * microsPerTick;
+      writer.event(1, event, micros);
+      endMicros = micros;
+      if (event.id >= TRACE_ID_COUNT) continue;
+      SpanStats& span = stats[event.id];
+      if (event.kind == TRACE_KIND_INSTANT) {
+        span.instants++;
+      }
+      else if (event.kind == TRACE_KIND_BEGIN) {
+        span.openAt = micros;
+      }
+      else if (span.openAt >= 0) {
+        double length = micros - span.openAt;
+        span.spans++;
+        span.totalMicros += length;
+        if (length > span.longestMicros) {
+          span.longestMicros = length;
+          span.longestAt = span.openAt;
+        }
+        span.openAt = -1;
+      }
+    }
+  }
+  fclose(in);
+  if (!writer.finish(error)) {
+    fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+
+  printf("%s: %u frames (%u missing), %llu events, %u dropped on the device, %.3f s\n",
+         tracePath.c_str(), frames, missing, (unsigned long long)writer.eventCount(), lost,
+         endMicros / 1e6);
+  printf("%-14s %9s %12s %10s %12s %12s\n", "name", "spans", "total_ms", "mean_us",
+         "longest_us", "at_ms");
+  for (uint8_t id = 0; id < TRACE_ID_COUNT; id++) {
+    const SpanStats& span = stats[id];
+    if (span.instants) {
+      printf("%-14s %9llu marks\n", traceName(id), (unsigned long long)span.instants);
+    }
+    if (!span.spans) continue;
+    printf("%-14s %9llu %12.3f %10.2f %12.2f %12.3f\n", traceName(id),
+           (unsigned long long)span.spans, span.totalMicros / 1e3, span.totalMicros / span.spans,
+           span.longestMicros, span.longestAt / 1e3);
+  }
+  return frames ? 0 : 1;
+}
@@ -0,0 +1,313 @@
+/*
+ * Digital Logic Lab Simulator - Waveform Store (host tool)
+ * Builds and queries the bit-plane stores of WaveStore.h.
+ *
+ *   import  store telemetry.log   telemetry frames as 1 us samples of
+ *                                 in0..in7, out0..out7 and the counter
+ *   info    store                 signals, samples, transitions per signal
+ *   query   store signal t0 t1    value at t0 and the changes up to t1
+ *   plot    store signal t0 t1 w  the window decimated to w pixels, as step
+ *                                 points, with the glitches underneath
+ *   bench   store [samples]       appends slow clocks with glitches, then
+ *                                 times random range queries, reporting
+ *                                 pages touched and the resident size, and
+ *                                 decimates whole and zoomed windows
+ *
+ * Build: g++ -O2 -std=c++11 -o wave_store host/wave_store.cpp \
+ *            host/WaveStore.cpp host/WaveDecimator.cpp host/FrameReader.cpp Frame.cpp
+ * Usage: wave_store import|info|query|plot|bench store.dlw ...
+ */
+
+#include "FrameReader.h"
+#include "WaveDecimator.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double secondsSince(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Resident set of this process, MB
+double residentMb() {
+  FILE* statm = fopen("/proc/self/statm", "r");
+  if (!statm) return 0;
+  unsigned long size = 0, resident = 0;
+  if (fscanf(statm, "%lu %lu", &size, &resident) != 2) resident = 0;
+  fclose(statm);
+  return resident * (double)sysconf(_SC_PAGESIZE) / 1e6;
+}
+
+int importTelemetry(const char* storePath, const char* streamPath) {
+  FILE* in = fopen(streamPath, "rb");
+  if (!in) {
+    fprintf(stderr, "%s: cannot open\n", streamPath);
+    return 1;
+  }
+  std::vector<std::string> names;
+  for (int i = 0; i < 8; i++) names.push_back("in" + std::to_string(i));
+  for (int i = 0; i < 8; i++) names.push_back("out" + std::to_string(i));
+  for (int i = 0; i < 8; i++) names.push_back("counter" + std::to_string(i));
+  WaveStore store;
+  std::string error;
+  if (!store.create(storePath, names, 1, "1us", error)) {
+    fprintf(stderr, "%s\n", error.c_str());
+    fclose(in);
+    return 1;
+  }
+
+  FrameReader reader;
+  TelemetryFrame frame;
+  bool started = false;
+  uint32_t lastMicros = 0;
+  uint64_t word = 0;
+  int c;
+  while ((c = fgetc(in)) != EOF) {
+    if (!reader.feed((uint8_t)c) || reader.type() != FRAME_TELEMETRY) continue;
+    if (!decodeTelemetry(reader.payload(), frame, error)) continue;
+    for (const TelemetryEvent& event : frame.events) {
+      // The previous word lasts until this event
+      if (started) store.appendRun(word, (uint32_t)(event.micros - lastMicros));
+      started = true;
+      lastMicros = event.micros;
+      word = event.word | (uint64_t)event.counter << 16;
+    }
+  }
+  fclose(in);
+  if (started) store.append(word);
+  printf("%s: %llu samples\n", storePath, (unsigned long long)store.sampleCount());
+  return store.close(error) ? 0 : 1;
+}
+
+int info(const char* storePath) {
+  WaveStore store;
+  std::string error;
+  if (!store.open(storePath, false, error)) {
+    fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+  printf("%s: %u signals, %llu samples of %llu %s, %llu chunks\n", storePath,
+         store.signalCount(), (unsigned long long)store.sampleCount(),
+         (unsigned long long)store.period(), store.timescale().c_str(),
+         (unsigned long long)store.chunkCount());
+  for (uint16_t s = 0; s < store.signalCount(); s++) {
+    uint64_t transitions = 0;
+    uint8_t last = 0;
+    for (uint64_t chunk = 0; chunk < store.chunkCount(); chunk++) {
+      const WaveChunkSignal* entry = store.chunkIndex(chunk, s);
+      transitions += entry->transitions + (chunk && entry->first != last ? 1 : 0);
+      last = entry->last;
+    }
+    printf("  %-12s %12llu transitions\n", store.signalName(s).c_str(),
+           (unsigned long long)transitions);
+  }
+  return 0;
+}
+
+bool openSignal(WaveStore& store, const char* storePath, const char* signalName,
+                uint16_t& signal) {
+  std::string error;
+  if (!store.open(storePath, false, error)) {
+    fprintf(stderr, "%s\n", error.c_str());
+    return false;
+  }
+  signal = 0;
+  while (signal < store.signalCount() && store.signalName(signal) != signalName) signal++;
+  if (signal == store.signalCount()) {
+    fprintf(stderr, "%s: no signal %s\n", storePath, signalName);
+    return false;
+  }
+  return true;
+}
+
+int query(const char* storePath, const char* signalName, uint64_t begin, uint64_t end) {
+  WaveStore store;
+  uint16_t signal;
+  if (!openSignal(store, storePath, signalName, signal)) return 1;
+  bool initial;
+  std::vector<uint64_t> changes;
+  store.transitions(signal, begin, end, initial, changes);
+  printf("%llu %d\n", (unsigned long long)begin, initial ? 1 : 0);
+  bool level = initial;
+  for (uint64_t sample : changes) {
+    level = !level;
+    printf("%llu %d\n", (unsigned long long)sample, level ? 1 : 0);
+  }
+  fprintf(stderr, "%zu changes, %llu index pages, %llu plane pages\n", changes.size(),
+          (unsigned long long)store.stats.indexPages, (unsigned long long)store.stats.planePages);
+  return 0;
+}
+
+int plot(const char* storePath, const char* signalName, uint64_t begin, uint64_t end,
+         uint32_t width) {
+  WaveStore store;
+  uint16_t signal;
+  if (!openSignal(store, storePath, signalName, signal)) return 1;
+  WaveDecimator decimator(store);
+  std::vector<WavePixel> pixels;
+  WaveSeries series;
+  Clock::time_point start = Clock::now();
+  decimator.decimate(signal, begin, end, width, pixels);
+  buildSeries(pixels, series);
+  double seconds = secondsSince(start);
+  for (size_t i = 0; i < series.times.size(); i++) {
+    printf("%llu %d\n", (unsigned long long)series.times[i], series.values[i]);
+  }
+  for (uint64_t sample : series.glitches) printf("glitch %llu\n", (unsigned long long)sample);
+  fprintf(stderr, "%zu pixels, %zu points, %zu glitches in %.0f us, %llu plane pages\n",
+          pixels.size(), series.times.size(), series.glitches.size(), seconds * 1e6,
+          (unsigned long long)store.stats.planePages);
+  return 0;
+}
+
+// Decimates random windows of each size to width pixels; a repeat of the
+// same windows shows the cost once the chunk summaries are cached
+void benchDecimation(WaveStore& store, uint64_t samples, uint16_t numSignals, uint32_t width,
+                     std::mt19937_64& random) {
+  printf("%-10s %6s %8s %9s %10s %10s %10s %10s\n", "window", "pixels", "glitches",
+         "summ_pg", "plane_pg", "us/first", "us/repeat", "us/pixel");
+  WaveDecimator decimator(store, 1024);
+  std::vector<WavePixel> pixels;
+  for (uint64_t window = 10000; window <= samples; window *= 100) {
+    const int queries = 20;
+    std::vector<uint64_t> begins;
+    std::vector<uint16_t> signals;
+    for (int q = 0; q < queries; q++) {
+      begins.push_back(random() % (samples - window + 1));
+      signals.push_back(random() % numSignals);
+    }
+    uint64_t built = decimator.summariesBuilt;
+    WaveStoreStats before = store.stats;
+    uint64_t glitches = 0;
+    double seconds[2];
+    for (int pass = 0; pass < 2; pass++) {
+      Clock::time_point start = Clock::now();
+      for (int q = 0; q < queries; q++) {
+        decimator.decimate(signals[q], begins[q], begins[q] + window, width, pixels);
+        if (pass) continue;
+        for (const WavePixel& pixel : pixels) glitches += pixel.glitch;
+      }
+      seconds[pass] = secondsSince(start) / queries;
+    }
+    printf("%-10llu %6u %8.1f %9.1f %10.1f %10.1f %10.1f %10.3f\n", (unsigned long long)window,
+           width, (double)glitches / queries, (double)(decimator.summariesBuilt - built) / queries,
+           (double)(store.stats.planePages - before.planePages) / (2 * queries),
+           seconds[0] * 1e6, seconds[1] * 1e6, seconds[1] * 1e6 / width);
+    if (window == samples) break;
+    if (window * 100 > samples) window = samples / 100;
+  }
+}
+
+int bench(const char* storePath, uint64_t samples) {
+  // Signal k is a clock of period 2^(k+10) samples; signal 15 also carries
+  // rare one-sample glitches
+  const uint16_t numSignals = 16;
+  std::vector<std::string> names;
+  for (uint16_t i = 0; i < numSignals; i++) names.push_back("s" + std::to_string(i));
+  WaveStore store;
+  std::string error;
+  if (!store.create(storePath, names, 1, "1us", error)) {
+    fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+
+  // One sample at a time for the first million, then as runs
+  uint64_t perSample = samples < 1000000 ? samples : 1000000;
+  std::mt19937_64 random(12345);
+  auto wordAt = [&](uint64_t sample) {
+    uint64_t word = 0;
+    for (uint16_t k = 0; k < numSignals; k++) word |= (sample >> (k + 9) & 1) << k;
+    return word;
+  };
+  Clock::time_point start = Clock::now();
+  for (uint64_t i = 0; i < perSample; i++) store.append(wordAt(i));
+  double perSampleSeconds = secondsSince(start);
+
+  start = Clock::now();
+  uint64_t sample = perSample;
+  while (sample < samples) {
+    uint64_t next = (sample | 511) + 1;  // Signal 0 changes every 512 samples
+    if (next > samples) next = samples;
+    uint64_t word = wordAt(sample);
+    if (random() % 64 == 0 && next - sample > 2) {
+      uint64_t at = sample + random() % (next - sample - 1);
+      store.appendRun(word, at - sample);
+      store.append(word ^ (1ULL << 15));
+      store.appendRun(word, next - at - 1);
+    }
+    else {
+      store.appendRun(word, next - sample);
+    }
+    sample = next;
+  }
+  double runSeconds = secondsSince(start);
+  double appendResident = residentMb();
+  if (!store.close(error) || !store.open(storePath, false, error)) {
+    fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+
+  printf("appended %llu samples x %u signals: %.1f Msamples/s one at a time, %.1f Msamples/s as runs\n",
+         (unsigned long long)samples, numSignals, perSample / perSampleSeconds / 1e6,
+         (samples - perSample) / (runSeconds > 0 ? runSeconds : 1) / 1e6);
+  struct stat file;
+  double fileBytes = stat(storePath, &file) == 0 ? (double)file.st_size : 0;
+  printf("file %.1f MB (%.3f bytes per signal sample), resident %.1f MB while appending\n",
+         fileBytes / 1e6, fileBytes / (samples ? samples * numSignals : 1), appendResident);
+
+  printf("%-10s %8s %10s %10s %10s %10s %9s\n", "window", "queries", "changes",
+         "index_pg", "plane_pg", "us/query", "res_MB");
+  for (uint64_t window = 1000; window <= samples && window <= 100000000; window *= 100) {
+    const int queries = 200;
+    WaveStoreStats before = store.stats;
+    uint64_t changes = 0;
+    start = Clock::now();
+    for (int q = 0; q < queries; q++) {
+      uint16_t signal = random() % numSignals;
+      uint64_t begin = random() % (samples - window + 1);
+      bool initial;
+      std::vector<uint64_t> found;
+      store.transitions(signal, begin, begin + window, initial, found);
+      changes += found.size();
+    }
+    double seconds = secondsSince(start);
+    printf("%-10llu %8d %10.1f %10.1f %10.1f %10.1f %9.1f\n", (unsigned long long)window, queries,
+           (double)changes / queries,
+           (double)(store.stats.indexPages - before.indexPages) / queries,
+           (double)(store.stats.planePages - before.planePages) / queries,
+           seconds / queries * 1e6, residentMb());
+  }
+  benchDecimation(store, samples, numSignals, 1000, random);
+  return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  if (argc >= 4 && !strcmp(argv[1], "import")) return importTelemetry(argv[2], argv[3]);
+  if (argc == 3 && !strcmp(argv[1], "info")) return info(argv[2]);
+  if (argc == 6 && !strcmp(argv[1], "query")) {
+    return query(argv[2], argv[3], strtoull(argv[4], 0, 0), strtoull(argv[5], 0, 0));
+  }
+  if (argc == 7 && !strcmp(argv[1], "plot")) {
+    return plot(argv[2], argv[3], strtoull(argv[4], 0, 0), strtoull(argv[5], 0, 0),
+                (uint32_t)strtoul(argv[6], 0, 0));
+  }
+  if (argc >= 3 && !strcmp(argv[1], "bench")) {
+    return bench(argv[2], argc > 3 ? strtoull(argv[3], 0, 0) : 300000000ULL);
+  }
+  fprintf(stderr, "usage: %s import store.dlw telemetry.log | info store.dlw |\n"
+                  "       query store.dlw signal t0 t1 | plot store.dlw signal t0 t1 width |\n"
+                  "       bench store.dlw [samples]\n", argv[0]);
+  return 2;
+}
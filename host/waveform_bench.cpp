@@ -0,0 +1,210 @@
+/*
+ * Digital Logic Lab Simulator - Waveform Writer Benchmark (host tool)
+ * Simulates each netlist with random single-input toggles and streams
+ * every input and output change (every node with -all) to a waveform
+ * file, then reports the write throughput in value changes per second.
+ * A synthetic row writes random changes on a 64-signal bus to show the
+ * writer on its own. -trace records the first steps of each netlist
+ * simulation (stimulus, evaluation, waveform writes and input edges) in a
+ * TraceBuffer drained from memory into a Chrome trace, one process per
+ * circuit.
+ *
+ * Build: g++ -O2 -std=c++11 -o waveform_bench host/waveform_bench.cpp \
+ *            host/NetlistReader.cpp host/WaveformWriter.cpp host/TraceExport.cpp \
+ *            Netlist.cpp Aig.cpp Trace.cpp Frame.cpp
+ * Usage: waveform_bench [-all] [-n vectors] [-o wave.vcd|wave.fst]
+ *                       [-trace trace.json] netlist.bench...
+ */
+
+#include "NetlistReader.h"
+#include "TraceExport.h"
+#include "WaveformWriter.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double secondsSince(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Steps of each netlist that are traced
+const uint64_t traceSteps = 2000;
+
+// The traced steps of every netlist, drained from memory into one trace
+struct SimTrace {
+  ChromeTraceWriter writer;
+  TraceEvent storage[128];
+  TraceBuffer buffer;
+  TraceTimeline timeline;      // Nanosecond ticks
+  uint32_t pid;                // One process per netlist
+
+  SimTrace() : pid(0) { buffer.begin(storage, 128); }
+
+  void record(uint8_t id, uint8_t kind, uint16_t arg) {
+    uint64_t nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        Clock::now().time_since_epoch()).count();
+    buffer.record((uint32_t)nanos, id, kind, arg);
+    if (buffer.pending() >= 96) drain();
+  }
+
+  void drain() {
+    TraceEvent event;
+    while (buffer.read(event)) writer.event(pid, event, timeline.extend(event.ticks) / 1e3);
+  }
+};
+
+void printRow(const std::string& name, size_t signals, uint64_t steps,
+              const WaveformWriter& wave, double seconds) {
+  printf("%-16s %7zu %9llu %10llu %9.2f %8.3f %10.2f %8.1f\n", name.c_str(), signals,
+         (unsigned long long)steps, (unsigned long long)wave.changeCount(),
+         wave.bytesWritten() / 1e6, seconds, wave.changeCount() / seconds / 1e6,
+         wave.bytesWritten() / seconds / 1e6);
+}
+
+bool benchSynthetic(const std::string& path, uint64_t steps, std::mt19937& random,
+                    std::string& error) {
+  std::unique_ptr<WaveformWriter> wave = openWaveform(path, "synthetic", "1ns", error);
+  if (!wave) return false;
+  const uint16_t numSignals = 64;
+  for (uint16_t i = 0; i < numSignals; i++) {
+    wave->addSignal("bus", "b" + std::to_string(i), i % 8 == 7 ? 16 : 1);
+  }
+  Clock::time_point start = Clock::now();
+  for (uint64_t step = 0; step < steps; step++) {
+    uint32_t bits = random();
+    for (int k = 0; k < 4; k++) {
+      uint16_t signal = (bits >> (8 * k)) % numSignals;
+      wave->change(step * 10, signal, random());
+    }
+  }
+  if (!wave->finish(steps * 10, error)) return false;
+  printRow("synthetic", numSignals, steps, *wave, secondsSince(start));
+  return true;
+}
+
+bool benchNetlist(const std::string& path, HostNetlist& netlist, bool allNodes, uint64_t steps,
+                  std::mt19937& random, SimTrace* trace, std::string& error) {
+  std::unique_ptr<WaveformWriter> wave = openWaveform(path, netlist.name, "1ns", error);
+  if (!wave) return false;
+  Netlist& engine = netlist.engine;
+
+  // Signals are (node, id) pairs; the names come from the netlist file
+  std::vector<NodeId> nodes;
+  std::vector<uint16_t> ids;
+  auto nameOf = [&](NodeId node, const char* prefix) {
+    if (node < netlist.nodeNames.size() && !netlist.nodeNames[node].empty()) {
+      return netlist.nodeNames[node];
+    }
+    return prefix + std::to_string(node);
+  };
+  for (uint16_t i = 0; i < engine.inputCount(); i++) {
+    nodes.push_back(engine.sourceNode(i));
+    ids.push_back(wave->addSignal("inputs", nameOf(engine.sourceNode(i), "in"), 1));
+  }
+  for (uint16_t i = 0; i < engine.outputCount(); i++) {
+    nodes.push_back(engine.outputNode(i));
+    ids.push_back(wave->addSignal("outputs", nameOf(engine.outputNode(i), "out"), 1));
+  }
+  if (allNodes) {
+    for (NodeId node = 0; node < engine.nodeCount(); node++) {
+      if (node < engine.inputCount()) continue;
+      nodes.push_back(node);
+      ids.push_back(wave->addSignal("nodes", nameOf(node, "n"), 1));
+    }
+  }
+
+  uint16_t inputs = engine.inputCount();
+  if (trace) {
+    trace->pid++;
+    trace->buffer.start();
+    trace->writer.addProcess(trace->pid, netlist.name);
+  }
+  Clock::time_point start = Clock::now();
+  engine.evaluateAll();
+  for (uint64_t step = 0; step < steps; step++) {
+    SimTrace* traced = step < traceSteps ? trace : 0;
+    if (traced) traced->record(PHASE_SAMPLE, TRACE_KIND_BEGIN, 0);
+    if (inputs) {
+      uint16_t input = random() % inputs;
+      engine.setInput(input, !engine.value(engine.sourceNode(input)));
+      if (traced) traced->record(TRACE_INPUT_EDGE, TRACE_KIND_INSTANT, input);
+    }
+    if (traced) {
+      traced->record(PHASE_SAMPLE, TRACE_KIND_END, 0);
+      traced->record(PHASE_EVALUATE, TRACE_KIND_BEGIN, 0);
+    }
+    if (engine.flipFlopCount()) engine.clock();
+    engine.update();
+    if (traced) {
+      traced->record(PHASE_EVALUATE, TRACE_KIND_END, 0);
+      traced->record(PHASE_OUTPUT, TRACE_KIND_BEGIN, 0);
+    }
+    for (size_t i = 0; i < nodes.size(); i++) wave->change(step * 10, ids[i], engine.value(nodes[i]));
+    if (traced) traced->record(PHASE_OUTPUT, TRACE_KIND_END, 0);
+  }
+  if (trace) trace->drain();
+  if (!wave->finish(steps * 10, error)) return false;
+  printRow(netlist.name, nodes.size(), steps, *wave, secondsSince(start));
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  bool allNodes = false;
+  uint64_t steps = 1000000;
+  std::string wavePath = "waveform_bench.vcd";
+  std::string tracePath;
+  std::vector<std::string> paths;
+  for (int arg = 1; arg < argc; arg++) {
+    if (!strcmp(argv[arg], "-all")) allNodes = true;
+    else if (!strcmp(argv[arg], "-n") && arg + 1 < argc) steps = strtoull(argv[++arg], 0, 10);
+    else if (!strcmp(argv[arg], "-o") && arg + 1 < argc) wavePath = argv[++arg];
+    else if (!strcmp(argv[arg], "-trace") && arg + 1 < argc) tracePath = argv[++arg];
+    else paths.push_back(argv[arg]);
+  }
+
+  printf("%-16s %7s %9s %10s %9s %8s %10s %8s\n", "circuit", "signals", "steps",
+         "changes", "MB", "seconds", "Mchg/s", "MB/s");
+
+  int failures = 0;
+  std::mt19937 random(12345);
+  std::string error;
+  std::unique_ptr<SimTrace> trace;
+  if (!tracePath.empty()) {
+    trace.reset(new SimTrace);
+    if (!trace->writer.open(tracePath, error)) {
+      fprintf(stderr, "%s\n", error.c_str());
+      return 1;
+    }
+  }
+  if (!benchSynthetic(wavePath, steps, random, error)) {
+    fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+  for (const std::string& path : paths) {
+    HostNetlist netlist;
+    if (!loadNetlistFile(path, netlist, error) ||
+        !benchNetlist(wavePath, netlist, allNodes, steps, random, trace.get(), error)) {
+      fprintf(stderr, "%s\n", error.c_str());
+      failures++;
+    }
+  }
+  if (trace) {
+    if (!trace->writer.finish(error)) {
+      fprintf(stderr, "%s\n", error.c_str());
+      return 1;
+    }
+    printf("trace: %llu events of the first %llu steps per netlist in %s\n",
+           (unsigned long long)trace->writer.eventCount(), (unsigned long long)traceSteps,
+           tracePath.c_str());
+  }
+  return failures ? 1 : 0;
+}
@@ -1706,28 +1706,235 @@ for input_node in [node for node in st.session_state.nodes if "Input" in node]:
     st.session_state.input_values[input_node] = st.sidebar.checkbox(input_node, value=False)
 
 # **Logic Propagation Function**
-def compute_output(graph, inputs):
-    node_values = inputs.copy()
+def evaluate_gate(graph, node, node_values):
+    predecessors = list(graph.predecessors(node))
+    gate_type = st.session_state.nodes[node]
 
-    for node in nx.topological_sort(graph):
-        if node in node_values:
-            continue  # Skip inputs
+    if gate_type == "NOT" and len(predecessors) == 1:
+        return NOT(node_values[predecessors[0]])
+    elif len(predecessors) == 2:
+        a, b = node_values[predecessors[0]], node_values[predecessors[1]]
+        return gate_functions[gate_type](a, b)
+    return 0  # Default value if invalid
+
+FEEDBACK_ITERATION_LIMIT = 16
+
+def build_netlist_cache(graph):
+    """
+    Levelizes the circuit once and precomputes each input's fanout cone.
+    Feedback loops are collapsed into strongly connected components, which
+    are kept together in the evaluation order
+    """
+    condensed = nx.condensation(graph)
+    groups = []
+    for component in nx.topological_sort(condensed):
+        members = sorted(condensed.nodes[component]["members"])
+        cyclic = len(members) > 1 or graph.has_edge(members[0], members[0])
+        groups.append((members, cyclic))
+    inputs = [node for node in graph.nodes() if st.session_state.nodes.get(node) == "Input"]
+    has_feedback = any(cyclic for _, cyclic in groups)
+    return {
+        "signature": (frozenset(graph.nodes()), frozenset(graph.edges())),
+        "groups": groups,
+        "cones": {node: nx.descendants(graph, node) for node in graph.nodes()},
+        "aig": None if has_feedback else build_aig(graph, groups, inputs),
+        "inputs": {},
+        "values": None
+    }
 
+def build_aig(graph, groups, inputs):
+    """
+    Lowers a feed-forward circuit into two-input ANDs with complemented
+    edges (an And-Inverter Graph). Identical ANDs are shared through a
+    structural hash and constants are folded while the graph is built.
+    A literal is node << 1 | inverted; node 0 is the constant 0, then the
+    inputs, then the ANDs in evaluation order
+    """
+    literals = {node: (index + 1) << 1 for index, node in enumerate(inputs)}
+    first_and = len(inputs) + 1
+    ands, support, table = [], [], {}
+
+    def literal_support(literal):
+        node = literal >> 1
+        if node == 0:
+            return 0
+        if node < first_and:
+            return 1 << (node - 1)
+        return support[node - first_and]
+
+    def and_of(a, b):
+        a, b = min(a, b), max(a, b)
+        if a == 0 or a == b ^ 1:
+            return 0
+        if a == 1 or a == b:
+            return b
+        if (a, b) not in table:
+            table[(a, b)] = (first_and + len(ands)) << 1
+            ands.append((a, b))
+            support.append(literal_support(a) | literal_support(b))
+        return table[(a, b)]
+
+    def or_of(a, b):
+        return and_of(a ^ 1, b ^ 1) ^ 1
+
+    def xor_of(a, b):
+        return or_of(and_of(a, b ^ 1), and_of(a ^ 1, b))
+
+    lowered = {
+        "AND": and_of,
+        "OR": or_of,
+        "XOR": xor_of,
+        "NAND": lambda a, b: and_of(a, b) ^ 1,
+        "NOR": lambda a, b: or_of(a, b) ^ 1,
+        "XNOR": lambda a, b: xor_of(a, b) ^ 1
+    }
+    for members, _ in groups:
+        node = members[0]
+        if node in literals:
+            continue
         predecessors = list(graph.predecessors(node))
         gate_type = st.session_state.nodes[node]
-
+        # Same conventions as evaluate_gate()
         if gate_type == "NOT" and len(predecessors) == 1:
-            node_values[node] = NOT(node_values[predecessors[0]])
-        elif len(predecessors) == 2:
-            a, b = node_values[predecessors[0]], node_values[predecessors[1]]
-            node_values[node] = gate_functions[gate_type](a, b)
+            literals[node] = literals[predecessors[0]] ^ 1
+        elif len(predecessors) == 2 and gate_type in lowered:
+            literals[node] = lowered[gate_type](literals[predecessors[0]], literals[predecessors[1]])
         else:
-            node_values[node] = 0  # Default value if invalid
+            literals[node] = 0
+
+    return {"literals": literals, "ands": ands, "support": support, "inputs": inputs}
 
+def evaluate_aig(aig, inputs, values, changed_mask):
+    """
+    Evaluates the ANDs that depend on a changed input (all of them when
+    values is None). Returns (values, evaluations)
+    """
+    first_and = len(aig["inputs"]) + 1
+    if values is None:
+        values = [0] * (first_and + len(aig["ands"]))
+        changed_mask = -1
+    for index, node in enumerate(aig["inputs"]):
+        values[index + 1] = int(bool(inputs.get(node, 0)))
+
+    evaluated = 0
+    for index, (a, b) in enumerate(aig["ands"]):
+        if aig["support"][index] & changed_mask:
+            values[first_and + index] = (values[a >> 1] ^ (a & 1)) & (values[b >> 1] ^ (b & 1))
+            evaluated += 1
+    return values, evaluated
+
+def settle_feedback_loop(graph, members, node_values):
+    """
+    Fixed-point iteration over a feedback loop: all gates switch together
+    until nothing changes. Returns (evaluations, settled)
+    """
+    evaluated = 0
+    for _ in range(FEEDBACK_ITERATION_LIMIT):
+        next_values = {node: evaluate_gate(graph, node, node_values) for node in members}
+        evaluated += len(members)
+        if all(node_values.get(node) == next_values[node] for node in members):
+            return evaluated, True
+        node_values.update(next_values)
+
+    # Race: resolve it by switching one gate at a time
+    for _ in range(FEEDBACK_ITERATION_LIMIT):
+        changed = False
+        for node in members:
+            value = evaluate_gate(graph, node, node_values)
+            changed |= node_values.get(node) != value
+            node_values[node] = value
+        evaluated += len(members)
+        if not changed:
+            break
+    return evaluated, False
+
+def compute_output(graph, inputs):
+    """
+    Evaluates the circuit, re-evaluating only the fanout cones of inputs
+    that changed since the last run while the circuit structure is unchanged.
+    Feedback loops such as SR latches keep their state between runs
+    """
+    signature = (frozenset(graph.nodes()), frozenset(graph.edges()))
+    cache = st.session_state.get("netlist_cache")
+    if cache is None or cache["signature"] != signature:
+        cache = build_netlist_cache(graph)
+        st.session_state.netlist_cache = cache
+
+    gates = sum(len(members) for members, _ in cache["groups"]) - len(inputs)
+    aig = cache["aig"]
+    if aig is not None:
+        changed_mask = 0
+        for index, node in enumerate(aig["inputs"]):
+            if cache["inputs"].get(node) != inputs.get(node):
+                changed_mask |= 1 << index
+        values, evaluated = evaluate_aig(aig, inputs, cache["values"], changed_mask)
+        cache["inputs"] = dict(inputs)
+        cache["values"] = values
+        st.session_state.netlist_stats = {
+            "gates": gates,
+            "aig_nodes": len(aig["ands"]),
+            "evaluated": evaluated,
+            "oscillating": []
+        }
+        return {node: values[literal >> 1] ^ (literal & 1) for node, literal in aig["literals"].items()}
+
+    if cache["values"] is None:
+        affected = None  # Full evaluation
+    else:
+        changed = [node for node in inputs if cache["inputs"].get(node) != inputs[node]]
+        affected = set()
+        for node in changed:
+            affected |= cache["cones"].get(node, set())
+
+    node_values = {node: 0 for node in graph.nodes()}
+    if cache["values"] is not None:
+        node_values.update(cache["values"])
+    node_values.update(inputs)
+
+    evaluated = 0
+    oscillating = []
+    for members, cyclic in cache["groups"]:
+        if members[0] in inputs:
+            continue  # Skip inputs
+        if affected is not None and members[0] not in affected:
+            continue
+        if cyclic:
+            count, settled = settle_feedback_loop(graph, members, node_values)
+            evaluated += count
+            if not settled:
+                oscillating.extend(members)
+        else:
+            node_values[members[0]] = evaluate_gate(graph, members[0], node_values)
+            evaluated += 1
+
+    cache["inputs"] = dict(inputs)
+    cache["values"] = node_values
+    st.session_state.netlist_stats = {
+        "gates": gates,
+        "aig_nodes": None,
+        "evaluated": evaluated,
+        "oscillating": oscillating
+    }
     return node_values
 
 # Compute Circuit Output
 output_values = compute_output(st.session_state.circuit_graph, st.session_state.input_values)
+st.sidebar.caption(
+    f"Gates evaluated: {st.session_state.netlist_stats['evaluated']}"
+    f" / {st.session_state.netlist_stats['gates']}"
+)
+if st.session_state.netlist_stats["aig_nodes"] is not None:
+    gates = st.session_state.netlist_stats["gates"]
+    aig_nodes = st.session_state.netlist_stats["aig_nodes"]
+    st.sidebar.caption(
+        f"AIG: {aig_nodes} AND nodes for {gates} gates"
+        + (f" ({100 * (gates - aig_nodes) // gates}% fewer)" if 0 < aig_nodes < gates else "")
+    )
+if st.session_state.netlist_stats["oscillating"]:
+    st.sidebar.warning(
+        "⚠️ Feedback loop did not settle (race/oscillation): "
+        + ", ".join(st.session_state.netlist_stats["oscillating"])
+    )
 
 # **Graph Visualization with Gate Images**
 with col2: